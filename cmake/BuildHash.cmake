@@ -0,0 +1,31 @@
+# Write BuildHash.h defining BUILD_HASH as the short git hash of SOURCE_DIR ("-dirty" appended if the tree has local changes, "unknown" outside a git checkout).  Run as a script before every build so the hash follows the checkout - OUTPUT is only rewritten when the hash changes so it does not force a rebuild
+#
+#   cmake -DSOURCE_DIR=<repository> -DOUTPUT=<file> -P BuildHash.cmake
+
+execute_process(COMMAND git rev-parse --short HEAD
+	WORKING_DIRECTORY ${SOURCE_DIR}
+	OUTPUT_VARIABLE hash
+	OUTPUT_STRIP_TRAILING_WHITESPACE
+	RESULT_VARIABLE result
+	ERROR_QUIET)
+
+if(NOT result EQUAL 0 OR hash STREQUAL "")
+
+	set(hash unknown)
+
+else()
+
+	execute_process(COMMAND git diff --quiet HEAD --
+		WORKING_DIRECTORY ${SOURCE_DIR}
+		RESULT_VARIABLE dirty
+		ERROR_QUIET)
+
+	if(dirty EQUAL 1)
+		set(hash ${hash}-dirty)
+	endif()
+
+endif()
+
+file(WRITE ${OUTPUT}.tmp "#pragma once\n\n// Generated by cmake/BuildHash.cmake\n#define BUILD_HASH \"${hash}\"\n")
+execute_process(COMMAND ${CMAKE_COMMAND} -E copy_if_different ${OUTPUT}.tmp ${OUTPUT})
+file(REMOVE ${OUTPUT}.tmp)
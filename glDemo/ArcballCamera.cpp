@@ -1,16 +1,21 @@
 
 #include "ArcballCamera.h"
-#include "glm\gtx\euler_angles.hpp"
+#include "CPUProfiler.h"
+#include "glm/gtx/euler_angles.hpp"
 
 
 namespace cst {
 
+	std::atomic<unsigned long long> ArcballCamera::recomputeCount(0);
+	std::atomic<unsigned long long> ArcballCamera::recomputesAvoided(0);
+
+
 	//
 	// Private API
 	//
 
 	// update position, orientation and view matrices when camera rotation and radius is modified
-	void ArcballCamera::calculateDerivedValues() {
+	void ArcballCamera::calculateDerivedValues() const {
 
 		const float theta_ = glm::radians<float>(theta);
 		const float phi_ = glm::radians<float>(phi);
@@ -31,6 +36,32 @@ namespace cst {
 		//Vinv = GUMatrix4::rotationMatrix(0.0f, phi_, 0.0f) * GUMatrix4::rotationMatrix(theta_, 0.0f, 0.0f) * GUMatrix4::translationMatrix(0.0f, 0.0f, r);
 	}
 
+
+	// mark the derived values as stale.  If they are already stale the recalculation an eager update would have made is counted as avoided
+	void ArcballCamera::invalidateView() {
+
+		if (viewDirty)
+			recomputesAvoided++;
+
+		viewDirty = true;
+	}
+
+
+	// recalculate the derived values if stale and pass the new camera pose to the frustum (which recalculates its world coordinate planes when they are next used)
+	void ArcballCamera::updateView() const {
+
+		if (!viewDirty)
+			return;
+
+		CPU_PROFILE_ZONE("ArcballCamera::updateView");
+
+		calculateDerivedValues();
+		F.calculateWorldCoordPlanes(C, R);
+
+		viewDirty = false;
+		recomputeCount++;
+	}
+
 	//
 	// Public method implementation
 	//
@@ -46,9 +77,8 @@ namespace cst {
 
 		F = ViewFrustum(55.0f, 1.0f, 0.1f, 500.0f);
 
-		// calculate derived values
-		calculateDerivedValues();
-		F.calculateWorldCoordPlanes(C, R);
+		// derived values are calculated on first use
+		viewDirty = true;
 	}
 
 
@@ -65,9 +95,8 @@ namespace cst {
 
 		F = ViewFrustum(init_fovy, init_aspect, init_nearPlane, init_farPlane);
 
-		// calculate derived values
-		calculateDerivedValues();
-		F.calculateWorldCoordPlanes(C, R);
+		// derived values are calculated on first use
+		viewDirty = true;
 	}
 
 
@@ -80,27 +109,24 @@ namespace cst {
 
 		r *= s;
 
-		// calculate derived values
-		calculateDerivedValues();
-		F.calculateWorldCoordPlanes(C, R);
+		// derived values are recalculated on next use
+		invalidateView();
 	}
 
 	void ArcballCamera::incrementRadius(float i) {
 
 		r += std::max<float>(r + i, 0.0f);
 
-		// calculate derived values
-		calculateDerivedValues();
-		F.calculateWorldCoordPlanes(C, R);
+		// derived values are recalculated on next use
+		invalidateView();
 	}
 
 	void ArcballCamera::rotateCamera(float dTheta, float dPhi) {
 		theta += dTheta;
 		phi += dPhi;
 
-		// calculate derived values
-		calculateDerivedValues();
-		F.calculateWorldCoordPlanes(C, R);
+		// derived values are recalculated on next use
+		invalidateView();
 	}
 
 
@@ -121,30 +147,40 @@ namespace cst {
 	// return a const reference to the camera's view frustum
 	const ViewFrustum& ArcballCamera::getViewFrustum() const {
 
+		updateView();
+
 		return F;
 	}
 
 	// return the camera location in world coordinate space
 	glm::vec4 ArcballCamera::getPosition() const {
 
+		updateView();
+
 		return C;
 	}
 
 	// return a const reference to the camera's orientation matrix in world coordinate space
 	const glm::mat4& ArcballCamera::getOrientation() const {
 
+		updateView();
+
 		return R;
 	}
 
 	// return a const reference to the view transform matrix for the camera
 	const glm::mat4& ArcballCamera::viewTransform() const {
 
+		updateView();
+
 		return V;
 	}
 
 	// return a const reference to the matrix that maps the camera from eye coordinate space to world coordinate space
 	const glm::mat4& ArcballCamera::inverseViewTransform() const {
 
+		updateView();
+
 		return Vinv;
 	}
 
@@ -156,13 +192,12 @@ namespace cst {
 	}
 
 
-	// camera projection setter methods - these act as pass-through methods to the encapsulated GUViewFrustum.  Corresponding reader methods are not specified as these can be accessed via the const interface provided through the GUViewFrustum accessor specified above.  These methods also recalculate the world coordinate planes of the encapsulated frustum
+	// camera projection setter methods - these act as pass-through methods to the encapsulated GUViewFrustum.  Corresponding reader methods are not specified as these can be accessed via the const interface provided through the GUViewFrustum accessor specified above.  The frustum marks its world coordinate planes as stale so they are recalculated on next use
 
 	// set fovy to newFovy specified in degrees and recalculate derived frustum values.  newFovy represents the entire vertical field of view
 	void ArcballCamera::setFieldOfView(const float newFovy) {
 
 		F.setFieldOfView(newFovy);
-		F.calculateWorldCoordPlanes(C, R);
 	}
 
 
@@ -170,7 +205,6 @@ namespace cst {
 	void ArcballCamera::setAspectRatio(const float newAspect) {
 
 		F.setAspectRatio(newAspect);
-		F.calculateWorldCoordPlanes(C, R);
 	}
 
 
@@ -178,7 +212,6 @@ namespace cst {
 	void ArcballCamera::setNearPlaneDistance(const float newDistance) {
 
 		F.setNearPlaneDistance(newDistance);
-		F.calculateWorldCoordPlanes(C, R);
 	}
 
 
@@ -186,6 +219,19 @@ namespace cst {
 	void ArcballCamera::setFarPlaneDistance(const float newDistance) {
 
 		F.setFarPlaneDistance(newDistance);
-		F.calculateWorldCoordPlanes(C, R);
 	}
-}
\ No newline at end of file
+
+
+	// Derived value statistics across all cameras
+
+	unsigned long long ArcballCamera::getRecomputeCount() {
+
+		return recomputeCount;
+	}
+
+
+	unsigned long long ArcballCamera::getRecomputesAvoided() {
+
+		return recomputesAvoided;
+	}
+}
@@ -1,6 +1,6 @@
 #pragma once
 
-// Model an arcball / pivot camera looking at the origin in R3.  The camera by default looks down the negative z axis (using a right-handed coordinate system).  Therefore 'forwards' is along the -z axis.  The camera is actually right/left handed agnostic.  The encapsulated frustum however needs to know the differences for the projection matrix and frustum plane calculations
+// Model an arcball / pivot camera looking at the origin in R3.  The camera by default looks down the negative z axis (using a right-handed coordinate system).  Therefore 'forwards' is along the -z axis.  The camera is actually right/left handed agnostic.  The encapsulated frustum however needs to know the differences for the projection matrix and frustum plane calculations.  Position, orientation and view matrices are derived lazily so repeated rotation / zoom between frames only costs one update when the camera is next read
 #include "core.h"
 #include "ViewFrustum.h"
 
@@ -14,23 +14,33 @@ namespace cst {
 
 		float				r; // radius of the camera's spherical coordinate model.  This lies in the interval [0, +inf]
 
-		ViewFrustum			F; // view frustum of the camera
+		mutable ViewFrustum	F; // view frustum of the camera.  The frustum's camera pose is updated along with the derived values below
 
 
-		// derived values
+		// derived values - evaluated lazily when first accessed after the camera rotation or radius is modified
 
-		glm::vec4			C; // camera position
-		glm::mat4			R;  // camera orientation basis derived from <theta, phi>
+		mutable glm::vec4	C; // camera position
+		mutable glm::mat4	R;  // camera orientation basis derived from <theta, phi>
 
-		glm::mat4			V; //  view matrix for camera's current position and orientation - maps from world to eye coordinate space
-		glm::mat4			Vinv; // inverse view matrix = V^-1 maps from eye to world coordinate space
+		mutable glm::mat4	V; //  view matrix for camera's current position and orientation - maps from world to eye coordinate space
+		mutable glm::mat4	Vinv; // inverse view matrix = V^-1 maps from eye to world coordinate space
+
+		mutable bool		viewDirty; // true if the derived values above are stale
+
+		// derived value statistics across all cameras (see ViewFrustum)
+		static std::atomic<unsigned long long>	recomputeCount;
+		static std::atomic<unsigned long long>	recomputesAvoided;
 
 
 		//
 		// Private API
 		//
 
-		void calculateDerivedValues(); // update position, orientation and view matrices when camera rotation and radius is modified
+		void calculateDerivedValues() const; // update position, orientation and view matrices when camera rotation and radius is modified
+
+		void invalidateView(); // mark the derived values as stale
+
+		void updateView() const; // recalculate the derived values and frustum planes if stale
 
 	public:
 
@@ -70,7 +80,7 @@ namespace cst {
 		const glm::mat4& projectionTransform() const; // return a const reference the projection transform for the camera.  This is a pass-through method and calls projectionMatrix on the encapsulated ViewFrustum
 
 
-		// camera projection setter methods - these act as pass-through methods to the encapsulated ViewFrustum.  Corresponding reader methods are not specified as these can be accessed via the const interface provided through the ViewFrustum accessor specified above.  These methods also recalculate the world coordinate planes of the encapsulated frustum
+		// camera projection setter methods - these act as pass-through methods to the encapsulated ViewFrustum.  Corresponding reader methods are not specified as these can be accessed via the const interface provided through the ViewFrustum accessor specified above.  The frustum marks its derived values as stale so they are recalculated on next use
 
 		void setFieldOfView(const float newFovy); // set fovy to newFovy specified in degrees and recalculate derived frustum values.  newFovy represents the entire vertical field of view
 
@@ -80,6 +90,13 @@ namespace cst {
 
 		void setFarPlaneDistance(const float newDistance); // set the far plane distance to newDistance and recalculate derived frustum values.  If newDistance = 0.0 (as determined by equalf) the encapsulated frustum represents an infinite perspective projection.  newDistance >= 0 is assumed
 
+
+		// Derived value statistics across all cameras
+
+		static unsigned long long getRecomputeCount(); // number of times the view derived values were recalculated
+
+		static unsigned long long getRecomputesAvoided(); // number of recalculations avoided by lazy evaluation
+
 	};
 
 }
@@ -0,0 +1,253 @@
+
+#include "BatchModes.h"
+#include "Viewer.h"
+#include "GLDebugOutput.h"
+#include "GLCallTrace.h"
+#include <chrono>
+
+
+using namespace std;
+
+
+#pragma region Headless rendering
+
+OffscreenTarget* setupHeadlessRendering(HeadlessContext& context, int width, int height) {
+
+	if (!context.create(4, 1))
+		return nullptr;
+
+	// glewInit may report an error when there is no window system display but the GL entry points are loaded first
+	glewInit();
+
+	GLDebugOutput::install();
+
+	cout << "OpenGL " << glGetString(GL_VERSION) << " (" << glGetString(GL_RENDERER) << ")" << endl;
+
+	OffscreenTarget* target = new OffscreenTarget(width, height);
+
+	if (!target->isComplete()) {
+
+		delete target;
+		return nullptr;
+	}
+
+	target->bind();
+
+	redrawScheduler = new RedrawScheduler(false);
+	gpuProfiler = new GPUProfiler();
+	showOverlay = false;
+
+	setupScene(width, height);
+
+	return target;
+}
+
+
+double renderHeadlessFrame(OffscreenTarget* target, GLuint frameNumber) {
+
+	publishCameraSnapshot();
+	acquireCameraSnapshot();
+
+	auto startTime = chrono::steady_clock::now();
+
+	GLDebugOutput::setFrameNumber(frameNumber);
+
+	target->bind();
+
+	gpuProfiler->setTag(profileTag());
+	gpuProfiler->beginFrame();
+
+	renderScene();
+
+	gpuProfiler->endFrame();
+	GLCallTrace::endFrame();
+
+	glFinish();
+
+	return chrono::duration<double, milli>(chrono::steady_clock::now() - startTime).count();
+}
+
+#pragma endregion
+
+
+#pragma region Flythrough benchmark and capture
+
+bool runFlythroughBenchmark(const FlythroughSettings& settings, int width, int height) {
+
+	vector<FlythroughResult> results;
+
+	HeadlessContext context;
+	OffscreenTarget* target = setupHeadlessRendering(context, width, height);
+
+	if (!target)
+		return false;
+
+	cout << "Flythrough benchmark (build " << buildHash() << "): " << settings.warmupFrames << " warm-up and " << settings.measuredFrames << " timed frames per path" << endl;
+
+	GLuint frameNumber = 0;
+
+	for (GLuint filter = 0; filter < NUM_ROADS; filter++) {
+
+		currentRoad = filter;
+
+		for (int path = 0; path < NUM_FLYTHROUGH_PATHS; path++) {
+
+			vector<float> frameTimes;
+
+			frameTimes.reserve(settings.measuredFrames);
+
+			// Warm-up frames are rendered at the start pose so caches and driver state settle before timing starts
+			for (GLuint frame = 0; frame < settings.warmupFrames + settings.measuredFrames; frame++) {
+
+				float t = (frame < settings.warmupFrames) ? 0.0f : (float)(frame - settings.warmupFrames) / (float)std::max<GLuint>(settings.measuredFrames - 1, 1);
+
+				setFlythroughPose(mainCamera, (FlythroughPath)path, t);
+
+				float frameTime = (float)renderHeadlessFrame(target, frameNumber++);
+
+				if (frame >= settings.warmupFrames)
+					frameTimes.push_back(frameTime);
+			}
+
+			FlythroughResult result = { flythroughPathName((FlythroughPath)path), filterStrings[filter], calculateFrameTimeStats(frameTimes) };
+
+			printf("  %-14s %-26s median %8.3f ms, p95 %8.3f ms, p99 %8.3f ms\n", result.path.c_str(), result.configuration.c_str(), result.stats.median, result.stats.p95, result.stats.p99);
+
+			results.push_back(result);
+		}
+	}
+
+	delete target;
+
+	GLDebugOutput::reportSummary(cout);
+
+	if (!writeFlythroughResults(results, settings))
+		return false;
+
+	if (!settings.baselineFilename.empty() && !compareFlythroughBaseline(results, settings)) {
+
+		cout << "Flythrough benchmark FAILED against baseline " << settings.baselineFilename << endl;
+		return false;
+	}
+
+	return true;
+}
+
+
+bool runHeadlessCapture(const HeadlessCaptureSettings& settings) {
+
+	HeadlessContext context;
+	OffscreenTarget* target = setupHeadlessRendering(context, settings.width, settings.height);
+
+	if (!target)
+		return false;
+
+	ofstream manifest(settings.outputDirectory + "/captures.csv");
+
+	if (!manifest.is_open()) {
+
+		cout << "Cannot write to capture directory " << settings.outputDirectory << endl;
+		delete target;
+		return false;
+	}
+
+	manifest << "image,filter,path,t,render_ms" << endl;
+
+	bool passed = true;
+	GLuint frameNumber = 0;
+
+	cout << "Capturing " << NUM_ROADS * NUM_FLYTHROUGH_PATHS * settings.posesPerPath << " frames (" << settings.width << " x " << settings.height << ") to " << settings.outputDirectory << endl;
+
+	for (GLuint filter = 0; filter < NUM_ROADS && passed; filter++) {
+
+		currentRoad = filter;
+
+		for (int path = 0; path < NUM_FLYTHROUGH_PATHS && passed; path++) {
+
+			string pathTag = flythroughPathName((FlythroughPath)path);
+
+			replace(pathTag.begin(), pathTag.end(), ' ', '_');
+
+			for (GLuint pose = 0; pose < settings.posesPerPath && passed; pose++) {
+
+				float t = (settings.posesPerPath > 1) ? (float)pose / (float)(settings.posesPerPath - 1) : 0.0f;
+
+				setFlythroughPose(mainCamera, (FlythroughPath)path, t);
+
+				double renderTime = renderHeadlessFrame(target, frameNumber++);
+
+				char imageName[128];
+
+				snprintf(imageName, sizeof(imageName), "%s_%s_%03u.png", filterTags[filter], pathTag.c_str(), pose);
+
+				passed = target->saveImage(settings.outputDirectory + "/" + imageName);
+
+				if (passed)
+					manifest << imageName << "," << filterStrings[filter] << "," << flythroughPathName((FlythroughPath)path) << "," << t << "," << renderTime << endl;
+			}
+		}
+	}
+
+	if (passed)
+		cout << "Captured " << frameNumber << " frames - manifest written to " << settings.outputDirectory << "/captures.csv" << endl;
+
+	delete target;
+
+	GLDebugOutput::reportSummary(cout);
+
+	return passed;
+}
+
+#pragma endregion
+
+
+#pragma region Replays
+
+bool replayQualityTrace(const string& traceFilename, const string& logFilename, const vector<QualityStep>& ladder, const QualitySettings& settings) {
+
+	vector<QualityTraceFrame> trace;
+
+	if (!loadQualityTrace(traceFilename, trace))
+		return false;
+
+	QualityController controller(ladder, settings, (GLuint)ladder.size() - 1);
+
+	return runQualityReplay(trace, controller, logFilename);
+}
+
+
+void writeReplayTiming(const string& filename, const vector<float>& stepTimes, const vector<float>& frameTimes) {
+
+	ofstream file(filename);
+
+	if (!file.is_open()) {
+
+		cout << "Cannot write replay timing to " << filename << endl;
+		return;
+	}
+
+	size_t numFrames = std::min(stepTimes.size(), frameTimes.size());
+
+	file << "frame,step_ms,render_ms" << endl;
+
+	for (size_t i = 0; i < numFrames; i++)
+		file << i << "," << stepTimes[i] << "," << frameTimes[i] << endl;
+
+	auto report = [numFrames](const char* name, vector<float> times) {
+
+		if (numFrames == 0)
+			return;
+
+		times.resize(numFrames);
+
+		FrameTimeStats stats = calculateFrameTimeStats(times);
+
+		cout << "  " << name << ": median " << stats.median << " ms, p95 " << stats.p95 << " ms, p99 " << stats.p99 << " ms, max " << stats.maximum << " ms" << endl;
+	};
+
+	cout << "Replayed " << numFrames << " frames - timing written to " << filename << endl;
+	report("Step", stepTimes);
+	report("Render", frameTimes);
+}
+
+#pragma endregion
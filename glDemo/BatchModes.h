@@ -0,0 +1,36 @@
+#pragma once
+
+#include "core.h"
+#include "FlythroughBenchmark.h"
+#include "QualityController.h"
+#include "HeadlessContext.h"
+#include "OffscreenTarget.h"
+
+// Modes that run the viewer's scene unattended instead of the interactive loop and then exit - the flythrough benchmark (-flybench) and batch capture (-headless) render on the main thread into an offscreen target of a headless context so they need no window or display, the quality replay (-qualityreplay) runs the adaptive quality controller offline against a recorded trace, and the replay timing report summarises an input replay (-replay).  The scene itself is the viewer's (see Viewer.h)
+
+// Headless batch capture settings (-headless)
+struct HeadlessCaptureSettings {
+
+	GLsizei			width, height;
+	GLuint			posesPerPath; // frames captured along each flythrough path
+	std::string		outputDirectory;
+};
+
+
+// Create a headless context with a width x height offscreen target and set up the scene to render into it on the calling thread (there is no render thread or text overlay).  Return the bound target, or nullptr if the context or target cannot be created
+OffscreenTarget* setupHeadlessRendering(HeadlessContext& context, int width, int height);
+
+// Render the scene from the current camera pose into target and return the frame time in milliseconds, including waiting for the GPU to finish
+double renderHeadlessFrame(OffscreenTarget* target, GLuint frameNumber);
+
+// Render every flythrough path for every filtering mode into a width x height headless target, timing each frame to completion on the GPU.  Return false if the context cannot be created, the results cannot be written or a regression against the baseline is found
+bool runFlythroughBenchmark(const FlythroughSettings& settings, int width, int height);
+
+// Render every filtering mode at settings.posesPerPath points along each flythrough path and save each frame as a PNG in settings.outputDirectory, with a captures.csv manifest listing each image's filter, path, path position and render time.  Return false if the context, target or any image cannot be created
+bool runHeadlessCapture(const HeadlessCaptureSettings& settings);
+
+// Run a quality controller with the given ladder and settings (starting from the top step) against a recorded trace (see -qualitytrace) and write its decisions to logFilename (if not empty)
+bool replayQualityTrace(const std::string& traceFilename, const std::string& logFilename, const std::vector<QualityStep>& ladder, const QualitySettings& settings);
+
+// Write the time of each replayed step (main thread, including waiting for the frame) and frame (render thread, including the buffer swap) as CSV and report their distribution
+void writeReplayTiming(const std::string& filename, const std::vector<float>& stepTimes, const std::vector<float>& frameTimes);
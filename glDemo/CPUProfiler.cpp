@@ -0,0 +1,212 @@
+
+#include "CPUProfiler.h"
+#include <chrono>
+#include <iomanip>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define CST_CPU_PROFILER_RDTSC
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#endif
+
+
+using namespace std;
+
+
+mutex CPUProfiler::registryMutex;
+vector<CPUProfiler::ThreadBuffer*> CPUProfiler::threadBuffers;
+
+thread_local CPUProfiler::ThreadBuffer* CPUProfiler::currentThreadBuffer = nullptr;
+
+// Reference point for converting ticks to trace time
+static const chrono::steady_clock::time_point	originTime = chrono::steady_clock::now();
+static const unsigned long long					originTicks = CPUProfiler::now();
+
+
+#pragma region Private API
+
+CPUProfiler::ThreadBuffer* CPUProfiler::getThreadBuffer() {
+
+	if (!currentThreadBuffer) {
+
+		ThreadBuffer* buffer = new ThreadBuffer();
+
+		buffer->depth = 0;
+		buffer->head = 0;
+
+		lock_guard<mutex> lock(registryMutex);
+
+		buffer->threadIndex = (GLuint)threadBuffers.size();
+		buffer->threadName = string("Thread ") + to_string(buffer->threadIndex);
+
+		threadBuffers.push_back(buffer);
+
+		currentThreadBuffer = buffer;
+	}
+
+	return currentThreadBuffer;
+}
+
+
+// Escape a string for use in JSON
+static string jsonString(const string& value) {
+
+	string result = "\"";
+
+	for (char c : value) {
+
+		if (c == '"' || c == '\\')
+			result += '\\';
+
+		result += c;
+	}
+
+	return result + "\"";
+}
+
+#pragma endregion
+
+
+#pragma region Public API
+
+unsigned long long CPUProfiler::now() {
+
+#ifdef CST_CPU_PROFILER_RDTSC
+
+	return __rdtsc();
+
+#else
+
+	return (unsigned long long)chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+
+#endif
+}
+
+
+void CPUProfiler::setThreadName(const string& name) {
+
+	ThreadBuffer* buffer = getThreadBuffer();
+
+	lock_guard<mutex> lock(registryMutex);
+
+	buffer->threadName = name;
+}
+
+
+GLuint CPUProfiler::enterZone() {
+
+	return getThreadBuffer()->depth++;
+}
+
+
+void CPUProfiler::exitZone(const char* name, unsigned long long start, GLuint depth) {
+
+	unsigned long long end = now();
+
+	ThreadBuffer* buffer = currentThreadBuffer;
+
+	buffer->depth = depth;
+
+	unsigned long long index = buffer->head.load(memory_order_relaxed);
+	Event& event = buffer->events[index & (EVENTS_PER_THREAD - 1)];
+
+	event.name = name;
+	event.start = start;
+	event.end = end;
+	event.depth = depth;
+
+	buffer->head.store(index + 1, memory_order_release);
+}
+
+
+bool CPUProfiler::writeChromeTrace(const string& filename) {
+
+	ofstream file(filename);
+
+	if (!file.is_open()) {
+
+		cout << "Cannot write CPU trace to " << filename << endl;
+		return false;
+	}
+
+	// Ticks per microsecond.  rdtsc is calibrated over the time since startup
+	unsigned long long ticksNow = now();
+	double elapsedMicroseconds = chrono::duration<double, micro>(chrono::steady_clock::now() - originTime).count();
+
+#ifdef CST_CPU_PROFILER_RDTSC
+	double ticksPerMicrosecond = (elapsedMicroseconds > 0.0) ? (double)(ticksNow - originTicks) / elapsedMicroseconds : 1.0;
+#else
+	double ticksPerMicrosecond = 1000.0;
+#endif
+
+	auto toMicroseconds = [&](unsigned long long ticks) {
+
+		return (double)(long long)(ticks - originTicks) / ticksPerMicrosecond;
+	};
+
+	vector<ThreadBuffer*> buffers;
+	vector<string> threadNames;
+
+	{
+		lock_guard<mutex> lock(registryMutex);
+
+		buffers = threadBuffers;
+
+		for (auto buffer : buffers)
+			threadNames.push_back(buffer->threadName);
+	}
+
+	file << fixed << setprecision(3);
+	file << "{\"traceEvents\":[" << endl;
+
+	bool firstEvent = true;
+	size_t numEvents = 0;
+
+	for (size_t t = 0; t < buffers.size(); t++) {
+
+		ThreadBuffer* buffer = buffers[t];
+
+		file << ((firstEvent) ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->threadIndex << ",\"args\":{\"name\":" << jsonString(threadNames[t]) << "}}";
+		firstEvent = false;
+
+		// Copy the buffer then discard any events the owning thread overwrote during the copy
+		unsigned long long head = buffer->head.load(memory_order_acquire);
+		unsigned long long first = (head > EVENTS_PER_THREAD) ? head - EVENTS_PER_THREAD : 0;
+
+		vector<Event> events;
+
+		events.reserve((size_t)(head - first));
+
+		for (unsigned long long i = first; i < head; i++)
+			events.push_back(buffer->events[i & (EVENTS_PER_THREAD - 1)]);
+
+		// Keep the copy ahead of the reload of head (an acquire load alone does not stop earlier plain reads moving after it on weakly ordered CPUs)
+		atomic_thread_fence(memory_order_acquire);
+
+		unsigned long long headAfter = buffer->head.load(memory_order_acquire);
+
+		// Event headAfter may be being written now and shares its slot with event headAfter - EVENTS_PER_THREAD, so that one is discarded too
+		unsigned long long firstValid = (headAfter >= EVENTS_PER_THREAD) ? headAfter - EVENTS_PER_THREAD + 1 : 0;
+
+		for (unsigned long long i = std::max<unsigned long long>(first, firstValid); i < head; i++) {
+
+			const Event& event = events[(size_t)(i - first)];
+
+			file << ",\n{\"name\":" << jsonString(event.name) << ",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->threadIndex
+				<< ",\"ts\":" << toMicroseconds(event.start) << ",\"dur\":" << (double)(event.end - event.start) / ticksPerMicrosecond << "}";
+
+			numEvents++;
+		}
+	}
+
+	file << endl << "],\"displayTimeUnit\":\"ms\"}" << endl;
+
+	cout << "CPU trace with " << numEvents << " zones from " << buffers.size() << " threads written to " << filename << endl;
+
+	return true;
+}
+
+#pragma endregion
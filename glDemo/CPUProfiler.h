@@ -0,0 +1,103 @@
+#pragma once
+
+#include "core.h"
+#include <atomic>
+#include <mutex>
+
+// CPU instrumentation.  Scoped zones record their start and end timestamps into a ring buffer owned by the calling thread, so recording takes no locks and threads never contend.  Timestamps are read with rdtsc on x86 (calibrated against std::chrono::steady_clock when the trace is written) and steady_clock elsewhere.  The most recent EVENTS_PER_THREAD zones of every thread can be written as a Chrome trace / Perfetto JSON file (load in chrome://tracing or ui.perfetto.dev).  Instrument code with the CPU_PROFILE_* macros - defining CST_DISABLE_CPU_PROFILER compiles every zone out so instrumentation has no cost in builds that do not need it
+
+#ifndef CST_DISABLE_CPU_PROFILER
+#define CST_CPU_PROFILER_ENABLED
+#endif
+
+
+class CPUProfiler {
+
+public:
+
+	static const GLuint		EVENTS_PER_THREAD = 1 << 16; // must be a power of 2
+
+	struct Event {
+
+		const char*			name; // must have static storage duration
+		unsigned long long	start, end; // timestamps (see now)
+		GLuint				depth; // nesting depth on the recording thread
+	};
+
+private:
+
+	// Single producer ring buffer.  Only the owning thread writes events - writers publish with a release store of head and readers discard any events overwritten while they were being copied
+	struct ThreadBuffer {
+
+		std::string						threadName;
+		GLuint							threadIndex;
+		GLuint							depth;
+		std::atomic<unsigned long long>	head; // number of events ever recorded
+		Event							events[EVENTS_PER_THREAD];
+	};
+
+	// Buffers of every thread that has recorded a zone.  Buffers are never freed so zones recorded by threads that have exited (for example job workers) can still be written
+	static std::mutex					registryMutex;
+	static std::vector<ThreadBuffer*>	threadBuffers;
+
+	static thread_local ThreadBuffer*	currentThreadBuffer;
+
+	static ThreadBuffer* getThreadBuffer();
+
+public:
+
+	// Timestamp in profiler ticks
+	static unsigned long long now();
+
+	// Name the calling thread in traces
+	static void setThreadName(const std::string& name);
+
+	// Zone nesting on the calling thread (used by CPUProfileZone)
+	static GLuint enterZone();
+	static void exitZone(const char* name, unsigned long long start, GLuint depth);
+
+	// Write all threads' recorded zones as Chrome trace JSON.  Zones may be recorded by other threads while the file is written.  Return false if the file cannot be written
+	static bool writeChromeTrace(const std::string& filename);
+};
+
+
+// Record the enclosing block as a zone
+class CPUProfileZone {
+
+	const char*			name;
+	unsigned long long	start;
+	GLuint				depth;
+
+public:
+
+	CPUProfileZone(const char* name) {
+
+		this->name = name;
+		depth = CPUProfiler::enterZone();
+		start = CPUProfiler::now();
+	}
+
+	~CPUProfileZone() {
+
+		CPUProfiler::exitZone(name, start, depth);
+	}
+};
+
+
+// Instrumentation macros.  CPU_PROFILE_ZONE(name) times the rest of the enclosing block (name must be a string literal), CPU_PROFILE_FUNCTION() names the zone after the enclosing function and CPU_PROFILE_THREAD(name) names the calling thread
+#ifdef CST_CPU_PROFILER_ENABLED
+
+#define CPU_PROFILE_CONCAT_IMPL(a, b)	a##b
+#define CPU_PROFILE_CONCAT(a, b)		CPU_PROFILE_CONCAT_IMPL(a, b)
+
+#define CPU_PROFILE_ZONE(name)			CPUProfileZone CPU_PROFILE_CONCAT(cpuProfileZone, __LINE__)(name)
+#define CPU_PROFILE_FUNCTION()			CPU_PROFILE_ZONE(__FUNCTION__)
+#define CPU_PROFILE_THREAD(name)		CPUProfiler::setThreadName(name)
+
+#else
+
+#define CPU_PROFILE_ZONE(name)			((void)0)
+#define CPU_PROFILE_FUNCTION()			((void)0)
+#define CPU_PROFILE_THREAD(name)		((void)0)
+
+#endif
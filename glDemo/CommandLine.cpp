@@ -0,0 +1,236 @@
+
+#include "CommandLine.h"
+#include <ctype.h>
+
+
+using namespace std;
+
+
+static const char* usageText =
+	"Usage: glDemo [options]\n"
+	"\n"
+	"Viewer\n"
+	"  -continuous                 render every frame (for benchmarking) instead of only when the view changes\n"
+	"  -cpumips                    build texture mip chains on the job system instead of the driver\n"
+	"  -trace file                 write a CPU trace of the session to file (Chrome trace format) on exit\n"
+	"  -gltrace file               trace GL calls from startup and write the statistics to file on exit\n"
+	"  -capture prefix [png|raw]   capture every frame to prefix_<frame>.png (or raw BGRA) without stalling\n"
+	"                              rendering - V toggles capture at any time\n"
+	"  -quality ms                 start with adaptive quality holding the GPU frame time to ms (Q toggles it,\n"
+	"                              16.7 ms by default)\n"
+	"  -qualitylog file            write the quality controller's decisions to file when it stops\n"
+	"  -qualitytrace file          write the GPU time and quality step of each frame to file when it stops\n"
+	"  -anisopercentile pct        share of road pixels the recommended anisotropy level must cover (95)\n"
+	"  -record file                record all input to file\n"
+	"  -replay file [timing]       replay a recording one frame per step and write the time of each frame to\n"
+	"                              timing (replay_timing.csv)\n"
+	"\n"
+	"Batch modes (run without a window, then exit)\n"
+	"  -flybench prefix            render the scripted camera paths for every filtering mode in a headless\n"
+	"                              context and write the frame time statistics to prefix.json and prefix.csv\n"
+	"    -warmup n                 frames rendered at the start of each path before timing (60)\n"
+	"    -frames n                 frames timed along each path (600)\n"
+	"  -headless directory [WxH]   render every filtering mode at points along each flythrough path in a\n"
+	"                              headless context and save the frames to directory (1024x768)\n"
+	"    -poses n                  frames captured along each path (8)\n"
+	"  -qualityreplay trace [log]  run the quality controller against a trace recorded with -qualitytrace\n"
+	"  -microbench file.json       run the loader, conversion, mip, compression, culling and shader reading\n"
+	"                              microbenchmarks and write the results to file.json\n"
+	"    -sizes list               comma separated image sizes (256,1024,4096)\n"
+	"    -threads list             comma separated thread counts (1,2,4)\n"
+	"    -filter name              only run benchmarks whose name contains name\n"
+	"  -baseline file              compare -flybench (CSV) or -microbench (JSON) results with a previous run\n"
+	"  -threshold percent          fail if a median time regressed by more than percent against the baseline (10)\n"
+	"  -cullbench [numObjects]     frustum culling benchmark (1000000 objects)\n"
+	"  -bvhbench [maxObjects]      scene BVH benchmark (up to 1000000 objects)\n"
+	"\n"
+	"Self tests\n"
+	"  -feedbacktest               mip feedback reduction against synthetic data\n"
+	"  -footprinttest              footprint anisotropy analysis against views with known footprints\n"
+	"  -atlastest                  texture atlas packer, gutters and bleed check against synthetic images\n"
+	"\n"
+	"  -help                       show this list\n";
+
+
+#pragma region Private API
+
+static void setDefaultOptions(CommandLineOptions& options) {
+
+	options.command = COMMAND_VIEWER;
+	options.benchmarkObjects = 1000000;
+
+	options.continuousRedraw = false;
+	options.cpuMipmaps = false;
+	options.traceFilename = "";
+	options.glTraceFilename = "";
+	options.recordFilename = "";
+	options.replayFilename = "";
+	options.replayTimingFilename = "replay_timing.csv";
+	options.captureFromStartup = false;
+	options.captureFilenamePrefix = "capture";
+	options.captureOutput = CAPTURE_PNG;
+	options.adaptiveQuality = false;
+	options.quality = { 16.7f, 0.05f, 0.75f, 10, 60, 960 };
+	options.qualityLogFilename = "";
+	options.qualityTraceFilename = "";
+	options.footprintPercentile = 0.95f;
+
+	options.flythrough = { 60, 600, "", "", 0.10 };
+	options.headless = { 1024, 768, 8, "" };
+	options.qualityReplayFilename = "";
+	options.microBenchmarks = { { 256, 1024, 4096 }, { 1, 2, 4 }, "", "", 0.10, "" };
+}
+
+
+// Select command unless an earlier flag already chose what to run
+static void selectCommand(CommandLineOptions& options, ViewerCommand command) {
+
+	if (options.command == COMMAND_VIEWER)
+		options.command = command;
+}
+
+
+// An optional argument is present if the next word does not start a new option
+static bool hasOptionalArgument(int i, int argc, char* argv[]) {
+
+	return i + 1 < argc && argv[i + 1][0] != '-';
+}
+
+#pragma endregion
+
+
+#pragma region Public API
+
+bool parseCommandLine(int argc, char* argv[], CommandLineOptions& options) {
+
+	setDefaultOptions(options);
+
+	for (int i = 1; i < argc; i++) {
+
+		// Options taking an argument only match if one follows
+		bool hasArgument = i + 1 < argc;
+
+		if (strcmp(argv[i], "-help") == 0 || strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0)
+			selectCommand(options, COMMAND_HELP);
+
+		// Viewer
+		else if (strcmp(argv[i], "-continuous") == 0)
+			options.continuousRedraw = true;
+		else if (strcmp(argv[i], "-cpumips") == 0)
+			options.cpuMipmaps = true;
+		else if (strcmp(argv[i], "-trace") == 0 && hasArgument)
+			options.traceFilename = argv[++i];
+		else if (strcmp(argv[i], "-gltrace") == 0 && hasArgument)
+			options.glTraceFilename = argv[++i];
+		else if (strcmp(argv[i], "-capture") == 0 && hasArgument) {
+
+			options.captureFromStartup = true;
+			options.captureFilenamePrefix = argv[++i];
+
+			if (i + 1 < argc && (strcmp(argv[i + 1], "png") == 0 || strcmp(argv[i + 1], "raw") == 0))
+				options.captureOutput = (strcmp(argv[++i], "raw") == 0) ? CAPTURE_RAW : CAPTURE_PNG;
+		}
+		else if (strcmp(argv[i], "-quality") == 0 && hasArgument) {
+
+			options.adaptiveQuality = true;
+			options.quality.targetFrameTime = std::max((float)atof(argv[++i]), 0.1f);
+		}
+		else if (strcmp(argv[i], "-qualitylog") == 0 && hasArgument)
+			options.qualityLogFilename = argv[++i];
+		else if (strcmp(argv[i], "-qualitytrace") == 0 && hasArgument)
+			options.qualityTraceFilename = argv[++i];
+		else if (strcmp(argv[i], "-anisopercentile") == 0 && hasArgument)
+			options.footprintPercentile = glm::clamp<float>((float)atof(argv[++i]) / 100.0f, 0.0f, 1.0f);
+		else if (strcmp(argv[i], "-record") == 0 && hasArgument)
+			options.recordFilename = argv[++i];
+		else if (strcmp(argv[i], "-replay") == 0 && hasArgument) {
+
+			options.replayFilename = argv[++i];
+
+			if (hasOptionalArgument(i, argc, argv))
+				options.replayTimingFilename = argv[++i];
+		}
+
+		// Batch modes
+		else if (strcmp(argv[i], "-flybench") == 0 && hasArgument)
+			options.flythrough.outputPrefix = argv[++i];
+		else if (strcmp(argv[i], "-warmup") == 0 && hasArgument)
+			options.flythrough.warmupFrames = (GLuint)strtoul(argv[++i], nullptr, 10);
+		else if (strcmp(argv[i], "-frames") == 0 && hasArgument)
+			options.flythrough.measuredFrames = std::max<GLuint>((GLuint)strtoul(argv[++i], nullptr, 10), 1);
+		else if (strcmp(argv[i], "-headless") == 0 && hasArgument) {
+
+			options.headless.outputDirectory = argv[++i];
+
+			if (i + 1 < argc && sscanf(argv[i + 1], "%dx%d", &options.headless.width, &options.headless.height) == 2)
+				i++;
+		}
+		else if (strcmp(argv[i], "-poses") == 0 && hasArgument)
+			options.headless.posesPerPath = std::max<GLuint>((GLuint)strtoul(argv[++i], nullptr, 10), 1);
+		else if (strcmp(argv[i], "-qualityreplay") == 0 && hasArgument) {
+
+			options.qualityReplayFilename = argv[++i];
+
+			if (hasOptionalArgument(i, argc, argv))
+				options.qualityLogFilename = argv[++i];
+		}
+		else if (strcmp(argv[i], "-microbench") == 0 && hasArgument)
+			options.microBenchmarks.outputFilename = argv[++i];
+		else if (strcmp(argv[i], "-sizes") == 0 && hasArgument)
+			options.microBenchmarks.imageSizes = parseUintList(argv[++i]);
+		else if (strcmp(argv[i], "-threads") == 0 && hasArgument)
+			options.microBenchmarks.threadCounts = parseUintList(argv[++i]);
+		else if (strcmp(argv[i], "-filter") == 0 && hasArgument)
+			options.microBenchmarks.filter = argv[++i];
+		else if (strcmp(argv[i], "-baseline") == 0 && hasArgument)
+			options.flythrough.baselineFilename = options.microBenchmarks.baselineFilename = argv[++i];
+		else if (strcmp(argv[i], "-threshold") == 0 && hasArgument)
+			options.flythrough.regressionThreshold = options.microBenchmarks.regressionThreshold = atof(argv[++i]) / 100.0;
+		else if (strcmp(argv[i], "-cullbench") == 0 || strcmp(argv[i], "-bvhbench") == 0) {
+
+			selectCommand(options, (strcmp(argv[i], "-cullbench") == 0) ? COMMAND_CULLING_BENCHMARK : COMMAND_BVH_BENCHMARK);
+
+			if (i + 1 < argc && isdigit((unsigned char)argv[i + 1][0])) {
+
+				size_t numObjects = (size_t)strtoull(argv[++i], nullptr, 10);
+
+				if (numObjects > 0)
+					options.benchmarkObjects = numObjects;
+			}
+		}
+
+		// Self tests
+		else if (strcmp(argv[i], "-feedbacktest") == 0)
+			selectCommand(options, COMMAND_FEEDBACK_TEST);
+		else if (strcmp(argv[i], "-footprinttest") == 0)
+			selectCommand(options, COMMAND_FOOTPRINT_TEST);
+		else if (strcmp(argv[i], "-atlastest") == 0)
+			selectCommand(options, COMMAND_ATLAS_TEST);
+
+		else {
+
+			cout << "Unknown option or missing argument: " << argv[i] << " (-help lists the options)" << endl;
+			return false;
+		}
+	}
+
+	// Batch modes run in place of the viewer
+	if (!options.microBenchmarks.outputFilename.empty())
+		selectCommand(options, COMMAND_MICROBENCHMARKS);
+	else if (!options.headless.outputDirectory.empty())
+		selectCommand(options, COMMAND_HEADLESS_CAPTURE);
+	else if (!options.qualityReplayFilename.empty())
+		selectCommand(options, COMMAND_QUALITY_REPLAY);
+	else if (!options.flythrough.outputPrefix.empty())
+		selectCommand(options, COMMAND_FLYTHROUGH_BENCHMARK);
+
+	return true;
+}
+
+
+void printUsage(ostream& out) {
+
+	out << usageText;
+}
+
+#pragma endregion
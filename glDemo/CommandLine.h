@@ -0,0 +1,58 @@
+#pragma once
+
+#include "core.h"
+#include "FlythroughBenchmark.h"
+#include "MicroBenchmark.h"
+#include "QualityController.h"
+#include "FrameCapture.h"
+#include "BatchModes.h"
+
+// Command line of the viewer.  parseCommandLine fills CommandLineOptions (starting from the defaults) and decides what to run - the interactive viewer, one of the batch modes or benchmarks (which exit without opening a window) or a self test.  printUsage lists every option
+
+enum ViewerCommand {
+
+	COMMAND_VIEWER = 0,
+	COMMAND_HELP,
+	COMMAND_FLYTHROUGH_BENCHMARK, // -flybench
+	COMMAND_HEADLESS_CAPTURE, // -headless
+	COMMAND_QUALITY_REPLAY, // -qualityreplay
+	COMMAND_MICROBENCHMARKS, // -microbench
+	COMMAND_CULLING_BENCHMARK, // -cullbench
+	COMMAND_BVH_BENCHMARK, // -bvhbench
+	COMMAND_FEEDBACK_TEST, // -feedbacktest
+	COMMAND_FOOTPRINT_TEST, // -footprinttest
+	COMMAND_ATLAS_TEST // -atlastest
+};
+
+
+struct CommandLineOptions {
+
+	ViewerCommand			command;
+	size_t					benchmarkObjects; // -cullbench / -bvhbench object count
+
+	// Viewer
+	bool					continuousRedraw;
+	bool					cpuMipmaps;
+	std::string				traceFilename; // CPU trace written on exit
+	std::string				glTraceFilename; // GL call trace written on exit
+	std::string				recordFilename, replayFilename, replayTimingFilename;
+	bool					captureFromStartup;
+	std::string				captureFilenamePrefix;
+	CaptureOutput			captureOutput;
+	bool					adaptiveQuality; // start with adaptive quality enabled
+	QualitySettings			quality;
+	std::string				qualityLogFilename, qualityTraceFilename;
+	float					footprintPercentile; // share of road pixels the recommended anisotropy must cover
+
+	// Batch modes
+	FlythroughSettings		flythrough;
+	HeadlessCaptureSettings	headless;
+	std::string				qualityReplayFilename;
+	MicroBenchmarkSettings	microBenchmarks;
+};
+
+
+// Parse the command line into options.  The first benchmark or self test flag given runs in preference to the batch modes, and of those -microbench runs in preference to -headless, then -qualityreplay, then -flybench.  Return false (after reporting the option) if an option is not recognised or is missing its argument
+bool parseCommandLine(int argc, char* argv[], CommandLineOptions& options);
+
+void printUsage(std::ostream& out);
@@ -0,0 +1,262 @@
+
+#include "CullingBenchmark.h"
+#include "ViewFrustum.h"
+#include "SceneBVH.h"
+#include "JobSystem.h"
+#include "glm/gtx/euler_angles.hpp"
+#include <chrono>
+
+using namespace std;
+using namespace cst;
+
+
+// Number of timed passes - the fastest pass is reported to reduce noise
+static const int NUM_PASSES = 5;
+
+
+// Time fn over NUM_PASSES passes and return the fastest pass in milliseconds
+template <typename Fn>
+static double timeBestPass(Fn fn) {
+
+	double best = numeric_limits<double>::max();
+
+	for (int pass = 0; pass < NUM_PASSES; pass++) {
+
+		auto startTime = chrono::steady_clock::now();
+		fn();
+		double elapsed = chrono::duration<double, milli>(chrono::steady_clock::now() - startTime).count();
+
+		best = std::min(best, elapsed);
+	}
+
+	return best;
+}
+
+
+static bool benchmarkFrustum(const ViewFrustum& frustum, const char* label, const vector<float>* centre, const vector<float>& radius, const vector<float>* extent, size_t numObjects) {
+
+	size_t numWords = (numObjects + 31) / 32;
+
+	vector<uint32_t> scalarMask(numWords), batchMask(numWords);
+	size_t scalarVisible = 0, batchVisible = 0;
+
+	cout << label << endl;
+
+	// Spheres
+	double scalarTime = timeBestPass([&]() {
+
+		std::fill(scalarMask.begin(), scalarMask.end(), 0);
+		scalarVisible = 0;
+
+		for (size_t i = 0; i < numObjects; i++) {
+
+			if (frustum.sphereInFrustum(glm::vec3(centre[0][i], centre[1][i], centre[2][i]), radius[i])) {
+
+				scalarMask[i >> 5] |= 1u << (i & 31);
+				scalarVisible++;
+			}
+		}
+	});
+
+	double batchTime = timeBestPass([&]() {
+
+		batchVisible = frustum.cullSpheres(centre[0].data(), centre[1].data(), centre[2].data(), radius.data(), numObjects, batchMask.data());
+	});
+
+	bool spheresMatch = (scalarMask == batchMask && scalarVisible == batchVisible);
+
+	printf("  spheres: %zu / %zu visible, scalar %.3fms, batch %.3fms (%.2fx, %.1f Mobjects/s)%s\n", batchVisible, numObjects, scalarTime, batchTime, scalarTime / batchTime, double(numObjects) / (batchTime * 1000.0), spheresMatch ? "" : " MISMATCH");
+
+	// AABBs
+	scalarTime = timeBestPass([&]() {
+
+		std::fill(scalarMask.begin(), scalarMask.end(), 0);
+		scalarVisible = 0;
+
+		for (size_t i = 0; i < numObjects; i++) {
+
+			if (frustum.aabbInFrustum(glm::vec3(centre[0][i], centre[1][i], centre[2][i]), glm::vec3(extent[0][i], extent[1][i], extent[2][i]))) {
+
+				scalarMask[i >> 5] |= 1u << (i & 31);
+				scalarVisible++;
+			}
+		}
+	});
+
+	batchTime = timeBestPass([&]() {
+
+		batchVisible = frustum.cullAABBs(centre[0].data(), centre[1].data(), centre[2].data(), extent[0].data(), extent[1].data(), extent[2].data(), numObjects, batchMask.data());
+	});
+
+	bool aabbsMatch = (scalarMask == batchMask && scalarVisible == batchVisible);
+
+	printf("  AABBs:   %zu / %zu visible, scalar %.3fms, batch %.3fms (%.2fx, %.1f Mobjects/s)%s\n", batchVisible, numObjects, scalarTime, batchTime, scalarTime / batchTime, double(numObjects) / (batchTime * 1000.0), aabbsMatch ? "" : " MISMATCH");
+
+	return spheresMatch && aabbsMatch;
+}
+
+
+bool runCullingBenchmark(size_t numObjects) {
+
+#if defined(__AVX__)
+	const char* simdPath = "AVX (8 objects / iteration)";
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	const char* simdPath = "SSE2 (4 objects / iteration)";
+#else
+	const char* simdPath = "scalar";
+#endif
+
+	cout << "Frustum culling benchmark: " << numObjects << " objects, batch path " << simdPath << endl;
+
+	// Objects scattered in a 1km cube around the camera
+	mt19937 rng(1);
+	uniform_real_distribution<float> position(-500.0f, 500.0f);
+	uniform_real_distribution<float> size(0.5f, 5.0f);
+
+	vector<float> centre[3], extent[3], radius(numObjects);
+
+	for (int c = 0; c < 3; c++) {
+
+		centre[c].resize(numObjects);
+		extent[c].resize(numObjects);
+	}
+
+	for (size_t i = 0; i < numObjects; i++) {
+
+		for (int c = 0; c < 3; c++) {
+
+			centre[c][i] = position(rng);
+			extent[c][i] = size(rng);
+		}
+
+		radius[i] = glm::length(glm::vec3(extent[0][i], extent[1][i], extent[2][i]));
+	}
+
+	// Camera at the origin looking down an oblique axis so all planes have non-trivial normals
+	glm::vec4 cameraPos = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+	glm::mat4 R = glm::eulerAngleY(glm::radians(30.0f)) * glm::eulerAngleX(glm::radians(-20.0f));
+
+	ViewFrustum finiteFrustum(55.0f, 16.0f / 9.0f, 0.1f, 300.0f);
+	finiteFrustum.calculateWorldCoordPlanes(cameraPos, R);
+
+	ViewFrustum infiniteFrustum(55.0f, 16.0f / 9.0f, 0.1f, 0.0f);
+	infiniteFrustum.calculateWorldCoordPlanes(cameraPos, R);
+
+	bool finiteOK = benchmarkFrustum(finiteFrustum, "Finite frustum (6 planes)", centre, radius, extent, numObjects);
+	bool infiniteOK = benchmarkFrustum(infiniteFrustum, "Infinite frustum (far plane skipped)", centre, radius, extent, numObjects);
+
+	return finiteOK && infiniteOK;
+}
+
+
+// Generate numObjects road segment / billboard sized boxes scattered over a tiled ground plane.  Boxes are flat (0.5 - 8 units wide and up to 4 units tall) and the plane grows with the object count so density is constant
+static void generateTiledScene(size_t numObjects, mt19937& rng, vector<glm::vec3>& boundsMin, vector<glm::vec3>& boundsMax) {
+
+	float halfSize = 5.0f * sqrtf(float(numObjects));
+
+	uniform_real_distribution<float> position(-halfSize, halfSize);
+	uniform_real_distribution<float> width(0.25f, 4.0f);
+	uniform_real_distribution<float> height(0.0f, 4.0f);
+
+	boundsMin.resize(numObjects);
+	boundsMax.resize(numObjects);
+
+	for (size_t i = 0; i < numObjects; i++) {
+
+		glm::vec3 centre = glm::vec3(position(rng), height(rng), position(rng));
+		glm::vec3 extent = glm::vec3(width(rng), height(rng) * 0.5f, width(rng));
+
+		boundsMin[i] = centre - extent;
+		boundsMax[i] = centre + extent;
+	}
+}
+
+
+bool runBVHBenchmark(size_t maxObjects) {
+
+	JobSystem& jobSystem = JobSystem::global();
+
+	cout << "Scene BVH benchmark: up to " << maxObjects << " objects, " << jobSystem.getNumWorkers() + 1 << " threads" << endl;
+	printf("%10s %8s %12s %12s %10s %10s %12s %10s %10s %10s\n", "objects", "nodes", "build(1t)ms", "build(mt)ms", "refit ms", "cull ms", "brute ms", "visible", "visited", "tested");
+
+	bool allMatch = true;
+	mt19937 rng(7);
+
+	for (size_t numObjects = 1000; numObjects <= maxObjects; numObjects *= 10) {
+
+		vector<glm::vec3> boundsMin, boundsMax;
+
+		generateTiledScene(numObjects, rng, boundsMin, boundsMax);
+
+		// Camera above the ground plane looking down into the scene
+		float halfSize = 5.0f * sqrtf(float(numObjects));
+		glm::vec4 cameraPos = glm::vec4(0.0f, 50.0f, halfSize * 0.5f, 1.0f);
+		glm::mat4 R = glm::eulerAngleY(glm::radians(10.0f)) * glm::eulerAngleX(glm::radians(-25.0f));
+
+		ViewFrustum frustum(55.0f, 16.0f / 9.0f, 0.1f, 1000.0f);
+		frustum.calculateWorldCoordPlanes(cameraPos, R);
+
+		// Serial and parallel builds
+		SceneBVH bvh;
+
+		bvh.build(boundsMin.data(), boundsMax.data(), (GLuint)numObjects, nullptr);
+		double serialBuildTime = bvh.getBuildTime();
+
+		bvh.build(boundsMin.data(), boundsMax.data(), (GLuint)numObjects, &jobSystem);
+		double parallelBuildTime = bvh.getBuildTime();
+
+		// Move every object slightly and refit
+		uniform_real_distribution<float> jitter(-1.0f, 1.0f);
+
+		for (size_t i = 0; i < numObjects; i++) {
+
+			glm::vec3 offset = glm::vec3(jitter(rng), 0.0f, jitter(rng));
+
+			boundsMin[i] += offset;
+			boundsMax[i] += offset;
+		}
+
+		bvh.refit(boundsMin.data(), boundsMax.data());
+
+		// Cull with the BVH (best of several passes) and compare against a brute force batch test over all objects
+		vector<GLuint> visible;
+		double cullTime = timeBestPass([&]() { bvh.cull(frustum, visible); });
+
+		vector<float> soa[6];
+
+		for (int c = 0; c < 6; c++)
+			soa[c].resize(numObjects);
+
+		for (size_t i = 0; i < numObjects; i++) {
+
+			glm::vec3 centre = (boundsMin[i] + boundsMax[i]) * 0.5f;
+			glm::vec3 extent = (boundsMax[i] - boundsMin[i]) * 0.5f;
+
+			for (int c = 0; c < 3; c++) {
+
+				soa[c][i] = centre[c];
+				soa[3 + c][i] = extent[c];
+			}
+		}
+
+		vector<uint32_t> mask((numObjects + 31) / 32);
+		size_t bruteVisible = 0;
+
+		double bruteTime = timeBestPass([&]() {
+
+			bruteVisible = frustum.cullAABBs(soa[0].data(), soa[1].data(), soa[2].data(), soa[3].data(), soa[4].data(), soa[5].data(), numObjects, mask.data());
+		});
+
+		// Every object the BVH reports must be visible in the brute force mask and the counts must agree
+		bool match = (visible.size() == bruteVisible);
+
+		for (GLuint obj : visible)
+			match = match && ((mask[obj >> 5] >> (obj & 31)) & 1u);
+
+		allMatch = allMatch && match;
+
+		printf("%10zu %8u %12.2f %12.2f %10.2f %10.3f %12.3f %10zu %10u %10u%s\n", numObjects, bvh.getNodeCount(), serialBuildTime, parallelBuildTime, bvh.getRefitTime(), cullTime, bruteTime, visible.size(), bvh.getNodesVisited(), bvh.getObjectsTested(), match ? "" : " MISMATCH");
+	}
+
+	return allMatch;
+}
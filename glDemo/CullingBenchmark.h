@@ -0,0 +1,9 @@
+#pragma once
+
+#include "core.h"
+
+// Frustum culling benchmark.  Tests numObjects random spheres and AABBs against a view frustum with both the scalar per-object tests and the batch (SIMD) culling path of cst::ViewFrustum, checks both paths agree and reports the throughput of each.  Run from the command line with -cullbench [numObjects] (default 1M objects).  Return true if the scalar and batch results match
+bool runCullingBenchmark(size_t numObjects);
+
+// Scene BVH benchmark.  For scene sizes from 1K objects up to maxObjects (in steps of x10) build a SceneBVH serially and in parallel on the global job system, refit it after moving every object and cull it against a view frustum.  BVH culling is compared against the batch (SIMD) AABB test over all objects.  Run from the command line with -bvhbench [maxObjects] (default 1M objects).  Return true if the BVH and batch culling results match
+bool runBVHBenchmark(size_t maxObjects);
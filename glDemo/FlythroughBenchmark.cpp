@@ -0,0 +1,225 @@
+
+#include "FlythroughBenchmark.h"
+#include <map>
+#include <sstream>
+
+// BuildHash.h is generated from git before each build (cmake/BuildHash.cmake, or the pre-build step of glDemo.vcxproj)
+#if __has_include("BuildHash.h")
+#include "BuildHash.h"
+#endif
+
+#ifndef BUILD_HASH
+#define BUILD_HASH "unknown"
+#endif
+
+using namespace std;
+using namespace cst;
+
+
+// Path parameters.  Theta is the camera elevation (negative theta raises the camera above the road) and the road faces the camera at theta = -80
+static const float ORBIT_THETA = -25.0f;
+static const float ORBIT_RADIUS = 6.0f;
+static const float SWEEP_START_THETA = 0.0f; // about 10 degrees above the road plane
+static const float SWEEP_END_THETA = -80.0f;
+static const float SWEEP_RADIUS = 5.0f;
+static const float ZOOM_THETA = -15.0f;
+static const float ZOOM_START_RADIUS = 1.5f;
+static const float ZOOM_END_RADIUS = 60.0f;
+
+
+#pragma region Private API
+
+// Move the camera to an absolute pose
+static void setPose(ArcballCamera* camera, float theta, float phi, float radius) {
+
+	camera->rotateCamera(theta - camera->getTheta(), phi - camera->getPhi());
+	camera->scaleRadius(radius / camera->getRadius());
+}
+
+
+static string resultKey(const string& path, const string& configuration) {
+
+	return path + '\n' + configuration;
+}
+
+#pragma endregion
+
+
+#pragma region Public API
+
+const char* flythroughPathName(FlythroughPath path) {
+
+	static const char* names[NUM_FLYTHROUGH_PATHS] = { "orbit", "grazing sweep", "zoom" };
+
+	return (path < NUM_FLYTHROUGH_PATHS) ? names[path] : "unknown";
+}
+
+
+void setFlythroughPose(ArcballCamera* camera, FlythroughPath path, float t) {
+
+	switch (path) {
+
+		case FLYTHROUGH_ORBIT:
+			setPose(camera, ORBIT_THETA, 360.0f * t, ORBIT_RADIUS);
+			break;
+
+		case FLYTHROUGH_GRAZING_SWEEP:
+			setPose(camera, SWEEP_START_THETA + (SWEEP_END_THETA - SWEEP_START_THETA) * t, 0.0f, SWEEP_RADIUS);
+			break;
+
+		case FLYTHROUGH_ZOOM:
+
+			// Geometric zoom so each frame scales the radius by the same factor
+			setPose(camera, ZOOM_THETA, 0.0f, ZOOM_START_RADIUS * powf(ZOOM_END_RADIUS / ZOOM_START_RADIUS, t));
+			break;
+
+		default:
+			break;
+	}
+}
+
+
+FrameTimeStats calculateFrameTimeStats(vector<float> frameTimes) {
+
+	FrameTimeStats stats = {};
+
+	stats.frames = (GLuint)frameTimes.size();
+
+	if (frameTimes.empty())
+		return stats;
+
+	sort(frameTimes.begin(), frameTimes.end());
+
+	double sum = 0.0;
+
+	for (float time : frameTimes)
+		sum += time;
+
+	// Nearest-rank percentiles
+	auto percentile = [&frameTimes](double p) {
+
+		size_t rank = (size_t)ceil(p * (double)frameTimes.size());
+
+		return (double)frameTimes[std::min<size_t>(std::max<size_t>(rank, 1), frameTimes.size()) - 1];
+	};
+
+	stats.mean = sum / (double)frameTimes.size();
+	stats.median = percentile(0.50);
+	stats.p95 = percentile(0.95);
+	stats.p99 = percentile(0.99);
+	stats.minimum = frameTimes.front();
+	stats.maximum = frameTimes.back();
+
+	return stats;
+}
+
+
+string buildHash() {
+
+	const char* hash = getenv("CST_BUILD_HASH");
+
+	return (hash && hash[0]) ? string(hash) : string(BUILD_HASH);
+}
+
+
+bool writeFlythroughResults(const vector<FlythroughResult>& results, const FlythroughSettings& settings) {
+
+	string hash = buildHash();
+
+	ofstream jsonFile(settings.outputPrefix + ".json");
+	ofstream csvFile(settings.outputPrefix + ".csv");
+
+	if (!jsonFile.is_open() || !csvFile.is_open()) {
+
+		cout << "Cannot write benchmark results to " << settings.outputPrefix << ".json / .csv" << endl;
+		return false;
+	}
+
+	jsonFile << "{" << endl;
+	jsonFile << "  \"build\": \"" << hash << "\"," << endl;
+	jsonFile << "  \"warmup_frames\": " << settings.warmupFrames << "," << endl;
+	jsonFile << "  \"measured_frames\": " << settings.measuredFrames << "," << endl;
+	jsonFile << "  \"results\": [";
+
+	csvFile << "build,path,configuration,frames,mean_ms,median_ms,p95_ms,p99_ms,min_ms,max_ms" << endl;
+
+	for (size_t i = 0; i < results.size(); i++) {
+
+		const FlythroughResult& result = results[i];
+		const FrameTimeStats& stats = result.stats;
+
+		jsonFile << ((i > 0) ? "," : "") << endl << "    { \"path\": \"" << result.path << "\", \"configuration\": \"" << result.configuration << "\", \"frames\": " << stats.frames
+			<< ", \"mean_ms\": " << stats.mean << ", \"median_ms\": " << stats.median << ", \"p95_ms\": " << stats.p95 << ", \"p99_ms\": " << stats.p99
+			<< ", \"min_ms\": " << stats.minimum << ", \"max_ms\": " << stats.maximum << " }";
+
+		csvFile << hash << "," << result.path << "," << result.configuration << "," << stats.frames << "," << stats.mean << "," << stats.median << "," << stats.p95 << "," << stats.p99 << "," << stats.minimum << "," << stats.maximum << endl;
+	}
+
+	jsonFile << endl << "  ]" << endl << "}" << endl;
+
+	cout << "Benchmark results written to " << settings.outputPrefix << ".json and " << settings.outputPrefix << ".csv" << endl;
+
+	return true;
+}
+
+
+bool compareFlythroughBaseline(const vector<FlythroughResult>& results, const FlythroughSettings& settings) {
+
+	ifstream file(settings.baselineFilename);
+
+	if (!file.is_open()) {
+
+		cout << "Cannot read benchmark baseline " << settings.baselineFilename << endl;
+		return false;
+	}
+
+	// Median frame time of each path / configuration in the baseline
+	map<string, double> baseline;
+	string baselineBuild;
+	string line;
+
+	getline(file, line); // header
+
+	while (getline(file, line)) {
+
+		vector<string> fields;
+		stringstream lineStream(line);
+		string field;
+
+		while (getline(lineStream, field, ','))
+			fields.push_back(field);
+
+		if (fields.size() < 6)
+			continue;
+
+		baselineBuild = fields[0];
+		baseline[resultKey(fields[1], fields[2])] = atof(fields[5].c_str());
+	}
+
+	cout << "Comparison with baseline " << settings.baselineFilename << " (build " << baselineBuild << "), regression threshold " << settings.regressionThreshold * 100.0 << "%" << endl;
+
+	bool passed = true;
+
+	for (const FlythroughResult& result : results) {
+
+		auto it = baseline.find(resultKey(result.path, result.configuration));
+
+		if (it == baseline.end() || it->second <= 0.0) {
+
+			printf("  %-14s %-26s median %8.3f ms   (no baseline)\n", result.path.c_str(), result.configuration.c_str(), result.stats.median);
+			continue;
+		}
+
+		double change = (result.stats.median - it->second) / it->second;
+		bool regressed = change > settings.regressionThreshold;
+
+		printf("  %-14s %-26s median %8.3f ms, baseline %8.3f ms (%+6.1f%%)%s\n", result.path.c_str(), result.configuration.c_str(), result.stats.median, it->second, change * 100.0, (regressed) ? "  REGRESSION" : "");
+
+		if (regressed)
+			passed = false;
+	}
+
+	return passed;
+}
+
+#pragma endregion
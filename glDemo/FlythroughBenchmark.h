@@ -0,0 +1,59 @@
+#pragma once
+
+#include "core.h"
+#include "ArcballCamera.h"
+
+// Scripted camera flythrough benchmark.  The viewer renders each camera path for every filtering configuration in a headless context (see HeadlessContext) so it runs on machines with no display - warm-up frames are rendered at the start of the path then a fixed number of frames are timed along it.  Frame times are summarised with order statistics (median, p95, p99) so a few slow frames do not skew the comparison, written as JSON and CSV tagged with the build hash and optionally compared against the CSV of a previous run to flag regressions.  The paths and reporting are here - the frame loop is runFlythroughBenchmark in BatchModes.cpp
+
+enum FlythroughPath {
+
+	FLYTHROUGH_ORBIT = 0, // full orbit around the road at a fixed elevation
+	FLYTHROUGH_GRAZING_SWEEP, // from a grazing view of the road up to overhead
+	FLYTHROUGH_ZOOM, // zoom out from close to the road with scaleRadius
+
+	NUM_FLYTHROUGH_PATHS
+};
+
+
+struct FlythroughSettings {
+
+	GLuint			warmupFrames;
+	GLuint			measuredFrames;
+	std::string		outputPrefix; // results are written to outputPrefix.json and outputPrefix.csv
+	std::string		baselineFilename; // CSV of a previous run to compare against (empty for no comparison)
+	double			regressionThreshold; // relative increase in median frame time reported as a regression
+};
+
+
+// Order statistics of a set of frame times (milliseconds)
+struct FrameTimeStats {
+
+	GLuint			frames;
+	double			mean, median, p95, p99, minimum, maximum;
+};
+
+
+struct FlythroughResult {
+
+	std::string		path;
+	std::string		configuration;
+	FrameTimeStats	stats;
+};
+
+
+const char* flythroughPathName(FlythroughPath path);
+
+// Move camera to its pose at t (in [0, 1]) along path.  The camera is moved with rotateCamera and scaleRadius relative to its current pose
+void setFlythroughPose(cst::ArcballCamera* camera, FlythroughPath path, float t);
+
+// Mean, nearest-rank percentiles and range of frameTimes.  Shared by the benchmarks and GPUProfiler so every report computes its percentiles the same way
+FrameTimeStats calculateFrameTimeStats(std::vector<float> frameTimes);
+
+// Build identifier recorded with the results - the CST_BUILD_HASH environment variable if set, otherwise the git hash of the checkout generated into BuildHash.h by the build (or "unknown")
+std::string buildHash();
+
+// Write results to settings.outputPrefix.json and .csv.  Return false if either file cannot be written
+bool writeFlythroughResults(const std::vector<FlythroughResult>& results, const FlythroughSettings& settings);
+
+// Compare median frame times against the baseline CSV and report each path / configuration.  Return false if any regressed by more than settings.regressionThreshold (or the baseline cannot be read)
+bool compareFlythroughBaseline(const std::vector<FlythroughResult>& results, const FlythroughSettings& settings);
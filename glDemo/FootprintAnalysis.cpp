@@ -0,0 +1,286 @@
+
+#include "FootprintAnalysis.h"
+#include "SelfTest.h"
+
+
+using namespace std;
+
+
+#pragma region Private API
+
+// Position (in the plane of the quad) and texture coordinates (in texels) where the ray through the normalised device position ndc meets the plane.  Return false if the plane does not lie between the near and far planes at that position.  Double precision keeps the one pixel differences accurate at grazing angles
+static bool planeTexCoord(const glm::dmat4& inverseMVP, const glm::dvec2& ndc, const glm::dvec2& textureSize, glm::dvec2& position, glm::dvec2& texel) {
+
+	glm::dvec4 nearPoint = inverseMVP * glm::dvec4(ndc, -1.0, 1.0);
+	glm::dvec4 farPoint = inverseMVP * glm::dvec4(ndc, 1.0, 1.0);
+
+	if (nearPoint.w == 0.0 || farPoint.w == 0.0)
+		return false;
+
+	glm::dvec3 a = glm::dvec3(nearPoint) / nearPoint.w;
+	glm::dvec3 b = glm::dvec3(farPoint) / farPoint.w;
+
+	double dz = b.z - a.z;
+
+	if (fabs(dz) < 1.0e-12)
+		return false;
+
+	double t = -a.z / dz;
+
+	if (t < 0.0 || t > 1.0)
+		return false;
+
+	glm::dvec3 p = a + t * (b - a);
+
+	position = glm::dvec2(p);
+	texel = glm::dvec2(p.x + 0.5, 0.5 - p.y) * textureSize;
+
+	return true;
+}
+
+
+static glm::dvec2 windowToNDC(double x, double y, GLuint viewportWidth, GLuint viewportHeight) {
+
+	return glm::dvec2(2.0 * x / viewportWidth - 1.0, 2.0 * y / viewportHeight - 1.0);
+}
+
+#pragma endregion
+
+
+#pragma region Public API
+
+void clearFootprintHistogram(FootprintHistogram& histogram) {
+
+	histogram.pixels = 0;
+	histogram.beyondMax = 0;
+	histogram.magnified = 0;
+
+	for (GLuint i = 0; i <= FOOTPRINT_MAX_ANISOTROPY; i++)
+		histogram.anisotropy[i] = 0;
+
+	for (GLuint i = 0; i < FOOTPRINT_LOD_BINS; i++)
+		histogram.lod[i] = 0;
+}
+
+
+void analyseQuadFootprint(const glm::mat4& modelViewProjection, const glm::vec2& textureSize, GLuint viewportWidth, GLuint viewportHeight, GLuint stride, FootprintHistogram& histogram) {
+
+	if (viewportWidth == 0 || viewportHeight == 0)
+		return;
+
+	stride = std::max<GLuint>(stride, 1);
+
+	glm::dmat4 inverseMVP = glm::inverse(glm::dmat4(modelViewProjection));
+	glm::dvec2 size = glm::dvec2(textureSize);
+
+	for (GLuint y = stride / 2; y < viewportHeight; y += stride) {
+
+		for (GLuint x = stride / 2; x < viewportWidth; x += stride) {
+
+			glm::dvec2 position, texel, rightPosition, rightTexel, upPosition, upTexel;
+
+			// Pixel centre and its right and upper neighbours - the plane is unbounded for the neighbours so pixels at the edge of the quad have derivatives
+			if (!planeTexCoord(inverseMVP, windowToNDC(x + 0.5, y + 0.5, viewportWidth, viewportHeight), size, position, texel))
+				continue;
+
+			if (fabs(position.x) > 0.5 || fabs(position.y) > 0.5)
+				continue;
+
+			if (!planeTexCoord(inverseMVP, windowToNDC(x + 1.5, y + 0.5, viewportWidth, viewportHeight), size, rightPosition, rightTexel) ||
+				!planeTexCoord(inverseMVP, windowToNDC(x + 0.5, y + 1.5, viewportWidth, viewportHeight), size, upPosition, upTexel))
+				continue;
+
+			glm::dvec2 dx = rightTexel - texel;
+			glm::dvec2 dy = upTexel - texel;
+
+			double px = glm::length(dx);
+			double py = glm::length(dy);
+			double pmax = std::max(std::max(px, py), 1.0e-12);
+			double pmin = std::max(std::min(px, py), 1.0e-12);
+
+			// Samples taken along the major axis.  The small tolerance keeps exact ratios (2.0000001) in their own bin
+			double ratio = pmax / pmin;
+			GLuint samples = (GLuint)std::max(ceil(ratio - 1.0e-4), 1.0);
+
+			if (samples > FOOTPRINT_MAX_ANISOTROPY) {
+
+				histogram.beyondMax++;
+				samples = FOOTPRINT_MAX_ANISOTROPY;
+			}
+
+			histogram.anisotropy[samples]++;
+
+			double lod = log2(pmax / samples);
+
+			if (lod < 0.0) {
+
+				histogram.magnified++;
+				histogram.lod[0]++;
+			}
+			else {
+
+				histogram.lod[std::min((GLuint)lod, FOOTPRINT_LOD_BINS - 1)]++;
+			}
+
+			histogram.pixels++;
+		}
+	}
+}
+
+
+GLuint anisotropyPercentile(const FootprintHistogram& histogram, float fraction) {
+
+	if (histogram.pixels == 0)
+		return 1;
+
+	GLuint target = (GLuint)ceil(glm::clamp<float>(fraction, 0.0f, 1.0f) * histogram.pixels);
+	GLuint count = 0;
+
+	for (GLuint n = 1; n <= FOOTPRINT_MAX_ANISOTROPY; n++) {
+
+		count += histogram.anisotropy[n];
+
+		if (count >= target)
+			return n;
+	}
+
+	return FOOTPRINT_MAX_ANISOTROPY;
+}
+
+
+GLuint lodPercentile(const FootprintHistogram& histogram, float fraction) {
+
+	if (histogram.pixels == 0)
+		return 0;
+
+	GLuint target = (GLuint)ceil(glm::clamp<float>(fraction, 0.0f, 1.0f) * histogram.pixels);
+	GLuint count = 0;
+
+	for (GLuint i = 0; i < FOOTPRINT_LOD_BINS; i++) {
+
+		count += histogram.lod[i];
+
+		if (count >= target)
+			return i;
+	}
+
+	return FOOTPRINT_LOD_BINS - 1;
+}
+
+
+GLfloat recommendAnisotropy(const FootprintHistogram& histogram, float fraction, GLfloat maxSupported) {
+
+	GLuint needed = anisotropyPercentile(histogram, fraction);
+	GLuint level = 1;
+
+	while (level < needed)
+		level *= 2;
+
+	return std::max(std::min((GLfloat)level, maxSupported), 1.0f);
+}
+
+
+void printFootprintHistogram(const FootprintHistogram& histogram, ostream& out) {
+
+	out << "Footprint of " << histogram.pixels << " sampled pixels" << endl;
+
+	if (histogram.pixels == 0)
+		return;
+
+	double scale = 100.0 / histogram.pixels;
+
+	out << "  Anisotropy ratio (samples):" << endl;
+
+	for (GLuint n = 1; n <= FOOTPRINT_MAX_ANISOTROPY; n++) {
+
+		if (histogram.anisotropy[n] > 0)
+			out << "    " << n << ((n == FOOTPRINT_MAX_ANISOTROPY) ? "+" : "") << ": " << histogram.anisotropy[n] << " (" << histogram.anisotropy[n] * scale << "%)" << endl;
+	}
+
+	out << "  Level of detail (" << FOOTPRINT_MAX_ANISOTROPY << "x anisotropic, " << histogram.magnified << " pixels magnified):" << endl;
+
+	for (GLuint i = 0; i < FOOTPRINT_LOD_BINS; i++) {
+
+		if (histogram.lod[i] > 0)
+			out << "    " << i << ": " << histogram.lod[i] << " (" << histogram.lod[i] * scale << "%)" << endl;
+	}
+}
+
+#pragma endregion
+
+
+#pragma region Self test
+
+// Orthographic view of the quad filling a 256 x 256 viewport, tilted away from the viewer about the x axis by angle
+static FootprintHistogram tiltedQuad(float angle) {
+
+	glm::mat4 projection = glm::ortho(-0.5f, 0.5f, -0.5f, 0.5f, -1.0f, 1.0f);
+	glm::mat4 model = glm::rotate(glm::mat4(1.0f), angle, glm::vec3(1.0f, 0.0f, 0.0f));
+
+	FootprintHistogram histogram;
+
+	clearFootprintHistogram(histogram);
+	analyseQuadFootprint(projection * model, glm::vec2(256.0f, 256.0f), 256, 256, 1, histogram);
+
+	return histogram;
+}
+
+
+bool runFootprintSelfTest() {
+
+	int failures = 0;
+
+	cout << "Footprint analysis self test" << endl;
+
+	FootprintHistogram empty;
+
+	clearFootprintHistogram(empty);
+
+	selfTestCheck(recommendAnisotropy(empty, 0.95f, 16.0f) == 1.0f, "no pixels needs no anisotropy", failures);
+
+	// Facing the viewer one texel maps to one pixel
+	FootprintHistogram facing = tiltedQuad(0.0f);
+
+	selfTestCheck(facing.pixels == 256 * 256, "quad covers the viewport", failures);
+	selfTestCheck(facing.anisotropy[1] == facing.pixels, "facing quad is isotropic", failures);
+	selfTestCheck(lodPercentile(facing, 1.0f) == 0 && facing.magnified == 0, "facing quad samples level 0", failures);
+
+	// Tilted by 60 degrees the quad covers half the rows so each pixel spans 2 texels vertically
+	FootprintHistogram tilted60 = tiltedQuad(glm::radians(60.0f));
+
+	selfTestCheck(tilted60.pixels > 0 && tilted60.anisotropy[2] == tilted60.pixels, "60 degree tilt has ratio 2", failures);
+	selfTestCheck(lodPercentile(tilted60, 1.0f) == 0, "ratio 2 with 2 samples stays at level 0", failures);
+	selfTestCheck(recommendAnisotropy(tilted60, 0.95f, 16.0f) == 2.0f, "60 degree tilt recommends 2x", failures);
+
+	// cos(angle) = 1 / 6 - ratio 6 is covered by the 8x level
+	FootprintHistogram tilted6 = tiltedQuad(acosf(1.0f / 6.0f));
+
+	selfTestCheck(anisotropyPercentile(tilted6, 0.95f) == 6, "ratio 6 found at the 95th percentile", failures);
+	selfTestCheck(recommendAnisotropy(tilted6, 0.95f, 16.0f) == 8.0f, "ratio 6 recommends 8x", failures);
+	selfTestCheck(recommendAnisotropy(tilted6, 0.95f, 4.0f) == 4.0f, "recommendation clamped to the supported maximum", failures);
+
+	// A road receding towards the horizon (the demo's road view) - the ratio and level of detail grow with distance
+	glm::mat4 projection = glm::perspective(glm::radians(55.0f), 1024.0f / 768.0f, 0.1f, 500.0f);
+	glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 2.0f, 60.0f), glm::vec3(0.0f, 0.0f, -60.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	glm::mat4 model = glm::rotate(glm::mat4(1.0f), glm::radians(-90.0f), glm::vec3(1.0f, 0.0f, 0.0f)) * glm::scale(glm::mat4(1.0f), glm::vec3(32.0f, 128.0f, 1.0f));
+
+	FootprintHistogram road;
+
+	clearFootprintHistogram(road);
+	analyseQuadFootprint(projection * view * model, glm::vec2(512.0f, 512.0f), 1024, 768, 4, road);
+
+	GLuint lodTotal = 0;
+
+	for (GLuint i = 0; i < FOOTPRINT_LOD_BINS; i++)
+		lodTotal += road.lod[i];
+
+	selfTestCheck(road.pixels > 0 && lodTotal == road.pixels, "every sampled pixel has a level of detail", failures);
+	selfTestCheck(anisotropyPercentile(road, 0.5f) < anisotropyPercentile(road, 0.99f), "grazing road needs more anisotropy towards the horizon", failures);
+	selfTestCheck(recommendAnisotropy(road, 0.95f, 16.0f) >= 4.0f, "grazing road recommends at least 4x", failures);
+
+	printFootprintHistogram(road, cout);
+
+	return selfTestSummary(failures);
+}
+
+#pragma endregion
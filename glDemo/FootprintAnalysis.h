@@ -0,0 +1,39 @@
+#pragma once
+
+#include "core.h"
+
+// Texel footprint statistics for a view of a textured quad (the TexturedQuadModel geometry - a unit quad in the z = 0 plane with texture coordinates (0, 0) at its top left corner).  Each sampled pixel is unprojected onto the plane of the quad, and the texture coordinates of the pixel and its right and upper neighbours give the texel footprint along each screen axis, as dFdx / dFdy would on the GPU.  The anisotropy ratio of the footprint is the number of samples GL_EXT_texture_filter_anisotropic takes along its major axis (ceil(Pmax / Pmin)) and the level of detail selected is log2(Pmax / N) for N samples.  The histograms show which anisotropy level the view actually needs, so the lowest level that covers a given fraction of pixels can be used instead of a fixed maximum.  These functions make no GL calls
+
+static const GLuint		FOOTPRINT_MAX_ANISOTROPY = 16; // highest ratio binned - larger ratios are counted in the last bin
+static const GLuint		FOOTPRINT_LOD_BINS = 16;
+
+
+struct FootprintHistogram {
+
+	GLuint		pixels; // sampled pixels covered by the quad
+	GLuint		anisotropy[FOOTPRINT_MAX_ANISOTROPY + 1]; // pixels needing n samples (bin 0 unused)
+	GLuint		beyondMax; // pixels whose ratio exceeds FOOTPRINT_MAX_ANISOTROPY (also counted in the last bin)
+	GLuint		lod[FOOTPRINT_LOD_BINS]; // pixels by whole level of detail selected with FOOTPRINT_MAX_ANISOTROPY samples (magnified pixels in bin 0)
+	GLuint		magnified; // pixels with a level of detail below 0
+};
+
+// Clear every bin
+void clearFootprintHistogram(FootprintHistogram& histogram);
+
+// Add the pixels of a viewportWidth x viewportHeight view of the quad transformed by modelViewProjection, sampling every stride pixels in each direction.  textureSize is the size of the texture's base level in texels
+void analyseQuadFootprint(const glm::mat4& modelViewProjection, const glm::vec2& textureSize, GLuint viewportWidth, GLuint viewportHeight, GLuint stride, FootprintHistogram& histogram);
+
+// Lowest anisotropy ratio (samples) covering at least fraction of the sampled pixels (1 if no pixels were sampled)
+GLuint anisotropyPercentile(const FootprintHistogram& histogram, float fraction);
+
+// Lowest whole level of detail at or below which at least fraction of the sampled pixels lie (0 if no pixels were sampled)
+GLuint lodPercentile(const FootprintHistogram& histogram, float fraction);
+
+// Lowest power of two anisotropy level (the steps hardware implements) covering fraction of the sampled pixels, clamped to maxSupported (GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT)
+GLfloat recommendAnisotropy(const FootprintHistogram& histogram, float fraction, GLfloat maxSupported);
+
+// Write both histograms to out with the percentage of pixels in each bin
+void printFootprintHistogram(const FootprintHistogram& histogram, std::ostream& out);
+
+// Check the analysis against views with known footprints and report the results to cout.  Return true if all checks pass
+bool runFootprintSelfTest();
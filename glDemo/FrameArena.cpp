@@ -0,0 +1,127 @@
+
+#include "FrameArena.h"
+
+
+using namespace std;
+
+
+FrameArena::FrameArena(size_t blockSize) {
+
+	this->blockSize = blockSize;
+
+	currentBlock = 0;
+	currentOffset = 0;
+
+	bytesAllocated = 0;
+	peakBytesAllocated = 0;
+
+	addBlock(blockSize);
+}
+
+
+FrameArena::~FrameArena() {
+
+	for (auto& block : blocks)
+		free(block.data);
+}
+
+
+void* FrameArena::allocate(size_t size, size_t alignment) {
+
+	// Find the first block (from the current block onwards) with enough space for the aligned allocation
+	while (true) {
+
+		Block& block = blocks[currentBlock];
+
+		size_t alignedOffset = (currentOffset + alignment - 1) & ~(alignment - 1);
+
+		if (alignedOffset + size <= block.size) {
+
+			currentOffset = alignedOffset + size;
+
+			bytesAllocated += size;
+			peakBytesAllocated = std::max<size_t>(peakBytesAllocated, bytesAllocated);
+
+			return block.data + alignedOffset;
+		}
+
+		if (currentBlock + 1 == blocks.size())
+			addBlock(size + alignment);
+
+		currentBlock++;
+		currentOffset = 0;
+	}
+}
+
+
+const char* FrameArena::vformat(size_t* length, const char* formatString, va_list args) {
+
+	// Try to format directly into the space remaining in the current block - this succeeds for almost all strings
+	Block& block = blocks[currentBlock];
+	size_t available = block.size - currentOffset;
+
+	va_list argsCopy;
+	va_copy(argsCopy, args);
+	int len = vsnprintf(block.data + currentOffset, available, formatString, argsCopy);
+	va_end(argsCopy);
+
+	if (len < 0) {
+
+		if (length)
+			*length = 0;
+
+		return "";
+	}
+
+	char* str;
+
+	if ((size_t)len < available) {
+
+		str = (char*)allocate((size_t)len + 1, 1);
+	}
+	else {
+
+		// String did not fit - allocate the exact size (possibly from a new block) and format again
+		str = (char*)allocate((size_t)len + 1, 1);
+		vsnprintf(str, (size_t)len + 1, formatString, args);
+	}
+
+	if (length)
+		*length = (size_t)len;
+
+	return str;
+}
+
+
+void FrameArena::reset() {
+
+	currentBlock = 0;
+	currentOffset = 0;
+	bytesAllocated = 0;
+}
+
+
+size_t FrameArena::getBytesAllocated() const {
+
+	return bytesAllocated;
+}
+
+
+size_t FrameArena::getPeakBytesAllocated() const {
+
+	return peakBytesAllocated;
+}
+
+
+
+// Private method implementation
+
+void FrameArena::addBlock(size_t minSize) {
+
+	Block block;
+
+	block.size = std::max<size_t>(blockSize, minSize);
+	block.data = (char*)malloc(block.size);
+
+	blocks.push_back(block);
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "core.h"
+
+// Linear (bump) allocator for transient per-frame data.  Memory is allocated from a list of fixed size blocks and released all at once by reset().  Blocks are retained between frames so a steady-state frame performs no heap allocations.  Allocations larger than the block size get a dedicated block
+
+class FrameArena {
+
+	struct Block {
+
+		char*		data;
+		size_t		size;
+	};
+
+	std::vector<Block>		blocks;
+	size_t					blockSize;
+	size_t					currentBlock;
+	size_t					currentOffset;
+
+	size_t					bytesAllocated; // bytes handed out since the last reset
+	size_t					peakBytesAllocated;
+
+	void addBlock(size_t minSize);
+
+public:
+
+	FrameArena(size_t blockSize = 64 * 1024);
+	~FrameArena();
+
+	FrameArena(const FrameArena&) = delete;
+	FrameArena& operator=(const FrameArena&) = delete;
+
+	// Return size bytes aligned to 'alignment' (which must be a power of 2).  The memory remains valid until the next call to reset
+	void* allocate(size_t size, size_t alignment = sizeof(void*));
+
+	// printf-style formatting into the arena.  Return a null-terminated string valid until the next call to reset.  If length is not nullptr the string length is returned in *length
+	const char* vformat(size_t* length, const char* formatString, va_list args);
+
+	// Release all allocations
+	void reset();
+
+	size_t getBytesAllocated() const;
+	size_t getPeakBytesAllocated() const;
+};
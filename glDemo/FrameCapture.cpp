@@ -0,0 +1,321 @@
+
+#include "FrameCapture.h"
+#include "CPUProfiler.h"
+#include "GLDebugOutput.h"
+#include <chrono>
+
+
+using namespace std;
+
+
+#pragma region Private API
+
+// Copy a completed read into a pooled frame and queue it for the encoder.  The fence of slot must have signalled
+void FrameCapture::processSlot(Slot& slot) {
+
+	CPU_PROFILE_FUNCTION();
+
+	// Reuse a frame the encoder has finished with.  At most QUEUE_SIZE frames exist so the encode queue cannot overflow - if they are all waiting to be encoded the frame is dropped
+	CapturedFrame* frame = nullptr;
+
+	if (!freeQueue.pop(frame) && framesAllocated < QUEUE_SIZE) {
+
+		frame = new CapturedFrame();
+		framesAllocated++;
+	}
+
+	GLsizeiptr frameSize = (GLsizeiptr)slot.width * slot.height * 4;
+
+	if (frame) {
+
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+
+		const GLubyte* pixels = (const GLubyte*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, frameSize, GL_MAP_READ_BIT);
+
+		if (pixels) {
+
+			frame->frameNumber = slot.frameNumber;
+			frame->width = slot.width;
+			frame->height = slot.height;
+			frame->pixels.assign(pixels, pixels + frameSize);
+
+			glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+		}
+		else {
+
+			// The encoder returns frames with no pixels to the pool without encoding them
+			frame->pixels.clear();
+			framesDropped++;
+		}
+
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+		encodeQueue.push(frame);
+
+		{
+			lock_guard<mutex> lock(encoderMutex);
+		}
+
+		encoderCondition.notify_one();
+	}
+	else {
+
+		framesDropped++;
+	}
+
+	glDeleteSync(slot.fence);
+	slot.fence = 0;
+}
+
+
+void FrameCapture::encoderMain() {
+
+	CPU_PROFILE_THREAD("Frame encoder");
+
+	while (true) {
+
+		CapturedFrame* frame;
+
+		while (encodeQueue.pop(frame)) {
+
+			// Frames with no pixels were dropped after a failed map and are only being returned to the pool
+			if (!frame->pixels.empty()) {
+
+				encode(*frame);
+				framesEncoded++;
+			}
+
+			freeQueue.push(frame);
+		}
+
+		unique_lock<mutex> lock(encoderMutex);
+
+		if (!encoderRunning && encodeQueue.size() == 0)
+			break;
+
+		encoderCondition.wait(lock, [this]() { return !encoderRunning || encodeQueue.size() > 0; });
+	}
+}
+
+
+void FrameCapture::encode(const CapturedFrame& frame) {
+
+	CPU_PROFILE_FUNCTION();
+
+	char filename[512];
+
+	switch (output) {
+
+		case CAPTURE_PNG:
+		{
+			snprintf(filename, sizeof(filename), "%s_%06llu.png", filenamePrefix.c_str(), frame.frameNumber);
+
+			FIBITMAP* bitmap = FreeImage_ConvertFromRawBits((BYTE*)frame.pixels.data(), frame.width, frame.height, frame.width * 4, 32, FI_RGBA_RED_MASK, FI_RGBA_GREEN_MASK, FI_RGBA_BLUE_MASK, FALSE);
+
+			if (!bitmap || !FreeImage_Save(FIF_PNG, bitmap, filename, PNG_Z_BEST_SPEED))
+				cout << "Frame capture: cannot write " << filename << endl;
+
+			FreeImage_Unload(bitmap);
+			break;
+		}
+
+		case CAPTURE_RAW:
+		{
+			snprintf(filename, sizeof(filename), "%s_%06llu_%ux%u.bgra", filenamePrefix.c_str(), frame.frameNumber, frame.width, frame.height);
+
+			ofstream file(filename, ios::binary);
+
+			if (!file.is_open() || !file.write((const char*)frame.pixels.data(), frame.pixels.size()))
+				cout << "Frame capture: cannot write " << filename << endl;
+
+			break;
+		}
+
+		case CAPTURE_CONSUMER:
+			consumer(frame);
+			break;
+	}
+}
+
+#pragma endregion
+
+
+#pragma region Public API
+
+FrameCapture::FrameCapture(CaptureOutput output, const string& filenamePrefix, FrameConsumer consumer) {
+
+	this->output = (output == CAPTURE_CONSUMER && !consumer) ? CAPTURE_PNG : output;
+	this->filenamePrefix = filenamePrefix;
+	this->consumer = consumer;
+
+	for (GLuint i = 0; i < NUM_SLOTS; i++) {
+
+		glGenBuffers(1, &slots[i].buffer);
+		slots[i].size = 0;
+		slots[i].fence = 0;
+	}
+
+	currentSlot = 0;
+	framesAllocated = 0;
+
+	framesCaptured = 0;
+	framesDropped = 0;
+	framesEncoded = 0;
+	frameTime = 0.0;
+	lastFrameTime = 0.0;
+
+	encoderRunning = true;
+	encoder = thread(&FrameCapture::encoderMain, this);
+}
+
+
+FrameCapture::~FrameCapture() {
+
+	flush();
+
+	{
+		lock_guard<mutex> lock(encoderMutex);
+
+		encoderRunning = false;
+	}
+
+	encoderCondition.notify_one();
+	encoder.join();
+
+	// Every frame is back in the free queue once the encoder has stopped
+	CapturedFrame* frame;
+
+	while (freeQueue.pop(frame))
+		delete frame;
+
+	for (GLuint i = 0; i < NUM_SLOTS; i++) {
+
+		if (slots[i].fence)
+			glDeleteSync(slots[i].fence);
+
+		glDeleteBuffers(1, &slots[i].buffer);
+	}
+
+	cout << "Frame capture: " << framesCaptured << " frames captured, " << framesEncoded << " encoded, " << framesDropped << " dropped" << endl;
+}
+
+
+void FrameCapture::capture(GLuint width, GLuint height, unsigned long long frameNumber) {
+
+	CPU_PROFILE_FUNCTION();
+	GLCallContext glCallContext(__FUNCTION__);
+
+	auto startTime = chrono::steady_clock::now();
+
+	lastFrameTime = frameTime;
+	frameTime = 0.0;
+
+	Slot& slot = slots[currentSlot];
+
+	// Every slot is still waiting for the GPU - drop the frame rather than stall
+	if (slot.fence) {
+
+		framesDropped++;
+		return;
+	}
+
+	GLsizeiptr frameSize = (GLsizeiptr)width * height * 4;
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+
+	if (slot.size < frameSize) {
+
+		glBufferData(GL_PIXEL_PACK_BUFFER, frameSize, nullptr, GL_STREAM_READ);
+		slot.size = frameSize;
+	}
+
+	// With a pack buffer bound glReadPixels returns immediately and the copy happens on the GPU timeline
+	glPixelStorei(GL_PACK_ALIGNMENT, 4);
+	glReadPixels(0, 0, width, height, GL_BGRA, GL_UNSIGNED_BYTE, nullptr);
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	slot.width = width;
+	slot.height = height;
+	slot.frameNumber = frameNumber;
+
+	currentSlot = (currentSlot + 1) % NUM_SLOTS;
+	framesCaptured++;
+
+	frameTime += chrono::duration<double, milli>(chrono::steady_clock::now() - startTime).count();
+}
+
+
+void FrameCapture::update() {
+
+	auto startTime = chrono::steady_clock::now();
+
+	// Oldest read first.  Polling with a zero timeout never blocks
+	for (GLuint i = 0; i < NUM_SLOTS; i++) {
+
+		Slot& slot = slots[(currentSlot + i) % NUM_SLOTS];
+
+		if (!slot.fence)
+			continue;
+
+		GLenum result = glClientWaitSync(slot.fence, 0, 0);
+
+		if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED)
+			processSlot(slot);
+	}
+
+	frameTime += chrono::duration<double, milli>(chrono::steady_clock::now() - startTime).count();
+}
+
+
+void FrameCapture::flush() {
+
+	for (GLuint i = 0; i < NUM_SLOTS; i++) {
+
+		Slot& slot = slots[(currentSlot + i) % NUM_SLOTS];
+
+		if (!slot.fence)
+			continue;
+
+		// Wait up to a second - a read that has not completed by then is abandoned
+		GLenum result = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000ull);
+
+		if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED) {
+
+			processSlot(slot);
+		}
+		else {
+
+			glDeleteSync(slot.fence);
+			slot.fence = 0;
+			framesDropped++;
+		}
+	}
+}
+
+
+unsigned long long FrameCapture::getFramesCaptured() const {
+
+	return framesCaptured;
+}
+
+
+unsigned long long FrameCapture::getFramesDropped() const {
+
+	return framesDropped;
+}
+
+
+unsigned long long FrameCapture::getFramesEncoded() const {
+
+	return framesEncoded;
+}
+
+
+double FrameCapture::getFrameTime() const {
+
+	return lastFrameTime;
+}
+
+#pragma endregion
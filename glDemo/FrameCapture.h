@@ -0,0 +1,102 @@
+#pragma once
+
+#include "core.h"
+#include "SPSCQueue.h"
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+
+// Asynchronous frame capture.  capture() queues a glReadPixels of the current read framebuffer into the next of a ring of pixel pack buffers followed by a fence, so the read is pipelined behind rendering instead of stalling it.  update() polls the fences without blocking - a slot whose read has completed (normally one or two frames later) is mapped, its pixels copied into a pooled frame and the buffer released.  Frames are handed to an encoder thread through a lock-free queue and written as PNG or raw BGRA files, or passed to a consumer callback, so the render thread only pays for the map and copy.  If every slot is still in flight or the encoder falls behind the frame is dropped rather than stalling the pipeline.  capture, update and flush must be called on the thread with the GL context
+
+// Captured frame pixels are 32 bit BGRA, bottom row first (the layout of a FreeImage bitmap)
+struct CapturedFrame {
+
+	unsigned long long		frameNumber;
+	GLuint					width, height;
+	std::vector<GLubyte>	pixels;
+};
+
+
+enum CaptureOutput {
+
+	CAPTURE_PNG = 0, // prefix_<frame>.png
+	CAPTURE_RAW, // prefix_<frame>_<width>x<height>.bgra
+	CAPTURE_CONSUMER // frames are passed to the consumer callback
+};
+
+
+// Called on the encoder thread.  The frame is only valid for the duration of the call
+typedef std::function<void(const CapturedFrame& frame)> FrameConsumer;
+
+
+class FrameCapture {
+
+	static const GLuint			NUM_SLOTS = 3; // reads in flight
+	static const size_t			QUEUE_SIZE = 8; // frames waiting for the encoder (power of 2)
+
+	struct Slot {
+
+		GLuint					buffer;
+		GLsizeiptr				size; // bytes allocated
+		GLsync					fence; // 0 if the slot is free
+		GLuint					width, height;
+		unsigned long long		frameNumber;
+	};
+
+	Slot						slots[NUM_SLOTS];
+	GLuint						currentSlot;
+
+	CaptureOutput				output;
+	std::string					filenamePrefix;
+	FrameConsumer				consumer;
+
+	// Frames are handed to the encoder through encodeQueue and returned for reuse through freeQueue so pixel storage is only allocated for the first few frames
+	cst::SPSCQueue<CapturedFrame*, QUEUE_SIZE>	encodeQueue;
+	cst::SPSCQueue<CapturedFrame*, QUEUE_SIZE * 2>	freeQueue;
+	size_t						framesAllocated;
+
+	std::thread					encoder;
+	std::atomic<bool>			encoderRunning;
+	std::mutex					encoderMutex;
+	std::condition_variable		encoderCondition;
+
+	// Statistics
+	unsigned long long			framesCaptured;
+	unsigned long long			framesDropped;
+	std::atomic<unsigned long long>	framesEncoded;
+	double						frameTime; // render thread time spent in capture and update since the last capture (ms)
+	double						lastFrameTime;
+
+	void processSlot(Slot& slot);
+	void encoderMain();
+	void encode(const CapturedFrame& frame);
+
+public:
+
+	// Create the capture ring.  Filenames are filenamePrefix followed by the frame number.  consumer is only used (and must be set) for CAPTURE_CONSUMER
+	FrameCapture(CaptureOutput output, const std::string& filenamePrefix, FrameConsumer consumer = nullptr);
+
+	// Complete any reads in flight, encode every queued frame and stop the encoder thread
+	~FrameCapture();
+
+	FrameCapture(const FrameCapture&) = delete;
+	FrameCapture& operator=(const FrameCapture&) = delete;
+
+	// Queue a read of the width x height frame in the current read framebuffer.  Call after rendering and before the buffer swap
+	void capture(GLuint width, GLuint height, unsigned long long frameNumber);
+
+	// Hand completed reads to the encoder.  Never blocks
+	void update();
+
+	// Wait for every read in flight and hand it to the encoder
+	void flush();
+
+	unsigned long long getFramesCaptured() const;
+	unsigned long long getFramesDropped() const;
+	unsigned long long getFramesEncoded() const;
+
+	// Render thread time spent in capture and update for the last captured frame (ms)
+	double getFrameTime() const;
+};
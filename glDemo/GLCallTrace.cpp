@@ -0,0 +1,861 @@
+
+#define CST_GL_TRACE_IMPLEMENTATION
+#include "GLCallTrace.h"
+#include <iomanip>
+
+
+using namespace std;
+
+
+bool GLCallTrace::installed = false;
+
+GLCallTrace::FrameStats GLCallTrace::currentFrame = {};
+GLCallTrace::FrameStats GLCallTrace::lastFrame = {};
+GLCallTrace::FrameStats GLCallTrace::totals = {};
+unsigned long long GLCallTrace::framesTraced = 0;
+unsigned long long GLCallTrace::frameNumber = 0;
+
+vector<GLCallTrace::FrameSummary> GLCallTrace::history;
+GLuint GLCallTrace::historyNext = 0;
+
+
+#ifdef CST_GL_TRACE_ENABLED
+
+PFNCSTGLBINDTEXTUREPROC		cstglBindTexture = glBindTexture;
+PFNCSTGLTEXIMAGE2DPROC		cstglTexImage2D = glTexImage2D;
+PFNCSTGLTEXSUBIMAGE2DPROC	cstglTexSubImage2D = glTexSubImage2D;
+PFNCSTGLDRAWARRAYSPROC		cstglDrawArrays = glDrawArrays;
+PFNCSTGLDRAWELEMENTSPROC	cstglDrawElements = glDrawElements;
+PFNCSTGLDELETETEXTURESPROC	cstglDeleteTextures = glDeleteTextures;
+
+#endif
+
+
+#pragma region Private API
+
+#ifdef CST_GL_TRACE_ENABLED
+
+// Every traced entry point - the pointer that is hooked and the name of its wrapper (traceName) and saved driver function (realName)
+#define GL_TRACE_ENTRY_POINTS(X) \
+	X(__glewBindVertexArray, BindVertexArray) \
+	X(__glewUseProgram, UseProgram) \
+	X(__glewBindBuffer, BindBuffer) \
+	X(__glewActiveTexture, ActiveTexture) \
+	X(cstglBindTexture, BindTexture) \
+	X(__glewBindFramebuffer, BindFramebuffer) \
+	X(__glewBufferData, BufferData) \
+	X(__glewBufferSubData, BufferSubData) \
+	X(__glewBufferStorage, BufferStorage) \
+	X(cstglTexImage2D, TexImage2D) \
+	X(cstglTexSubImage2D, TexSubImage2D) \
+	X(__glewTexImage3D, TexImage3D) \
+	X(__glewTexSubImage3D, TexSubImage3D) \
+	X(__glewMapBufferRange, MapBufferRange) \
+	X(__glewGenerateMipmap, GenerateMipmap) \
+	X(cstglDrawArrays, DrawArrays) \
+	X(cstglDrawElements, DrawElements) \
+	X(__glewDrawArraysInstanced, DrawArraysInstanced) \
+	X(__glewDrawElementsInstanced, DrawElementsInstanced) \
+	X(__glewMultiDrawArrays, MultiDrawArrays) \
+	X(__glewMultiDrawElementsIndirect, MultiDrawElementsIndirect) \
+	X(__glewUniform1i, Uniform1i) \
+	X(__glewUniform1f, Uniform1f) \
+	X(__glewUniform2i, Uniform2i) \
+	X(__glewUniform2f, Uniform2f) \
+	X(__glewUniformMatrix4fv, UniformMatrix4fv) \
+	X(__glewDeleteBuffers, DeleteBuffers) \
+	X(__glewDeleteVertexArrays, DeleteVertexArrays) \
+	X(__glewDeleteFramebuffers, DeleteFramebuffers) \
+	X(cstglDeleteTextures, DeleteTextures) \
+	X(__glewDeleteProgram, DeleteProgram)
+
+#define GL_TRACE_DECLARE_REAL(pointer, name) static decltype(pointer) real##name = nullptr;
+
+GL_TRACE_ENTRY_POINTS(GL_TRACE_DECLARE_REAL)
+
+
+//
+// Shadow binding state.  UNKNOWN_BINDING marks state that has not been seen since tracing was installed (or was invalidated), so the next bind is never reported as redundant
+//
+
+static const GLuint		UNKNOWN_BINDING = 0xFFFFFFFF;
+
+enum ShadowBufferTarget { SHADOW_ARRAY_BUFFER = 0, SHADOW_ELEMENT_ARRAY_BUFFER, SHADOW_UNIFORM_BUFFER, SHADOW_DRAW_INDIRECT_BUFFER, SHADOW_PIXEL_PACK_BUFFER, SHADOW_PIXEL_UNPACK_BUFFER, SHADOW_TEXTURE_BUFFER, SHADOW_COPY_READ_BUFFER, SHADOW_COPY_WRITE_BUFFER, SHADOW_SHADER_STORAGE_BUFFER, NUM_SHADOW_BUFFER_TARGETS };
+enum ShadowTextureTarget { SHADOW_TEX_1D = 0, SHADOW_TEX_2D, SHADOW_TEX_3D, SHADOW_TEX_2D_ARRAY, SHADOW_TEX_CUBE_MAP, SHADOW_TEX_BUFFER, SHADOW_TEX_RECTANGLE, NUM_SHADOW_TEX_TARGETS };
+
+static GLuint			boundVertexArray;
+static GLuint			boundProgram;
+static GLuint			boundDrawFramebuffer, boundReadFramebuffer;
+static GLuint			boundBuffers[NUM_SHADOW_BUFFER_TARGETS];
+static GLuint			activeUnit;
+static GLuint			boundTextures[GLCallTrace::MAX_TEXTURE_UNITS][NUM_SHADOW_TEX_TARGETS];
+
+
+static void resetShadowState() {
+
+	boundVertexArray = UNKNOWN_BINDING;
+	boundProgram = UNKNOWN_BINDING;
+	boundDrawFramebuffer = boundReadFramebuffer = UNKNOWN_BINDING;
+	activeUnit = UNKNOWN_BINDING;
+
+	for (GLuint i = 0; i < NUM_SHADOW_BUFFER_TARGETS; i++)
+		boundBuffers[i] = UNKNOWN_BINDING;
+
+	for (GLuint unit = 0; unit < GLCallTrace::MAX_TEXTURE_UNITS; unit++) {
+
+		for (GLuint i = 0; i < NUM_SHADOW_TEX_TARGETS; i++)
+			boundTextures[unit][i] = UNKNOWN_BINDING;
+	}
+}
+
+
+// Shadow slot for a buffer target, or nullptr if the target is not tracked
+static GLuint* shadowBuffer(GLenum target) {
+
+	switch (target) {
+
+		case GL_ARRAY_BUFFER: return &boundBuffers[SHADOW_ARRAY_BUFFER];
+		case GL_ELEMENT_ARRAY_BUFFER: return &boundBuffers[SHADOW_ELEMENT_ARRAY_BUFFER];
+		case GL_UNIFORM_BUFFER: return &boundBuffers[SHADOW_UNIFORM_BUFFER];
+		case GL_DRAW_INDIRECT_BUFFER: return &boundBuffers[SHADOW_DRAW_INDIRECT_BUFFER];
+		case GL_PIXEL_PACK_BUFFER: return &boundBuffers[SHADOW_PIXEL_PACK_BUFFER];
+		case GL_PIXEL_UNPACK_BUFFER: return &boundBuffers[SHADOW_PIXEL_UNPACK_BUFFER];
+		case GL_TEXTURE_BUFFER: return &boundBuffers[SHADOW_TEXTURE_BUFFER];
+		case GL_COPY_READ_BUFFER: return &boundBuffers[SHADOW_COPY_READ_BUFFER];
+		case GL_COPY_WRITE_BUFFER: return &boundBuffers[SHADOW_COPY_WRITE_BUFFER];
+		case GL_SHADER_STORAGE_BUFFER: return &boundBuffers[SHADOW_SHADER_STORAGE_BUFFER];
+		default: return nullptr;
+	}
+}
+
+
+// Shadow slot for a texture target on the active unit, or nullptr if the target or unit is not tracked
+static GLuint* shadowTexture(GLenum target) {
+
+	if (activeUnit >= GLCallTrace::MAX_TEXTURE_UNITS)
+		return nullptr;
+
+	switch (target) {
+
+		case GL_TEXTURE_1D: return &boundTextures[activeUnit][SHADOW_TEX_1D];
+		case GL_TEXTURE_2D: return &boundTextures[activeUnit][SHADOW_TEX_2D];
+		case GL_TEXTURE_3D: return &boundTextures[activeUnit][SHADOW_TEX_3D];
+		case GL_TEXTURE_2D_ARRAY: return &boundTextures[activeUnit][SHADOW_TEX_2D_ARRAY];
+		case GL_TEXTURE_CUBE_MAP: return &boundTextures[activeUnit][SHADOW_TEX_CUBE_MAP];
+		case GL_TEXTURE_BUFFER: return &boundTextures[activeUnit][SHADOW_TEX_BUFFER];
+		case GL_TEXTURE_RECTANGLE: return &boundTextures[activeUnit][SHADOW_TEX_RECTANGLE];
+		default: return nullptr;
+	}
+}
+
+
+// Record a bind to a shadow slot.  Return true if the bind changed the binding
+static bool shadowBind(GLuint* slot, GLuint name, GLTraceCall call) {
+
+	if (slot && *slot == name) {
+
+		GLCallTrace::recordRedundant(call);
+		return false;
+	}
+
+	if (slot)
+		*slot = name;
+
+	return true;
+}
+
+
+// Deleted objects may be rebound under the same name, so forget any binding to them
+static void invalidateShadow(GLuint* slots, GLuint count, GLsizei n, const GLuint* names) {
+
+	for (GLsizei i = 0; i < n; i++) {
+
+		for (GLuint j = 0; j < count; j++) {
+
+			if (slots[j] == names[i])
+				slots[j] = UNKNOWN_BINDING;
+		}
+	}
+}
+
+
+// Bytes per pixel of client pixel data
+static GLuint pixelBytes(GLenum format, GLenum type) {
+
+	switch (type) {
+
+		case GL_UNSIGNED_INT_8_8_8_8:
+		case GL_UNSIGNED_INT_8_8_8_8_REV:
+		case GL_UNSIGNED_INT_2_10_10_10_REV:
+		case GL_UNSIGNED_INT_10F_11F_11F_REV:
+		case GL_UNSIGNED_INT_24_8:
+			return 4;
+
+		case GL_UNSIGNED_SHORT_5_6_5:
+		case GL_UNSIGNED_SHORT_4_4_4_4:
+		case GL_UNSIGNED_SHORT_5_5_5_1:
+			return 2;
+	}
+
+	GLuint components;
+
+	switch (format) {
+
+		case GL_RG:
+		case GL_RG_INTEGER:
+			components = 2;
+			break;
+
+		case GL_RGB:
+		case GL_BGR:
+		case GL_RGB_INTEGER:
+			components = 3;
+			break;
+
+		case GL_RGBA:
+		case GL_BGRA:
+		case GL_RGBA_INTEGER:
+			components = 4;
+			break;
+
+		default:
+			components = 1;
+	}
+
+	switch (type) {
+
+		case GL_SHORT:
+		case GL_UNSIGNED_SHORT:
+		case GL_HALF_FLOAT:
+			return components * 2;
+
+		case GL_INT:
+		case GL_UNSIGNED_INT:
+		case GL_FLOAT:
+			return components * 4;
+
+		default:
+			return components;
+	}
+}
+
+
+// Pixel data is uploaded from client memory or from a bound pixel unpack buffer.  A null pointer with no unpack buffer only allocates storage
+static bool isTextureUpload(const void* pixels) {
+
+	return pixels != nullptr || (boundBuffers[SHADOW_PIXEL_UNPACK_BUFFER] != 0 && boundBuffers[SHADOW_PIXEL_UNPACK_BUFFER] != UNKNOWN_BINDING);
+}
+
+
+//
+// Wrappers
+//
+
+static void GLAPIENTRY traceBindVertexArray(GLuint array) {
+
+	GLCallTrace::recordCall(GLTRACE_BIND_VERTEX_ARRAY);
+
+	// The element array buffer binding is vertex array state
+	if (shadowBind(&boundVertexArray, array, GLTRACE_BIND_VERTEX_ARRAY))
+		boundBuffers[SHADOW_ELEMENT_ARRAY_BUFFER] = UNKNOWN_BINDING;
+
+	realBindVertexArray(array);
+}
+
+
+static void GLAPIENTRY traceUseProgram(GLuint program) {
+
+	GLCallTrace::recordCall(GLTRACE_USE_PROGRAM);
+	shadowBind(&boundProgram, program, GLTRACE_USE_PROGRAM);
+
+	realUseProgram(program);
+}
+
+
+static void GLAPIENTRY traceBindBuffer(GLenum target, GLuint buffer) {
+
+	GLCallTrace::recordCall(GLTRACE_BIND_BUFFER);
+	shadowBind(shadowBuffer(target), buffer, GLTRACE_BIND_BUFFER);
+
+	realBindBuffer(target, buffer);
+}
+
+
+static void GLAPIENTRY traceActiveTexture(GLenum texture) {
+
+	GLCallTrace::recordCall(GLTRACE_ACTIVE_TEXTURE);
+
+	GLuint unit = texture - GL_TEXTURE0;
+
+	if (unit < GLCallTrace::MAX_TEXTURE_UNITS)
+		shadowBind(&activeUnit, unit, GLTRACE_ACTIVE_TEXTURE);
+	else
+		activeUnit = UNKNOWN_BINDING;
+
+	realActiveTexture(texture);
+}
+
+
+static void GLAPIENTRY traceBindTexture(GLenum target, GLuint texture) {
+
+	GLCallTrace::recordCall(GLTRACE_BIND_TEXTURE);
+	shadowBind(shadowTexture(target), texture, GLTRACE_BIND_TEXTURE);
+
+	realBindTexture(target, texture);
+}
+
+
+static void GLAPIENTRY traceBindFramebuffer(GLenum target, GLuint framebuffer) {
+
+	GLCallTrace::recordCall(GLTRACE_BIND_FRAMEBUFFER);
+
+	if (target == GL_FRAMEBUFFER) {
+
+		if (boundDrawFramebuffer == framebuffer && boundReadFramebuffer == framebuffer)
+			GLCallTrace::recordRedundant(GLTRACE_BIND_FRAMEBUFFER);
+
+		boundDrawFramebuffer = boundReadFramebuffer = framebuffer;
+	}
+	else if (target == GL_DRAW_FRAMEBUFFER) {
+
+		shadowBind(&boundDrawFramebuffer, framebuffer, GLTRACE_BIND_FRAMEBUFFER);
+	}
+	else if (target == GL_READ_FRAMEBUFFER) {
+
+		shadowBind(&boundReadFramebuffer, framebuffer, GLTRACE_BIND_FRAMEBUFFER);
+	}
+
+	realBindFramebuffer(target, framebuffer);
+}
+
+
+static void GLAPIENTRY traceBufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage) {
+
+	GLCallTrace::recordCall(GLTRACE_BUFFER_DATA);
+
+	if (data)
+		GLCallTrace::recordBufferUpload(size);
+
+	realBufferData(target, size, data, usage);
+}
+
+
+static void GLAPIENTRY traceBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void* data) {
+
+	GLCallTrace::recordCall(GLTRACE_BUFFER_SUB_DATA);
+	GLCallTrace::recordBufferUpload(size);
+
+	realBufferSubData(target, offset, size, data);
+}
+
+
+static void GLAPIENTRY traceBufferStorage(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags) {
+
+	GLCallTrace::recordCall(GLTRACE_BUFFER_STORAGE);
+
+	if (data)
+		GLCallTrace::recordBufferUpload(size);
+
+	realBufferStorage(target, size, data, flags);
+}
+
+
+static void GLAPIENTRY traceTexImage2D(GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const void* pixels) {
+
+	GLCallTrace::recordCall(GLTRACE_TEX_IMAGE_2D);
+
+	if (isTextureUpload(pixels))
+		GLCallTrace::recordTextureUpload(width, height, 1, format, type);
+
+	realTexImage2D(target, level, internalformat, width, height, border, format, type, pixels);
+}
+
+
+static void GLAPIENTRY traceTexSubImage2D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height, GLenum format, GLenum type, const void* pixels) {
+
+	GLCallTrace::recordCall(GLTRACE_TEX_SUB_IMAGE_2D);
+	GLCallTrace::recordTextureUpload(width, height, 1, format, type);
+
+	realTexSubImage2D(target, level, xoffset, yoffset, width, height, format, type, pixels);
+}
+
+
+static void GLAPIENTRY traceTexImage3D(GLenum target, GLint level, GLint internalFormat, GLsizei width, GLsizei height, GLsizei depth, GLint border, GLenum format, GLenum type, const void* pixels) {
+
+	GLCallTrace::recordCall(GLTRACE_TEX_IMAGE_3D);
+
+	if (isTextureUpload(pixels))
+		GLCallTrace::recordTextureUpload(width, height, depth, format, type);
+
+	realTexImage3D(target, level, internalFormat, width, height, depth, border, format, type, pixels);
+}
+
+
+static void GLAPIENTRY traceTexSubImage3D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLint zoffset, GLsizei width, GLsizei height, GLsizei depth, GLenum format, GLenum type, const void* pixels) {
+
+	GLCallTrace::recordCall(GLTRACE_TEX_SUB_IMAGE_3D);
+	GLCallTrace::recordTextureUpload(width, height, depth, format, type);
+
+	realTexSubImage3D(target, level, xoffset, yoffset, zoffset, width, height, depth, format, type, pixels);
+}
+
+
+static void* GLAPIENTRY traceMapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access) {
+
+	GLCallTrace::recordCall(GLTRACE_MAP_BUFFER_RANGE);
+
+	return realMapBufferRange(target, offset, length, access);
+}
+
+
+static void GLAPIENTRY traceGenerateMipmap(GLenum target) {
+
+	GLCallTrace::recordCall(GLTRACE_GENERATE_MIPMAP);
+
+	realGenerateMipmap(target);
+}
+
+
+static void GLAPIENTRY traceDrawArrays(GLenum mode, GLint first, GLsizei count) {
+
+	GLCallTrace::recordCall(GLTRACE_DRAW_ARRAYS);
+
+	realDrawArrays(mode, first, count);
+}
+
+
+static void GLAPIENTRY traceDrawElements(GLenum mode, GLsizei count, GLenum type, const void* indices) {
+
+	GLCallTrace::recordCall(GLTRACE_DRAW_ELEMENTS);
+
+	realDrawElements(mode, count, type, indices);
+}
+
+
+static void GLAPIENTRY traceDrawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei primcount) {
+
+	GLCallTrace::recordCall(GLTRACE_DRAW_ARRAYS_INSTANCED);
+
+	realDrawArraysInstanced(mode, first, count, primcount);
+}
+
+
+static void GLAPIENTRY traceDrawElementsInstanced(GLenum mode, GLsizei count, GLenum type, const void* indices, GLsizei primcount) {
+
+	GLCallTrace::recordCall(GLTRACE_DRAW_ELEMENTS_INSTANCED);
+
+	realDrawElementsInstanced(mode, count, type, indices, primcount);
+}
+
+
+static void GLAPIENTRY traceMultiDrawArrays(GLenum mode, const GLint* first, const GLsizei* count, GLsizei drawcount) {
+
+	GLCallTrace::recordCall(GLTRACE_MULTI_DRAW_ARRAYS);
+
+	realMultiDrawArrays(mode, first, count, drawcount);
+}
+
+
+static void GLAPIENTRY traceMultiDrawElementsIndirect(GLenum mode, GLenum type, const void* indirect, GLsizei primcount, GLsizei stride) {
+
+	GLCallTrace::recordCall(GLTRACE_MULTI_DRAW_ELEMENTS_INDIRECT);
+
+	realMultiDrawElementsIndirect(mode, type, indirect, primcount, stride);
+}
+
+
+static void GLAPIENTRY traceUniform1i(GLint location, GLint v0) {
+
+	GLCallTrace::recordCall(GLTRACE_UNIFORM_1I);
+
+	realUniform1i(location, v0);
+}
+
+
+static void GLAPIENTRY traceUniform1f(GLint location, GLfloat v0) {
+
+	GLCallTrace::recordCall(GLTRACE_UNIFORM_1F);
+
+	realUniform1f(location, v0);
+}
+
+
+static void GLAPIENTRY traceUniform2i(GLint location, GLint v0, GLint v1) {
+
+	GLCallTrace::recordCall(GLTRACE_UNIFORM_2I);
+
+	realUniform2i(location, v0, v1);
+}
+
+
+static void GLAPIENTRY traceUniform2f(GLint location, GLfloat v0, GLfloat v1) {
+
+	GLCallTrace::recordCall(GLTRACE_UNIFORM_2F);
+
+	realUniform2f(location, v0, v1);
+}
+
+
+static void GLAPIENTRY traceUniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value) {
+
+	GLCallTrace::recordCall(GLTRACE_UNIFORM_MATRIX_4FV);
+
+	realUniformMatrix4fv(location, count, transpose, value);
+}
+
+
+static void GLAPIENTRY traceDeleteBuffers(GLsizei n, const GLuint* buffers) {
+
+	GLCallTrace::recordCall(GLTRACE_DELETE_BUFFERS);
+	invalidateShadow(boundBuffers, NUM_SHADOW_BUFFER_TARGETS, n, buffers);
+
+	realDeleteBuffers(n, buffers);
+}
+
+
+static void GLAPIENTRY traceDeleteVertexArrays(GLsizei n, const GLuint* arrays) {
+
+	GLCallTrace::recordCall(GLTRACE_DELETE_VERTEX_ARRAYS);
+	invalidateShadow(&boundVertexArray, 1, n, arrays);
+
+	realDeleteVertexArrays(n, arrays);
+}
+
+
+static void GLAPIENTRY traceDeleteFramebuffers(GLsizei n, const GLuint* framebuffers) {
+
+	GLCallTrace::recordCall(GLTRACE_DELETE_FRAMEBUFFERS);
+	invalidateShadow(&boundDrawFramebuffer, 1, n, framebuffers);
+	invalidateShadow(&boundReadFramebuffer, 1, n, framebuffers);
+
+	realDeleteFramebuffers(n, framebuffers);
+}
+
+
+static void GLAPIENTRY traceDeleteTextures(GLsizei n, const GLuint* textures) {
+
+	GLCallTrace::recordCall(GLTRACE_DELETE_TEXTURES);
+	invalidateShadow(&boundTextures[0][0], GLCallTrace::MAX_TEXTURE_UNITS * NUM_SHADOW_TEX_TARGETS, n, textures);
+
+	realDeleteTextures(n, textures);
+}
+
+
+static void GLAPIENTRY traceDeleteProgram(GLuint program) {
+
+	GLCallTrace::recordCall(GLTRACE_DELETE_PROGRAM);
+	invalidateShadow(&boundProgram, 1, 1, &program);
+
+	realDeleteProgram(program);
+}
+
+
+// Replace an entry point with its wrapper, saving the driver function.  Entry points the driver does not provide are left null
+template <typename T>
+static void hookEntryPoint(T& pointer, T& real, T wrapper) {
+
+	if (pointer && pointer != wrapper) {
+
+		real = pointer;
+		pointer = wrapper;
+	}
+}
+
+
+template <typename T>
+static void unhookEntryPoint(T& pointer, T real, T wrapper) {
+
+	if (pointer == wrapper)
+		pointer = real;
+}
+
+#endif
+
+
+// Write one set of statistics as a JSON object.  Counts are multiplied by scale (for per-frame averages)
+static void writeStatsJSON(ofstream& file, const char* name, const GLCallTrace::FrameStats& stats, double scale) {
+
+	file << "  \"" << name << "\": {" << endl;
+	file << "    \"total_calls\": " << (double)GLCallTrace::totalCalls(stats) * scale << "," << endl;
+	file << "    \"draw_calls\": " << (double)GLCallTrace::drawCalls(stats) * scale << "," << endl;
+	file << "    \"redundant_binds\": " << (double)GLCallTrace::redundantBinds(stats) * scale << "," << endl;
+	file << "    \"buffer_bytes\": " << (double)stats.bufferBytes * scale << "," << endl;
+	file << "    \"texture_bytes\": " << (double)stats.textureBytes * scale << "," << endl;
+	file << "    \"calls\": {";
+
+	bool first = true;
+
+	for (int i = 0; i < NUM_GLTRACE_CALLS; i++) {
+
+		if (stats.calls[i] == 0)
+			continue;
+
+		file << ((first) ? "" : ",") << endl << "      \"" << GLCallTrace::callName((GLTraceCall)i) << "\": { \"calls\": " << (double)stats.calls[i] * scale << ", \"redundant\": " << (double)stats.redundant[i] * scale << " }";
+		first = false;
+	}
+
+	file << endl << "    }" << endl << "  }";
+}
+
+#pragma endregion
+
+
+#pragma region Public API
+
+bool GLCallTrace::install() {
+
+#ifdef CST_GL_TRACE_ENABLED
+
+	if (installed)
+		return true;
+
+	resetShadowState();
+
+#define GL_TRACE_HOOK(pointer, name) hookEntryPoint(pointer, real##name, trace##name);
+
+	GL_TRACE_ENTRY_POINTS(GL_TRACE_HOOK)
+
+#undef GL_TRACE_HOOK
+
+	currentFrame = {};
+	installed = true;
+
+	return true;
+
+#else
+
+	cout << "GL call tracing is compiled out (CST_DISABLE_GL_TRACE)" << endl;
+	return false;
+
+#endif
+}
+
+
+void GLCallTrace::uninstall() {
+
+#ifdef CST_GL_TRACE_ENABLED
+
+	if (!installed)
+		return;
+
+#define GL_TRACE_UNHOOK(pointer, name) unhookEntryPoint(pointer, real##name, trace##name);
+
+	GL_TRACE_ENTRY_POINTS(GL_TRACE_UNHOOK)
+
+#undef GL_TRACE_UNHOOK
+
+	installed = false;
+
+#endif
+}
+
+
+bool GLCallTrace::isInstalled() {
+
+	return installed;
+}
+
+
+void GLCallTrace::endFrame() {
+
+	if (!installed)
+		return;
+
+	lastFrame = currentFrame;
+
+	for (int i = 0; i < NUM_GLTRACE_CALLS; i++) {
+
+		totals.calls[i] += currentFrame.calls[i];
+		totals.redundant[i] += currentFrame.redundant[i];
+	}
+
+	totals.bufferBytes += currentFrame.bufferBytes;
+	totals.textureBytes += currentFrame.textureBytes;
+
+	FrameSummary summary = { frameNumber, totalCalls(currentFrame), drawCalls(currentFrame), redundantBinds(currentFrame), currentFrame.bufferBytes + currentFrame.textureBytes };
+
+	if (history.size() < HISTORY_SIZE)
+		history.push_back(summary);
+	else
+		history[historyNext] = summary;
+
+	historyNext = (historyNext + 1) % HISTORY_SIZE;
+
+	framesTraced++;
+	frameNumber++;
+
+	currentFrame = {};
+}
+
+
+void GLCallTrace::reset() {
+
+	currentFrame = {};
+	lastFrame = {};
+	totals = {};
+	framesTraced = 0;
+
+	history.clear();
+	historyNext = 0;
+}
+
+
+const GLCallTrace::FrameStats& GLCallTrace::getLastFrame() {
+
+	return lastFrame;
+}
+
+
+const GLCallTrace::FrameStats& GLCallTrace::getTotals() {
+
+	return totals;
+}
+
+
+unsigned long long GLCallTrace::getFramesTraced() {
+
+	return framesTraced;
+}
+
+
+unsigned long long GLCallTrace::totalCalls(const FrameStats& stats) {
+
+	unsigned long long count = 0;
+
+	for (int i = 0; i < NUM_GLTRACE_CALLS; i++)
+		count += stats.calls[i];
+
+	return count;
+}
+
+
+unsigned long long GLCallTrace::drawCalls(const FrameStats& stats) {
+
+	unsigned long long count = 0;
+
+	for (int i = GLTRACE_DRAW_ARRAYS; i <= GLTRACE_MULTI_DRAW_ELEMENTS_INDIRECT; i++)
+		count += stats.calls[i];
+
+	return count;
+}
+
+
+unsigned long long GLCallTrace::redundantBinds(const FrameStats& stats) {
+
+	unsigned long long count = 0;
+
+	for (int i = 0; i < NUM_GLTRACE_CALLS; i++)
+		count += stats.redundant[i];
+
+	return count;
+}
+
+
+const char* GLCallTrace::callName(GLTraceCall call) {
+
+	static const char* names[NUM_GLTRACE_CALLS] = {
+		"glBindVertexArray",
+		"glUseProgram",
+		"glBindBuffer",
+		"glActiveTexture",
+		"glBindTexture",
+		"glBindFramebuffer",
+		"glBufferData",
+		"glBufferSubData",
+		"glBufferStorage",
+		"glTexImage2D",
+		"glTexSubImage2D",
+		"glTexImage3D",
+		"glTexSubImage3D",
+		"glMapBufferRange",
+		"glGenerateMipmap",
+		"glDrawArrays",
+		"glDrawElements",
+		"glDrawArraysInstanced",
+		"glDrawElementsInstanced",
+		"glMultiDrawArrays",
+		"glMultiDrawElementsIndirect",
+		"glUniform1i",
+		"glUniform1f",
+		"glUniform2i",
+		"glUniform2f",
+		"glUniformMatrix4fv",
+		"glDeleteBuffers",
+		"glDeleteVertexArrays",
+		"glDeleteFramebuffers",
+		"glDeleteTextures",
+		"glDeleteProgram" };
+
+	return (call < NUM_GLTRACE_CALLS) ? names[call] : "unknown";
+}
+
+
+bool GLCallTrace::writeJSON(const string& filename) {
+
+	ofstream file(filename);
+
+	if (!file.is_open()) {
+
+		cout << "Cannot write GL call trace to " << filename << endl;
+		return false;
+	}
+
+	file << fixed << setprecision(2);
+	file << "{" << endl;
+	file << "  \"frames_traced\": " << framesTraced << "," << endl;
+
+	writeStatsJSON(file, "last_frame", lastFrame, 1.0);
+	file << "," << endl;
+
+	writeStatsJSON(file, "per_frame_average", totals, (framesTraced > 0) ? 1.0 / (double)framesTraced : 0.0);
+	file << "," << endl;
+
+	writeStatsJSON(file, "totals", totals, 1.0);
+	file << "," << endl;
+
+	// History in frame order
+	file << "  \"history\": [";
+
+	size_t first = (history.size() < HISTORY_SIZE) ? 0 : historyNext;
+
+	for (size_t i = 0; i < history.size(); i++) {
+
+		const FrameSummary& summary = history[(first + i) % history.size()];
+
+		file << ((i > 0) ? "," : "") << endl << "    { \"frame\": " << summary.frame << ", \"calls\": " << summary.calls << ", \"draws\": " << summary.draws << ", \"redundant_binds\": " << summary.redundant << ", \"bytes\": " << summary.bytes << " }";
+	}
+
+	file << endl << "  ]" << endl << "}" << endl;
+
+	cout << "GL call trace of " << framesTraced << " frames written to " << filename << endl;
+
+	return true;
+}
+
+
+void GLCallTrace::recordCall(GLTraceCall call) {
+
+	currentFrame.calls[call]++;
+}
+
+
+void GLCallTrace::recordRedundant(GLTraceCall call) {
+
+	currentFrame.redundant[call]++;
+}
+
+
+void GLCallTrace::recordBufferUpload(GLsizeiptr bytes) {
+
+	currentFrame.bufferBytes += (unsigned long long)bytes;
+}
+
+
+void GLCallTrace::recordTextureUpload(GLsizei width, GLsizei height, GLsizei depth, GLenum format, GLenum type) {
+
+#ifdef CST_GL_TRACE_ENABLED
+	currentFrame.textureBytes += (unsigned long long)width * (unsigned long long)height * (unsigned long long)depth * pixelBytes(format, type);
+#endif
+}
+
+#pragma endregion
@@ -0,0 +1,156 @@
+#pragma once
+
+#include "core.h"
+
+// GL call tracing.  When installed, the GLEW function pointers of the traced entry points are replaced with wrappers that count calls per entry point per frame, detect redundant binds (binding the object that is already bound) against a shadow copy of the binding state and total the bytes uploaded to buffers and textures, then call the driver.  When not installed the original pointers are restored so tracing costs nothing.  GL 1.1 entry points (glBindTexture, glTexImage2D, glDrawArrays etc.) are exported directly by the GL library rather than loaded by GLEW, so they are routed through equivalent pointers declared below.  Only the context current when install is called should be traced.  Defining CST_DISABLE_GL_TRACE compiles the routing out and install always fails
+
+#ifndef CST_DISABLE_GL_TRACE
+#define CST_GL_TRACE_ENABLED
+#endif
+
+
+enum GLTraceCall {
+
+	// Binds (checked for redundancy)
+	GLTRACE_BIND_VERTEX_ARRAY = 0,
+	GLTRACE_USE_PROGRAM,
+	GLTRACE_BIND_BUFFER,
+	GLTRACE_ACTIVE_TEXTURE,
+	GLTRACE_BIND_TEXTURE,
+	GLTRACE_BIND_FRAMEBUFFER,
+
+	// Uploads
+	GLTRACE_BUFFER_DATA,
+	GLTRACE_BUFFER_SUB_DATA,
+	GLTRACE_BUFFER_STORAGE,
+	GLTRACE_TEX_IMAGE_2D,
+	GLTRACE_TEX_SUB_IMAGE_2D,
+	GLTRACE_TEX_IMAGE_3D,
+	GLTRACE_TEX_SUB_IMAGE_3D,
+	GLTRACE_MAP_BUFFER_RANGE,
+	GLTRACE_GENERATE_MIPMAP,
+
+	// Draws
+	GLTRACE_DRAW_ARRAYS,
+	GLTRACE_DRAW_ELEMENTS,
+	GLTRACE_DRAW_ARRAYS_INSTANCED,
+	GLTRACE_DRAW_ELEMENTS_INSTANCED,
+	GLTRACE_MULTI_DRAW_ARRAYS,
+	GLTRACE_MULTI_DRAW_ELEMENTS_INDIRECT,
+
+	// Uniforms
+	GLTRACE_UNIFORM_1I,
+	GLTRACE_UNIFORM_1F,
+	GLTRACE_UNIFORM_2I,
+	GLTRACE_UNIFORM_2F,
+	GLTRACE_UNIFORM_MATRIX_4FV,
+
+	// Deletes (invalidate the shadow binding state)
+	GLTRACE_DELETE_BUFFERS,
+	GLTRACE_DELETE_VERTEX_ARRAYS,
+	GLTRACE_DELETE_FRAMEBUFFERS,
+	GLTRACE_DELETE_TEXTURES,
+	GLTRACE_DELETE_PROGRAM,
+
+	NUM_GLTRACE_CALLS
+};
+
+
+class GLCallTrace {
+
+public:
+
+	static const GLuint		HISTORY_SIZE = 240; // frames kept for the per-frame series in the dump
+	static const GLuint		MAX_TEXTURE_UNITS = 32; // units tracked for redundant texture binds
+
+	// Counts for one frame, or totals over all traced frames
+	struct FrameStats {
+
+		unsigned long long	calls[NUM_GLTRACE_CALLS];
+		unsigned long long	redundant[NUM_GLTRACE_CALLS]; // binds that did not change the binding
+		unsigned long long	bufferBytes; // bytes uploaded by glBufferData, glBufferSubData and glBufferStorage
+		unsigned long long	textureBytes; // bytes uploaded by glTex(Sub)Image2D / 3D
+	};
+
+private:
+
+	// Summary of one frame for the history
+	struct FrameSummary {
+
+		unsigned long long	frame;
+		unsigned long long	calls, draws, redundant, bytes;
+	};
+
+	static bool							installed;
+
+	static FrameStats					currentFrame;
+	static FrameStats					lastFrame;
+	static FrameStats					totals;
+	static unsigned long long			framesTraced;
+	static unsigned long long			frameNumber;
+
+	static std::vector<FrameSummary>	history;
+	static GLuint						historyNext;
+
+public:
+
+	// Hook the traced entry points.  Return false if tracing is compiled out
+	static bool install();
+	static void uninstall();
+	static bool isInstalled();
+
+	// Close the current frame.  Calls made since the previous endFrame are reported as one frame
+	static void endFrame();
+
+	// Discard all statistics (tracing stays installed)
+	static void reset();
+
+	static const FrameStats& getLastFrame();
+	static const FrameStats& getTotals();
+	static unsigned long long getFramesTraced();
+
+	// Sums over the entry points of a frame
+	static unsigned long long totalCalls(const FrameStats& stats);
+	static unsigned long long drawCalls(const FrameStats& stats);
+	static unsigned long long redundantBinds(const FrameStats& stats);
+
+	static const char* callName(GLTraceCall call);
+
+	// Write the last frame, per-frame averages, totals and the recent per-frame history as JSON.  Return false if the file cannot be written
+	static bool writeJSON(const std::string& filename);
+
+	// Record a call (used by the wrappers)
+	static void recordCall(GLTraceCall call);
+	static void recordRedundant(GLTraceCall call);
+	static void recordBufferUpload(GLsizeiptr bytes);
+	static void recordTextureUpload(GLsizei width, GLsizei height, GLsizei depth, GLenum format, GLenum type);
+};
+
+
+#ifdef CST_GL_TRACE_ENABLED
+
+// Hookable pointers for the GL 1.1 entry points that are traced.  These start out pointing at the GL library's functions
+typedef void (GLAPIENTRY * PFNCSTGLBINDTEXTUREPROC) (GLenum target, GLuint texture);
+typedef void (GLAPIENTRY * PFNCSTGLTEXIMAGE2DPROC) (GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const void* pixels);
+typedef void (GLAPIENTRY * PFNCSTGLTEXSUBIMAGE2DPROC) (GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height, GLenum format, GLenum type, const void* pixels);
+typedef void (GLAPIENTRY * PFNCSTGLDRAWARRAYSPROC) (GLenum mode, GLint first, GLsizei count);
+typedef void (GLAPIENTRY * PFNCSTGLDRAWELEMENTSPROC) (GLenum mode, GLsizei count, GLenum type, const void* indices);
+typedef void (GLAPIENTRY * PFNCSTGLDELETETEXTURESPROC) (GLsizei n, const GLuint* textures);
+
+extern PFNCSTGLBINDTEXTUREPROC		cstglBindTexture;
+extern PFNCSTGLTEXIMAGE2DPROC		cstglTexImage2D;
+extern PFNCSTGLTEXSUBIMAGE2DPROC	cstglTexSubImage2D;
+extern PFNCSTGLDRAWARRAYSPROC		cstglDrawArrays;
+extern PFNCSTGLDRAWELEMENTSPROC		cstglDrawElements;
+extern PFNCSTGLDELETETEXTURESPROC	cstglDeleteTextures;
+
+#ifndef CST_GL_TRACE_IMPLEMENTATION
+#define glBindTexture		cstglBindTexture
+#define glTexImage2D		cstglTexImage2D
+#define glTexSubImage2D		cstglTexSubImage2D
+#define glDrawArrays		cstglDrawArrays
+#define glDrawElements		cstglDrawElements
+#define glDeleteTextures	cstglDeleteTextures
+#endif
+
+#endif
@@ -0,0 +1,316 @@
+
+#include "GLDebugOutput.h"
+#include <chrono>
+
+
+using namespace std;
+
+
+mutex GLDebugOutput::recordMutex;
+map<string, GLDebugOutput::MessageRecord> GLDebugOutput::records;
+vector<string> GLDebugOutput::recordOrder;
+
+atomic<unsigned long long> GLDebugOutput::frameNumber(0);
+thread_local const char* GLDebugOutput::currentContext = nullptr;
+
+bool GLDebugOutput::installed = false;
+double GLDebugOutput::printWindowStart = 0.0;
+GLuint GLDebugOutput::printsInWindow = 0;
+unsigned long long GLDebugOutput::printsSuppressed = 0;
+
+
+#pragma region Private API
+
+static const char* sourceName(GLenum source) {
+
+	switch (source) {
+
+		case GL_DEBUG_SOURCE_API: return "API";
+		case GL_DEBUG_SOURCE_WINDOW_SYSTEM: return "Window system";
+		case GL_DEBUG_SOURCE_SHADER_COMPILER: return "Shader compiler";
+		case GL_DEBUG_SOURCE_THIRD_PARTY: return "Third party";
+		case GL_DEBUG_SOURCE_APPLICATION: return "Application";
+		default: return "Other";
+	}
+}
+
+
+static const char* typeName(GLenum type) {
+
+	switch (type) {
+
+		case GL_DEBUG_TYPE_ERROR: return "Error";
+		case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR: return "Deprecated behaviour";
+		case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR: return "Undefined behaviour";
+		case GL_DEBUG_TYPE_PORTABILITY: return "Portability";
+		case GL_DEBUG_TYPE_PERFORMANCE: return "Performance";
+		case GL_DEBUG_TYPE_MARKER: return "Marker";
+		default: return "Other";
+	}
+}
+
+
+static const char* severityName(GLenum severity) {
+
+	switch (severity) {
+
+		case GL_DEBUG_SEVERITY_HIGH: return "high";
+		case GL_DEBUG_SEVERITY_MEDIUM: return "medium";
+		case GL_DEBUG_SEVERITY_LOW: return "low";
+		default: return "notification";
+	}
+}
+
+
+// Case insensitive substring test
+static bool containsText(const string& text, const char* pattern) {
+
+	string lowerText = text;
+
+	transform(lowerText.begin(), lowerText.end(), lowerText.begin(), [](unsigned char c) { return (char)tolower(c); });
+
+	return lowerText.find(pattern) != string::npos;
+}
+
+
+void GLAPIENTRY GLDebugOutput::callback(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* message, const void* /*userParam*/) {
+
+	recordMessage(source, type, id, severity, (length >= 0) ? string(message, (size_t)length) : string(message));
+}
+
+#pragma endregion
+
+
+#pragma region Public API
+
+bool GLDebugOutput::install() {
+
+	if (GLEW_VERSION_4_3 || GLEW_KHR_debug) {
+
+		glDebugMessageCallback(callback, nullptr);
+	}
+	else if (GLEW_ARB_debug_output) {
+
+		glDebugMessageCallbackARB(callback, nullptr);
+	}
+	else {
+
+		cout << "GL debug output not supported - driver messages will not be reported" << endl;
+		return false;
+	}
+
+	// Synchronous delivery means the callback runs on the thread (and within the call) that raised the message, so it can be tagged with the active GLCallContext
+	glEnable(GL_DEBUG_OUTPUT);
+	glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+
+	// Receive everything - notifications are aggregated but not printed
+	glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DONT_CARE, 0, nullptr, GL_TRUE);
+
+	installed = true;
+
+	return true;
+}
+
+
+bool GLDebugOutput::isInstalled() {
+
+	return installed;
+}
+
+
+void GLDebugOutput::setFrameNumber(unsigned long long frame) {
+
+	frameNumber = frame;
+}
+
+
+void GLDebugOutput::recordMessage(GLenum source, GLenum type, GLuint id, GLenum severity, const string& text) {
+
+	unsigned long long frame = frameNumber;
+	string context = (currentContext) ? currentContext : "(no context)";
+
+	lock_guard<mutex> lock(recordMutex);
+
+	string key = to_string(source) + ":" + to_string(type) + ":" + to_string(id) + ":" + text;
+	auto it = records.find(key);
+
+	if (it == records.end()) {
+
+		MessageRecord record;
+
+		record.source = source;
+		record.type = type;
+		record.severity = severity;
+		record.id = id;
+		record.text = text;
+		record.category = (type == GL_DEBUG_TYPE_PERFORMANCE) ? classifyPerformanceMessage(text) : GL_PERF_OTHER;
+		record.count = 0;
+		record.firstFrame = frame;
+
+		it = records.insert(make_pair(key, record)).first;
+		recordOrder.push_back(key);
+	}
+
+	MessageRecord& record = it->second;
+
+	record.count++;
+	record.lastFrame = frame;
+
+	if (record.contexts.size() < MAX_CONTEXTS_PER_MESSAGE && find(record.contexts.begin(), record.contexts.end(), context) == record.contexts.end())
+		record.contexts.push_back(context);
+
+	// Print the first few occurrences of each message, subject to the overall rate limit.  Notifications are only counted
+	if (severity == GL_DEBUG_SEVERITY_NOTIFICATION || record.count > MAX_PRINTS_PER_MESSAGE)
+		return;
+
+	double now = chrono::duration<double>(chrono::steady_clock::now().time_since_epoch()).count();
+
+	if (now - printWindowStart >= 1.0) {
+
+		if (printsSuppressed > 0)
+			cout << "GL debug: " << printsSuppressed << " messages suppressed by rate limit" << endl;
+
+		printWindowStart = now;
+		printsInWindow = 0;
+		printsSuppressed = 0;
+	}
+
+	if (printsInWindow >= MAX_PRINTS_PER_SECOND) {
+
+		printsSuppressed++;
+		return;
+	}
+
+	printsInWindow++;
+
+	cout << "GL debug [" << typeName(type) << ", " << severityName(severity) << ", " << sourceName(source) << " " << id << "] frame " << frame << ", " << context;
+
+	if (type == GL_DEBUG_TYPE_PERFORMANCE)
+		cout << " (" << categoryName(record.category) << ")";
+
+	cout << ": " << text << endl;
+
+	if (record.count == MAX_PRINTS_PER_MESSAGE)
+		cout << "GL debug: further occurrences of this message will be counted but not printed" << endl;
+}
+
+
+GLPerformanceCategory GLDebugOutput::classifyPerformanceMessage(const string& text) {
+
+	if (containsText(text, "recompil"))
+		return GL_PERF_SHADER_RECOMPILE;
+
+	if (containsText(text, "conversion") || containsText(text, "convert") || containsText(text, "swizzl"))
+		return GL_PERF_FORMAT_CONVERSION;
+
+	if (containsText(text, "stall") || containsText(text, "synchroniz") || containsText(text, "wait") || containsText(text, "flush"))
+		return GL_PERF_PIPELINE_STALL;
+
+	if (containsText(text, "video memory") || containsText(text, "system memory") || containsText(text, "host memory") || (containsText(text, "buffer object") && containsText(text, "moved")))
+		return GL_PERF_BUFFER_PLACEMENT;
+
+	if (containsText(text, "software") || containsText(text, "fallback") || containsText(text, "emulat"))
+		return GL_PERF_SOFTWARE_FALLBACK;
+
+	return GL_PERF_OTHER;
+}
+
+
+const char* GLDebugOutput::categoryName(GLPerformanceCategory category) {
+
+	static const char* names[NUM_GL_PERF_CATEGORIES] = {
+		"format conversion",
+		"shader recompile",
+		"pipeline stall",
+		"buffer placement",
+		"software fallback",
+		"other" };
+
+	return (category < NUM_GL_PERF_CATEGORIES) ? names[category] : "other";
+}
+
+
+unsigned long long GLDebugOutput::getPerformanceMessageCount() {
+
+	lock_guard<mutex> lock(recordMutex);
+
+	unsigned long long count = 0;
+
+	for (auto& entry : records) {
+
+		if (entry.second.type == GL_DEBUG_TYPE_PERFORMANCE)
+			count += entry.second.count;
+	}
+
+	return count;
+}
+
+
+void GLDebugOutput::reportSummary(ostream& out) {
+
+	lock_guard<mutex> lock(recordMutex);
+
+	out << endl << "GL debug output summary: " << records.size() << " distinct messages" << endl;
+
+	auto reportRecord = [&out](const MessageRecord& record) {
+
+		out << "    " << record.count << "x frames " << record.firstFrame << " - " << record.lastFrame << " [" << typeName(record.type) << ", " << severityName(record.severity) << "] in ";
+
+		for (size_t i = 0; i < record.contexts.size(); i++)
+			out << ((i > 0) ? ", " : "") << record.contexts[i];
+
+		out << ": " << record.text << endl;
+	};
+
+	// Slow paths grouped by category
+	for (int category = 0; category < NUM_GL_PERF_CATEGORIES; category++) {
+
+		unsigned long long total = 0;
+		size_t distinct = 0;
+
+		for (auto& key : recordOrder) {
+
+			const MessageRecord& record = records[key];
+
+			if (record.type == GL_DEBUG_TYPE_PERFORMANCE && record.category == category) {
+
+				total += record.count;
+				distinct++;
+			}
+		}
+
+		if (distinct == 0)
+			continue;
+
+		out << "  Slow path - " << categoryName((GLPerformanceCategory)category) << ": " << total << " occurrences of " << distinct << " messages" << endl;
+
+		for (auto& key : recordOrder) {
+
+			const MessageRecord& record = records[key];
+
+			if (record.type == GL_DEBUG_TYPE_PERFORMANCE && record.category == category)
+				reportRecord(record);
+		}
+	}
+
+	// Everything else in order of first occurrence
+	bool first = true;
+
+	for (auto& key : recordOrder) {
+
+		const MessageRecord& record = records[key];
+
+		if (record.type == GL_DEBUG_TYPE_PERFORMANCE)
+			continue;
+
+		if (first) {
+
+			out << "  Other messages:" << endl;
+			first = false;
+		}
+
+		reportRecord(record);
+	}
+}
+
+#pragma endregion
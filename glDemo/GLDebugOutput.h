@@ -0,0 +1,102 @@
+#pragma once
+
+#include "core.h"
+#include <atomic>
+#include <map>
+#include <mutex>
+
+// Aggregate GL debug output (KHR_debug / GL 4.3, or ARB_debug_output).  Messages are delivered synchronously so each can be tagged with the frame being rendered and the GL call context active on the calling thread (see GLCallContext).  Identical messages are counted rather than repeated - each distinct message is printed for its first MAX_PRINTS_PER_MESSAGE occurrences and at most MAX_PRINTS_PER_SECOND messages are printed in total.  GL_DEBUG_TYPE_PERFORMANCE messages are classified by the slow path they describe (format conversions, shader recompiles, stalls etc.) and reportSummary lists every slow path hit during the session
+
+enum GLPerformanceCategory {
+
+	GL_PERF_FORMAT_CONVERSION = 0,
+	GL_PERF_SHADER_RECOMPILE,
+	GL_PERF_PIPELINE_STALL,
+	GL_PERF_BUFFER_PLACEMENT,
+	GL_PERF_SOFTWARE_FALLBACK,
+	GL_PERF_OTHER,
+
+	NUM_GL_PERF_CATEGORIES
+};
+
+
+class GLDebugOutput {
+
+public:
+
+	static const GLuint		MAX_PRINTS_PER_MESSAGE = 3;
+	static const GLuint		MAX_PRINTS_PER_SECOND = 20;
+	static const GLuint		MAX_CONTEXTS_PER_MESSAGE = 8;
+
+private:
+
+	// All occurrences of one distinct message (source, type, id and text)
+	struct MessageRecord {
+
+		GLenum					source, type, severity;
+		GLuint					id;
+		std::string				text;
+		GLPerformanceCategory	category; // performance messages only
+		unsigned long long		count;
+		unsigned long long		firstFrame, lastFrame;
+		std::vector<std::string>	contexts; // distinct GL call contexts that triggered the message
+	};
+
+	static std::mutex							recordMutex;
+	static std::map<std::string, MessageRecord>	records;
+	static std::vector<std::string>				recordOrder; // keys in order of first occurrence
+
+	static std::atomic<unsigned long long>		frameNumber;
+	static thread_local const char*				currentContext;
+
+	static bool									installed;
+	static double								printWindowStart; // seconds
+	static GLuint								printsInWindow;
+	static unsigned long long					printsSuppressed;
+
+	static void GLAPIENTRY callback(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* message, const void* userParam);
+
+	friend class GLCallContext;
+
+public:
+
+	// Register the debug callback with the current context.  Return false if debug output is not supported
+	static bool install();
+	static bool isInstalled();
+
+	// Frame number used to tag subsequent messages
+	static void setFrameNumber(unsigned long long frame);
+
+	// Record a message as if delivered by the driver (used by the callback)
+	static void recordMessage(GLenum source, GLenum type, GLuint id, GLenum severity, const std::string& text);
+
+	// Classify the slow path described by a performance message
+	static GLPerformanceCategory classifyPerformanceMessage(const std::string& text);
+	static const char* categoryName(GLPerformanceCategory category);
+
+	// Number of performance messages received (all occurrences)
+	static unsigned long long getPerformanceMessageCount();
+
+	// Write a summary of every distinct message received, with performance messages grouped by category
+	static void reportSummary(std::ostream& out);
+};
+
+
+// Tag GL debug messages raised on this thread while the object is in scope with context (for example the function making the GL calls).  context must have static storage duration.  Contexts nest - the innermost is used
+class GLCallContext {
+
+	const char*		previous;
+
+public:
+
+	GLCallContext(const char* context) {
+
+		previous = GLDebugOutput::currentContext;
+		GLDebugOutput::currentContext = context;
+	}
+
+	~GLCallContext() {
+
+		GLDebugOutput::currentContext = previous;
+	}
+};
@@ -0,0 +1,317 @@
+
+#include "GPUProfiler.h"
+#include "FlythroughBenchmark.h"
+#include <fstream>
+
+
+using namespace std;
+
+
+// Definition for the push_back in beginScope, which takes the constant by reference
+const GLuint GPUProfiler::NO_SCOPE;
+
+
+#pragma region Private API
+
+void GPUProfiler::collectFrame(GLuint frame) {
+
+	FrameRecord& record = frames[frame];
+
+	for (GLuint i = 0; i < (GLuint)record.scopes.size(); i++) {
+
+		GLuint64 startTime = 0, endTime = 0;
+
+		glGetQueryObjectui64v(queries[frame][i * 2], GL_QUERY_RESULT, &startTime);
+		glGetQueryObjectui64v(queries[frame][i * 2 + 1], GL_QUERY_RESULT, &endTime);
+
+		addSample(record.tag, record.scopes[i].name, record.scopes[i].depth, (float)((double)(endTime - startTime) * 1.0e-6));
+	}
+
+	record.pending = false;
+	framesProfiled++;
+}
+
+
+void GPUProfiler::addSample(const string& tag, const char* name, GLuint depth, float milliseconds) {
+
+	string key = tag + '\n' + name;
+	auto it = seriesIndex.find(key);
+
+	if (it == seriesIndex.end()) {
+
+		Series newSeries;
+
+		newSeries.tag = tag;
+		newSeries.name = name;
+		newSeries.depth = depth;
+		newSeries.next = 0;
+		newSeries.totalSamples = 0;
+		newSeries.samples.reserve(WINDOW_SIZE);
+
+		it = seriesIndex.insert(make_pair(key, series.size())).first;
+		series.push_back(newSeries);
+	}
+
+	Series& s = series[it->second];
+
+	if (s.samples.size() < WINDOW_SIZE)
+		s.samples.push_back(milliseconds);
+	else
+		s.samples[s.next] = milliseconds;
+
+	s.next = (s.next + 1) % WINDOW_SIZE;
+	s.totalSamples++;
+}
+
+
+GPUProfiler::ScopeStats GPUProfiler::calculateStats(const Series& s) const {
+
+	ScopeStats stats;
+
+	stats.tag = s.tag;
+	stats.name = s.name;
+	stats.depth = s.depth;
+	stats.samples = (GLuint)s.samples.size();
+	stats.totalSamples = s.totalSamples;
+	stats.average = stats.p50 = stats.p95 = stats.p99 = stats.minimum = stats.maximum = 0.0;
+
+	if (s.samples.empty())
+		return stats;
+
+	// Same order statistics as the benchmarks report
+	FrameTimeStats sampleStats = calculateFrameTimeStats(s.samples);
+
+	stats.average = sampleStats.mean;
+	stats.p50 = sampleStats.median;
+	stats.p95 = sampleStats.p95;
+	stats.p99 = sampleStats.p99;
+	stats.minimum = sampleStats.minimum;
+	stats.maximum = sampleStats.maximum;
+
+	return stats;
+}
+
+#pragma endregion
+
+
+#pragma region Public API
+
+GPUProfiler::GPUProfiler() {
+
+	for (GLuint i = 0; i < NUM_FRAMES; i++) {
+
+		glGenQueries(MAX_SCOPES * 2, queries[i]);
+		frames[i].pending = false;
+		frames[i].lastQuery = 0;
+	}
+
+	currentFrame = 0;
+	frameActive = false;
+
+	framesProfiled = 0;
+	framesSkipped = 0;
+}
+
+
+GPUProfiler::~GPUProfiler() {
+
+	for (GLuint i = 0; i < NUM_FRAMES; i++)
+		glDeleteQueries(MAX_SCOPES * 2, queries[i]);
+}
+
+
+void GPUProfiler::setTag(const string& tag) {
+
+	currentTag = tag;
+}
+
+
+void GPUProfiler::beginFrame() {
+
+	FrameRecord& record = frames[currentFrame];
+
+	// Collect the results of the frame that last used this set of queries.  The GPU completes queries in order so the frame is complete if the last query written is (not the end of the last scope opened, which an enclosing scope outlives)
+	if (record.pending) {
+
+		GLint available = 0;
+
+		glGetQueryObjectiv(queries[currentFrame][record.lastQuery], GL_QUERY_RESULT_AVAILABLE, &available);
+
+		if (!available) {
+
+			framesSkipped++;
+			frameActive = false;
+			return;
+		}
+
+		collectFrame(currentFrame);
+	}
+
+	record.tag = currentTag;
+	record.scopes.clear();
+	record.lastQuery = 0;
+
+	openScopes.clear();
+	frameActive = true;
+}
+
+
+void GPUProfiler::endFrame() {
+
+	// Close any scopes left open
+	while (!openScopes.empty())
+		endScope();
+
+	if (!frameActive)
+		return;
+
+	frames[currentFrame].pending = !frames[currentFrame].scopes.empty();
+
+	currentFrame = (currentFrame + 1) % NUM_FRAMES;
+	frameActive = false;
+}
+
+
+void GPUProfiler::beginScope(const char* name) {
+
+	FrameRecord& record = frames[currentFrame];
+
+	if (!frameActive || record.scopes.size() >= MAX_SCOPES) {
+
+		openScopes.push_back(NO_SCOPE);
+		return;
+	}
+
+	GLuint index = (GLuint)record.scopes.size();
+
+	record.scopes.push_back({ name, (GLuint)openScopes.size() });
+	openScopes.push_back(index);
+
+	glQueryCounter(queries[currentFrame][index * 2], GL_TIMESTAMP);
+}
+
+
+void GPUProfiler::endScope() {
+
+	if (openScopes.empty())
+		return;
+
+	GLuint index = openScopes.back();
+
+	openScopes.pop_back();
+
+	if (frameActive && index != NO_SCOPE) {
+
+		glQueryCounter(queries[currentFrame][index * 2 + 1], GL_TIMESTAMP);
+		frames[currentFrame].lastQuery = index * 2 + 1;
+	}
+}
+
+
+vector<GPUProfiler::ScopeStats> GPUProfiler::getStats(const string& tag) const {
+
+	vector<ScopeStats> result;
+
+	for (const Series& s : series) {
+
+		if (s.tag == tag)
+			result.push_back(calculateStats(s));
+	}
+
+	return result;
+}
+
+
+bool GPUProfiler::getStats(const string& tag, const string& name, ScopeStats& stats) const {
+
+	auto it = seriesIndex.find(tag + '\n' + name);
+
+	if (it == seriesIndex.end())
+		return false;
+
+	stats = calculateStats(series[it->second]);
+
+	return true;
+}
+
+
+vector<string> GPUProfiler::getTags() const {
+
+	vector<string> tags;
+
+	for (const Series& s : series) {
+
+		if (find(tags.begin(), tags.end(), s.tag) == tags.end())
+			tags.push_back(s.tag);
+	}
+
+	return tags;
+}
+
+
+bool GPUProfiler::exportCSV(const string& filename) const {
+
+	ofstream file(filename);
+
+	if (!file.is_open()) {
+
+		cout << "Cannot write GPU profile to " << filename << endl;
+		return false;
+	}
+
+	file << "tag,scope,depth,window_samples,total_samples,average_ms,p50_ms,p95_ms,p99_ms,min_ms,max_ms" << endl;
+
+	for (const Series& s : series) {
+
+		ScopeStats stats = calculateStats(s);
+
+		file << "\"" << stats.tag << "\",\"" << stats.name << "\"," << stats.depth << "," << stats.samples << "," << stats.totalSamples << ","
+			<< stats.average << "," << stats.p50 << "," << stats.p95 << "," << stats.p99 << "," << stats.minimum << "," << stats.maximum << endl;
+	}
+
+	return true;
+}
+
+
+void GPUProfiler::reset() {
+
+	series.clear();
+	seriesIndex.clear();
+
+	framesProfiled = 0;
+	framesSkipped = 0;
+}
+
+
+unsigned long long GPUProfiler::getFramesProfiled() const {
+
+	return framesProfiled;
+}
+
+
+unsigned long long GPUProfiler::getFramesSkipped() const {
+
+	return framesSkipped;
+}
+
+#pragma endregion
+
+
+#pragma region GPUProfileScope
+
+GPUProfileScope::GPUProfileScope(GPUProfiler* profiler, const char* name) {
+
+	this->profiler = profiler;
+
+	if (profiler)
+		profiler->beginScope(name);
+}
+
+
+GPUProfileScope::~GPUProfileScope() {
+
+	if (profiler)
+		profiler->endScope();
+}
+
+#pragma endregion
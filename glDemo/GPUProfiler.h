@@ -0,0 +1,124 @@
+#pragma once
+
+#include "core.h"
+#include <map>
+
+// GPU profiler built on GL_TIMESTAMP queries.  Named scopes (which may be nested) are timed by writing a timestamp at the start and end of each scope.  Queries for NUM_FRAMES frames are kept in flight and a frame's results are only read once its last query is available, so profiling never stalls the pipeline - if the GPU falls further behind the frame is not profiled.  Each frame is recorded under a tag (for example the scene and filtering mode) and the last WINDOW_SIZE samples of each scope are kept per tag so the cost of different modes can be compared.  Statistics are reported as rolling averages and percentiles and can be exported to CSV
+
+class GPUProfiler {
+
+public:
+
+	static const GLuint		NUM_FRAMES = 4; // frames of queries in flight
+	static const GLuint		MAX_SCOPES = 64; // scopes recorded per frame
+	static const GLuint		WINDOW_SIZE = 240; // samples kept per scope for rolling statistics
+
+	// Statistics for one scope under one tag (times in milliseconds)
+	struct ScopeStats {
+
+		std::string			tag;
+		std::string			name;
+		GLuint				depth; // nesting depth - 0 for top level scopes
+		GLuint				samples; // samples in the rolling window
+		unsigned long long	totalSamples;
+		double				average, p50, p95, p99, minimum, maximum;
+	};
+
+private:
+
+	static const GLuint		NO_SCOPE = 0xFFFFFFFF;
+
+	struct ScopeRecord {
+
+		const char*			name;
+		GLuint				depth;
+	};
+
+	struct FrameRecord {
+
+		std::string					tag;
+		std::vector<ScopeRecord>	scopes; // scope i uses queries 2i (start) and 2i + 1 (end)
+		GLuint						lastQuery; // query written last (the end of the outermost scope closed last)
+		bool						pending; // queries issued and not yet read
+	};
+
+	// Rolling window of samples for one scope under one tag
+	struct Series {
+
+		std::string			tag;
+		std::string			name;
+		GLuint				depth;
+		std::vector<float>	samples;
+		GLuint				next; // ring position of the next sample
+		unsigned long long	totalSamples;
+	};
+
+	GLuint					queries[NUM_FRAMES][MAX_SCOPES * 2];
+	FrameRecord				frames[NUM_FRAMES];
+	GLuint					currentFrame;
+	bool					frameActive;
+	std::vector<GLuint>		openScopes; // stack of scope indices (NO_SCOPE for scopes not recorded)
+
+	std::string				currentTag;
+
+	std::vector<Series>		series; // in order of first appearance
+	std::map<std::string, size_t>	seriesIndex; // tag + '\n' + name -> series
+
+	unsigned long long		framesProfiled, framesSkipped;
+
+	//
+	// Private API
+	//
+
+	void collectFrame(GLuint frame);
+	void addSample(const std::string& tag, const char* name, GLuint depth, float milliseconds);
+	ScopeStats calculateStats(const Series& s) const;
+
+public:
+
+	GPUProfiler();
+
+	~GPUProfiler();
+
+	// Tag for subsequent frames
+	void setTag(const std::string& tag);
+
+	// Mark the start and end of a frame.  Scopes must be opened and closed between these calls
+	void beginFrame();
+	void endFrame();
+
+	// Open and close a named scope.  name must remain valid until the frame's results are collected (string literals are expected)
+	void beginScope(const char* name);
+	void endScope();
+
+	// Statistics for every scope recorded under tag, in the order the scopes were first recorded
+	std::vector<ScopeStats> getStats(const std::string& tag) const;
+
+	// Statistics for the named scope under tag.  Return false if the scope has not been recorded under tag
+	bool getStats(const std::string& tag, const std::string& name, ScopeStats& stats) const;
+
+	// All tags recorded, in order of first appearance
+	std::vector<std::string> getTags() const;
+
+	// Write statistics for every tag and scope to a CSV file.  Return false if the file cannot be written
+	bool exportCSV(const std::string& filename) const;
+
+	// Discard all samples
+	void reset();
+
+	unsigned long long getFramesProfiled() const;
+	unsigned long long getFramesSkipped() const;
+};
+
+
+// Time the enclosing block as a scope of profiler.  If profiler is nullptr the scope is ignored
+class GPUProfileScope {
+
+	GPUProfiler*		profiler;
+
+public:
+
+	GPUProfileScope(GPUProfiler* profiler, const char* name);
+
+	~GPUProfileScope();
+};
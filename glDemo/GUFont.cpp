@@ -1,57 +1,169 @@
 
 #include "GUFont.h"
+#include "GLDebugOutput.h"
+#include "ShaderSetup.h"
 
 
 using namespace std;
 
 
-GUFont::GUFont(const wstring& fontName, const int fontSize) {
+// Embedded 8x8 bitmap font covering printable ASCII (0x20 - 0x7E).  Each glyph is stored as 8 rows (top to bottom) and the least significant bit of each row is the leftmost pixel
+
+static const int		firstGlyph = 0x20;
+static const int		numGlyphs = 95;
+static const int		glyphSize = 8;
+
+static const GLubyte	glyphBitmaps[numGlyphs][glyphSize] = {
+
+	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// space
+	{ 0x18, 0x3C, 0x3C, 0x18, 0x18, 0x00, 0x18, 0x00 },	// !
+	{ 0x36, 0x36, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// "
+	{ 0x36, 0x36, 0x7F, 0x36, 0x7F, 0x36, 0x36, 0x00 },	// #
+	{ 0x0C, 0x3E, 0x03, 0x1E, 0x30, 0x1F, 0x0C, 0x00 },	// $
+	{ 0x00, 0x63, 0x33, 0x18, 0x0C, 0x66, 0x63, 0x00 },	// %
+	{ 0x1C, 0x36, 0x1C, 0x6E, 0x3B, 0x33, 0x6E, 0x00 },	// &
+	{ 0x06, 0x06, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00 },	// '
+	{ 0x18, 0x0C, 0x06, 0x06, 0x06, 0x0C, 0x18, 0x00 },	// (
+	{ 0x06, 0x0C, 0x18, 0x18, 0x18, 0x0C, 0x06, 0x00 },	// )
+	{ 0x00, 0x66, 0x3C, 0xFF, 0x3C, 0x66, 0x00, 0x00 },	// *
+	{ 0x00, 0x0C, 0x0C, 0x3F, 0x0C, 0x0C, 0x00, 0x00 },	// +
+	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C, 0x06 },	// ,
+	{ 0x00, 0x00, 0x00, 0x3F, 0x00, 0x00, 0x00, 0x00 },	// -
+	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C, 0x00 },	// .
+	{ 0x60, 0x30, 0x18, 0x0C, 0x06, 0x03, 0x01, 0x00 },	// /
+	{ 0x3E, 0x63, 0x73, 0x7B, 0x6F, 0x67, 0x3E, 0x00 },	// 0
+	{ 0x0C, 0x0E, 0x0C, 0x0C, 0x0C, 0x0C, 0x3F, 0x00 },	// 1
+	{ 0x1E, 0x33, 0x30, 0x1C, 0x06, 0x33, 0x3F, 0x00 },	// 2
+	{ 0x1E, 0x33, 0x30, 0x1C, 0x30, 0x33, 0x1E, 0x00 },	// 3
+	{ 0x38, 0x3C, 0x36, 0x33, 0x7F, 0x30, 0x78, 0x00 },	// 4
+	{ 0x3F, 0x03, 0x1F, 0x30, 0x30, 0x33, 0x1E, 0x00 },	// 5
+	{ 0x1C, 0x06, 0x03, 0x1F, 0x33, 0x33, 0x1E, 0x00 },	// 6
+	{ 0x3F, 0x33, 0x30, 0x18, 0x0C, 0x0C, 0x0C, 0x00 },	// 7
+	{ 0x1E, 0x33, 0x33, 0x1E, 0x33, 0x33, 0x1E, 0x00 },	// 8
+	{ 0x1E, 0x33, 0x33, 0x3E, 0x30, 0x18, 0x0E, 0x00 },	// 9
+	{ 0x00, 0x0C, 0x0C, 0x00, 0x00, 0x0C, 0x0C, 0x00 },	// :
+	{ 0x00, 0x0C, 0x0C, 0x00, 0x00, 0x0C, 0x0C, 0x06 },	// ;
+	{ 0x18, 0x0C, 0x06, 0x03, 0x06, 0x0C, 0x18, 0x00 },	// <
+	{ 0x00, 0x00, 0x3F, 0x00, 0x00, 0x3F, 0x00, 0x00 },	// =
+	{ 0x06, 0x0C, 0x18, 0x30, 0x18, 0x0C, 0x06, 0x00 },	// >
+	{ 0x1E, 0x33, 0x30, 0x18, 0x0C, 0x00, 0x0C, 0x00 },	// ?
+	{ 0x3E, 0x63, 0x7B, 0x7B, 0x7B, 0x03, 0x1E, 0x00 },	// @
+	{ 0x0C, 0x1E, 0x33, 0x33, 0x3F, 0x33, 0x33, 0x00 },	// A
+	{ 0x3F, 0x66, 0x66, 0x3E, 0x66, 0x66, 0x3F, 0x00 },	// B
+	{ 0x3C, 0x66, 0x03, 0x03, 0x03, 0x66, 0x3C, 0x00 },	// C
+	{ 0x1F, 0x36, 0x66, 0x66, 0x66, 0x36, 0x1F, 0x00 },	// D
+	{ 0x7F, 0x46, 0x16, 0x1E, 0x16, 0x46, 0x7F, 0x00 },	// E
+	{ 0x7F, 0x46, 0x16, 0x1E, 0x16, 0x06, 0x0F, 0x00 },	// F
+	{ 0x3C, 0x66, 0x03, 0x03, 0x73, 0x66, 0x7C, 0x00 },	// G
+	{ 0x33, 0x33, 0x33, 0x3F, 0x33, 0x33, 0x33, 0x00 },	// H
+	{ 0x1E, 0x0C, 0x0C, 0x0C, 0x0C, 0x0C, 0x1E, 0x00 },	// I
+	{ 0x78, 0x30, 0x30, 0x30, 0x33, 0x33, 0x1E, 0x00 },	// J
+	{ 0x67, 0x66, 0x36, 0x1E, 0x36, 0x66, 0x67, 0x00 },	// K
+	{ 0x0F, 0x06, 0x06, 0x06, 0x46, 0x66, 0x7F, 0x00 },	// L
+	{ 0x63, 0x77, 0x7F, 0x7F, 0x6B, 0x63, 0x63, 0x00 },	// M
+	{ 0x63, 0x67, 0x6F, 0x7B, 0x73, 0x63, 0x63, 0x00 },	// N
+	{ 0x1C, 0x36, 0x63, 0x63, 0x63, 0x36, 0x1C, 0x00 },	// O
+	{ 0x3F, 0x66, 0x66, 0x3E, 0x06, 0x06, 0x0F, 0x00 },	// P
+	{ 0x1E, 0x33, 0x33, 0x33, 0x3B, 0x1E, 0x38, 0x00 },	// Q
+	{ 0x3F, 0x66, 0x66, 0x3E, 0x36, 0x66, 0x67, 0x00 },	// R
+	{ 0x1E, 0x33, 0x07, 0x0E, 0x38, 0x33, 0x1E, 0x00 },	// S
+	{ 0x3F, 0x2D, 0x0C, 0x0C, 0x0C, 0x0C, 0x1E, 0x00 },	// T
+	{ 0x33, 0x33, 0x33, 0x33, 0x33, 0x33, 0x3F, 0x00 },	// U
+	{ 0x33, 0x33, 0x33, 0x33, 0x33, 0x1E, 0x0C, 0x00 },	// V
+	{ 0x63, 0x63, 0x63, 0x6B, 0x7F, 0x77, 0x63, 0x00 },	// W
+	{ 0x63, 0x63, 0x36, 0x1C, 0x1C, 0x36, 0x63, 0x00 },	// X
+	{ 0x33, 0x33, 0x33, 0x1E, 0x0C, 0x0C, 0x1E, 0x00 },	// Y
+	{ 0x7F, 0x63, 0x31, 0x18, 0x4C, 0x66, 0x7F, 0x00 },	// Z
+	{ 0x1E, 0x06, 0x06, 0x06, 0x06, 0x06, 0x1E, 0x00 },	// [
+	{ 0x03, 0x06, 0x0C, 0x18, 0x30, 0x60, 0x40, 0x00 },	// backslash
+	{ 0x1E, 0x18, 0x18, 0x18, 0x18, 0x18, 0x1E, 0x00 },	// ]
+	{ 0x08, 0x1C, 0x36, 0x63, 0x00, 0x00, 0x00, 0x00 },	// ^
+	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF },	// _
+	{ 0x0C, 0x0C, 0x18, 0x00, 0x00, 0x00, 0x00, 0x00 },	// `
+	{ 0x00, 0x00, 0x1E, 0x30, 0x3E, 0x33, 0x6E, 0x00 },	// a
+	{ 0x07, 0x06, 0x06, 0x3E, 0x66, 0x66, 0x3B, 0x00 },	// b
+	{ 0x00, 0x00, 0x1E, 0x33, 0x03, 0x33, 0x1E, 0x00 },	// c
+	{ 0x38, 0x30, 0x30, 0x3E, 0x33, 0x33, 0x6E, 0x00 },	// d
+	{ 0x00, 0x00, 0x1E, 0x33, 0x3F, 0x03, 0x1E, 0x00 },	// e
+	{ 0x1C, 0x36, 0x06, 0x0F, 0x06, 0x06, 0x0F, 0x00 },	// f
+	{ 0x00, 0x00, 0x6E, 0x33, 0x33, 0x3E, 0x30, 0x1F },	// g
+	{ 0x07, 0x06, 0x36, 0x6E, 0x66, 0x66, 0x67, 0x00 },	// h
+	{ 0x0C, 0x00, 0x0E, 0x0C, 0x0C, 0x0C, 0x1E, 0x00 },	// i
+	{ 0x30, 0x00, 0x30, 0x30, 0x30, 0x33, 0x33, 0x1E },	// j
+	{ 0x07, 0x06, 0x66, 0x36, 0x1E, 0x36, 0x67, 0x00 },	// k
+	{ 0x0E, 0x0C, 0x0C, 0x0C, 0x0C, 0x0C, 0x1E, 0x00 },	// l
+	{ 0x00, 0x00, 0x33, 0x7F, 0x7F, 0x6B, 0x63, 0x00 },	// m
+	{ 0x00, 0x00, 0x1F, 0x33, 0x33, 0x33, 0x33, 0x00 },	// n
+	{ 0x00, 0x00, 0x1E, 0x33, 0x33, 0x33, 0x1E, 0x00 },	// o
+	{ 0x00, 0x00, 0x3B, 0x66, 0x66, 0x3E, 0x06, 0x0F },	// p
+	{ 0x00, 0x00, 0x6E, 0x33, 0x33, 0x3E, 0x30, 0x78 },	// q
+	{ 0x00, 0x00, 0x3B, 0x6E, 0x66, 0x06, 0x0F, 0x00 },	// r
+	{ 0x00, 0x00, 0x3E, 0x03, 0x1E, 0x30, 0x1F, 0x00 },	// s
+	{ 0x08, 0x0C, 0x3E, 0x0C, 0x0C, 0x2C, 0x18, 0x00 },	// t
+	{ 0x00, 0x00, 0x33, 0x33, 0x33, 0x33, 0x6E, 0x00 },	// u
+	{ 0x00, 0x00, 0x33, 0x33, 0x33, 0x1E, 0x0C, 0x00 },	// v
+	{ 0x00, 0x00, 0x63, 0x6B, 0x7F, 0x7F, 0x36, 0x00 },	// w
+	{ 0x00, 0x00, 0x63, 0x36, 0x1C, 0x36, 0x63, 0x00 },	// x
+	{ 0x00, 0x00, 0x33, 0x33, 0x33, 0x3E, 0x30, 0x1F },	// y
+	{ 0x00, 0x00, 0x3F, 0x19, 0x0C, 0x26, 0x3F, 0x00 },	// z
+	{ 0x38, 0x0C, 0x0C, 0x07, 0x0C, 0x0C, 0x38, 0x00 },	// {
+	{ 0x18, 0x18, 0x18, 0x00, 0x18, 0x18, 0x18, 0x00 },	// |
+	{ 0x07, 0x0C, 0x0C, 0x38, 0x0C, 0x0C, 0x07, 0x00 },	// }
+	{ 0x6E, 0x3B, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// ~
+};
+
+
+// The atlas is a grid of glyph cells
+static const int		atlasColumns = 16;
+static const int		atlasRows = (numGlyphs + atlasColumns - 1) / atlasColumns;
+static const int		atlasWidth = atlasColumns * glyphSize;
+static const int		atlasHeight = atlasRows * glyphSize;
+
+
+// FNV-1a hash used to identify cached strings
+static uint64_t hashBytes(const void* data, size_t size, uint64_t hash = 14695981039346656037ull) {
+
+	const unsigned char* bytes = (const unsigned char*)data;
+
+	for (size_t i = 0; i < size; i++) {
+
+		hash ^= bytes[i];
+		hash *= 1099511628211ull;
+	}
 
-	fnt_base = 0;
+	return hash;
+}
 
-	// Get device context
-	HDC hDC = GetDC(NULL);
 
-	if (!hDC)
-		return;
+GUFont::GUFont(const int fontSize) {
 
-	// Generate and validate display list
-	fnt_base = glGenLists(256);
+	atlasTexture = 0;
+	textVertexArrayObj = 0;
+	textVertexBuffer = 0;
+	textVertexBufferSize = 0;
 
-	if (!fnt_base)
-		return;
+	glyphScale = std::max<int>(1, (int)roundf((float)fontSize / (float)glyphSize));
 
-	HFONT font = CreateFont(-fontSize,				// Height Of Font
-		0,							// Width Of Font
-		0,							// Angle Of Escapement
-		0,							// Orientation Angle
-		FW_BOLD,					// Font Weight
-		FALSE,						// Italic
-		FALSE,						// Underline
-		FALSE,						// Strikeout
-		ANSI_CHARSET,				// Character Set Identifier
-		OUT_TT_PRECIS,				// Output Precision
-		CLIP_DEFAULT_PRECIS,		// Clipping Precision
-		ANTIALIASED_QUALITY,		// Output Quality
-		FF_DONTCARE | DEFAULT_PITCH,	// Family And Pitch
-		fontName.c_str());
-
-	if (!font) {
-
-		deleteFont();
-		ReleaseDC(NULL, hDC);
-		return;
-	}
+	viewportWidth = 1;
+	viewportHeight = 1;
+
+	liveVertices = 0;
+	dirtyBegin = 0;
+	dirtyEnd = 0;
+	frameIndex = 0;
+
+	lastStringCount = 0;
+	lastRegeneratedCount = 0;
+	regeneratedCount = 0;
+	lastArenaBytes = 0;
 
-	// select new font
-	SelectObject(hDC, font);
+	textShader = setupShaders(string("Shaders\\text.vs.txt"), string(""), string("Shaders\\text.fs.txt"));
 
-	// setup display lists to render font (using ASCII char set)
-	wglUseFontBitmaps(hDC, 0, 256, fnt_base);
+	pixelScaleLocation = glGetUniformLocation(textShader, "pixelScale");
+	atlasLocation = glGetUniformLocation(textShader, "glyphAtlas");
 
-	// release device context and dispose local resources
-	ReleaseDC(NULL, hDC);
-	DeleteObject(font);
+	createAtlas();
+	setupVAO();
 }
 
 
@@ -61,57 +173,342 @@ GUFont::~GUFont() {
 }
 
 
-void GUFont::renderText(const float x, const float y, const glm::mat4& view, const glm::vec4& colour, const char* formatString, ...) const {
+void GUFont::setViewportSize(const int width, const int height) {
+
+	viewportWidth = std::max<int>(width, 1);
+	viewportHeight = std::max<int>(height, 1);
+}
+
+
+void GUFont::renderText(const float x, const float y, const glm::mat4& view, const glm::vec4& colour, const char* formatString, ...) {
 
 	if (!formatString)
 		return;
 
 	// Parse the string for variables
-	const int	maxStringLength = 256;
-
-	char		text[maxStringLength];
+	size_t		length;
 	va_list		ap;
 
 	va_start(ap, formatString);
-	vsprintf_s(text, maxStringLength, formatString, ap);
+	const char* text = arena.vformat(&length, formatString, ap);
 	va_end(ap);
 
-	// Render text
+	// Identify the string by its text, position, view and colour
+	uint64_t key = hashBytes(text, length);
+
+	key = hashBytes(&x, sizeof(float), key);
+	key = hashBytes(&y, sizeof(float), key);
+	key = hashBytes(&view, sizeof(glm::mat4), key);
+	key = hashBytes(&colour, sizeof(glm::vec4), key);
+
+	auto entry = textCache.find(key);
+
+	if (entry == textCache.end() || entry->second.text.compare(0, std::string::npos, text, length) != 0) {
+
+		// New or changed string - generate glyph quads at the end of the cache
+		glm::vec4 anchor = view * glm::vec4(x, y, 0.0f, 1.0f);
+
+		anchor /= anchor.w;
+
+		CachedText& cached = textCache[key];
+
+		if (cached.numVertices > 0)
+			liveVertices -= cached.numVertices; // hash collision - the previous geometry becomes garbage
+
+		size_t first = cachedVertices.size();
+
+		appendGlyphQuads(text, anchor, colour, cachedVertices);
+
+		cached.text.assign(text, length);
+		cached.firstVertex = (GLint)first;
+		cached.numVertices = (GLsizei)(cachedVertices.size() - first);
+
+		liveVertices += cached.numVertices;
+
+		dirtyBegin = std::min<size_t>(dirtyBegin, first);
+		dirtyEnd = cachedVertices.size();
+
+		entry = textCache.find(key);
+		regeneratedCount++;
+	}
+
+	entry->second.lastFrame = frameIndex;
+
+	if (entry->second.numVertices > 0)
+		frameStrings.push_back(&entry->second);
+}
+
 
-	glMatrixMode(GL_PROJECTION);
-	glPushMatrix();
-	glLoadIdentity();
-	glMultMatrixf((GLfloat*)&(view));
+void GUFont::render() {
 
-	glMatrixMode(GL_MODELVIEW);
-	glPushMatrix();
-	glLoadIdentity();
-	glRasterPos2f(x, y);
+	GLCallContext glCallContext(__FUNCTION__);
 
-	glColor4f(colour.r, colour.g, colour.b, colour.a);
+	lastStringCount = (GLuint)frameStrings.size();
+	lastRegeneratedCount = regeneratedCount;
+	regeneratedCount = 0;
 
-	glPushAttrib(GL_LIST_BIT);
+	evictAndCompact();
+	uploadCache();
 
-	glListBase(fnt_base);
-	glCallLists((GLsizei)strlen(text), GL_UNSIGNED_BYTE, text);
+	// Build the draw ranges for this frame, merging strings that are adjacent in the vertex buffer
+	drawFirst.clear();
+	drawCount.clear();
 
-	glPopAttrib();
+	for (const CachedText* cached : frameStrings) {
 
-	glMatrixMode(GL_PROJECTION);
-	glPopMatrix();
+		if (!drawFirst.empty() && drawFirst.back() + drawCount.back() == cached->firstVertex)
+			drawCount.back() += cached->numVertices;
+		else {
 
-	glMatrixMode(GL_MODELVIEW);
-	glPopMatrix();
+			drawFirst.push_back(cached->firstVertex);
+			drawCount.push_back(cached->numVertices);
+		}
+	}
+
+	frameStrings.clear();
+	lastArenaBytes = arena.getBytesAllocated();
+	arena.reset();
+	frameIndex++;
+
+	if (drawFirst.empty())
+		return;
+
+	glUseProgram(textShader);
+	glUniform2f(pixelScaleLocation, 2.0f / (float)viewportWidth, 2.0f / (float)viewportHeight);
+	glUniform1i(atlasLocation, 0);
+
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, atlasTexture);
+
+	GLboolean blendEnabled = glIsEnabled(GL_BLEND);
+	GLboolean depthTestEnabled = glIsEnabled(GL_DEPTH_TEST);
+
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	glDisable(GL_DEPTH_TEST);
+
+	glBindVertexArray(textVertexArrayObj);
+	glMultiDrawArrays(GL_TRIANGLES, drawFirst.data(), drawCount.data(), (GLsizei)drawFirst.size());
+	glBindVertexArray(0);
+
+	if (!blendEnabled)
+		glDisable(GL_BLEND);
+
+	if (depthTestEnabled)
+		glEnable(GL_DEPTH_TEST);
+}
+
+
+GLuint GUFont::getStringCount() const {
+
+	return lastStringCount;
+}
+
+
+GLuint GUFont::getRegeneratedCount() const {
+
+	return lastRegeneratedCount;
+}
+
+
+size_t GUFont::getArenaBytes() const {
+
+	return lastArenaBytes;
+}
+
+
+size_t GUFont::getPeakArenaBytes() const {
+
+	return arena.getPeakBytesAllocated();
 }
 
 
 
 // Private method implementation
 
+// Generate glyph quads (as triangle pairs) for text anchored at 'anchor' (in normalised device coordinates) and append them to vertices
+void GUFont::appendGlyphQuads(const char* text, const glm::vec4& anchor, const glm::vec4& colour, vector<GlyphVertex>& vertices) const {
+
+	GLubyte c[4] = {
+		(GLubyte)(glm::clamp(colour.r, 0.0f, 1.0f) * 255.0f),
+		(GLubyte)(glm::clamp(colour.g, 0.0f, 1.0f) * 255.0f),
+		(GLubyte)(glm::clamp(colour.b, 0.0f, 1.0f) * 255.0f),
+		(GLubyte)(glm::clamp(colour.a, 0.0f, 1.0f) * 255.0f) };
+
+	const float		glyphPixels = (float)(glyphSize * glyphScale);
+	const float		du = 1.0f / (float)atlasColumns;
+	const float		dv = 1.0f / (float)atlasRows;
+
+	float			penX = 0.0f;
+	float			penY = -(float)glyphScale; // drop glyph cells by one row so descenders sit below the baseline
+
+	for (const char* ch = text; *ch; ch++) {
+
+		int glyph = (int)(unsigned char)(*ch) - firstGlyph;
+
+		// Unsupported characters (and space) advance the pen without generating geometry
+		if (glyph > 0 && glyph < numGlyphs) {
+
+			float u0 = (float)(glyph % atlasColumns) * du;
+			float v0 = (float)(glyph / atlasColumns) * dv;
+			float u1 = u0 + du;
+			float v1 = v0 + dv;
+
+			// Atlas row 0 holds the top of each glyph so the top edge of the quad uses v0
+			GlyphVertex quad[4] = {
+				{ { anchor.x, anchor.y }, { penX, penY }, { u0, v1 }, { c[0], c[1], c[2], c[3] } },
+				{ { anchor.x, anchor.y }, { penX + glyphPixels, penY }, { u1, v1 }, { c[0], c[1], c[2], c[3] } },
+				{ { anchor.x, anchor.y }, { penX, penY + glyphPixels }, { u0, v0 }, { c[0], c[1], c[2], c[3] } },
+				{ { anchor.x, anchor.y }, { penX + glyphPixels, penY + glyphPixels }, { u1, v0 }, { c[0], c[1], c[2], c[3] } }
+			};
+
+			vertices.insert(vertices.end(), { quad[0], quad[1], quad[2], quad[2], quad[1], quad[3] });
+		}
+
+		penX += glyphPixels;
+	}
+}
+
+
+// Remove strings not drawn this frame from the cache.  Once more than half of the cached vertices are garbage the cache is compacted and re-uploaded in full
+void GUFont::evictAndCompact() {
+
+	for (auto i = textCache.begin(); i != textCache.end();) {
+
+		if (i->second.lastFrame != frameIndex) {
+
+			liveVertices -= i->second.numVertices;
+			i = textCache.erase(i);
+		}
+		else {
+
+			i++;
+		}
+	}
+
+	if (cachedVertices.size() > 1024 && cachedVertices.size() > liveVertices * 2) {
+
+		vector<GlyphVertex> compacted;
+
+		compacted.reserve(liveVertices);
+
+		for (auto& entry : textCache) {
+
+			CachedText& cached = entry.second;
+			size_t first = compacted.size();
+
+			compacted.insert(compacted.end(), cachedVertices.begin() + cached.firstVertex, cachedVertices.begin() + cached.firstVertex + cached.numVertices);
+			cached.firstVertex = (GLint)first;
+		}
+
+		cachedVertices.swap(compacted);
+
+		dirtyBegin = 0;
+		dirtyEnd = cachedVertices.size();
+	}
+}
+
+
+// Upload the dirty range of the cache to the vertex buffer, growing the buffer if needed
+void GUFont::uploadCache() {
+
+	GLsizeiptr requiredSize = (GLsizeiptr)(cachedVertices.size() * sizeof(GlyphVertex));
+
+	if (requiredSize > textVertexBufferSize) {
+
+		textVertexBufferSize = std::max<GLsizeiptr>(requiredSize * 2, 4096 * sizeof(GlyphVertex));
+
+		glBindBuffer(GL_ARRAY_BUFFER, textVertexBuffer);
+		glBufferData(GL_ARRAY_BUFFER, textVertexBufferSize, nullptr, GL_DYNAMIC_DRAW);
+		glBufferSubData(GL_ARRAY_BUFFER, 0, requiredSize, cachedVertices.data());
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+	else if (dirtyEnd > dirtyBegin) {
+
+		glBindBuffer(GL_ARRAY_BUFFER, textVertexBuffer);
+		glBufferSubData(GL_ARRAY_BUFFER, (GLintptr)(dirtyBegin * sizeof(GlyphVertex)), (GLsizeiptr)((dirtyEnd - dirtyBegin) * sizeof(GlyphVertex)), cachedVertices.data() + dirtyBegin);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+
+	dirtyBegin = cachedVertices.size();
+	dirtyEnd = cachedVertices.size();
+}
+
+void GUFont::createAtlas() {
+
+	vector<GLubyte> atlas(atlasWidth * atlasHeight, 0);
+
+	for (int glyph = 0; glyph < numGlyphs; glyph++) {
+
+		int cellX = (glyph % atlasColumns) * glyphSize;
+		int cellY = (glyph / atlasColumns) * glyphSize;
+
+		for (int row = 0; row < glyphSize; row++) {
+
+			for (int col = 0; col < glyphSize; col++) {
+
+				if (glyphBitmaps[glyph][row] & (1 << col))
+					atlas[(cellY + row) * atlasWidth + cellX + col] = 255;
+			}
+		}
+	}
+
+	glGenTextures(1, &atlasTexture);
+	glBindTexture(GL_TEXTURE_2D, atlasTexture);
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, atlasWidth, atlasHeight, 0, GL_RED, GL_UNSIGNED_BYTE, atlas.data());
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+	// Glyphs are drawn at integer scales so point sampling keeps them crisp
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+
+void GUFont::setupVAO() {
+
+	glGenVertexArrays(1, &textVertexArrayObj);
+	glBindVertexArray(textVertexArrayObj);
+
+	glGenBuffers(1, &textVertexBuffer);
+	glBindBuffer(GL_ARRAY_BUFFER, textVertexBuffer);
+
+	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(GlyphVertex), (const GLvoid*)offsetof(GlyphVertex, anchor));
+	glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(GlyphVertex), (const GLvoid*)offsetof(GlyphVertex, colour));
+	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(GlyphVertex), (const GLvoid*)offsetof(GlyphVertex, offset));
+	glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, sizeof(GlyphVertex), (const GLvoid*)offsetof(GlyphVertex, texCoord));
+
+	glEnableVertexAttribArray(0);
+	glEnableVertexAttribArray(1);
+	glEnableVertexAttribArray(2);
+	glEnableVertexAttribArray(3);
+
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+
 void GUFont::deleteFont() {
 
-	if (fnt_base)
-		glDeleteLists(fnt_base, 256);
+	if (atlasTexture)
+		glDeleteTextures(1, &atlasTexture);
+
+	if (textVertexBuffer)
+		glDeleteBuffers(1, &textVertexBuffer);
+
+	if (textVertexArrayObj)
+		glDeleteVertexArrays(1, &textVertexArrayObj);
+
+	if (textShader)
+		glDeleteProgram(textShader);
 
-	fnt_base = 0;
+	atlasTexture = 0;
+	textVertexBuffer = 0;
+	textVertexArrayObj = 0;
+	textShader = 0;
 }
@@ -1,20 +1,93 @@
 #pragma once
 
 #include "core.h"
+#include "FrameArena.h"
+#include <unordered_map>
+
+// Batched text renderer.  Glyphs are taken from an 8x8 bitmap font embedded in GUFont.cpp and packed into a single atlas texture at startup.  Strings are formatted into a per-frame arena and each string is hashed together with its position, view transform and colour.  Glyph quads are only generated for strings not seen in the previous frame - unchanged strings reuse the quads already stored in a persistent vertex buffer.  render() uploads only the changed range and draws all of the frame's text with a single glMultiDrawArrays call using the core profile shader in Shaders\text.vs and Shaders\text.fs
 
 class GUFont {
 
-	GLuint				fnt_base;
+	// Vertex layout for a glyph quad corner.  anchor is the string origin in normalised device coordinates and offset is the corner's offset from the anchor in pixels.  This means the generated geometry does not depend on the viewport size
+	struct GlyphVertex {
+
+		GLfloat		anchor[2];
+		GLfloat		offset[2];
+		GLfloat		texCoord[2];
+		GLubyte		colour[4];
+	};
+
+	// Cached geometry for a string drawn in a previous frame
+	struct CachedText {
+
+		std::string				text;
+		GLint					firstVertex;
+		GLsizei					numVertices;
+		GLuint					lastFrame;
+	};
+
+	GLuint						atlasTexture;
+
+	GLuint						textVertexArrayObj;
+	GLuint						textVertexBuffer;
+	GLsizeiptr					textVertexBufferSize;
+
+	GLuint						textShader;
+	GLint						pixelScaleLocation;
+	GLint						atlasLocation;
+
+	int							glyphScale; // integer scale applied to the 8x8 glyphs so text is close to the requested font size
+	int							viewportWidth, viewportHeight;
+
+	// Text cache - cachedVertices mirrors the contents of textVertexBuffer
+	std::unordered_map<uint64_t, CachedText>	textCache;
+	std::vector<GlyphVertex>	cachedVertices;
+	size_t						liveVertices; // vertices referenced by textCache - the remainder of cachedVertices is garbage from evicted strings
+	size_t						dirtyBegin, dirtyEnd; // range of cachedVertices not yet uploaded
+	GLuint						frameIndex;
+
+	std::vector<const CachedText*>	frameStrings; // strings to draw this frame in submission order
+	std::vector<GLint>			drawFirst;
+	std::vector<GLsizei>		drawCount;
+
+	FrameArena					arena;
+
+	// Statistics for the last frame rendered
+	GLuint						lastStringCount;
+	GLuint						lastRegeneratedCount;
+	GLuint						regeneratedCount;
+	size_t						lastArenaBytes; // bytes of formatted text
 
 public:
 
-	GUFont(const std::wstring& fontName, const int fontSize);
+	GUFont(const int fontSize);
 	~GUFont();
 
-	void renderText(const float x, const float y, const glm::mat4& view, const glm::vec4& colour, const char* formatString, ...) const;
+	// Set the viewport size in pixels so glyph offsets map to whole pixels
+	void setViewportSize(const int width, const int height);
+
+	// Append the formatted string to this frame's text.  <x, y> is the position of the string's baseline origin and is transformed by 'view' into normalised device coordinates
+	void renderText(const float x, const float y, const glm::mat4& view, const glm::vec4& colour, const char* formatString, ...);
+
+	// Draw all text appended since the last call to render with a single draw call
+	void render();
+
+	// Return the number of strings drawn in the last frame and how many of these needed new geometry
+	GLuint getStringCount() const;
+	GLuint getRegeneratedCount() const;
+
+	// Return the bytes of formatted text in the last frame and the most formatted in any frame
+	size_t getArenaBytes() const;
+	size_t getPeakArenaBytes() const;
 
 private:
 
+	void appendGlyphQuads(const char* text, const glm::vec4& anchor, const glm::vec4& colour, std::vector<GlyphVertex>& vertices) const;
+	void evictAndCompact();
+	void uploadCache();
+
+	void createAtlas();
+	void setupVAO();
 	void deleteFont();
 
 };
@@ -0,0 +1,399 @@
+
+#include "HeadlessContext.h"
+
+#if defined(CST_HEADLESS_OSMESA)
+#include <GL/osmesa.h>
+#elif !defined(_WIN32) && !defined(CST_HEADLESS_NONE)
+#define CST_HEADLESS_EGL
+#define EGL_NO_X11
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+
+using namespace std;
+
+
+#pragma region Private API
+
+#ifdef CST_HEADLESS_EGL
+
+static bool hasExtension(const char* extensions, const char* name) {
+
+	if (!extensions)
+		return false;
+
+	size_t length = strlen(name);
+
+	for (const char* s = strstr(extensions, name); s; s = strstr(s + length, name)) {
+
+		if ((s == extensions || s[-1] == ' ') && (s[length] == ' ' || s[length] == '\0'))
+			return true;
+	}
+
+	return false;
+}
+
+
+// Return the display to create the context on.  The Mesa surfaceless platform needs no display server, the device platform selects a GPU directly (headless NVIDIA drivers) and the default display is the last resort
+static EGLDisplay getHeadlessDisplay() {
+
+	const char* clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+
+	PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+
+	if (getPlatformDisplay && hasExtension(clientExtensions, "EGL_MESA_platform_surfaceless")) {
+
+		EGLDisplay display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+
+		if (display != EGL_NO_DISPLAY)
+			return display;
+	}
+
+	PFNEGLQUERYDEVICESEXTPROC queryDevices = (PFNEGLQUERYDEVICESEXTPROC)eglGetProcAddress("eglQueryDevicesEXT");
+
+	if (getPlatformDisplay && queryDevices && hasExtension(clientExtensions, "EGL_EXT_platform_device")) {
+
+		EGLDeviceEXT device;
+		EGLint numDevices = 0;
+
+		if (queryDevices(1, &device, &numDevices) && numDevices > 0) {
+
+			EGLDisplay display = getPlatformDisplay(EGL_PLATFORM_DEVICE_EXT, device, nullptr);
+
+			if (display != EGL_NO_DISPLAY)
+				return display;
+		}
+	}
+
+	return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+}
+
+#endif
+
+#pragma endregion
+
+
+#pragma region Public API
+
+HeadlessContext::HeadlessContext() {
+
+	backend = HEADLESS_NONE;
+	display = nullptr;
+	context = nullptr;
+}
+
+
+HeadlessContext::~HeadlessContext() {
+
+	destroy();
+}
+
+
+bool HeadlessContext::create(int majorVersion, int minorVersion) {
+
+	destroy();
+
+#if defined(CST_HEADLESS_OSMESA)
+	return createOSMesa(majorVersion, minorVersion);
+#elif defined(CST_HEADLESS_EGL)
+	return createEGL(majorVersion, minorVersion);
+#else
+	return createHiddenWindow(majorVersion, minorVersion);
+#endif
+}
+
+
+bool HeadlessContext::createEGL(int majorVersion, int minorVersion) {
+
+#ifdef CST_HEADLESS_EGL
+
+	EGLDisplay eglDisplay = getHeadlessDisplay();
+	EGLint eglMajor = 0, eglMinor = 0;
+
+	if (eglDisplay == EGL_NO_DISPLAY || !eglInitialize(eglDisplay, &eglMajor, &eglMinor)) {
+
+		cout << "EGL: cannot initialise a display (error 0x" << hex << eglGetError() << dec << ")" << endl;
+		return false;
+	}
+
+	const char* displayExtensions = eglQueryString(eglDisplay, EGL_EXTENSIONS);
+
+	if (!hasExtension(displayExtensions, "EGL_KHR_surfaceless_context")) {
+
+		cout << "EGL: surfaceless contexts are not supported by " << eglQueryString(eglDisplay, EGL_VENDOR) << endl;
+		eglTerminate(eglDisplay);
+		return false;
+	}
+
+	// No surface is created so any OpenGL capable config will do (or none at all where EGL_KHR_no_config_context is supported)
+	const EGLint configAttribs[] = { EGL_SURFACE_TYPE, 0, EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE };
+
+	EGLConfig config = nullptr;
+	EGLint numConfigs = 0;
+
+	if ((!eglChooseConfig(eglDisplay, configAttribs, &config, 1, &numConfigs) || numConfigs == 0) && !hasExtension(displayExtensions, "EGL_KHR_no_config_context")) {
+
+		cout << "EGL: no OpenGL config available" << endl;
+		eglTerminate(eglDisplay);
+		return false;
+	}
+
+	eglBindAPI(EGL_OPENGL_API);
+
+	// Request the viewer's context (compatibility profile, debug) then fall back to whatever version the implementation provides
+	const EGLint versionAttribs[] = {
+
+		EGL_CONTEXT_MAJOR_VERSION_KHR, majorVersion,
+		EGL_CONTEXT_MINOR_VERSION_KHR, minorVersion,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK_KHR, EGL_CONTEXT_OPENGL_COMPATIBILITY_PROFILE_BIT_KHR,
+		EGL_CONTEXT_FLAGS_KHR, EGL_CONTEXT_OPENGL_DEBUG_BIT_KHR,
+		EGL_NONE
+	};
+
+	const EGLint defaultAttribs[] = { EGL_NONE };
+
+	EGLContext eglContext = eglCreateContext(eglDisplay, (numConfigs > 0) ? config : (EGLConfig)0, EGL_NO_CONTEXT, versionAttribs);
+
+	if (eglContext == EGL_NO_CONTEXT) {
+
+		cout << "EGL: OpenGL " << majorVersion << "." << minorVersion << " compatibility context not available - using the default context" << endl;
+		eglContext = eglCreateContext(eglDisplay, (numConfigs > 0) ? config : (EGLConfig)0, EGL_NO_CONTEXT, defaultAttribs);
+	}
+
+	if (eglContext == EGL_NO_CONTEXT) {
+
+		cout << "EGL: cannot create an OpenGL context (error 0x" << hex << eglGetError() << dec << ")" << endl;
+		eglTerminate(eglDisplay);
+		return false;
+	}
+
+	display = eglDisplay;
+	context = eglContext;
+	backend = HEADLESS_EGL;
+
+	if (!makeCurrent()) {
+
+		destroy();
+		return false;
+	}
+
+	cout << "EGL " << eglMajor << "." << eglMinor << " surfaceless context (" << eglQueryString(eglDisplay, EGL_VENDOR) << ")" << endl;
+
+	return true;
+
+#else
+
+	(void)majorVersion;
+	(void)minorVersion;
+
+	return false;
+
+#endif
+}
+
+
+bool HeadlessContext::createOSMesa(int majorVersion, int minorVersion) {
+
+#ifdef CST_HEADLESS_OSMESA
+
+	const int versionAttribs[] = {
+
+		OSMESA_FORMAT, OSMESA_RGBA,
+		OSMESA_DEPTH_BITS, 24,
+		OSMESA_PROFILE, OSMESA_COMPAT_PROFILE,
+		OSMESA_CONTEXT_MAJOR_VERSION, majorVersion,
+		OSMESA_CONTEXT_MINOR_VERSION, minorVersion,
+		0
+	};
+
+	OSMesaContext osmesaContext = OSMesaCreateContextAttribs(versionAttribs, nullptr);
+
+	if (!osmesaContext) {
+
+		cout << "OSMesa: OpenGL " << majorVersion << "." << minorVersion << " compatibility context not available - using the default context" << endl;
+		osmesaContext = OSMesaCreateContextExt(OSMESA_RGBA, 24, 0, 0, nullptr);
+	}
+
+	if (!osmesaContext) {
+
+		cout << "OSMesa: cannot create an OpenGL context" << endl;
+		return false;
+	}
+
+	// Rendering goes to framebuffer objects so the context's own buffer can be tiny
+	osmesaBuffer.assign(4 * 4 * 4, 0);
+
+	context = osmesaContext;
+	backend = HEADLESS_OSMESA;
+
+	if (!makeCurrent()) {
+
+		destroy();
+		return false;
+	}
+
+	cout << "OSMesa software context" << endl;
+
+	return true;
+
+#else
+
+	(void)majorVersion;
+	(void)minorVersion;
+
+	return false;
+
+#endif
+}
+
+
+bool HeadlessContext::createHiddenWindow(int majorVersion, int minorVersion) {
+
+	if (!glfwInit()) {
+
+		cout << "Headless rendering needs EGL or OSMesa, or a display for a hidden GLFW window" << endl;
+		return false;
+	}
+
+	glfwDefaultWindowHints();
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, majorVersion);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, minorVersion);
+
+	GLFWwindow* window = glfwCreateWindow(16, 16, "Headless", NULL, NULL);
+
+	if (!window) {
+
+		cout << "GLFW: OpenGL " << majorVersion << "." << minorVersion << " context not available - using the default context" << endl;
+
+		glfwDefaultWindowHints();
+		glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+		window = glfwCreateWindow(16, 16, "Headless", NULL, NULL);
+	}
+
+	if (!window) {
+
+		cout << "GLFW: cannot create a hidden window" << endl;
+		glfwTerminate();
+		return false;
+	}
+
+	// Rendering goes to framebuffer objects so the window's own framebuffer can be tiny
+	context = window;
+	backend = HEADLESS_HIDDEN_WINDOW;
+
+	if (!makeCurrent()) {
+
+		destroy();
+		return false;
+	}
+
+	cout << "Hidden GLFW window context (no headless backend in this build)" << endl;
+
+	return true;
+}
+
+
+void HeadlessContext::destroy() {
+
+	releaseCurrent();
+
+#if defined(CST_HEADLESS_OSMESA)
+
+	if (context)
+		OSMesaDestroyContext((OSMesaContext)context);
+
+#elif defined(CST_HEADLESS_EGL)
+
+	if (context)
+		eglDestroyContext((EGLDisplay)display, (EGLContext)context);
+
+	if (display)
+		eglTerminate((EGLDisplay)display);
+
+#endif
+
+	if (backend == HEADLESS_HIDDEN_WINDOW) {
+
+		glfwDestroyWindow((GLFWwindow*)context);
+		glfwTerminate();
+	}
+
+	backend = HEADLESS_NONE;
+	display = nullptr;
+	context = nullptr;
+	osmesaBuffer.clear();
+}
+
+
+bool HeadlessContext::makeCurrent() {
+
+#if defined(CST_HEADLESS_OSMESA)
+
+	if (backend == HEADLESS_OSMESA && OSMesaMakeCurrent((OSMesaContext)context, osmesaBuffer.data(), GL_UNSIGNED_BYTE, 4, 4))
+		return true;
+
+#elif defined(CST_HEADLESS_EGL)
+
+	if (backend == HEADLESS_EGL && eglMakeCurrent((EGLDisplay)display, EGL_NO_SURFACE, EGL_NO_SURFACE, (EGLContext)context))
+		return true;
+
+#endif
+
+	if (backend == HEADLESS_HIDDEN_WINDOW) {
+
+		glfwMakeContextCurrent((GLFWwindow*)context);
+		return true;
+	}
+
+	cout << "Cannot make the " << getBackendName() << " headless context current" << endl;
+
+	return false;
+}
+
+
+void HeadlessContext::releaseCurrent() {
+
+#if defined(CST_HEADLESS_OSMESA)
+
+	// OSMesa has no call to release a context - it stays current until another is made current
+
+#elif defined(CST_HEADLESS_EGL)
+
+	if (backend == HEADLESS_EGL)
+		eglMakeCurrent((EGLDisplay)display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+
+#endif
+
+	if (backend == HEADLESS_HIDDEN_WINDOW)
+		glfwMakeContextCurrent(NULL);
+}
+
+
+HeadlessBackend HeadlessContext::getBackend() const {
+
+	return backend;
+}
+
+
+const char* HeadlessContext::getBackendName() const {
+
+	switch (backend) {
+
+		case HEADLESS_EGL:
+			return "EGL";
+
+		case HEADLESS_OSMESA:
+			return "OSMesa";
+
+		case HEADLESS_HIDDEN_WINDOW:
+			return "hidden window";
+
+		default:
+			return "none";
+	}
+}
+
+#pragma endregion
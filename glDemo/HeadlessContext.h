@@ -0,0 +1,48 @@
+#pragma once
+
+#include "core.h"
+
+// Windowless OpenGL context for batch rendering on machines with no display (or no GPU).  The EGL backend (the default on non-Windows builds) creates a surfaceless context - on the Mesa surfaceless platform where available so llvmpipe works without a display server, otherwise on the first EGL device or the default display.  Building with CST_HEADLESS_OSMESA uses an OSMesa software context instead and CST_HEADLESS_NONE leaves headless rendering out (see CMakeLists.txt).  The context has no default framebuffer that can be rendered to, so rendering goes to an OffscreenTarget.  GL entry points are loaded with glewInit as for a window context.  Builds with neither backend (Windows, or CST_HEADLESS_NONE) fall back to a hidden GLFW window - nothing is shown but a display is still needed
+
+enum HeadlessBackend {
+
+	HEADLESS_NONE = 0,
+	HEADLESS_EGL,
+	HEADLESS_OSMESA,
+	HEADLESS_HIDDEN_WINDOW
+};
+
+
+class HeadlessContext {
+
+	HeadlessBackend		backend;
+
+	// Backend handles (EGLDisplay / EGLContext, OSMesaContext or GLFWwindow)
+	void*				display;
+	void*				context;
+
+	std::vector<GLubyte>	osmesaBuffer; // OSMesa needs a colour buffer to make a context current
+
+	bool createEGL(int majorVersion, int minorVersion);
+	bool createOSMesa(int majorVersion, int minorVersion);
+	bool createHiddenWindow(int majorVersion, int minorVersion);
+
+public:
+
+	HeadlessContext();
+	~HeadlessContext();
+
+	HeadlessContext(const HeadlessContext&) = delete;
+	HeadlessContext& operator=(const HeadlessContext&) = delete;
+
+	// Create a compatibility profile context of at least the given version (falling back to the highest version available) and make it current on the calling thread.  Return false if no headless context can be created
+	bool create(int majorVersion, int minorVersion);
+
+	void destroy();
+
+	bool makeCurrent();
+	void releaseCurrent();
+
+	HeadlessBackend getBackend() const;
+	const char* getBackendName() const;
+};
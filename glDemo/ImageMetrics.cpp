@@ -0,0 +1,77 @@
+
+#include "ImageMetrics.h"
+#include "JobSystem.h"
+
+using namespace std;
+
+
+double psnrFromMSE(double mse) {
+
+	if (mse <= 0.0)
+		return numeric_limits<double>::infinity();
+
+	return 10.0 * log10((255.0 * 255.0) / mse);
+}
+
+
+ImageErrorStats compareImages(const GLubyte* imageA, const GLubyte* imageB, GLuint width, GLuint height, JobSystem* jobSystem) {
+
+	ImageErrorStats stats = {};
+
+	if (!imageA || !imageB || width == 0 || height == 0)
+		return stats;
+
+	if (!jobSystem)
+		jobSystem = &JobSystem::global();
+
+	// Each job accumulates into its own partial result which are summed once all jobs complete - this avoids contention on shared totals
+	struct Partial {
+
+		unsigned long long	sumSq[4];
+		int					maxAbsError;
+	};
+
+	size_t grainSize = std::max<size_t>(1, 65536 / width);
+	size_t numChunks = (height + grainSize - 1) / grainSize;
+
+	vector<Partial> partials(numChunks, Partial{});
+
+	jobSystem->parallelFor(0, height, grainSize, [&](size_t firstRow, size_t lastRow) {
+
+		Partial& partial = partials[firstRow / grainSize];
+
+		for (size_t y = firstRow; y < lastRow; y++) {
+
+			const GLubyte* a = imageA + y * width * 4;
+			const GLubyte* b = imageB + y * width * 4;
+
+			for (GLuint i = 0; i < width * 4; i++) {
+
+				int d = int(a[i]) - int(b[i]);
+
+				partial.sumSq[i & 3] += (unsigned long long)(d * d);
+				partial.maxAbsError = std::max(partial.maxAbsError, abs(d));
+			}
+		}
+	});
+
+	unsigned long long sumSq[4] = { 0, 0, 0, 0 };
+
+	for (auto& partial : partials) {
+
+		for (int c = 0; c < 4; c++)
+			sumSq[c] += partial.sumSq[c];
+
+		stats.maxAbsError = std::max(stats.maxAbsError, partial.maxAbsError);
+	}
+
+	double numPixels = double(width) * double(height);
+
+	for (int c = 0; c < 4; c++)
+		stats.mse[c] = double(sumSq[c]) / numPixels;
+
+	stats.mseRGB = (stats.mse[0] + stats.mse[1] + stats.mse[2]) / 3.0;
+	stats.psnrRGB = psnrFromMSE(stats.mseRGB);
+
+	return stats;
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "core.h"
+
+class JobSystem;
+
+// Image comparison metrics for 32 bit (4 channel, 8 bits per channel) images of equal size.  Used to measure the error introduced by mip generation, compression and atlas packing.  Rows are processed in parallel on the given job system (the global job system if nullptr)
+
+struct ImageErrorStats {
+
+	double		mse[4]; // per-channel mean squared error
+	double		mseRGB; // mean squared error over the first 3 channels
+	double		psnrRGB; // peak signal to noise ratio (dB) over the first 3 channels.  Infinite if the images are identical
+	int			maxAbsError; // largest per-channel absolute difference
+};
+
+
+ImageErrorStats compareImages(const GLubyte* imageA, const GLubyte* imageB, GLuint width, GLuint height, JobSystem* jobSystem = nullptr);
+
+// Peak signal to noise ratio for the given mean squared error of 8 bit data
+double psnrFromMSE(double mse);
@@ -0,0 +1,313 @@
+
+#include "InputLog.h"
+
+
+using namespace std;
+
+
+// Log header
+static const char		INPUT_LOG_MAGIC[4] = { 'C', 'S', 'T', 'I' };
+static const GLuint		INPUT_LOG_VERSION = 1;
+
+
+#pragma region Private API
+
+template <typename T>
+static void writeValue(ofstream& file, T value) {
+
+	file.write((const char*)&value, sizeof(T));
+}
+
+
+template <typename T>
+static bool readValue(ifstream& file, T& value) {
+
+	return (bool)file.read((char*)&value, sizeof(T));
+}
+
+#pragma endregion
+
+
+#pragma region Public API
+
+InputLog::InputLog() {
+
+	mode = INPUT_LIVE;
+
+	startTime = 0.0;
+	eventsRecorded = 0;
+
+	nextEventIndex = 0;
+	lastStep = 0;
+
+	step = 0;
+}
+
+
+InputLog::~InputLog() {
+
+	stop();
+}
+
+
+bool InputLog::startRecording(const string& filename) {
+
+	stop();
+
+	file.open(filename, ios::binary);
+
+	if (!file.is_open()) {
+
+		cout << "Cannot write input log " << filename << endl;
+		return false;
+	}
+
+	file.write(INPUT_LOG_MAGIC, sizeof(INPUT_LOG_MAGIC));
+	writeValue<GLuint>(file, INPUT_LOG_VERSION);
+
+	this->filename = filename;
+
+	mode = INPUT_RECORD;
+	startTime = glfwGetTime();
+	eventsRecorded = 0;
+	step = 0;
+
+	cout << "Recording input to " << filename << endl;
+
+	return true;
+}
+
+
+bool InputLog::startReplay(const string& filename) {
+
+	stop();
+
+	ifstream logFile(filename, ios::binary);
+
+	if (!logFile.is_open()) {
+
+		cout << "Cannot open input log " << filename << endl;
+		return false;
+	}
+
+	char magic[4];
+	GLuint version = 0;
+
+	if (!logFile.read(magic, sizeof(magic)) || memcmp(magic, INPUT_LOG_MAGIC, sizeof(magic)) != 0 || !readValue(logFile, version) || version != INPUT_LOG_VERSION) {
+
+		cout << filename << " is not an input log (or was written by a different version)" << endl;
+		return false;
+	}
+
+	events.clear();
+
+	bool complete = false;
+
+	while (!complete) {
+
+		InputEvent event = {};
+		GLubyte type;
+
+		if (!readValue(logFile, event.step) || !readValue(logFile, event.time) || !readValue(logFile, type))
+			break;
+
+		event.type = (InputEventType)type;
+
+		bool valid = true;
+
+		switch (event.type) {
+
+			case INPUT_CURSOR_POS:
+			case INPUT_SCROLL:
+			{
+				float x, y;
+
+				valid = readValue(logFile, x) && readValue(logFile, y);
+				event.x = x;
+				event.y = y;
+				break;
+			}
+
+			case INPUT_MOUSE_BUTTON:
+			{
+				GLubyte button, action;
+				float x, y;
+
+				valid = readValue(logFile, button) && readValue(logFile, action) && readValue(logFile, x) && readValue(logFile, y);
+				event.key = button;
+				event.action = action;
+				event.x = x;
+				event.y = y;
+				break;
+			}
+
+			case INPUT_KEY:
+			{
+				GLshort key;
+				GLubyte action, mods;
+
+				valid = readValue(logFile, key) && readValue(logFile, action) && readValue(logFile, mods);
+				event.key = key;
+				event.action = action;
+				event.mods = mods;
+				break;
+			}
+
+			case INPUT_RESIZE:
+			{
+				GLushort width, height;
+
+				valid = readValue(logFile, width) && readValue(logFile, height);
+				event.width = width;
+				event.height = height;
+				break;
+			}
+
+			case INPUT_END:
+				complete = true;
+				break;
+
+			default:
+				valid = false;
+		}
+
+		if (!valid) {
+
+			cout << "Input log " << filename << " is corrupt after " << events.size() << " events" << endl;
+			break;
+		}
+
+		events.push_back(event);
+	}
+
+	// A recording that was not stopped cleanly is replayed up to its last event
+	if (!complete)
+		cout << "Input log " << filename << " has no end marker - replaying the events read" << endl;
+
+	this->filename = filename;
+
+	mode = INPUT_REPLAY;
+	nextEventIndex = 0;
+	lastStep = (events.empty()) ? 0 : events.back().step;
+	step = 0;
+
+	cout << "Replaying " << events.size() - ((complete) ? 1 : 0) << " input events over " << lastStep + 1 << " steps from " << filename << endl;
+
+	return true;
+}
+
+
+void InputLog::stop() {
+
+	if (mode == INPUT_RECORD) {
+
+		InputEvent endEvent = {};
+
+		endEvent.type = INPUT_END;
+		record(endEvent);
+
+		file.close();
+
+		cout << "Recorded " << eventsRecorded << " input events over " << step + 1 << " steps to " << filename << endl;
+	}
+
+	events.clear();
+	mode = INPUT_LIVE;
+}
+
+
+bool InputLog::isRecording() const {
+
+	return mode == INPUT_RECORD;
+}
+
+
+bool InputLog::isReplaying() const {
+
+	return mode == INPUT_REPLAY;
+}
+
+
+void InputLog::record(InputEvent event) {
+
+	if (mode != INPUT_RECORD)
+		return;
+
+	writeValue<GLuint>(file, step);
+	writeValue<float>(file, (float)(glfwGetTime() - startTime));
+	writeValue<GLubyte>(file, (GLubyte)event.type);
+
+	switch (event.type) {
+
+		case INPUT_CURSOR_POS:
+		case INPUT_SCROLL:
+			writeValue<float>(file, (float)event.x);
+			writeValue<float>(file, (float)event.y);
+			break;
+
+		case INPUT_MOUSE_BUTTON:
+			writeValue<GLubyte>(file, (GLubyte)event.key);
+			writeValue<GLubyte>(file, (GLubyte)event.action);
+			writeValue<float>(file, (float)event.x);
+			writeValue<float>(file, (float)event.y);
+			break;
+
+		case INPUT_KEY:
+			writeValue<GLshort>(file, (GLshort)event.key);
+			writeValue<GLubyte>(file, (GLubyte)event.action);
+			writeValue<GLubyte>(file, (GLubyte)event.mods);
+			break;
+
+		case INPUT_RESIZE:
+			writeValue<GLushort>(file, (GLushort)event.width);
+			writeValue<GLushort>(file, (GLushort)event.height);
+			break;
+
+		default:
+			break;
+	}
+
+	if (event.type != INPUT_END)
+		eventsRecorded++;
+}
+
+
+bool InputLog::nextEvent(InputEvent& event) {
+
+	if (mode != INPUT_REPLAY || nextEventIndex >= events.size() || events[nextEventIndex].step != step)
+		return false;
+
+	event = events[nextEventIndex++];
+
+	// The end marker only records the length of the recording
+	if (event.type == INPUT_END)
+		return false;
+
+	return true;
+}
+
+
+void InputLog::endStep() {
+
+	step++;
+}
+
+
+GLuint InputLog::getStep() const {
+
+	return step;
+}
+
+
+bool InputLog::isReplayFinished() const {
+
+	return mode == INPUT_REPLAY && step > lastStep;
+}
+
+
+GLuint InputLog::getReplayLength() const {
+
+	return (mode == INPUT_REPLAY) ? lastStep + 1 : 0;
+}
+
+#pragma endregion
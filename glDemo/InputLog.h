@@ -0,0 +1,83 @@
+#pragma once
+
+#include "core.h"
+
+// Record and replay of viewer input.  While recording, every GLFW input event is written to a compact binary log with the simulation step it was applied in and the time since recording started.  A replay feeds the events back step by step - events are applied in exactly the steps they were recorded in (rather than at their recorded times) and the viewer renders one frame per step, so every replay of a log renders the same sequence of frames regardless of how fast the machine is.  The log stores values in the byte order of the machine that recorded it
+
+enum InputEventType {
+
+	INPUT_CURSOR_POS = 0,
+	INPUT_MOUSE_BUTTON,
+	INPUT_SCROLL,
+	INPUT_KEY,
+	INPUT_RESIZE,
+	INPUT_END, // marks the last step of a recording
+
+	NUM_INPUT_EVENT_TYPES
+};
+
+
+struct InputEvent {
+
+	InputEventType	type;
+	GLuint			step; // simulation step the event was applied in
+	float			time; // seconds since recording started
+	int				key; // key or mouse button
+	int				action; // GLFW_PRESS / GLFW_RELEASE
+	int				mods;
+	int				width, height; // framebuffer size (resize events)
+	double			x, y; // cursor position or scroll offset
+};
+
+
+class InputLog {
+
+	enum Mode { INPUT_LIVE = 0, INPUT_RECORD, INPUT_REPLAY };
+
+	Mode					mode;
+	std::string				filename;
+
+	// Recording
+	std::ofstream			file;
+	double					startTime;
+	unsigned long long		eventsRecorded;
+
+	// Replay
+	std::vector<InputEvent>	events;
+	size_t					nextEventIndex;
+	GLuint					lastStep;
+
+	GLuint					step;
+
+public:
+
+	InputLog();
+	~InputLog();
+
+	// Start recording to / replaying from filename.  Return false if the file cannot be opened (or is not a valid log)
+	bool startRecording(const std::string& filename);
+	bool startReplay(const std::string& filename);
+
+	// Finish the recording (writing the end marker) or replay
+	void stop();
+
+	bool isRecording() const;
+	bool isReplaying() const;
+
+	// Append an event to the recording, stamped with the current step and time
+	void record(InputEvent event);
+
+	// Return the next replayed event of the current step.  Return false when the step has no more events
+	bool nextEvent(InputEvent& event);
+
+	// Advance to the next simulation step
+	void endStep();
+
+	GLuint getStep() const;
+
+	// True once every recorded step has been replayed
+	bool isReplayFinished() const;
+
+	// Number of steps in the log being replayed
+	GLuint getReplayLength() const;
+};
@@ -0,0 +1,451 @@
+
+#include "JobSystem.h"
+#include "CPUProfiler.h"
+
+
+using namespace std;
+
+
+// The job system (if any) and worker index of the calling thread.  currentWorkerIndex is -1 for threads that are not workers
+static thread_local JobSystem*	currentJobSystem = nullptr;
+static thread_local int			currentWorkerIndex = -1;
+
+JobSystem* JobSystem::globalInstance = nullptr;
+
+
+#pragma region Work-stealing deque
+
+JobSystem::WorkStealingDeque::WorkStealingDeque() : top(0), bottom(0) {
+
+	for (int64_t i = 0; i < capacity; i++)
+		buffer[i].store(nullptr, memory_order_relaxed);
+}
+
+
+bool JobSystem::WorkStealingDeque::push(Job* job) {
+
+	int64_t b = bottom.load(memory_order_relaxed);
+	int64_t t = top.load(memory_order_acquire);
+
+	if (b - t >= capacity)
+		return false;
+
+	buffer[b & (capacity - 1)].store(job, memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+	bottom.store(b + 1, memory_order_relaxed);
+
+	return true;
+}
+
+
+JobSystem::Job* JobSystem::WorkStealingDeque::pop() {
+
+	int64_t b = bottom.load(memory_order_relaxed) - 1;
+
+	bottom.store(b, memory_order_relaxed);
+	atomic_thread_fence(memory_order_seq_cst);
+
+	int64_t t = top.load(memory_order_relaxed);
+
+	if (t > b) {
+
+		// Deque was empty
+		bottom.store(b + 1, memory_order_relaxed);
+		return nullptr;
+	}
+
+	Job* job = buffer[b & (capacity - 1)].load(memory_order_relaxed);
+
+	if (t == b) {
+
+		// Last item - race against thieves for it
+		if (!top.compare_exchange_strong(t, t + 1, memory_order_seq_cst, memory_order_relaxed))
+			job = nullptr;
+
+		bottom.store(b + 1, memory_order_relaxed);
+	}
+
+	return job;
+}
+
+
+JobSystem::Job* JobSystem::WorkStealingDeque::steal() {
+
+	int64_t t = top.load(memory_order_acquire);
+	atomic_thread_fence(memory_order_seq_cst);
+	int64_t b = bottom.load(memory_order_acquire);
+
+	if (t >= b)
+		return nullptr;
+
+	Job* job = buffer[t & (capacity - 1)].load(memory_order_relaxed);
+
+	if (!top.compare_exchange_strong(t, t + 1, memory_order_seq_cst, memory_order_relaxed))
+		return nullptr; // lost the race to another thief or the owner
+
+	return job;
+}
+
+#pragma endregion
+
+
+#pragma region Private API
+
+void JobSystem::workerMain(int workerIndex) {
+
+	currentJobSystem = this;
+	currentWorkerIndex = workerIndex;
+
+	CPU_PROFILE_THREAD(string("Job worker ") + to_string(workerIndex));
+
+	while (!stopping) {
+
+		Job* job = findJob(workerIndex);
+
+		if (job) {
+
+			execute(job, workerIndex);
+		}
+		else {
+
+			// Sleep until work is queued.  The timeout guards against a job being made visible after the predicate was tested
+			unique_lock<mutex> lock(sleepMutex);
+			sleepCondition.wait_for(lock, chrono::milliseconds(10), [this]() { return pendingJobs > 0 || stopping; });
+		}
+	}
+}
+
+
+void JobSystem::enqueue(Job* job) {
+
+	bool queued = false;
+
+	if (currentJobSystem == this && currentWorkerIndex >= 0)
+		queued = workers[currentWorkerIndex]->deque.push(job);
+
+	if (!queued) {
+
+		lock_guard<mutex> lock(injectionMutex);
+		injectionQueue.push_back(job);
+	}
+
+	pendingJobs++;
+
+	{
+		lock_guard<mutex> lock(sleepMutex);
+	}
+
+	sleepCondition.notify_one();
+}
+
+
+JobSystem::Job* JobSystem::findJob(int workerIndex) {
+
+	Job* job = nullptr;
+
+	// 1. Own deque (most recently pushed job first for cache locality)
+	if (workerIndex >= 0)
+		job = workers[workerIndex]->deque.pop();
+
+	// 2. Jobs submitted from outside the worker pool (oldest first)
+	if (!job) {
+
+		lock_guard<mutex> lock(injectionMutex);
+
+		if (!injectionQueue.empty()) {
+
+			job = injectionQueue.front();
+			injectionQueue.pop_front();
+		}
+	}
+
+	// 3. Steal from the other workers
+	if (!job) {
+
+		int numWorkers = (int)workers.size();
+		int start = (workerIndex >= 0) ? workerIndex + 1 : 0;
+
+		for (int i = 0; i < numWorkers && !job; i++) {
+
+			int victim = (start + i) % numWorkers;
+
+			if (victim == workerIndex)
+				continue;
+
+			job = workers[victim]->deque.steal();
+
+			if (job && workerIndex >= 0)
+				workers[workerIndex]->jobsStolen++;
+		}
+	}
+
+	if (job)
+		pendingJobs--;
+
+	return job;
+}
+
+
+void JobSystem::execute(Job* job, int workerIndex) {
+
+	auto startTime = chrono::steady_clock::now();
+
+	{
+		CPU_PROFILE_ZONE("Job");
+
+		job->function();
+	}
+
+	if (workerIndex >= 0) {
+
+		auto elapsed = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - startTime);
+
+		workers[workerIndex]->busyNanoseconds += (unsigned long long)elapsed.count();
+		workers[workerIndex]->jobsExecuted++;
+	}
+
+	JobCounter* counter = job->counter;
+
+	delete job;
+
+	if (counter)
+		completeJob(counter);
+}
+
+
+void JobSystem::completeJob(JobCounter* counter) {
+
+	// A waiter may destroy the counter as soon as it is complete, so completing is held until the counter is no longer touched and released as the last access
+	counter->completing.fetch_add(1, memory_order_acq_rel);
+
+	if (counter->value.fetch_sub(1, memory_order_acq_rel) != 1) {
+
+		counter->completing.fetch_sub(1, memory_order_release);
+		return;
+	}
+
+	// Counter reached zero - release any jobs waiting on it
+	vector<pair<function<void()>, JobCounter*>> released;
+
+	{
+		lock_guard<mutex> lock(counter->continuationMutex);
+		released.swap(counter->continuations);
+	}
+
+	counter->completing.fetch_sub(1, memory_order_release);
+
+	for (auto& continuation : released) {
+
+		Job* job = new Job();
+
+		job->function = std::move(continuation.first);
+		job->counter = continuation.second;
+
+		enqueue(job);
+	}
+}
+
+#pragma endregion
+
+
+#pragma region Public API
+
+JobSystem::JobSystem(unsigned int numWorkers) : pendingJobs(0), stopping(false) {
+
+	if (numWorkers == AUTO_WORKERS)
+		numWorkers = std::max<unsigned int>(thread::hardware_concurrency(), 2) - 1;
+
+	statsResetTime = chrono::steady_clock::now();
+
+	for (unsigned int i = 0; i < numWorkers; i++) {
+
+		Worker* worker = new Worker();
+
+		worker->jobsExecuted = 0;
+		worker->jobsStolen = 0;
+		worker->busyNanoseconds = 0;
+
+		workers.push_back(worker);
+	}
+
+	// Start threads once all workers exist since any worker may steal from any other
+	for (unsigned int i = 0; i < numWorkers; i++)
+		workers[i]->thread = thread(&JobSystem::workerMain, this, (int)i);
+}
+
+
+JobSystem::~JobSystem() {
+
+	stopping = true;
+
+	{
+		lock_guard<mutex> lock(sleepMutex);
+	}
+
+	sleepCondition.notify_all();
+
+	for (auto worker : workers) {
+
+		worker->thread.join();
+
+		while (Job* job = worker->deque.pop())
+			delete job;
+
+		delete worker;
+	}
+
+	for (auto job : injectionQueue)
+		delete job;
+
+	if (globalInstance == this)
+		globalInstance = nullptr;
+}
+
+
+JobSystem& JobSystem::global() {
+
+	static mutex creationMutex;
+
+	lock_guard<mutex> lock(creationMutex);
+
+	if (!globalInstance)
+		globalInstance = new JobSystem();
+
+	return *globalInstance;
+}
+
+
+unsigned int JobSystem::getNumWorkers() const {
+
+	return (unsigned int)workers.size();
+}
+
+
+void JobSystem::submit(function<void()> function, JobCounter* counter) {
+
+	Job* job = new Job();
+
+	job->function = std::move(function);
+	job->counter = counter;
+
+	if (counter)
+		counter->value.fetch_add(1, memory_order_acq_rel);
+
+	enqueue(job);
+}
+
+
+void JobSystem::submitAfter(JobCounter& dependency, function<void()> function, JobCounter* counter) {
+
+	if (counter)
+		counter->value.fetch_add(1, memory_order_acq_rel);
+
+	{
+		lock_guard<mutex> lock(dependency.continuationMutex);
+
+		// Defer the job if the dependency is outstanding.  completeJob takes the continuation lock after the counter reaches zero so the job cannot be missed
+		if (dependency.value.load(memory_order_acquire) != 0) {
+
+			dependency.continuations.push_back(make_pair(std::move(function), counter));
+			return;
+		}
+	}
+
+	Job* job = new Job();
+
+	job->function = std::move(function);
+	job->counter = counter;
+
+	enqueue(job);
+}
+
+
+void JobSystem::wait(JobCounter& counter) {
+
+	int workerIndex = (currentJobSystem == this) ? currentWorkerIndex : -1;
+
+	while (!counter.isComplete()) {
+
+		Job* job = findJob(workerIndex);
+
+		if (job)
+			execute(job, workerIndex);
+		else
+			this_thread::yield();
+	}
+}
+
+
+void JobSystem::parallelFor(size_t begin, size_t end, size_t grainSize, const function<void(size_t, size_t)>& function) {
+
+	if (end <= begin)
+		return;
+
+	size_t count = end - begin;
+
+	if (grainSize == 0)
+		grainSize = std::max<size_t>(1, count / ((workers.size() + 1) * 4));
+
+	// Small ranges are executed directly
+	if (count <= grainSize) {
+
+		function(begin, end);
+		return;
+	}
+
+	JobCounter counter;
+
+	for (size_t chunkBegin = begin; chunkBegin < end; chunkBegin += grainSize) {
+
+		size_t chunkEnd = std::min<size_t>(chunkBegin + grainSize, end);
+
+		submit([&function, chunkBegin, chunkEnd]() { function(chunkBegin, chunkEnd); }, &counter);
+	}
+
+	wait(counter);
+}
+
+
+JobWorkerStats JobSystem::getWorkerStats(unsigned int workerIndex) const {
+
+	JobWorkerStats stats = {};
+
+	if (workerIndex >= workers.size())
+		return stats;
+
+	const Worker* worker = workers[workerIndex];
+	double elapsed = chrono::duration<double>(chrono::steady_clock::now() - statsResetTime).count();
+
+	stats.jobsExecuted = worker->jobsExecuted;
+	stats.jobsStolen = worker->jobsStolen;
+	stats.busyTime = (double)worker->busyNanoseconds * 1.0e-9;
+	stats.utilisation = (elapsed > 0.0) ? std::min<double>(stats.busyTime / elapsed, 1.0) : 0.0;
+
+	return stats;
+}
+
+
+void JobSystem::resetStats() {
+
+	for (auto worker : workers) {
+
+		worker->jobsExecuted = 0;
+		worker->jobsStolen = 0;
+		worker->busyNanoseconds = 0;
+	}
+
+	statsResetTime = chrono::steady_clock::now();
+}
+
+
+void JobSystem::reportStats(ostream& out) const {
+
+	for (unsigned int i = 0; i < (unsigned int)workers.size(); i++) {
+
+		JobWorkerStats stats = getWorkerStats(i);
+
+		out << "Job worker " << i << ": " << stats.jobsExecuted << " jobs (" << stats.jobsStolen << " stolen), busy " << stats.busyTime * 1000.0 << "ms, utilisation " << stats.utilisation * 100.0 << "%" << endl;
+	}
+}
+
+#pragma endregion
@@ -0,0 +1,143 @@
+#pragma once
+
+#include "core.h"
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+#include <deque>
+
+// Work-stealing job system shared by the texture loader, mip builder and image analysis code so parallel work from different subsystems does not oversubscribe the machine.  Each worker owns a Chase-Lev deque - jobs submitted from a worker are pushed onto its own deque and idle workers steal from the others.  Jobs submitted from non-worker threads go through a shared injection queue.  Completion is tracked with JobCounters - a counter is incremented for each job submitted against it and decremented as each job completes.  Jobs can be made dependent on a counter so they are only queued once that counter reaches zero.  Threads waiting on a counter execute other jobs while they wait
+
+class JobSystem;
+
+
+class JobCounter {
+
+	friend class JobSystem;
+
+	std::atomic<int>		value;
+	std::atomic<int>		completing; // workers still releasing continuations after decrementing value - the counter must outlive them
+
+	std::mutex				continuationMutex;
+	std::vector<std::pair<std::function<void()>, JobCounter*>> continuations; // jobs queued when value reaches zero
+
+public:
+
+	JobCounter() : value(0), completing(0) {}
+
+	JobCounter(const JobCounter&) = delete;
+	JobCounter& operator=(const JobCounter&) = delete;
+
+	// value is read first - the worker that takes it to zero has already registered in completing
+	bool isComplete() const { return value.load(std::memory_order_acquire) == 0 && completing.load(std::memory_order_acquire) == 0; }
+};
+
+
+// Per-worker statistics.  busyTime is the time spent executing jobs - utilisation is busyTime / (time since the statistics were last reset)
+struct JobWorkerStats {
+
+	unsigned long long		jobsExecuted;
+	unsigned long long		jobsStolen;
+	double					busyTime; // seconds
+	double					utilisation; // [0, 1]
+};
+
+
+class JobSystem {
+
+	struct Job {
+
+		std::function<void()>	function;
+		JobCounter*				counter;
+	};
+
+	// Fixed capacity Chase-Lev work-stealing deque.  push and pop are called by the owning worker only, steal by any thread
+	class WorkStealingDeque {
+
+		static const int64_t	capacity = 4096;
+
+		std::atomic<Job*>		buffer[capacity];
+
+		alignas(64) std::atomic<int64_t>	top;
+		alignas(64) std::atomic<int64_t>	bottom;
+
+	public:
+
+		WorkStealingDeque();
+
+		bool push(Job* job);
+		Job* pop();
+		Job* steal();
+	};
+
+	struct Worker {
+
+		WorkStealingDeque		deque;
+		std::thread				thread;
+
+		std::atomic<unsigned long long>	jobsExecuted;
+		std::atomic<unsigned long long>	jobsStolen;
+		std::atomic<unsigned long long>	busyNanoseconds;
+	};
+
+	std::vector<Worker*>		workers;
+
+	std::mutex					injectionMutex;
+	std::deque<Job*>			injectionQueue; // FIFO - popped from the front
+
+	std::mutex					sleepMutex;
+	std::condition_variable		sleepCondition;
+	std::atomic<int>			pendingJobs; // jobs queued but not yet started - used to put idle workers to sleep
+	std::atomic<bool>			stopping;
+
+	std::chrono::steady_clock::time_point	statsResetTime;
+
+	static JobSystem*			globalInstance;
+
+	//
+	// Private API
+	//
+
+	void workerMain(int workerIndex);
+
+	void enqueue(Job* job);
+	Job* findJob(int workerIndex);
+	void execute(Job* job, int workerIndex);
+	void completeJob(JobCounter* counter);
+
+public:
+
+	static const unsigned int	AUTO_WORKERS = ~0u;
+
+	// Create a job system with numWorkers worker threads.  If numWorkers = AUTO_WORKERS one worker is created per hardware thread, less one for the submitting thread (which helps execute jobs while it waits).  With no workers every job is executed by the thread waiting on it
+	JobSystem(unsigned int numWorkers = AUTO_WORKERS);
+	~JobSystem();
+
+	JobSystem(const JobSystem&) = delete;
+	JobSystem& operator=(const JobSystem&) = delete;
+
+	// Shared instance used by subsystems that do not own a job system (created on first use)
+	static JobSystem& global();
+
+	unsigned int getNumWorkers() const;
+
+	// Queue function for execution.  If counter is not nullptr it is incremented now and decremented once the job completes
+	void submit(std::function<void()> function, JobCounter* counter = nullptr);
+
+	// Queue function for execution once dependency reaches zero.  counter is incremented immediately so waiting on it covers the deferred job
+	void submitAfter(JobCounter& dependency, std::function<void()> function, JobCounter* counter = nullptr);
+
+	// Block until counter reaches zero.  The calling thread executes queued jobs while it waits
+	void wait(JobCounter& counter);
+
+	// Split [begin, end) into chunks of at most grainSize elements and call function(chunkBegin, chunkEnd) for each chunk in parallel.  Return once all chunks have completed.  If grainSize = 0 the range is split into roughly 4 chunks per thread
+	void parallelFor(size_t begin, size_t end, size_t grainSize, const std::function<void(size_t, size_t)>& function);
+
+	// Per-worker statistics since the last call to resetStats
+	JobWorkerStats getWorkerStats(unsigned int workerIndex) const;
+	void resetStats();
+	void reportStats(std::ostream& out) const;
+};
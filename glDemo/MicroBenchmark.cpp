@@ -0,0 +1,629 @@
+
+#include "MicroBenchmark.h"
+#include "MipBuilder.h"
+#include "ImageMetrics.h"
+#include "JobSystem.h"
+#include "ViewFrustum.h"
+#include "ShaderSetup.h"
+#include "glm/gtx/euler_angles.hpp"
+#include <chrono>
+#include <map>
+#include <sstream>
+
+using namespace std;
+using namespace cst;
+
+
+// Each benchmark runs for at least MIN_ITERATIONS iterations and MIN_TIME milliseconds (up to MAX_ITERATIONS)
+static const int			MIN_ITERATIONS = 5;
+static const int			MAX_ITERATIONS = 1000;
+static const double			MIN_TIME = 250.0;
+
+static const size_t			NUM_FRUSTUM_OBJECTS = 100000;
+
+static const char*			shaderFiles[] = {
+
+	"Shaders\\basic_shader.vs.txt",
+	"Shaders\\basic_shader.fs.txt",
+	"Shaders\\basic_texture.vs.txt",
+	"Shaders\\basic_texture.fs.txt",
+	"Shaders\\multidraw_texture.vs.txt",
+	"Shaders\\multidraw_texture.fs.txt",
+	"Shaders\\sampler_feedback.fs.txt",
+	"Shaders\\streaming_road.vs.txt",
+	"Shaders\\text.vs.txt",
+	"Shaders\\text.fs.txt"
+};
+
+
+#pragma region Private API
+
+// Time fn once to warm up then over repeated iterations and return the iteration time statistics
+template <typename Fn>
+static FrameTimeStats timeIterations(Fn fn) {
+
+	fn();
+
+	vector<float> times;
+	double totalTime = 0.0;
+
+	while ((int)times.size() < MIN_ITERATIONS || (totalTime < MIN_TIME && (int)times.size() < MAX_ITERATIONS)) {
+
+		auto startTime = chrono::steady_clock::now();
+		fn();
+		double elapsed = chrono::duration<double, milli>(chrono::steady_clock::now() - startTime).count();
+
+		times.push_back((float)elapsed);
+		totalTime += elapsed;
+	}
+
+	return calculateFrameTimeStats(times);
+}
+
+
+// Run and report a benchmark unless it is excluded by the settings filter
+template <typename Fn>
+static void runBenchmark(const MicroBenchmarkSettings& settings, vector<MicroBenchmarkResult>& results, const string& name, GLuint size, GLuint threads, double work, const char* unit, Fn fn) {
+
+	if (!settings.filter.empty() && name.find(settings.filter) == string::npos)
+		return;
+
+	MicroBenchmarkResult result = { name, size, threads, work, unit, timeIterations(fn) };
+
+	printf("  %-26s %6u %3u  median %9.3f ms, p95 %9.3f ms  %10.2f %s/s\n", name.c_str(), size, threads, result.stats.median, result.stats.p95, work / (result.stats.median / 1000.0), unit);
+
+	results.push_back(result);
+}
+
+
+// Return a size x size 24 bit test image - smooth gradients with noise so the image is neither trivially compressible nor pure noise
+static FIBITMAP* createTestImage(GLuint size) {
+
+	FIBITMAP* bitmap = FreeImage_Allocate(size, size, 24);
+
+	if (!bitmap)
+		return nullptr;
+
+	mt19937 rng(size);
+	uniform_int_distribution<int> noise(-16, 16);
+
+	for (GLuint y = 0; y < size; y++) {
+
+		BYTE* row = FreeImage_GetScanLine(bitmap, y);
+
+		for (GLuint x = 0; x < size; x++) {
+
+			row[x * 3 + 0] = (BYTE)glm::clamp<int>((x * 255) / size + noise(rng), 0, 255);
+			row[x * 3 + 1] = (BYTE)glm::clamp<int>((y * 255) / size + noise(rng), 0, 255);
+			row[x * 3 + 2] = (BYTE)glm::clamp<int>(((x + y) * 127) / size + noise(rng), 0, 255);
+		}
+	}
+
+	return bitmap;
+}
+
+
+// Flip bitmap vertically in place by swapping rows through a temporary row
+static void flipRowSwap(FIBITMAP* bitmap, vector<BYTE>& tempRow) {
+
+	unsigned pitch = FreeImage_GetPitch(bitmap);
+	unsigned height = FreeImage_GetHeight(bitmap);
+	BYTE* bits = FreeImage_GetBits(bitmap);
+
+	tempRow.resize(pitch);
+
+	for (unsigned y = 0; y < height / 2; y++) {
+
+		BYTE* top = bits + (size_t)y * pitch;
+		BYTE* bottom = bits + (size_t)(height - 1 - y) * pitch;
+
+		memcpy(tempRow.data(), top, pitch);
+		memcpy(top, bottom, pitch);
+		memcpy(bottom, tempRow.data(), pitch);
+	}
+}
+
+
+// Copy bitmap into dst with the rows in reverse order (flipping while copying the image out of the bitmap, as an upload staging copy would)
+static void flipCopy(FIBITMAP* bitmap, vector<BYTE>& dst) {
+
+	unsigned pitch = FreeImage_GetPitch(bitmap);
+	unsigned height = FreeImage_GetHeight(bitmap);
+	const BYTE* bits = FreeImage_GetBits(bitmap);
+
+	dst.resize((size_t)pitch * height);
+
+	for (unsigned y = 0; y < height; y++)
+		memcpy(&dst[(size_t)(height - 1 - y) * pitch], bits + (size_t)y * pitch, pitch);
+}
+
+
+// Image decode, conversion, flip, mip and sRGB benchmarks for one image size.  Return false if a custom flip or the sRGB round trip gives a different result to the reference
+static bool benchmarkImageKernels(const MicroBenchmarkSettings& settings, vector<MicroBenchmarkResult>& results, GLuint size) {
+
+	FIBITMAP* bitmap24 = createTestImage(size);
+	FIBITMAP* bitmap32 = (bitmap24) ? FreeImage_ConvertTo32Bits(bitmap24) : nullptr;
+
+	if (!bitmap32) {
+
+		cout << "Cannot create " << size << " x " << size << " test image" << endl;
+		FreeImage_Unload(bitmap24);
+		return false;
+	}
+
+	bool passed = true;
+	double rgbMB = double(size) * size * 3 / 1.0e6;
+	double rgbaMB = double(size) * size * 4 / 1.0e6;
+
+	// Decode (BMP is the format of the viewer's road texture, PNG the format of the sprite assets)
+	const FREE_IMAGE_FORMAT formats[] = { FIF_BMP, FIF_PNG };
+	const char* formatNames[] = { "decode/bmp", "decode/png" };
+
+	for (int i = 0; i < 2; i++) {
+
+		FIMEMORY* memory = FreeImage_OpenMemory();
+
+		if (FreeImage_SaveToMemory(formats[i], bitmap24, memory)) {
+
+			runBenchmark(settings, results, formatNames[i], size, 1, rgbMB, "MB", [&]() {
+
+				FreeImage_SeekMemory(memory, 0, SEEK_SET);
+				FreeImage_Unload(FreeImage_LoadFromMemory(formats[i], memory));
+			});
+		}
+
+		FreeImage_CloseMemory(memory);
+	}
+
+	// Conversion to 32 bits
+	runBenchmark(settings, results, "convert/24to32", size, 1, rgbaMB, "MB", [&]() {
+
+		FreeImage_Unload(FreeImage_ConvertTo32Bits(bitmap24));
+	});
+
+	// Vertical flips.  The custom flips are checked against FreeImage_FlipVertical first
+	vector<BYTE> tempRow, flipped;
+
+	{
+		FIBITMAP* reference = FreeImage_Clone(bitmap32);
+		FIBITMAP* swapped = FreeImage_Clone(bitmap32);
+
+		FreeImage_FlipVertical(reference);
+		flipRowSwap(swapped, tempRow);
+		flipCopy(bitmap32, flipped);
+
+		size_t imageBytes = (size_t)FreeImage_GetPitch(bitmap32) * size;
+
+		if (memcmp(FreeImage_GetBits(reference), FreeImage_GetBits(swapped), imageBytes) != 0 || memcmp(FreeImage_GetBits(reference), flipped.data(), imageBytes) != 0) {
+
+			cout << "  flip: custom flip does not match FreeImage_FlipVertical (" << size << " x " << size << ") MISMATCH" << endl;
+			passed = false;
+		}
+
+		FreeImage_Unload(reference);
+		FreeImage_Unload(swapped);
+	}
+
+	runBenchmark(settings, results, "flip/freeimage", size, 1, rgbaMB, "MB", [&]() { FreeImage_FlipVertical(bitmap32); });
+	runBenchmark(settings, results, "flip/rowswap", size, 1, rgbaMB, "MB", [&]() { flipRowSwap(bitmap32, tempRow); });
+	runBenchmark(settings, results, "flip/copy", size, 1, rgbaMB, "MB", [&]() { flipCopy(bitmap32, flipped); });
+
+	// Mip chain generation for each thread count (the job system workers plus the submitting thread)
+	const GLubyte* basePixels = FreeImage_GetBits(bitmap32);
+	vector<MipLevel> levels;
+
+	for (GLuint threads : settings.threadCounts) {
+
+		JobSystem jobSystem(threads - 1);
+
+		runBenchmark(settings, results, "mip/linear", size, threads, rgbaMB, "MB", [&]() { buildMipChain(basePixels, size, size, false, levels, &jobSystem); });
+		runBenchmark(settings, results, "mip/srgb", size, threads, rgbaMB, "MB", [&]() { buildMipChain(basePixels, size, size, true, levels, &jobSystem); });
+	}
+
+	// Image comparison for each thread count.  The parallel reduction is checked against a serial sum first, using the error linear filtering introduces into the first sRGB mip level (also reported)
+	if (size >= 2) {
+
+		vector<MipLevel> linearLevels, srgbLevels;
+
+		buildMipChain(basePixels, size, size, false, linearLevels);
+		buildMipChain(basePixels, size, size, true, srgbLevels);
+
+		const GLubyte* linearPixels = linearLevels[0].pixels.data();
+		const GLubyte* srgbPixels = srgbLevels[0].pixels.data();
+		GLuint levelSize = linearLevels[0].width * linearLevels[0].height;
+
+		unsigned long long sumSq = 0;
+
+		for (size_t i = 0; i < (size_t)levelSize * 4; i++) {
+
+			if ((i & 3) != 3)
+				sumSq += (unsigned long long)((int(linearPixels[i]) - int(srgbPixels[i])) * (int(linearPixels[i]) - int(srgbPixels[i])));
+		}
+
+		double serialMSE = (double)sumSq / ((double)levelSize * 3.0);
+		ImageErrorStats error = compareImages(linearPixels, srgbPixels, linearLevels[0].width, linearLevels[0].height);
+		ImageErrorStats identical = compareImages(basePixels, basePixels, size, size);
+
+		if (fabs(error.mseRGB - serialMSE) > 1.0e-9 * std::max(serialMSE, 1.0) || identical.maxAbsError != 0 || identical.mseRGB != 0.0) {
+
+			cout << "  metrics: parallel comparison gives MSE " << error.mseRGB << ", serial " << serialMSE << " (" << size << " x " << size << ") MISMATCH" << endl;
+			passed = false;
+		}
+
+		cout << "  metrics: linear vs sRGB mip level 1 (" << size << " x " << size << ") PSNR " << error.psnrRGB << " dB, max error " << error.maxAbsError << endl;
+
+		for (GLuint threads : settings.threadCounts) {
+
+			JobSystem jobSystem(threads - 1);
+
+			runBenchmark(settings, results, "metrics/compare", size, threads, rgbaMB, "MB", [&]() { error = compareImages(basePixels, basePixels, size, size, &jobSystem); });
+		}
+	}
+
+	// sRGB decode (table lookup) and encode of the colour channels
+	size_t numValues = (size_t)size * size * 3;
+	const BYTE* srgbValues = FreeImage_GetBits(bitmap24);
+	vector<float> linearValues(numValues);
+	vector<GLubyte> encodedValues(numValues);
+
+	for (int i = 0; i < 256; i++) {
+
+		if (linearToSRGB(srgbToLinear((GLubyte)i)) != i) {
+
+			cout << "  srgb: round trip of " << i << " gives " << (int)linearToSRGB(srgbToLinear((GLubyte)i)) << " MISMATCH" << endl;
+			passed = false;
+			break;
+		}
+	}
+
+	runBenchmark(settings, results, "srgb/decode", size, 1, rgbMB, "MB", [&]() {
+
+		for (size_t i = 0; i < numValues; i++)
+			linearValues[i] = srgbToLinear(srgbValues[i]);
+	});
+
+	runBenchmark(settings, results, "srgb/encode", size, 1, rgbMB, "MB", [&]() {
+
+		for (size_t i = 0; i < numValues; i++)
+			encodedValues[i] = linearToSRGB(linearValues[i]);
+	});
+
+	FreeImage_Unload(bitmap32);
+	FreeImage_Unload(bitmap24);
+
+	return passed;
+}
+
+
+// Block compression is done by the driver when an image is uploaded with a compressed internal format (GL_COMPRESSED_SRGB for the viewer's point filtered road), so upload each image size uncompressed and compressed in a hidden window.  Skipped if no GL context can be created
+static void benchmarkBlockCompression(const MicroBenchmarkSettings& settings, vector<MicroBenchmarkResult>& results) {
+
+	if (!glfwInit()) {
+
+		cout << "  compress: cannot initialise GLFW - skipped" << endl;
+		return;
+	}
+
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+	GLFWwindow* window = glfwCreateWindow(64, 64, "Microbenchmark", NULL, NULL);
+
+	if (!window) {
+
+		cout << "  compress: cannot create a GL context - skipped" << endl;
+		glfwTerminate();
+		return;
+	}
+
+	glfwMakeContextCurrent(window);
+	glewInit();
+
+	struct UploadFormat {
+
+		const char*		name;
+		GLenum			internalFormat;
+		bool			supported;
+	};
+
+	const UploadFormat formats[] = {
+
+		{ "upload/srgb8_alpha8", GL_SRGB8_ALPHA8, true },
+		{ "compress/generic_srgb", GL_COMPRESSED_SRGB, true },
+		{ "compress/dxt1_srgb", GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT, GLEW_EXT_texture_compression_s3tc && GLEW_EXT_texture_sRGB }
+	};
+
+	GLuint texture = 0;
+
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_2D, texture);
+
+	for (GLuint size : settings.imageSizes) {
+
+		FIBITMAP* bitmap24 = createTestImage(size);
+		FIBITMAP* bitmap32 = (bitmap24) ? FreeImage_ConvertTo32Bits(bitmap24) : nullptr;
+
+		if (bitmap32) {
+
+			const BYTE* pixels = FreeImage_GetBits(bitmap32);
+
+			for (const UploadFormat& format : formats) {
+
+				if (!format.supported)
+					continue;
+
+				runBenchmark(settings, results, format.name, size, 1, double(size) * size * 4 / 1.0e6, "MB", [&]() {
+
+					glTexImage2D(GL_TEXTURE_2D, 0, format.internalFormat, size, size, 0, GL_BGRA, GL_UNSIGNED_BYTE, pixels);
+					glFinish();
+				});
+
+				GLint compressed = GL_FALSE;
+
+				glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_COMPRESSED, &compressed);
+
+				if (format.internalFormat != GL_SRGB8_ALPHA8 && !compressed)
+					cout << "    (" << format.name << ": the driver stored the image uncompressed)" << endl;
+			}
+		}
+
+		FreeImage_Unload(bitmap32);
+		FreeImage_Unload(bitmap24);
+	}
+
+	glDeleteTextures(1, &texture);
+
+	glfwDestroyWindow(window);
+	glfwTerminate();
+}
+
+
+// ViewFrustum sphere and AABB tests - scalar per-object tests and the batch culling path
+static void benchmarkFrustum(const MicroBenchmarkSettings& settings, vector<MicroBenchmarkResult>& results) {
+
+	size_t numObjects = NUM_FRUSTUM_OBJECTS;
+	double work = double(numObjects) / 1.0e6;
+
+	mt19937 rng(1);
+	uniform_real_distribution<float> position(-500.0f, 500.0f);
+	uniform_real_distribution<float> size(0.5f, 5.0f);
+
+	vector<float> centre[3], extent[3], radius(numObjects);
+
+	for (int c = 0; c < 3; c++) {
+
+		centre[c].resize(numObjects);
+		extent[c].resize(numObjects);
+	}
+
+	for (size_t i = 0; i < numObjects; i++) {
+
+		for (int c = 0; c < 3; c++) {
+
+			centre[c][i] = position(rng);
+			extent[c][i] = size(rng);
+		}
+
+		radius[i] = glm::length(glm::vec3(extent[0][i], extent[1][i], extent[2][i]));
+	}
+
+	ViewFrustum frustum(55.0f, 16.0f / 9.0f, 0.1f, 300.0f);
+	frustum.calculateWorldCoordPlanes(glm::vec4(0.0f, 0.0f, 0.0f, 1.0f), glm::eulerAngleY(glm::radians(30.0f)) * glm::eulerAngleX(glm::radians(-20.0f)));
+
+	vector<uint32_t> mask((numObjects + 31) / 32);
+	volatile size_t visible = 0;
+
+	runBenchmark(settings, results, "frustum/sphere_scalar", 0, 1, work, "Mobjects", [&]() {
+
+		size_t count = 0;
+
+		for (size_t i = 0; i < numObjects; i++)
+			count += frustum.sphereInFrustum(glm::vec3(centre[0][i], centre[1][i], centre[2][i]), radius[i]) ? 1 : 0;
+
+		visible = count;
+	});
+
+	runBenchmark(settings, results, "frustum/sphere_batch", 0, 1, work, "Mobjects", [&]() {
+
+		visible = frustum.cullSpheres(centre[0].data(), centre[1].data(), centre[2].data(), radius.data(), numObjects, mask.data());
+	});
+
+	runBenchmark(settings, results, "frustum/aabb_scalar", 0, 1, work, "Mobjects", [&]() {
+
+		size_t count = 0;
+
+		for (size_t i = 0; i < numObjects; i++)
+			count += frustum.aabbInFrustum(glm::vec3(centre[0][i], centre[1][i], centre[2][i]), glm::vec3(extent[0][i], extent[1][i], extent[2][i])) ? 1 : 0;
+
+		visible = count;
+	});
+
+	runBenchmark(settings, results, "frustum/aabb_batch", 0, 1, work, "Mobjects", [&]() {
+
+		visible = frustum.cullAABBs(centre[0].data(), centre[1].data(), centre[2].data(), extent[0].data(), extent[1].data(), extent[2].data(), numObjects, mask.data());
+	});
+}
+
+
+// Read every viewer shader source with the loader used by setupShaders.  Skipped if the shaders are not found (the benchmark must be run from the project directory)
+static void benchmarkShaderReading(const MicroBenchmarkSettings& settings, vector<MicroBenchmarkResult>& results) {
+
+	const size_t numFiles = sizeof(shaderFiles) / sizeof(shaderFiles[0]);
+
+	for (size_t i = 0; i < numFiles; i++) {
+
+		const string* source = shaderSourceStringFromFile(shaderFiles[i]);
+
+		if (!source) {
+
+			cout << "  shader/read: cannot read " << shaderFiles[i] << " - skipped" << endl;
+			return;
+		}
+
+		delete source;
+	}
+
+	runBenchmark(settings, results, "shader/read", 0, 1, double(numFiles), "files", [&]() {
+
+		for (size_t i = 0; i < numFiles; i++)
+			delete shaderSourceStringFromFile(shaderFiles[i]);
+	});
+}
+
+
+static string resultKey(const string& name, GLuint size, GLuint threads) {
+
+	return name + "/" + to_string(size) + "/" + to_string(threads);
+}
+
+
+// Return the value of "key" in a single line JSON object written by writeResults (quotes removed)
+static string jsonField(const string& line, const string& key) {
+
+	size_t start = line.find("\"" + key + "\": ");
+
+	if (start == string::npos)
+		return string();
+
+	start += key.length() + 4;
+
+	if (start < line.length() && line[start] == '\"') {
+
+		size_t end = line.find('\"', start + 1);
+
+		return (end == string::npos) ? string() : line.substr(start + 1, end - start - 1);
+	}
+
+	return line.substr(start, line.find_first_of(",}", start) - start);
+}
+
+
+static bool writeResults(const vector<MicroBenchmarkResult>& results, const MicroBenchmarkSettings& settings) {
+
+	ofstream file(settings.outputFilename);
+
+	if (!file.is_open()) {
+
+		cout << "Cannot write benchmark results to " << settings.outputFilename << endl;
+		return false;
+	}
+
+	file << "{" << endl;
+	file << "  \"build\": \"" << buildHash() << "\"," << endl;
+	file << "  \"results\": [";
+
+	for (size_t i = 0; i < results.size(); i++) {
+
+		const MicroBenchmarkResult& result = results[i];
+
+		file << ((i > 0) ? "," : "") << endl << "    { \"name\": \"" << result.name << "\", \"size\": " << result.size << ", \"threads\": " << result.threads << ", \"iterations\": " << result.stats.frames
+			<< ", \"median_ms\": " << result.stats.median << ", \"p95_ms\": " << result.stats.p95 << ", \"min_ms\": " << result.stats.minimum
+			<< ", \"throughput\": " << result.work / (result.stats.median / 1000.0) << ", \"unit\": \"" << result.unit << "/s\" }";
+	}
+
+	file << endl << "  ]" << endl << "}" << endl;
+
+	cout << "Benchmark results written to " << settings.outputFilename << endl;
+
+	return true;
+}
+
+
+static bool compareBaseline(const vector<MicroBenchmarkResult>& results, const MicroBenchmarkSettings& settings) {
+
+	ifstream file(settings.baselineFilename);
+
+	if (!file.is_open()) {
+
+		cout << "Cannot read benchmark baseline " << settings.baselineFilename << endl;
+		return false;
+	}
+
+	map<string, double> baseline;
+	string baselineBuild;
+	string line;
+
+	while (getline(file, line)) {
+
+		if (line.find("\"build\"") != string::npos)
+			baselineBuild = jsonField(line, "build");
+
+		string name = jsonField(line, "name");
+
+		if (!name.empty())
+			baseline[resultKey(name, (GLuint)atoi(jsonField(line, "size").c_str()), (GLuint)atoi(jsonField(line, "threads").c_str()))] = atof(jsonField(line, "median_ms").c_str());
+	}
+
+	cout << "Comparison with baseline " << settings.baselineFilename << " (build " << baselineBuild << "), regression threshold " << settings.regressionThreshold * 100.0 << "%" << endl;
+
+	bool passed = true;
+
+	for (const MicroBenchmarkResult& result : results) {
+
+		auto it = baseline.find(resultKey(result.name, result.size, result.threads));
+
+		if (it == baseline.end() || it->second <= 0.0)
+			continue;
+
+		double change = (result.stats.median - it->second) / it->second;
+		bool regressed = change > settings.regressionThreshold;
+
+		if (regressed)
+			passed = false;
+
+		printf("  %-26s %6u %3u  median %9.3f ms, baseline %9.3f ms (%+6.1f%%)%s\n", result.name.c_str(), result.size, result.threads, result.stats.median, it->second, change * 100.0, (regressed) ? "  REGRESSION" : "");
+	}
+
+	return passed;
+}
+
+#pragma endregion
+
+
+#pragma region Public API
+
+vector<GLuint> parseUintList(const char* list) {
+
+	vector<GLuint> values;
+	stringstream listStream(list);
+	string item;
+
+	while (getline(listStream, item, ',')) {
+
+		GLuint value = (GLuint)strtoul(item.c_str(), nullptr, 10);
+
+		if (value > 0)
+			values.push_back(value);
+	}
+
+	return values;
+}
+
+
+bool runMicroBenchmarks(const MicroBenchmarkSettings& settings) {
+
+	vector<MicroBenchmarkResult> results;
+	bool passed = true;
+
+	cout << "Microbenchmarks (build " << buildHash() << ")" << endl;
+	printf("  %-26s %6s %3s\n", "benchmark", "size", "thr");
+
+	for (GLuint size : settings.imageSizes)
+		passed = benchmarkImageKernels(settings, results, size) && passed;
+
+	benchmarkBlockCompression(settings, results);
+	benchmarkFrustum(settings, results);
+	benchmarkShaderReading(settings, results);
+
+	if (!writeResults(results, settings))
+		return false;
+
+	if (!settings.baselineFilename.empty() && !compareBaseline(results, settings)) {
+
+		cout << "Microbenchmarks FAILED against baseline " << settings.baselineFilename << endl;
+		return false;
+	}
+
+	return passed;
+}
+
+#pragma endregion
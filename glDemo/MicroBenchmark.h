@@ -0,0 +1,34 @@
+#pragma once
+
+#include "core.h"
+#include "FlythroughBenchmark.h"
+
+// Microbenchmarks for the CPU hot paths of texture loading and scene setup - image decode and 24 -> 32 bit conversion (the two steps of fiLoadTexture's decode), FreeImage_FlipVertical against custom row flips, CPU mip chain generation (linear and sRGB) and image comparison (ImageMetrics, also reporting the error linear filtering adds to an sRGB mip level) for each thread count, sRGB encode / decode, driver block compression of uploaded images, ViewFrustum sphere and AABB tests and shader source file reading.  Image benchmarks are run for each image size.  Each benchmark is run once to warm up, then repeatedly until both a minimum number of iterations and a minimum time are reached - the median iteration time is reported.  Results are written as JSON (one benchmark per line, tagged with the build hash) so runs from different commits can be compared, and can be checked against the JSON of a previous run to flag regressions.  Run from the command line with -microbench file.json
+
+struct MicroBenchmarkSettings {
+
+	std::vector<GLuint>	imageSizes; // square image sizes
+	std::vector<GLuint>	threadCounts; // total threads (job system workers + the submitting thread) for the parallel benchmarks
+	std::string			outputFilename;
+	std::string			baselineFilename; // JSON of a previous run to compare against (empty for no comparison)
+	double				regressionThreshold; // relative increase in median time reported as a regression
+	std::string			filter; // only run benchmarks whose name contains filter (empty to run all)
+};
+
+
+struct MicroBenchmarkResult {
+
+	std::string		name;
+	GLuint			size; // image size (0 if not an image benchmark)
+	GLuint			threads;
+	double			work; // amount of work per iteration in units of unit
+	const char*		unit; // "MB", "Mobjects" or "files"
+	FrameTimeStats	stats; // iteration times (milliseconds)
+};
+
+
+// Parse a comma separated list of positive integers ("256,1024,4096").  Invalid entries are skipped
+std::vector<GLuint> parseUintList(const char* list);
+
+// Run the benchmarks, write the results to settings.outputFilename and compare them with the baseline if given.  Return false if a benchmark fails its correctness check, the results cannot be written or a regression is found
+bool runMicroBenchmarks(const MicroBenchmarkSettings& settings);
@@ -0,0 +1,171 @@
+
+#include "MipBuilder.h"
+#include "CPUProfiler.h"
+#include "JobSystem.h"
+
+using namespace std;
+
+
+#pragma region sRGB conversion
+
+// Return the 8 bit sRGB -> linear lookup table (built on first use - initialisation of the local static is thread safe)
+static const float* srgbToLinearTable() {
+
+	static float table[256];
+
+	static bool initialised = []() {
+
+		for (int i = 0; i < 256; i++) {
+
+			float c = float(i) / 255.0f;
+
+			table[i] = (c <= 0.04045f) ? c / 12.92f : powf((c + 0.055f) / 1.055f, 2.4f);
+		}
+
+		return true;
+	}();
+
+	(void)initialised;
+
+	return table;
+}
+
+
+float srgbToLinear(GLubyte c) {
+
+	return srgbToLinearTable()[c];
+}
+
+
+GLubyte linearToSRGB(float c) {
+
+	c = glm::clamp(c, 0.0f, 1.0f);
+
+	float s = (c <= 0.0031308f) ? c * 12.92f : 1.055f * powf(c, 1.0f / 2.4f) - 0.055f;
+
+	return GLubyte(s * 255.0f + 0.5f);
+}
+
+#pragma endregion
+
+
+// Filter rows [firstRow, lastRow) of dst from src
+static void filterRows(const MipLevel& src, MipLevel& dst, GLuint firstRow, GLuint lastRow, bool sRGB) {
+
+	const float* toLinear = srgbToLinearTable();
+
+	for (GLuint y = firstRow; y < lastRow; y++) {
+
+		GLuint y0 = std::min(y * 2, src.height - 1);
+		GLuint y1 = std::min(y * 2 + 1, src.height - 1);
+
+		const GLubyte* row0 = &src.pixels[y0 * src.width * 4];
+		const GLubyte* row1 = &src.pixels[y1 * src.width * 4];
+		GLubyte* out = &dst.pixels[y * dst.width * 4];
+
+		for (GLuint x = 0; x < dst.width; x++) {
+
+			GLuint x0 = std::min(x * 2, src.width - 1) * 4;
+			GLuint x1 = std::min(x * 2 + 1, src.width - 1) * 4;
+
+			for (int c = 0; c < 3; c++) {
+
+				if (sRGB) {
+
+					float sum = toLinear[row0[x0 + c]] + toLinear[row0[x1 + c]] + toLinear[row1[x0 + c]] + toLinear[row1[x1 + c]];
+
+					out[x * 4 + c] = linearToSRGB(sum * 0.25f);
+				}
+				else {
+
+					out[x * 4 + c] = GLubyte((row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c] + 2) >> 2);
+				}
+			}
+
+			out[x * 4 + 3] = GLubyte((row0[x0 + 3] + row0[x1 + 3] + row1[x0 + 3] + row1[x1 + 3] + 2) >> 2);
+		}
+	}
+}
+
+
+GLuint mipLevelCount(GLuint width, GLuint height) {
+
+	GLuint levels = 1;
+
+	while (width > 1 || height > 1) {
+
+		width = std::max<GLuint>(width / 2, 1);
+		height = std::max<GLuint>(height / 2, 1);
+		levels++;
+	}
+
+	return levels;
+}
+
+
+bool isSRGBFormat(GLint internalFormat) {
+
+	switch (internalFormat) {
+
+	case GL_SRGB:
+	case GL_SRGB8:
+	case GL_SRGB_ALPHA:
+	case GL_SRGB8_ALPHA8:
+	case GL_COMPRESSED_SRGB:
+	case GL_COMPRESSED_SRGB_ALPHA:
+	case GL_COMPRESSED_SRGB_S3TC_DXT1_EXT:
+	case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT:
+	case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT:
+	case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT:
+		return true;
+
+	default:
+		return false;
+	}
+}
+
+
+void buildMipChain(const GLubyte* basePixels, GLuint width, GLuint height, bool sRGB, vector<MipLevel>& levels, JobSystem* jobSystem) {
+
+	CPU_PROFILE_FUNCTION();
+
+	levels.clear();
+
+	if (!basePixels || width == 0 || height == 0)
+		return;
+
+	if (!jobSystem)
+		jobSystem = &JobSystem::global();
+
+	GLuint numLevels = mipLevelCount(width, height);
+
+	levels.resize(numLevels - 1);
+
+	// Wrap the base image so every level is filtered the same way.  The base pixels are copied once - this is small compared to the filtering cost
+	MipLevel base;
+
+	base.width = width;
+	base.height = height;
+	base.pixels.assign(basePixels, basePixels + size_t(width) * height * 4);
+
+	const MipLevel* src = &base;
+
+	for (GLuint i = 0; i < numLevels - 1; i++) {
+
+		MipLevel& dst = levels[i];
+
+		dst.width = std::max<GLuint>(src->width / 2, 1);
+		dst.height = std::max<GLuint>(src->height / 2, 1);
+		dst.pixels.resize(size_t(dst.width) * dst.height * 4);
+
+		// Aim for roughly 64K texels per job so small levels are not split
+		size_t grainSize = std::max<size_t>(1, 65536 / dst.width);
+
+		jobSystem->parallelFor(0, dst.height, grainSize, [src, &dst, sRGB](size_t firstRow, size_t lastRow) {
+
+			filterRows(*src, dst, (GLuint)firstRow, (GLuint)lastRow, sRGB);
+		});
+
+		src = &dst;
+	}
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "core.h"
+
+class JobSystem;
+
+// CPU mipmap generation for 32 bit (BGRA / RGBA) images.  Each level is a 2x2 box filter of the previous level (odd dimensions clamp to the last row / column).  If sRGB is true the colour channels are converted to linear space before averaging and back afterwards so darker texels are not over-weighted - alpha is always averaged linearly.  Rows of each level are filtered in parallel on the given job system
+
+struct MipLevel {
+
+	GLuint					width;
+	GLuint					height;
+	std::vector<GLubyte>	pixels; // width * height * 4 bytes
+};
+
+
+// Return the number of levels in a full mip chain for a width x height image, including the base level
+GLuint mipLevelCount(GLuint width, GLuint height);
+
+// Convert an 8 bit sRGB value to linear [0, 1] (table lookup) and a linear value to 8 bit sRGB (rounded)
+float srgbToLinear(GLubyte c);
+GLubyte linearToSRGB(float c);
+
+// Return true if internalFormat stores colour in sRGB space
+bool isSRGBFormat(GLint internalFormat);
+
+// Build levels 1..n of the mip chain for the given base image.  levels is cleared and level i-1 of the output holds mip level i.  If jobSystem is nullptr the global job system is used
+void buildMipChain(const GLubyte* basePixels, GLuint width, GLuint height, bool sRGB, std::vector<MipLevel>& levels, JobSystem* jobSystem = nullptr);
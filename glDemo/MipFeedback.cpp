@@ -0,0 +1,159 @@
+
+#include "MipFeedback.h"
+#include "SelfTest.h"
+
+
+using namespace std;
+
+
+#pragma region Reduction
+
+GLuint encodeFeedbackLOD(float lod) {
+
+	const float maxLOD = 31.0f;
+
+	lod = glm::clamp<float>(lod, 0.0f, maxLOD);
+
+	return (GLuint)(lod * float(1 << FEEDBACK_LOD_FRACTION_BITS));
+}
+
+
+float decodeFeedbackLOD(GLuint value) {
+
+	return float(value) / float(1 << FEEDBACK_LOD_FRACTION_BITS);
+}
+
+
+GLint reduceMinMip(const GLuint* tiles, size_t count, GLuint numLevels) {
+
+	GLuint minValue = FEEDBACK_NOT_SAMPLED;
+
+	for (size_t i = 0; i < count; i++)
+		minValue = std::min<GLuint>(minValue, tiles[i]);
+
+	if (minValue == FEEDBACK_NOT_SAMPLED || numLevels == 0)
+		return MIP_NOT_NEEDED;
+
+	GLint level = (GLint)(minValue >> FEEDBACK_LOD_FRACTION_BITS);
+
+	return std::min<GLint>(level, (GLint)numLevels - 1);
+}
+
+#pragma endregion
+
+
+#pragma region Residency
+
+void initMipResidency(MipResidency& residency, GLuint numLevels) {
+
+	residency.numLevels = numLevels;
+	residency.baseLevel = 0;
+	residency.framesOverResident = 0;
+	residency.windowMinNeeded = 0;
+}
+
+
+bool updateMipResidency(MipResidency& residency, GLint minMipNeeded, GLuint evictDelay) {
+
+	if (residency.numLevels == 0)
+		return false;
+
+	GLint coarsest = (GLint)residency.numLevels - 1;
+	GLint needed = (minMipNeeded == MIP_NOT_NEEDED) ? coarsest : glm::clamp<GLint>(minMipNeeded, 0, coarsest);
+	GLint previous = residency.baseLevel;
+
+	if (needed < residency.baseLevel) {
+
+		// Finer levels needed - make them resident immediately
+		residency.baseLevel = needed;
+		residency.framesOverResident = 0;
+	}
+	else if (needed > residency.baseLevel) {
+
+		// Finer levels than needed are resident - once this has been the case for evictDelay results evict the levels none of them needed
+		residency.windowMinNeeded = (residency.framesOverResident == 0) ? needed : std::min<GLint>(residency.windowMinNeeded, needed);
+		residency.framesOverResident++;
+
+		if (residency.framesOverResident >= evictDelay) {
+
+			residency.baseLevel = residency.windowMinNeeded;
+			residency.framesOverResident = 0;
+		}
+	}
+	else {
+
+		residency.framesOverResident = 0;
+	}
+
+	return residency.baseLevel != previous;
+}
+
+#pragma endregion
+
+
+#pragma region Self test
+
+bool runMipFeedbackSelfTest() {
+
+	int failures = 0;
+
+	cout << "Mip feedback self test" << endl;
+
+	// Encoding
+	selfTestCheck(encodeFeedbackLOD(-2.0f) == 0, "magnified LOD encodes as level 0", failures);
+	selfTestCheck(decodeFeedbackLOD(encodeFeedbackLOD(3.5f)) == 3.5f, "LOD round trips through encoding", failures);
+
+	// Reduction over a synthetic 16 x 12 tile screen
+	const GLuint numTiles = 16 * 12;
+	vector<GLuint> tiles(numTiles, FEEDBACK_NOT_SAMPLED);
+
+	selfTestCheck(reduceMinMip(tiles.data(), numTiles, 10) == MIP_NOT_NEEDED, "unsampled texture needs no level", failures);
+
+	// A receding surface - LOD increases towards the top of the screen, the nearest row samples level 2.7
+	for (GLuint y = 0; y < 12; y++) {
+
+		for (GLuint x = 0; x < 16; x++)
+			tiles[y * 16 + x] = encodeFeedbackLOD(2.7f + float(y) * 0.5f);
+	}
+
+	selfTestCheck(reduceMinMip(tiles.data(), numTiles, 10) == 2, "minimum over tiles rounds down to level 2", failures);
+	selfTestCheck(reduceMinMip(tiles.data(), numTiles, 2) == 1, "minimum is clamped to the coarsest level", failures);
+
+	tiles[100] = encodeFeedbackLOD(0.25f);
+	selfTestCheck(reduceMinMip(tiles.data(), numTiles, 10) == 0, "a single close tile needs level 0", failures);
+
+	// Residency
+	MipResidency residency;
+
+	initMipResidency(residency, 10);
+	selfTestCheck(residency.baseLevel == 0, "full chain resident initially", failures);
+
+	bool changed1 = updateMipResidency(residency, 3, 3);
+	bool changed2 = updateMipResidency(residency, 3, 3);
+	selfTestCheck(!changed1 && !changed2 && residency.baseLevel == 0, "eviction deferred until evictDelay results", failures);
+
+	bool changed = updateMipResidency(residency, 3, 3);
+	selfTestCheck(changed && residency.baseLevel == 3, "levels 0 - 2 evicted after evictDelay results", failures);
+
+	updateMipResidency(residency, 5, 3);
+	updateMipResidency(residency, 3, 3);
+	updateMipResidency(residency, 5, 3);
+	selfTestCheck(residency.baseLevel == 3, "alternating need does not evict", failures);
+
+	updateMipResidency(residency, 4, 3);
+	updateMipResidency(residency, 8, 3);
+	updateMipResidency(residency, 8, 3);
+	selfTestCheck(residency.baseLevel == 4, "eviction keeps the finest level needed over the delay", failures);
+
+	changed = updateMipResidency(residency, 1, 3);
+	selfTestCheck(changed && residency.baseLevel == 1, "finer level made resident immediately", failures);
+
+	for (int i = 0; i < 3; i++)
+		updateMipResidency(residency, MIP_NOT_NEEDED, 3);
+
+	selfTestCheck(residency.baseLevel == 9, "unsampled texture keeps only the coarsest level", failures);
+
+	return selfTestSummary(failures);
+}
+
+#pragma endregion
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "core.h"
+
+// CPU side of sampler feedback.  The feedback pass records, for each screen tile and texture, the finest level of detail any fragment in the tile wanted (see SamplerFeedback).  These functions decode that data, reduce it to the minimum mip level each texture needs and decide which levels should be resident.  They make no GL calls so they can be driven with synthetic feedback data
+
+// Tile value meaning no fragment in the tile sampled the texture
+static const GLuint		FEEDBACK_NOT_SAMPLED = 0xFFFFFFFF;
+
+// Returned by reduceMinMip when no tile sampled the texture
+static const GLint		MIP_NOT_NEEDED = -1;
+
+// Number of fractional bits used to store a level of detail in a feedback tile
+static const GLuint		FEEDBACK_LOD_FRACTION_BITS = 8;
+
+
+// Encode / decode a level of detail as stored in a feedback tile.  Negative (magnified) values are stored as 0
+GLuint encodeFeedbackLOD(float lod);
+float decodeFeedbackLOD(GLuint value);
+
+// Return the finest mip level needed by any of the count tiles, clamped to [0, numLevels - 1], or MIP_NOT_NEEDED if no tile sampled the texture.  The level is rounded down so a trilinear filter blending towards the finer level has it available
+GLint reduceMinMip(const GLuint* tiles, size_t count, GLuint numLevels);
+
+
+// Residency of a single texture's mip chain.  Levels [baseLevel, numLevels) are resident
+struct MipResidency {
+
+	GLuint		numLevels;
+	GLint		baseLevel;
+	GLuint		framesOverResident; // consecutive feedback results that needed a coarser level than baseLevel
+	GLint		windowMinNeeded; // finest level needed by those results
+};
+
+// Initialise residency with the full mip chain resident
+void initMipResidency(MipResidency& residency, GLuint numLevels);
+
+// Update residency from the minimum mip level reported by a feedback result (MIP_NOT_NEEDED if unsampled, in which case only the coarsest level is needed).  Finer levels are made resident as soon as they are needed.  Levels are only evicted once evictDelay consecutive results have not needed them, and then only down to the finest level any of those results needed, so a texture at a mip boundary (or a single coarse result) does not alternate between uploading and evicting.  Return true if baseLevel changed
+bool updateMipResidency(MipResidency& residency, GLint minMipNeeded, GLuint evictDelay);
+
+// Check the reduction and residency functions against synthetic feedback data and report the results to cout.  Return true if all checks pass
+bool runMipFeedbackSelfTest();
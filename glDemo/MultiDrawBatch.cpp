@@ -0,0 +1,454 @@
+
+#include "core.h"
+#include "MultiDrawBatch.h"
+#include "GLDebugOutput.h"
+#include "ShaderSetup.h"
+
+
+using namespace std;
+
+
+// Interleaved vertex layout for batched meshes - position (vec4), colour (vec4), texture coordinate (vec2)
+static const GLuint vertexStride = 10;
+
+
+//
+// Private API
+//
+
+void MultiDrawBatch::loadShader() {
+
+	shader = setupShaders(
+		string("Shaders\\multidraw_texture.vs.txt"),
+		string(""),
+		string("Shaders\\multidraw_texture.fs.txt")
+	);
+
+	viewProjectionLocation = glGetUniformLocation(shader, "viewProjectionMatrix");
+	textureArrayLocation = glGetUniformLocation(shader, "textureArray");
+}
+
+
+void MultiDrawBatch::setupBuffers() {
+
+	persistentMapping = (glewIsSupported("GL_ARB_buffer_storage") == GL_TRUE);
+
+	glGenVertexArrays(1, &vertexArrayObj);
+	glBindVertexArray(vertexArrayObj);
+
+	// Mesh vertex and index buffers - data is uploaded once meshes have been added
+	glGenBuffers(1, &meshVertexBuffer);
+	glBindBuffer(GL_ARRAY_BUFFER, meshVertexBuffer);
+
+	glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, vertexStride * sizeof(float), (const GLvoid*)0);
+	glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, vertexStride * sizeof(float), (const GLvoid*)(4 * sizeof(float)));
+	glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, vertexStride * sizeof(float), (const GLvoid*)(8 * sizeof(float)));
+
+	glEnableVertexAttribArray(0);
+	glEnableVertexAttribArray(1);
+	glEnableVertexAttribArray(3);
+
+	glGenBuffers(1, &meshIndexBuffer);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, meshIndexBuffer);
+
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	setupFrameBuffers();
+
+	// Fall back to client-side staging if the buffers could not be mapped.  Immutable storage cannot be respecified or updated with glBufferSubData (it was not created with GL_DYNAMIC_STORAGE_BIT) so both buffers are unmapped, deleted and recreated with glBufferData
+	if (persistentMapping && (!mappedInstances || !mappedCommands)) {
+
+		if (mappedInstances) {
+
+			glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+			glUnmapBuffer(GL_ARRAY_BUFFER);
+			glBindBuffer(GL_ARRAY_BUFFER, 0);
+		}
+
+		if (mappedCommands) {
+
+			glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer);
+			glUnmapBuffer(GL_DRAW_INDIRECT_BUFFER);
+			glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+		}
+
+		glDeleteBuffers(1, &instanceBuffer);
+		glDeleteBuffers(1, &indirectBuffer);
+
+		mappedInstances = nullptr;
+		mappedCommands = nullptr;
+		persistentMapping = false;
+
+		setupFrameBuffers();
+	}
+
+	if (!persistentMapping) {
+
+		stagingInstances.resize(maxDraws);
+		stagingCommands.resize(maxDraws);
+	}
+}
+
+
+void MultiDrawBatch::setupFrameBuffers() {
+
+	GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+	// Per-draw instance buffer - the model transform occupies attribute locations 4-7 and the draw parameters location 8.  Each attribute advances once per instance so baseInstance selects the per-draw data
+	GLsizeiptr instanceBufferSize = (GLsizeiptr)NUM_REGIONS * maxDraws * sizeof(MultiDrawInstance);
+
+	glBindVertexArray(vertexArrayObj);
+
+	glGenBuffers(1, &instanceBuffer);
+	glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+
+	if (persistentMapping) {
+
+		glBufferStorage(GL_ARRAY_BUFFER, instanceBufferSize, nullptr, flags);
+		mappedInstances = (MultiDrawInstance*)glMapBufferRange(GL_ARRAY_BUFFER, 0, instanceBufferSize, flags);
+	}
+	else {
+
+		glBufferData(GL_ARRAY_BUFFER, instanceBufferSize, nullptr, GL_STREAM_DRAW);
+	}
+
+	for (GLuint i = 0; i < 4; i++) {
+
+		glVertexAttribPointer(4 + i, 4, GL_FLOAT, GL_FALSE, sizeof(MultiDrawInstance), (const GLvoid*)(i * sizeof(glm::vec4)));
+		glVertexAttribDivisor(4 + i, 1);
+		glEnableVertexAttribArray(4 + i);
+	}
+
+	glVertexAttribPointer(8, 4, GL_FLOAT, GL_FALSE, sizeof(MultiDrawInstance), (const GLvoid*)offsetof(MultiDrawInstance, params));
+	glVertexAttribDivisor(8, 1);
+	glEnableVertexAttribArray(8);
+
+	glBindVertexArray(0);
+
+	// Indirect command buffer
+	GLsizeiptr indirectBufferSize = (GLsizeiptr)NUM_REGIONS * maxDraws * sizeof(DrawElementsIndirectCommand);
+
+	glGenBuffers(1, &indirectBuffer);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer);
+
+	if (persistentMapping) {
+
+		glBufferStorage(GL_DRAW_INDIRECT_BUFFER, indirectBufferSize, nullptr, flags);
+		mappedCommands = (DrawElementsIndirectCommand*)glMapBufferRange(GL_DRAW_INDIRECT_BUFFER, 0, indirectBufferSize, flags);
+	}
+	else {
+
+		glBufferData(GL_DRAW_INDIRECT_BUFFER, indirectBufferSize, nullptr, GL_STREAM_DRAW);
+	}
+
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+
+void MultiDrawBatch::uploadMeshData() {
+
+	glBindBuffer(GL_ARRAY_BUFFER, meshVertexBuffer);
+	glBufferData(GL_ARRAY_BUFFER, meshVertexData.size() * sizeof(float), meshVertexData.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	// The element array binding is VAO state so bind the VAO first
+	glBindVertexArray(vertexArrayObj);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, meshIndexBuffer);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, meshIndexData.size() * sizeof(GLuint), meshIndexData.data(), GL_STATIC_DRAW);
+	glBindVertexArray(0);
+
+	meshDataChanged = false;
+}
+
+
+void MultiDrawBatch::waitForRegion(GLuint region) {
+
+	if (!regionFence[region])
+		return;
+
+	GLenum result = glClientWaitSync(regionFence[region], 0, 0);
+
+	while (result != GL_ALREADY_SIGNALED && result != GL_CONDITION_SATISFIED && result != GL_WAIT_FAILED) {
+
+		result = glClientWaitSync(regionFence[region], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000); // 1ms
+	}
+
+	glDeleteSync(regionFence[region]);
+	regionFence[region] = 0;
+}
+
+
+//
+// Public API
+//
+
+MultiDrawBatch::MultiDrawBatch(GLuint maxDraws) {
+
+	this->maxDraws = maxDraws;
+
+	textureArray = 0;
+	meshDataChanged = false;
+
+	currentRegion = 0;
+	numDraws = 0;
+
+	for (GLuint i = 0; i < NUM_REGIONS; i++)
+		regionFence[i] = 0;
+
+	mappedInstances = nullptr;
+	mappedCommands = nullptr;
+
+	lastCommandCount = 0;
+	lastAPICallCount = 0;
+
+	loadShader();
+	setupBuffers();
+}
+
+
+MultiDrawBatch::~MultiDrawBatch() {
+
+	for (GLuint i = 0; i < NUM_REGIONS; i++) {
+
+		if (regionFence[i])
+			glDeleteSync(regionFence[i]);
+	}
+
+	glBindVertexArray(0);
+
+	if (persistentMapping) {
+
+		glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+		glUnmapBuffer(GL_ARRAY_BUFFER);
+
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer);
+		glUnmapBuffer(GL_DRAW_INDIRECT_BUFFER);
+	}
+
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+	glDeleteBuffers(1, &meshVertexBuffer);
+	glDeleteBuffers(1, &meshIndexBuffer);
+	glDeleteBuffers(1, &instanceBuffer);
+	glDeleteBuffers(1, &indirectBuffer);
+
+	glDeleteVertexArrays(1, &vertexArrayObj);
+
+	glDeleteProgram(shader);
+}
+
+
+GLuint MultiDrawBatch::addMesh(GLenum mode, const glm::vec4* positions, const glm::vec4* colours, const glm::vec2* texCoords, GLuint numVertices, const GLuint* indices, GLuint numIndices) {
+
+	Mesh mesh;
+
+	mesh.mode = mode;
+	mesh.firstIndex = (GLuint)meshIndexData.size();
+	mesh.numIndices = numIndices;
+	mesh.baseVertex = (GLint)(meshVertexData.size() / vertexStride);
+
+	for (GLuint i = 0; i < numVertices; i++) {
+
+		glm::vec4 colour = (colours) ? colours[i] : glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
+		glm::vec2 texCoord = (texCoords) ? texCoords[i] : glm::vec2(0.0f, 0.0f);
+
+		meshVertexData.insert(meshVertexData.end(), { positions[i].x, positions[i].y, positions[i].z, positions[i].w });
+		meshVertexData.insert(meshVertexData.end(), { colour.r, colour.g, colour.b, colour.a });
+		meshVertexData.insert(meshVertexData.end(), { texCoord.s, texCoord.t });
+	}
+
+	meshIndexData.insert(meshIndexData.end(), indices, indices + numIndices);
+
+	// Register a command list for the mesh's primitive mode if one does not already exist
+	bool modeFound = false;
+
+	for (auto& list : commandLists)
+		modeFound = modeFound || (list.mode == mode);
+
+	if (!modeFound) {
+
+		CommandList list;
+		list.mode = mode;
+		list.commands.reserve(maxDraws);
+
+		commandLists.push_back(list);
+	}
+
+	meshes.push_back(mesh);
+	meshDataChanged = true;
+
+	return (GLuint)(meshes.size() - 1);
+}
+
+
+void MultiDrawBatch::setTextureArray(GLuint textureArray) {
+
+	this->textureArray = textureArray;
+}
+
+
+GLuint MultiDrawBatch::getMaxDraws() const {
+
+	return maxDraws;
+}
+
+
+void MultiDrawBatch::beginFrame() {
+
+	// Make sure the GPU has finished with the region we're about to overwrite
+	waitForRegion(currentRegion);
+
+	numDraws = 0;
+
+	for (auto& list : commandLists)
+		list.commands.clear();
+}
+
+
+bool MultiDrawBatch::addDraw(GLuint meshID, const glm::mat4& modelTransform, GLint textureLayer) {
+
+	MultiDrawInstance* instance = reserveDraws(meshID, 1);
+
+	if (!instance)
+		return false;
+
+	instance->modelTransform = modelTransform;
+	instance->params = glm::vec4((float)textureLayer, 0.0f, 0.0f, 0.0f);
+
+	return true;
+}
+
+
+MultiDrawInstance* MultiDrawBatch::reserveDraws(GLuint meshID, GLuint count) {
+
+	if (count == 0 || numDraws + count > maxDraws || meshID >= (GLuint)meshes.size())
+		return nullptr;
+
+	const Mesh& mesh = meshes[meshID];
+
+	// Per-draw data is written directly into the current region
+	MultiDrawInstance* instances = (persistentMapping) ? &mappedInstances[currentRegion * maxDraws + numDraws] : &stagingInstances[numDraws];
+
+	GLuint baseInstance = currentRegion * maxDraws + numDraws;
+
+	numDraws += count;
+
+	for (auto& list : commandLists) {
+
+		if (list.mode != mesh.mode)
+			continue;
+
+		// Consecutive draws of the same mesh are merged into a single instanced command
+		if (!list.commands.empty()) {
+
+			DrawElementsIndirectCommand& last = list.commands.back();
+
+			if (last.firstIndex == mesh.firstIndex && last.baseVertex == mesh.baseVertex && last.baseInstance + last.instanceCount == baseInstance) {
+
+				last.instanceCount += count;
+				return instances;
+			}
+		}
+
+		DrawElementsIndirectCommand command;
+
+		command.count = mesh.numIndices;
+		command.instanceCount = count;
+		command.firstIndex = mesh.firstIndex;
+		command.baseVertex = mesh.baseVertex;
+		command.baseInstance = baseInstance;
+
+		list.commands.push_back(command);
+		break;
+	}
+
+	return instances;
+}
+
+
+void MultiDrawBatch::render(const glm::mat4& viewProjection) {
+
+	GLCallContext glCallContext(__FUNCTION__);
+
+	if (meshDataChanged)
+		uploadMeshData();
+
+	// Pack the command lists for each primitive mode contiguously into the current region of the indirect buffer
+	DrawElementsIndirectCommand* commandBase = (persistentMapping) ? &mappedCommands[currentRegion * maxDraws] : stagingCommands.data();
+	GLuint numCommands = 0;
+
+	for (auto& list : commandLists) {
+
+		if (!list.commands.empty())
+			memcpy(commandBase + numCommands, list.commands.data(), list.commands.size() * sizeof(DrawElementsIndirectCommand));
+
+		numCommands += (GLuint)list.commands.size();
+	}
+
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer);
+
+	if (!persistentMapping) {
+
+		glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+		glBufferSubData(GL_ARRAY_BUFFER, (GLintptr)currentRegion * maxDraws * sizeof(MultiDrawInstance), numDraws * sizeof(MultiDrawInstance), stagingInstances.data());
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+		glBufferSubData(GL_DRAW_INDIRECT_BUFFER, (GLintptr)currentRegion * maxDraws * sizeof(DrawElementsIndirectCommand), numCommands * sizeof(DrawElementsIndirectCommand), stagingCommands.data());
+	}
+
+	glUseProgram(shader);
+	glUniformMatrix4fv(viewProjectionLocation, 1, GL_FALSE, (const GLfloat*)&(viewProjection));
+	glUniform1i(textureArrayLocation, 0);
+
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, textureArray);
+
+	glBindVertexArray(vertexArrayObj);
+
+	// One multi-draw call per primitive mode
+	GLuint apiCalls = 0;
+	GLintptr commandOffset = (GLintptr)currentRegion * maxDraws * sizeof(DrawElementsIndirectCommand);
+
+	for (auto& list : commandLists) {
+
+		if (list.commands.empty())
+			continue;
+
+		glMultiDrawElementsIndirect(list.mode, GL_UNSIGNED_INT, (const GLvoid*)commandOffset, (GLsizei)list.commands.size(), 0);
+
+		commandOffset += list.commands.size() * sizeof(DrawElementsIndirectCommand);
+		apiCalls++;
+	}
+
+	glBindVertexArray(0);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+	// Fence the region so it is not overwritten until the GPU has consumed it
+	regionFence[currentRegion] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	currentRegion = (currentRegion + 1) % NUM_REGIONS;
+
+	lastCommandCount = numCommands;
+	lastAPICallCount = apiCalls;
+}
+
+
+GLuint MultiDrawBatch::getDrawCount() const {
+
+	return numDraws;
+}
+
+
+GLuint MultiDrawBatch::getCommandCount() const {
+
+	return lastCommandCount;
+}
+
+
+GLuint MultiDrawBatch::getAPICallCount() const {
+
+	return lastAPICallCount;
+}
@@ -0,0 +1,129 @@
+#pragma once
+
+#include "core.h"
+
+// Model a batch of heterogeneous meshes submitted with glMultiDrawElementsIndirect.  All meshes added to the batch share a single vertex and index buffer.  Each frame the draws for the scene are written as DrawElementsIndirectCommands into a persistently mapped indirect buffer, so the whole scene is rendered with one API call per primitive mode (for example GL_TRIANGLE_STRIP for TexturedQuadModel geometry and GL_LINES for PrincipleAxesModel geometry).  Per-draw data (model transform and texture array layer) is sourced as an instanced vertex attribute, indexed via each command's baseInstance, so textures are selected from a single GL_TEXTURE_2D_ARRAY with no per-object binds.  Rendered with Shaders\multidraw_texture.vs and Shaders\multidraw_texture.fs
+
+
+// Layout of an indirect draw command as defined by the GL specification for glMultiDrawElementsIndirect
+struct DrawElementsIndirectCommand {
+
+	GLuint		count;
+	GLuint		instanceCount;
+	GLuint		firstIndex;
+	GLint		baseVertex;
+	GLuint		baseInstance;
+};
+
+
+// Per-draw data sourced via baseInstance.  params.x stores the texture array layer (< 0 means use the vertex colour only)
+struct MultiDrawInstance {
+
+	glm::mat4	modelTransform;
+	glm::vec4	params;
+};
+
+
+class MultiDrawBatch {
+
+public:
+
+	static const GLint		NO_TEXTURE = -1;
+
+private:
+
+	// Number of regions the per-frame buffers are split into so the CPU can write frame n+1 while the GPU reads frame n
+	static const GLuint		NUM_REGIONS = 3;
+
+	struct Mesh {
+
+		GLenum		mode;
+		GLuint		firstIndex;
+		GLuint		numIndices;
+		GLint		baseVertex;
+	};
+
+	// Indirect commands for a single primitive mode
+	struct CommandList {
+
+		GLenum										mode;
+		std::vector<DrawElementsIndirectCommand>	commands;
+	};
+
+	GLuint					vertexArrayObj;
+
+	GLuint					meshVertexBuffer;
+	GLuint					meshIndexBuffer;
+	GLuint					instanceBuffer;
+	GLuint					indirectBuffer;
+
+	GLuint					shader;
+	GLint					viewProjectionLocation;
+	GLint					textureArrayLocation;
+
+	GLuint					textureArray;
+
+	// Mesh data - uploaded on the first render after new meshes are added
+	std::vector<float>		meshVertexData;
+	std::vector<GLuint>		meshIndexData;
+	std::vector<Mesh>		meshes;
+	bool					meshDataChanged;
+
+	// Per-frame state
+	GLuint					maxDraws;
+	GLuint					currentRegion;
+	GLuint					numDraws;
+	GLsync					regionFence[NUM_REGIONS];
+
+	bool					persistentMapping; // true if GL_ARB_buffer_storage is available, otherwise per-frame data is staged in client memory and uploaded with glBufferSubData
+	MultiDrawInstance*		mappedInstances;
+	DrawElementsIndirectCommand* mappedCommands;
+
+	std::vector<MultiDrawInstance>				stagingInstances;
+	std::vector<DrawElementsIndirectCommand>	stagingCommands;
+
+	std::vector<CommandList>	commandLists;
+
+	GLuint					lastCommandCount;
+	GLuint					lastAPICallCount;
+
+	//
+	// Private API
+	//
+
+	void loadShader();
+	void setupBuffers();
+	void setupFrameBuffers(); // per-frame instance and indirect buffers - persistently mapped if persistentMapping is set
+	void uploadMeshData();
+	void waitForRegion(GLuint region);
+
+public:
+
+	MultiDrawBatch(GLuint maxDraws);
+
+	~MultiDrawBatch();
+
+	// Add a mesh to the batch and return its ID.  positions and numVertices are required.  colours and texCoords are optional - if nullptr the colour defaults to white and texture coordinates default to <0, 0>.  Meshes must be added before the first frame is rendered that uses them
+	GLuint addMesh(GLenum mode, const glm::vec4* positions, const glm::vec4* colours, const glm::vec2* texCoords, GLuint numVertices, const GLuint* indices, GLuint numIndices);
+
+	void setTextureArray(GLuint textureArray);
+
+	GLuint getMaxDraws() const;
+
+	// Start recording draws for a new frame.  This blocks only if the GPU is still reading the buffer region written NUM_REGIONS frames ago
+	void beginFrame();
+
+	// Record a draw of meshID with the given model transform, textured with layer 'textureLayer' of the batch's texture array.  Return false if the batch is full
+	bool addDraw(GLuint meshID, const glm::mat4& modelTransform, GLint textureLayer = NO_TEXTURE);
+
+	// Reserve count consecutive draws of meshID and return a pointer to their per-draw data so the caller can write transforms and texture layers straight into the frame's instance buffer.  The returned memory may be written from any thread until render is called.  Return nullptr if the batch does not have room
+	MultiDrawInstance* reserveDraws(GLuint meshID, GLuint count);
+
+	// Submit all draws recorded since beginFrame - one glMultiDrawElementsIndirect call is made per primitive mode
+	void render(const glm::mat4& viewProjection);
+
+	// Statistics for the last frame rendered
+	GLuint getDrawCount() const;
+	GLuint getCommandCount() const;
+	GLuint getAPICallCount() const;
+};
@@ -0,0 +1,145 @@
+
+#include "OffscreenTarget.h"
+#include "GLDebugOutput.h"
+
+
+using namespace std;
+
+
+#pragma region Public API
+
+OffscreenTarget::OffscreenTarget(GLsizei width, GLsizei height) {
+
+	GLCallContext glCallContext(__FUNCTION__);
+
+	this->width = width;
+	this->height = height;
+
+	glGenFramebuffers(1, &framebuffer);
+	glGenRenderbuffers(1, &colourBuffer);
+	glGenRenderbuffers(1, &depthBuffer);
+
+	glBindRenderbuffer(GL_RENDERBUFFER, colourBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+
+	glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colourBuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+
+	GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+
+	complete = (status == GL_FRAMEBUFFER_COMPLETE);
+
+	if (!complete)
+		cout << "Offscreen target " << width << " x " << height << " is incomplete (status 0x" << hex << status << dec << ")" << endl;
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+
+OffscreenTarget::~OffscreenTarget() {
+
+	glDeleteFramebuffers(1, &framebuffer);
+	glDeleteRenderbuffers(1, &colourBuffer);
+	glDeleteRenderbuffers(1, &depthBuffer);
+}
+
+
+bool OffscreenTarget::isComplete() const {
+
+	return complete;
+}
+
+
+GLsizei OffscreenTarget::getWidth() const {
+
+	return width;
+}
+
+
+GLsizei OffscreenTarget::getHeight() const {
+
+	return height;
+}
+
+
+void OffscreenTarget::bind() {
+
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glViewport(0, 0, width, height);
+}
+
+
+void OffscreenTarget::unbind() {
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+
+void OffscreenTarget::blitToDefault(GLsizei width, GLsizei height) {
+
+	GLCallContext glCallContext(__FUNCTION__);
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+	glBlitFramebuffer(0, 0, this->width, this->height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glViewport(0, 0, width, height);
+}
+
+
+void OffscreenTarget::readPixels(vector<GLubyte>& pixels) {
+
+	GLCallContext glCallContext(__FUNCTION__);
+
+	pixels.resize((size_t)width * height * 4);
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+	glReadBuffer(GL_COLOR_ATTACHMENT0);
+	glPixelStorei(GL_PACK_ALIGNMENT, 4);
+	glReadPixels(0, 0, width, height, GL_BGRA, GL_UNSIGNED_BYTE, pixels.data());
+}
+
+
+bool OffscreenTarget::saveImage(const string& filename) {
+
+	vector<GLubyte> pixels;
+
+	readPixels(pixels);
+
+	FIBITMAP* bitmap = FreeImage_ConvertFromRawBits(pixels.data(), width, height, width * 4, 32, FI_RGBA_RED_MASK, FI_RGBA_GREEN_MASK, FI_RGBA_BLUE_MASK, FALSE);
+
+	if (!bitmap) {
+
+		cout << "Cannot create image for " << filename << endl;
+		return false;
+	}
+
+	FREE_IMAGE_FORMAT format = FreeImage_GetFIFFromFilename(filename.c_str());
+
+	// Formats without alpha (JPEG) need a 24 bit image
+	if (format != FIF_UNKNOWN && !FreeImage_FIFSupportsExportBPP(format, 32)) {
+
+		FIBITMAP* bitmap24 = FreeImage_ConvertTo24Bits(bitmap);
+
+		FreeImage_Unload(bitmap);
+		bitmap = bitmap24;
+	}
+
+	bool saved = (format != FIF_UNKNOWN && bitmap && FreeImage_Save(format, bitmap, filename.c_str()));
+
+	if (!saved)
+		cout << "Cannot save image " << filename << endl;
+
+	FreeImage_Unload(bitmap);
+
+	return saved;
+}
+
+#pragma endregion
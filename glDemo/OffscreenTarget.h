@@ -0,0 +1,43 @@
+#pragma once
+
+#include "core.h"
+
+// Framebuffer object with a colour and depth renderbuffer of arbitrary size.  Used as the render target of headless contexts (which have no default framebuffer), for captures larger than the window and for rendering below window resolution.  The colour buffer is 8 bit RGBA without sRGB encoding so captures match what the viewer displays
+
+class OffscreenTarget {
+
+	GLuint		framebuffer;
+	GLuint		colourBuffer;
+	GLuint		depthBuffer;
+	GLsizei		width, height;
+	bool		complete;
+
+public:
+
+	OffscreenTarget(GLsizei width, GLsizei height);
+	~OffscreenTarget();
+
+	OffscreenTarget(const OffscreenTarget&) = delete;
+	OffscreenTarget& operator=(const OffscreenTarget&) = delete;
+
+	// Return true if the framebuffer was created and is complete
+	bool isComplete() const;
+
+	GLsizei getWidth() const;
+	GLsizei getHeight() const;
+
+	// Bind the framebuffer for drawing and reading and set the viewport to cover it
+	void bind();
+
+	// Bind the default framebuffer
+	void unbind();
+
+	// Scale the colour buffer into the width x height default framebuffer (with linear filtering), then bind the default framebuffer and set the viewport to cover it.  Used to present frames rendered at reduced resolution
+	void blitToDefault(GLsizei width, GLsizei height);
+
+	// Read the colour buffer as 32 bit BGRA, bottom row first (the layout of a FreeImage bitmap).  Waits for rendering to finish
+	void readPixels(std::vector<GLubyte>& pixels);
+
+	// Save the colour buffer to filename.  The image format is taken from the file extension.  Return false if the image cannot be saved
+	bool saveImage(const std::string& filename);
+};
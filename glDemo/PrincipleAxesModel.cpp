@@ -1,6 +1,7 @@
 
 #include "PrincipleAxesModel.h"
 #include "ShaderSetup.h"
+#include "MultiDrawBatch.h"
 
 
 using namespace std;
@@ -134,3 +135,9 @@ void PrincipleAxesModel::render(const glm::mat4& T) {
 	glBindVertexArray(paVertexArrayObj);
 	glDrawElements(GL_LINES, 20, GL_UNSIGNED_INT, (const GLvoid*)0);
 }
+
+
+GLuint PrincipleAxesModel::addMeshToBatch(MultiDrawBatch* batch) {
+
+	return batch->addMesh(GL_LINES, (const glm::vec4*)paPositionArray, (const glm::vec4*)paColourArray, nullptr, 18, paIndexArray, 20);
+}
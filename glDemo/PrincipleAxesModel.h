@@ -2,6 +2,8 @@
 
 #include "core.h"
 
+class MultiDrawBatch;
+
 class PrincipleAxesModel {
 
 private:
@@ -22,6 +24,9 @@ public:
 	~PrincipleAxesModel();
 
 	void render(const glm::mat4& T);
+
+	// Add the principle axes geometry to the given MultiDrawBatch and return the batch mesh ID
+	static GLuint addMeshToBatch(MultiDrawBatch* batch);
 };
 
 
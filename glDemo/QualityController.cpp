@@ -0,0 +1,420 @@
+
+#include "QualityController.h"
+
+
+using namespace std;
+
+
+static const GLuint NO_STEP = 0xFFFFFFFF;
+
+
+#pragma region Private API
+
+// Average of the last frames samples of the window
+float QualityController::windowAverage(GLuint frames) const {
+
+	GLuint windowSize = (GLuint)window.size();
+	frames = std::min(frames, windowCount);
+
+	if (frames == 0)
+		return 0.0f;
+
+	double total = 0.0;
+
+	for (GLuint i = 1; i <= frames; i++)
+		total += window[(windowNext + windowSize - i) % windowSize];
+
+	return (float)(total / frames);
+}
+
+
+void QualityController::changeStep(GLuint newStep, float averageTime, GLuint windowFrames) {
+
+	QualityDecision decision;
+
+	decision.frame = frameNumber;
+	decision.fromStep = currentStep;
+	decision.toStep = newStep;
+	decision.averageTime = averageTime;
+	decision.windowFrames = windowFrames;
+	decision.holdFrames = (holdUntilFrame > frameNumber) ? (GLuint)(holdUntilFrame - frameNumber) : 0;
+
+	decisions.push_back(decision);
+
+	if (printDecisions) {
+
+		cout << "Quality: frame " << frameNumber << " step " << currentStep << " (" << steps[currentStep].name << ") -> " << newStep << " (" << steps[newStep].name << "), " << averageTime << " ms average over " << windowFrames << " frames, budget " << settings.targetFrameTime << " ms";
+
+		if (decision.holdFrames > 0)
+			cout << ", step " << heldStep << " held for " << decision.holdFrames << " frames";
+
+		cout << endl;
+	}
+
+	currentStep = newStep;
+
+	// Each step is judged only on frames rendered at that step
+	windowCount = 0;
+	windowNext = 0;
+}
+
+#pragma endregion
+
+
+#pragma region Public API
+
+QualityController::QualityController(const vector<QualityStep>& steps, const QualitySettings& settings, GLuint initialStep, bool printDecisions) {
+
+	this->steps = steps;
+	this->settings = settings;
+	this->settings.decreaseWindow = std::max<GLuint>(settings.decreaseWindow, 1);
+	this->settings.increaseWindow = std::max<GLuint>(settings.increaseWindow, 1);
+	this->printDecisions = printDecisions;
+
+	window.assign(std::max(this->settings.decreaseWindow, this->settings.increaseWindow), 0.0f);
+
+	frameNumber = 0;
+
+	reset(initialStep);
+}
+
+
+bool QualityController::addFrameTime(float frameTime) {
+
+	if (steps.empty())
+		return false;
+
+	frameNumber++;
+
+	window[windowNext] = frameTime;
+	windowNext = (windowNext + 1) % (GLuint)window.size();
+	windowCount = std::min(windowCount + 1, (GLuint)window.size());
+
+	// A step that has held for a full increase window after being entered is affordable - forget earlier failures
+	bool increasePending = (lastIncreaseFrame > 0 && frameNumber - lastIncreaseFrame <= settings.increaseWindow);
+
+	if (lastIncreaseFrame > 0 && !increasePending) {
+
+		lastIncreaseFrame = 0;
+		holdFrames = 0;
+	}
+
+	// Over budget - step down
+	if (currentStep > 0 && windowCount >= settings.decreaseWindow) {
+
+		float averageTime = windowAverage(settings.decreaseWindow);
+
+		if (averageTime > settings.targetFrameTime * (1.0f + settings.decreaseMargin)) {
+
+			// The step was only just entered so it cannot be afforded.  Hold it back for twice as long as last time
+			if (increasePending) {
+
+				heldStep = currentStep;
+				holdFrames = std::min(std::max(holdFrames * 2, settings.increaseWindow), settings.maxHoldFrames);
+				holdUntilFrame = frameNumber + holdFrames;
+				lastIncreaseFrame = 0;
+			}
+
+			changeStep(currentStep - 1, averageTime, settings.decreaseWindow);
+			return true;
+		}
+	}
+
+	// Comfortably under budget - step up unless the next step is being held back
+	if (currentStep + 1 < (GLuint)steps.size() && windowCount >= settings.increaseWindow) {
+
+		float averageTime = windowAverage(settings.increaseWindow);
+		bool held = (currentStep + 1 == heldStep && frameNumber < holdUntilFrame);
+
+		if (averageTime < settings.targetFrameTime * settings.increaseThreshold && !held) {
+
+			changeStep(currentStep + 1, averageTime, settings.increaseWindow);
+			lastIncreaseFrame = frameNumber;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+
+void QualityController::reset(GLuint step) {
+
+	currentStep = (steps.empty()) ? 0 : std::min(step, (GLuint)steps.size() - 1);
+
+	windowCount = 0;
+	windowNext = 0;
+
+	heldStep = NO_STEP;
+	holdFrames = 0;
+	holdUntilFrame = 0;
+	lastIncreaseFrame = 0;
+}
+
+
+GLuint QualityController::getCurrentStep() const {
+
+	return currentStep;
+}
+
+
+const QualityStep& QualityController::getStep(GLuint step) const {
+
+	return steps[step];
+}
+
+
+GLuint QualityController::getNumSteps() const {
+
+	return (GLuint)steps.size();
+}
+
+
+const QualitySettings& QualityController::getSettings() const {
+
+	return settings;
+}
+
+
+float QualityController::getAverageFrameTime() const {
+
+	return windowAverage(windowCount);
+}
+
+
+unsigned long long QualityController::getFrameNumber() const {
+
+	return frameNumber;
+}
+
+
+const vector<QualityDecision>& QualityController::getDecisions() const {
+
+	return decisions;
+}
+
+
+bool QualityController::writeDecisionLog(const string& filename) const {
+
+	ofstream file(filename);
+
+	if (!file.is_open()) {
+
+		cout << "Cannot write quality decisions to " << filename << endl;
+		return false;
+	}
+
+	file << "frame,from_step,from_name,to_step,to_name,average_ms,window_frames,hold_frames" << endl;
+
+	for (const QualityDecision& decision : decisions)
+		file << decision.frame << "," << decision.fromStep << "," << steps[decision.fromStep].name << "," << decision.toStep << "," << steps[decision.toStep].name << "," << decision.averageTime << "," << decision.windowFrames << "," << decision.holdFrames << endl;
+
+	return true;
+}
+
+
+GPUFrameTimer::GPUFrameTimer() {
+
+	glGenQueries(NUM_QUERIES * 2, &queries[0][0]);
+
+	for (GLuint i = 0; i < NUM_QUERIES; i++)
+		pending[i] = false;
+
+	currentQuery = 0;
+	oldestQuery = 0;
+	frameActive = false;
+}
+
+
+GPUFrameTimer::~GPUFrameTimer() {
+
+	glDeleteQueries(NUM_QUERIES * 2, &queries[0][0]);
+}
+
+
+void GPUFrameTimer::beginFrame(GLuint tag) {
+
+	// Every query is still in flight - skip the frame rather than wait for the GPU
+	if (pending[currentQuery]) {
+
+		frameActive = false;
+		return;
+	}
+
+	glQueryCounter(queries[currentQuery][0], GL_TIMESTAMP);
+	tags[currentQuery] = tag;
+	frameActive = true;
+}
+
+
+void GPUFrameTimer::endFrame() {
+
+	if (!frameActive)
+		return;
+
+	glQueryCounter(queries[currentQuery][1], GL_TIMESTAMP);
+
+	pending[currentQuery] = true;
+	currentQuery = (currentQuery + 1) % NUM_QUERIES;
+	frameActive = false;
+}
+
+
+bool GPUFrameTimer::getFrameTime(float& frameTime, GLuint& tag) {
+
+	if (!pending[oldestQuery])
+		return false;
+
+	// The end timestamp is written last so once it is available so is the start
+	GLint available = 0;
+
+	glGetQueryObjectiv(queries[oldestQuery][1], GL_QUERY_RESULT_AVAILABLE, &available);
+
+	if (!available)
+		return false;
+
+	GLuint64 startTime = 0, endTime = 0;
+
+	glGetQueryObjectui64v(queries[oldestQuery][0], GL_QUERY_RESULT, &startTime);
+	glGetQueryObjectui64v(queries[oldestQuery][1], GL_QUERY_RESULT, &endTime);
+
+	frameTime = (endTime > startTime) ? (float)((double)(endTime - startTime) * 1.0e-6) : 0.0f;
+	tag = tags[oldestQuery];
+
+	pending[oldestQuery] = false;
+	oldestQuery = (oldestQuery + 1) % NUM_QUERIES;
+
+	return true;
+}
+
+
+bool loadQualityTrace(const string& filename, vector<QualityTraceFrame>& trace) {
+
+	ifstream file(filename);
+
+	if (!file.is_open()) {
+
+		cout << "Cannot read quality trace " << filename << endl;
+		return false;
+	}
+
+	trace.clear();
+
+	string line;
+
+	// Skip the header
+	getline(file, line);
+
+	while (getline(file, line)) {
+
+		unsigned long long frame;
+		QualityTraceFrame traceFrame;
+
+		if (sscanf(line.c_str(), "%llu,%u,%f", &frame, &traceFrame.step, &traceFrame.frameTime) == 3)
+			trace.push_back(traceFrame);
+	}
+
+	return true;
+}
+
+
+bool writeQualityTrace(const string& filename, const vector<QualityTraceFrame>& trace) {
+
+	ofstream file(filename);
+
+	if (!file.is_open()) {
+
+		cout << "Cannot write quality trace to " << filename << endl;
+		return false;
+	}
+
+	file << "frame,step,gpu_ms" << endl;
+
+	for (size_t i = 0; i < trace.size(); i++)
+		file << i << "," << trace[i].step << "," << trace[i].frameTime << endl;
+
+	return true;
+}
+
+
+bool runQualityReplay(const vector<QualityTraceFrame>& trace, QualityController& controller, const string& logFilename) {
+
+	if (trace.empty()) {
+
+		cout << "Quality replay: the trace is empty" << endl;
+		return false;
+	}
+
+	GLuint numSteps = controller.getNumSteps();
+
+	// Mean cost of each step recorded in the trace
+	vector<double> stepCost(numSteps, 0.0);
+	vector<GLuint> stepFrames(numSteps, 0);
+
+	for (const QualityTraceFrame& frame : trace) {
+
+		GLuint step = std::min(frame.step, numSteps - 1);
+
+		stepCost[step] += frame.frameTime;
+		stepFrames[step]++;
+	}
+
+	for (GLuint i = 0; i < numSteps; i++) {
+
+		if (stepFrames[i] > 0)
+			stepCost[i] /= stepFrames[i];
+	}
+
+	// Steps with no frames are interpolated between the nearest recorded steps either side (or take the cost of the nearest recorded step at the ends of the ladder)
+	for (GLuint i = 0; i < numSteps; i++) {
+
+		if (stepFrames[i] > 0)
+			continue;
+
+		int below = (int)i - 1, above = (int)i + 1;
+
+		while (below >= 0 && stepFrames[below] == 0)
+			below--;
+
+		while (above < (int)numSteps && stepFrames[above] == 0)
+			above++;
+
+		if (below >= 0 && above < (int)numSteps)
+			stepCost[i] = stepCost[below] + (stepCost[above] - stepCost[below]) * (double)((int)i - below) / (double)(above - below);
+		else if (below >= 0)
+			stepCost[i] = stepCost[below];
+		else if (above < (int)numSteps)
+			stepCost[i] = stepCost[above];
+	}
+
+	float budget = controller.getSettings().targetFrameTime;
+	GLuint framesOverBudget = 0;
+	vector<GLuint> framesAtStep(numSteps, 0);
+
+	for (const QualityTraceFrame& frame : trace) {
+
+		GLuint recordedStep = std::min(frame.step, numSteps - 1);
+		GLuint step = controller.getCurrentStep();
+
+		float frameTime = (stepCost[recordedStep] > 0.0) ? (float)(frame.frameTime * stepCost[step] / stepCost[recordedStep]) : frame.frameTime;
+
+		if (frameTime > budget)
+			framesOverBudget++;
+
+		framesAtStep[step]++;
+
+		controller.addFrameTime(frameTime);
+	}
+
+	cout << "Quality replay: " << trace.size() << " frames, " << framesOverBudget << " over the " << budget << " ms budget (" << 100.0 * framesOverBudget / trace.size() << "%), " << controller.getDecisions().size() << " decisions, final step " << controller.getCurrentStep() << " (" << controller.getStep(controller.getCurrentStep()).name << ")" << endl;
+
+	for (GLuint i = 0; i < numSteps; i++)
+		cout << "  step " << i << " (" << controller.getStep(i).name << "): " << framesAtStep[i] << " frames, trace cost " << stepCost[i] << " ms (" << stepFrames[i] << " frames recorded)" << endl;
+
+	if (!logFilename.empty() && controller.writeDecisionLog(logFilename))
+		cout << "Quality decisions written to " << logFilename << endl;
+
+	return true;
+}
+
+#pragma endregion
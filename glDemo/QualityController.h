@@ -0,0 +1,135 @@
+#pragma once
+
+#include "core.h"
+
+// Dynamic quality scaling.  QualityController holds a ladder of quality steps (cheapest first) and is fed one GPU frame time per frame.  When the average over the last decreaseWindow frames exceeds the budget by more than decreaseMargin it moves one step down, and when the average over the last increaseWindow frames is below increaseThreshold of the budget it moves one step up.  The window restarts after every change so each step is judged on its own frames, and a step that was entered and then abandoned within increaseWindow frames is not retried for a hold period that doubles with each failure (up to maxHoldFrames), so the controller does not oscillate between a step it cannot afford and the one below.  Every decision is logged.  The controller makes no GL calls so it can be driven offline from a recorded timing trace (see runQualityReplay) - GPUFrameTimer measures frame times for the live controller with GL_TIMESTAMP queries
+
+// One rung of the quality ladder
+struct QualityStep {
+
+	const char*		name;
+	GLuint			textureLevel; // index into the ladder of texture (filtering) configurations
+	GLfloat			lodBias; // GL_TEXTURE_LOD_BIAS applied to the texture
+	GLfloat			renderScale; // fraction of the window resolution the scene is rendered at
+};
+
+
+struct QualitySettings {
+
+	float			targetFrameTime; // budget (ms)
+	float			decreaseMargin; // step down when the average exceeds the budget by this fraction
+	float			increaseThreshold; // step up when the average is below this fraction of the budget
+	GLuint			decreaseWindow; // frames averaged before stepping down
+	GLuint			increaseWindow; // frames averaged before stepping up
+	GLuint			maxHoldFrames; // longest wait before retrying a step that was abandoned
+};
+
+
+// A change of step and the measurement that caused it
+struct QualityDecision {
+
+	unsigned long long	frame;
+	GLuint				fromStep, toStep;
+	float				averageTime; // ms over the window that triggered the change
+	GLuint				windowFrames;
+	GLuint				holdFrames; // frames the next increase is held for after the change
+};
+
+
+class QualityController {
+
+	std::vector<QualityStep>	steps;
+	QualitySettings				settings;
+
+	GLuint						currentStep;
+	unsigned long long			frameNumber;
+
+	// Frame times since the last change (ring of increaseWindow samples)
+	std::vector<float>			window;
+	GLuint						windowCount;
+	GLuint						windowNext;
+
+	// Hysteresis - the step abandoned most recently is held back until holdUntilFrame
+	GLuint						heldStep;
+	GLuint						holdFrames;
+	unsigned long long			holdUntilFrame;
+	unsigned long long			lastIncreaseFrame;
+
+	std::vector<QualityDecision>	decisions;
+	bool						printDecisions;
+
+	float windowAverage(GLuint frames) const;
+	void changeStep(GLuint newStep, float averageTime, GLuint windowFrames);
+
+public:
+
+	// Start at initialStep (clamped to the ladder).  If printDecisions is set each decision is also written to cout
+	QualityController(const std::vector<QualityStep>& steps, const QualitySettings& settings, GLuint initialStep, bool printDecisions = true);
+
+	// Record the GPU time of the next frame (ms).  Return true if the step changed
+	bool addFrameTime(float frameTime);
+
+	// Restart measurement at step (for example after the user overrides the quality)
+	void reset(GLuint step);
+
+	GLuint getCurrentStep() const;
+	const QualityStep& getStep(GLuint step) const;
+	GLuint getNumSteps() const;
+	const QualitySettings& getSettings() const;
+
+	// Average of the frames measured at the current step so far (0 if none)
+	float getAverageFrameTime() const;
+
+	unsigned long long getFrameNumber() const;
+	const std::vector<QualityDecision>& getDecisions() const;
+
+	// Write every decision as CSV.  Return false if the file cannot be written
+	bool writeDecisionLog(const std::string& filename) const;
+};
+
+
+// GPU time of whole frames from a pair of GL_TIMESTAMP queries written at the start and end of the frame.  Timestamps (unlike GL_TIME_ELAPSED) cannot nest with another timer, so the frame may contain other timed work (see StreamingRoad).  NUM_QUERIES frames are kept in flight and results are only read once available so timing never stalls the pipeline.  Each frame carries a tag (the quality step it was rendered at) since results arrive a few frames late
+class GPUFrameTimer {
+
+	static const GLuint		NUM_QUERIES = 4;
+
+	GLuint					queries[NUM_QUERIES][2]; // start and end timestamp of each frame
+	GLuint					tags[NUM_QUERIES];
+	bool					pending[NUM_QUERIES];
+	GLuint					currentQuery;
+	GLuint					oldestQuery;
+	bool					frameActive;
+
+public:
+
+	GPUFrameTimer();
+	~GPUFrameTimer();
+
+	GPUFrameTimer(const GPUFrameTimer&) = delete;
+	GPUFrameTimer& operator=(const GPUFrameTimer&) = delete;
+
+	// Mark the start and end of the GPU work to time.  If every query is still in flight the frame is not timed
+	void beginFrame(GLuint tag);
+	void endFrame();
+
+	// Return the time (ms) and tag of the oldest completed frame not yet read.  Return false if none has completed
+	bool getFrameTime(float& frameTime, GLuint& tag);
+};
+
+
+// A frame of a recorded timing trace - the step in use and the GPU time it took
+struct QualityTraceFrame {
+
+	GLuint			step;
+	float			frameTime;
+};
+
+
+// Load a timing trace written by writeQualityTrace (CSV with frame,step,gpu_ms columns).  Return false if the file cannot be read
+bool loadQualityTrace(const std::string& filename, std::vector<QualityTraceFrame>& trace);
+
+// Write a timing trace as CSV.  Return false if the file cannot be written
+bool writeQualityTrace(const std::string& filename, const std::vector<QualityTraceFrame>& trace);
+
+// Drive controller from a recorded trace.  Each trace frame is rescaled from the step it was recorded at to the controller's current step using the mean cost of each step in the trace (steps with no frames are interpolated from the recorded steps either side), so the controller's decisions feed back into the times it sees.  Reports the frames over budget and the decisions made and writes the decision log to logFilename if given.  Return false if the trace is empty
+bool runQualityReplay(const std::vector<QualityTraceFrame>& trace, QualityController& controller, const std::string& logFilename);
@@ -0,0 +1,197 @@
+
+#include "RedrawScheduler.h"
+
+
+using namespace std;
+
+
+RedrawScheduler::RedrawScheduler(bool continuous, double idleTimeout) {
+
+	this->continuous = continuous;
+	this->idleTimeout = idleTimeout;
+
+	// Always render the first frame
+	dirty = true;
+	interrupted = false;
+	frameLocked = false;
+	frameRequested = false;
+
+	framesRendered = 0;
+	idleWakeups = 0;
+	framesCompleted = 0;
+
+	for (int i = 0; i < NUM_REDRAW_REASONS; i++)
+		reasonCount[i] = 0;
+}
+
+
+void RedrawScheduler::markDirty(RedrawReason reason) {
+
+	dirty = true;
+	reasonCount[reason]++;
+
+	wake();
+}
+
+
+void RedrawScheduler::setContinuous(bool continuous) {
+
+	this->continuous = continuous;
+
+	// Render at least one frame after switching mode so any overlay reflects the change
+	dirty = true;
+
+	wake();
+}
+
+
+bool RedrawScheduler::isContinuous() const {
+
+	return continuous;
+}
+
+
+void RedrawScheduler::setFrameLocked(bool frameLocked) {
+
+	this->frameLocked = frameLocked;
+
+	wake();
+}
+
+
+bool RedrawScheduler::isFrameLocked() const {
+
+	return frameLocked;
+}
+
+
+unsigned long long RedrawScheduler::requestFrame() {
+
+	// No frame is in progress while frame-locked (each one is waited for) so the next frame presented is the requested one
+	unsigned long long frame = framesCompleted + 1;
+
+	frameRequested = true;
+	reasonCount[REDRAW_REPLAY]++;
+
+	wake();
+
+	return frame;
+}
+
+
+void RedrawScheduler::waitForFrame(unsigned long long frame) {
+
+	std::unique_lock<std::mutex> lock(wakeMutex);
+
+	frameCondition.wait(lock, [this, frame]() { return framesCompleted >= frame; });
+}
+
+
+bool RedrawScheduler::beginFrame() {
+
+	if (frameLocked) {
+
+		if (frameRequested.exchange(false)) {
+
+			dirty = false;
+			framesRendered++;
+
+			return true;
+		}
+
+		idleWakeups++;
+		return false;
+	}
+
+	if (dirty.exchange(false) || continuous) {
+
+		framesRendered++;
+
+		return true;
+	}
+
+	idleWakeups++;
+	return false;
+}
+
+
+void RedrawScheduler::endFrame() {
+
+	{
+		std::lock_guard<std::mutex> lock(wakeMutex);
+
+		framesCompleted++;
+	}
+
+	frameCondition.notify_all();
+}
+
+
+void RedrawScheduler::waitForRedraw() {
+
+	std::unique_lock<std::mutex> lock(wakeMutex);
+
+	wakeCondition.wait_for(lock, std::chrono::duration<double>(idleTimeout), [this]() { return (frameLocked) ? (frameRequested || interrupted) : (dirty || continuous || interrupted); });
+
+	interrupted = false;
+}
+
+
+void RedrawScheduler::interrupt() {
+
+	interrupted = true;
+	wake();
+}
+
+
+unsigned long long RedrawScheduler::getFramesRendered() const {
+
+	return framesRendered;
+}
+
+
+unsigned long long RedrawScheduler::getIdleWakeups() const {
+
+	return idleWakeups;
+}
+
+
+void RedrawScheduler::reportSummary(ostream& out) const {
+
+	out << endl << "Redraw summary: " << framesRendered << " frames rendered, " << framesCompleted << " presented, " << idleWakeups << " idle wakeups" << endl;
+
+	for (int i = 0; i < NUM_REDRAW_REASONS; i++) {
+
+		if (reasonCount[i] > 0)
+			out << "    " << reasonName((RedrawReason)i) << ": " << reasonCount[i] << " requests" << endl;
+	}
+}
+
+
+// Notify a waiting render thread.  The mutex is taken (briefly) so a notification cannot be lost between the waiting thread testing its predicate and blocking
+void RedrawScheduler::wake() {
+
+	{
+		std::lock_guard<std::mutex> lock(wakeMutex);
+	}
+
+	wakeCondition.notify_one();
+}
+
+
+const char* RedrawScheduler::reasonName(RedrawReason reason) {
+
+	static const char* names[NUM_REDRAW_REASONS] = {
+		"camera",
+		"filter mode",
+		"scene mode",
+		"resize",
+		"asset arrived",
+		"animation",
+		"replay",
+		"overlay",
+		"quality",
+		"tool" };
+
+	return (reason < NUM_REDRAW_REASONS) ? names[reason] : "unknown";
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "core.h"
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+
+// Decide when the render thread needs to render.  In event-driven mode (the default) a frame is only rendered after something marks the scheduler dirty - camera changes, filter mode switches, window resizes or asset arrivals.  While nothing is dirty the render thread blocks in waitForRedraw (and the input thread blocks in glfwWaitEventsTimeout) so an unchanged view costs no CPU or GPU time.  Continuous mode renders every iteration and is intended for benchmarking.  Frame-locked mode (used to replay recorded input) renders exactly one frame per requestFrame call and lets the requesting thread wait for that frame to be presented, so a sequence of scene updates always produces the same sequence of frames.  markDirty and setContinuous may be called from any thread.  beginFrame and waitForRedraw are called from the render thread
+
+enum RedrawReason {
+
+	REDRAW_CAMERA = 0,
+	REDRAW_FILTER_MODE,
+	REDRAW_SCENE_MODE,
+	REDRAW_RESIZE,
+	REDRAW_ASSET_ARRIVED,
+	REDRAW_ANIMATION,
+	REDRAW_REPLAY,
+	REDRAW_OVERLAY, // overlay and visualisation toggles (profiler, footprint)
+	REDRAW_QUALITY, // adaptive quality and sampler feedback toggles
+	REDRAW_TOOL, // trace, capture and export commands
+
+	NUM_REDRAW_REASONS
+};
+
+
+class RedrawScheduler {
+
+	std::atomic<bool>	continuous;
+	std::atomic<bool>	dirty;
+	std::atomic<bool>	interrupted;
+	std::atomic<bool>	frameLocked;
+	std::atomic<bool>	frameRequested;
+	double				idleTimeout; // maximum time (in seconds) to block waiting for a redraw request
+
+	std::mutex			wakeMutex;
+	std::condition_variable	wakeCondition;
+	std::condition_variable	frameCondition;
+
+	unsigned long long	framesRendered;
+	unsigned long long	idleWakeups; // beginFrame calls that found nothing to render (idle timeouts and polls)
+	std::atomic<unsigned long long>	framesCompleted;
+	std::atomic<unsigned long long>	reasonCount[NUM_REDRAW_REASONS];
+
+	void wake();
+
+	static const char* reasonName(RedrawReason reason);
+
+public:
+
+	RedrawScheduler(bool continuous = false, double idleTimeout = 0.25);
+
+	// Request a new frame
+	void markDirty(RedrawReason reason);
+
+	void setContinuous(bool continuous);
+	bool isContinuous() const;
+
+	// In frame-locked mode frames are only rendered when requested - dirty marks and continuous mode are ignored
+	void setFrameLocked(bool frameLocked);
+	bool isFrameLocked() const;
+
+	// Request a frame in frame-locked mode and return its number for waitForFrame.  Only one request may be outstanding
+	unsigned long long requestFrame();
+
+	// Block until frame has been presented (any thread except the render thread)
+	void waitForFrame(unsigned long long frame);
+
+	// Return true if a frame should be rendered this iteration.  The dirty state is cleared so anything changing during the frame requests a further frame
+	bool beginFrame();
+
+	// Report that the frame started by beginFrame has been presented
+	void endFrame();
+
+	// Block until a redraw is requested or the idle timeout expires.  Return immediately in continuous mode or if a redraw is already pending
+	void waitForRedraw();
+
+	// Wake a render thread blocked in waitForRedraw without requesting a frame (used at shutdown)
+	void interrupt();
+
+	unsigned long long getFramesRendered() const;
+	unsigned long long getIdleWakeups() const;
+
+	// Report the frames rendered and presented, idle wakeups and the number of redraw requests for each reason
+	void reportSummary(std::ostream& out) const;
+};
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+// Bounded lock-free single-producer / single-consumer queue.  push must only be called from one thread and pop from one (other) thread.  Capacity must be a power of 2.  The head and tail counters live on separate cache lines so the producer and consumer do not contend
+
+namespace cst {
+
+	template <typename T, size_t Capacity>
+	class SPSCQueue {
+
+		static_assert((Capacity & (Capacity - 1)) == 0, "SPSCQueue capacity must be a power of 2");
+
+		T							items[Capacity];
+
+		alignas(64) std::atomic<size_t>	head; // next item to pop - written by the consumer
+		alignas(64) std::atomic<size_t>	tail; // next free slot - written by the producer
+
+	public:
+
+		SPSCQueue() : head(0), tail(0) {}
+
+		SPSCQueue(const SPSCQueue&) = delete;
+		SPSCQueue& operator=(const SPSCQueue&) = delete;
+
+		// Add item to the queue.  Return false if the queue is full (producer thread only)
+		bool push(const T& item) {
+
+			size_t t = tail.load(std::memory_order_relaxed);
+
+			if (t - head.load(std::memory_order_acquire) == Capacity)
+				return false;
+
+			items[t & (Capacity - 1)] = item;
+			tail.store(t + 1, std::memory_order_release);
+
+			return true;
+		}
+
+		// Remove the oldest item from the queue into 'item'.  Return false if the queue is empty (consumer thread only)
+		bool pop(T& item) {
+
+			size_t h = head.load(std::memory_order_relaxed);
+
+			if (h == tail.load(std::memory_order_acquire))
+				return false;
+
+			item = items[h & (Capacity - 1)];
+			head.store(h + 1, std::memory_order_release);
+
+			return true;
+		}
+
+		// Approximate number of queued items - exact only when called from the producer or consumer while the other thread is idle
+		size_t size() const {
+
+			return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+		}
+
+		bool empty() const {
+
+			return size() == 0;
+		}
+	};
+
+}
@@ -0,0 +1,373 @@
+
+#include "core.h"
+#include "SamplerFeedback.h"
+#include "GLDebugOutput.h"
+#include "ShaderSetup.h"
+#include "MipBuilder.h"
+
+
+using namespace std;
+
+
+#pragma region Private API
+
+void SamplerFeedback::allocateTileBuffer() {
+
+	tileBufferSize = getTileCount() * (GLuint)textures.size() * sizeof(GLuint);
+
+	glBindBuffer(GL_TEXTURE_BUFFER, tileBuffer);
+	glBufferData(GL_TEXTURE_BUFFER, tileBufferSize, nullptr, GL_DYNAMIC_COPY);
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+	glBindTexture(GL_TEXTURE_BUFFER, tileTexture);
+	glTexBuffer(GL_TEXTURE_BUFFER, GL_R32UI, tileBuffer);
+	glBindTexture(GL_TEXTURE_BUFFER, 0);
+
+	clearData.assign(tileBufferSize / sizeof(GLuint), FEEDBACK_NOT_SAMPLED);
+}
+
+
+void SamplerFeedback::processReadback(Readback& readback) {
+
+	GLuint tilesPerSlot = readback.tilesX * readback.tilesY;
+
+	glBindBuffer(GL_COPY_READ_BUFFER, readback.buffer);
+
+	const GLuint* tiles = (const GLuint*)glMapBufferRange(GL_COPY_READ_BUFFER, 0, (GLsizeiptr)tilesPerSlot * readback.numSlots * sizeof(GLuint), GL_MAP_READ_BIT);
+
+	if (tiles) {
+
+		for (GLuint slot = 0; slot < readback.numSlots; slot++) {
+
+			FeedbackTexture& feedbackTexture = textures[slot];
+
+			feedbackTexture.lastMinMip = reduceMinMip(tiles + slot * tilesPerSlot, tilesPerSlot, feedbackTexture.residency.numLevels);
+
+			if (updateMipResidency(feedbackTexture.residency, feedbackTexture.lastMinMip, evictDelay)) {
+
+				glBindTexture(GL_TEXTURE_2D, feedbackTexture.texture);
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, feedbackTexture.residency.baseLevel);
+				glBindTexture(GL_TEXTURE_2D, 0);
+
+				residencyChanged = true;
+			}
+		}
+
+		glUnmapBuffer(GL_COPY_READ_BUFFER);
+
+		resultsProcessed++;
+	}
+
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+	glDeleteSync(readback.fence);
+	readback.fence = 0;
+}
+
+#pragma endregion
+
+
+#pragma region Public API
+
+SamplerFeedback::SamplerFeedback(GLuint tileSize, GLuint viewportWidth, GLuint viewportHeight, GLuint evictDelay) {
+
+	supported = (glewIsSupported("GL_ARB_shader_image_load_store") == GL_TRUE);
+
+	this->tileSize = std::max<GLuint>(tileSize, 1);
+	this->evictDelay = evictDelay;
+
+	tileBuffer = 0;
+	tileTexture = 0;
+	tileBufferSize = 0;
+
+	currentReadback = 0;
+	passActive = false;
+	residencyChanged = false;
+
+	resultsProcessed = 0;
+	framesSkipped = 0;
+
+	setViewportSize(viewportWidth, viewportHeight);
+
+	for (GLuint i = 0; i < NUM_READBACK_BUFFERS; i++) {
+
+		readbacks[i].buffer = 0;
+		readbacks[i].fence = 0;
+		readbacks[i].size = 0;
+	}
+
+	if (!supported) {
+
+		cout << "Sampler feedback not available - GL_ARB_shader_image_load_store is not supported" << endl;
+		return;
+	}
+
+	glGenBuffers(1, &tileBuffer);
+	glGenTextures(1, &tileTexture);
+
+	for (GLuint i = 0; i < NUM_READBACK_BUFFERS; i++)
+		glGenBuffers(1, &readbacks[i].buffer);
+}
+
+
+SamplerFeedback::~SamplerFeedback() {
+
+	if (!supported)
+		return;
+
+	for (GLuint i = 0; i < NUM_READBACK_BUFFERS; i++) {
+
+		if (readbacks[i].fence)
+			glDeleteSync(readbacks[i].fence);
+
+		glDeleteBuffers(1, &readbacks[i].buffer);
+	}
+
+	glDeleteTextures(1, &tileTexture);
+	glDeleteBuffers(1, &tileBuffer);
+}
+
+
+bool SamplerFeedback::isSupported() const {
+
+	return supported;
+}
+
+
+void SamplerFeedback::setViewportSize(GLuint width, GLuint height) {
+
+	tilesX = std::max<GLuint>((width + tileSize - 1) / tileSize, 1);
+	tilesY = std::max<GLuint>((height + tileSize - 1) / tileSize, 1);
+}
+
+
+GLuint SamplerFeedback::registerTexture(GLuint texture) {
+
+	FeedbackTexture feedbackTexture;
+
+	feedbackTexture.texture = texture;
+	feedbackTexture.lastMinMip = MIP_NOT_NEEDED;
+
+	GLint width = 0, height = 0;
+	GLfloat anisotropy = 1.0f;
+
+	glBindTexture(GL_TEXTURE_2D, texture);
+
+	glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &width);
+	glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &height);
+	glGetTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, &anisotropy);
+
+	// Count the levels actually present - textures loaded without mipmaps have a single level
+	GLuint numLevels = 1;
+	GLuint maxLevels = mipLevelCount((GLuint)std::max<GLint>(width, 1), (GLuint)std::max<GLint>(height, 1));
+
+	while (numLevels < maxLevels) {
+
+		GLint levelWidth = 0;
+
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, numLevels, GL_TEXTURE_WIDTH, &levelWidth);
+
+		if (levelWidth == 0)
+			break;
+
+		numLevels++;
+	}
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	feedbackTexture.width = (GLuint)width;
+	feedbackTexture.height = (GLuint)height;
+	feedbackTexture.maxAnisotropy = std::max<GLfloat>(anisotropy, 1.0f);
+
+	initMipResidency(feedbackTexture.residency, numLevels);
+
+	textures.push_back(feedbackTexture);
+
+	return (GLuint)textures.size() - 1;
+}
+
+
+GLuint SamplerFeedback::createProgram(const string& vsPath) {
+
+	if (!supported)
+		return 0;
+
+	GLuint program = setupShaders(vsPath, string(""), string("Shaders\\sampler_feedback.fs.txt"));
+
+	glUseProgram(program);
+	glUniform1i(glGetUniformLocation(program, "feedbackTiles"), 0);
+	glUseProgram(0);
+
+	return program;
+}
+
+
+bool SamplerFeedback::beginPass() {
+
+	GLCallContext glCallContext(__FUNCTION__);
+
+	if (!supported || textures.empty())
+		return false;
+
+	// The readback buffer for this pass is reused once its previous result has been processed.  If the GPU is more than NUM_READBACK_BUFFERS frames behind the pass is skipped
+	if (readbacks[currentReadback].fence) {
+
+		framesSkipped++;
+		return false;
+	}
+
+	GLuint requiredSize = getTileCount() * (GLuint)textures.size() * sizeof(GLuint);
+
+	if (requiredSize != tileBufferSize)
+		allocateTileBuffer();
+
+	// Reset every tile to 'not sampled'
+	glBindBuffer(GL_TEXTURE_BUFFER, tileBuffer);
+	glBufferSubData(GL_TEXTURE_BUFFER, 0, tileBufferSize, clearData.data());
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+	glBindImageTexture(0, tileTexture, 0, GL_FALSE, 0, GL_READ_WRITE, GL_R32UI);
+
+	glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+	glDepthMask(GL_FALSE);
+
+	passActive = true;
+
+	return true;
+}
+
+
+void SamplerFeedback::bindSlot(GLuint program, GLuint slot) {
+
+	if (!passActive || slot >= textures.size())
+		return;
+
+	const FeedbackTexture& feedbackTexture = textures[slot];
+
+	glUniform2f(glGetUniformLocation(program, "textureSize"), (float)feedbackTexture.width, (float)feedbackTexture.height);
+	glUniform1f(glGetUniformLocation(program, "maxAnisotropy"), feedbackTexture.maxAnisotropy);
+	glUniform1i(glGetUniformLocation(program, "tileSize"), (GLint)tileSize);
+	glUniform2i(glGetUniformLocation(program, "tileCount"), (GLint)tilesX, (GLint)tilesY);
+	glUniform1i(glGetUniformLocation(program, "slotOffset"), (GLint)(slot * getTileCount()));
+}
+
+
+void SamplerFeedback::endPass() {
+
+	GLCallContext glCallContext(__FUNCTION__);
+
+	if (!passActive)
+		return;
+
+	glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+	glDepthMask(GL_TRUE);
+
+	glBindImageTexture(0, 0, 0, GL_FALSE, 0, GL_READ_WRITE, GL_R32UI);
+
+	// Make the atomic writes visible to the copy then queue the copy and a fence to mark its completion
+	glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+
+	Readback& readback = readbacks[currentReadback];
+
+	glBindBuffer(GL_COPY_READ_BUFFER, tileBuffer);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, readback.buffer);
+
+	if (readback.size < tileBufferSize) {
+
+		glBufferData(GL_COPY_WRITE_BUFFER, tileBufferSize, nullptr, GL_STREAM_READ);
+		readback.size = tileBufferSize;
+	}
+
+	glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, tileBufferSize);
+
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	readback.tilesX = tilesX;
+	readback.tilesY = tilesY;
+	readback.numSlots = tileBufferSize / (getTileCount() * sizeof(GLuint));
+
+	currentReadback = (currentReadback + 1) % NUM_READBACK_BUFFERS;
+	passActive = false;
+}
+
+
+bool SamplerFeedback::update() {
+
+	if (!supported)
+		return false;
+
+	// Oldest readback first.  Polling with a zero timeout never blocks
+	for (GLuint i = 0; i < NUM_READBACK_BUFFERS; i++) {
+
+		Readback& readback = readbacks[(currentReadback + i) % NUM_READBACK_BUFFERS];
+
+		if (!readback.fence)
+			continue;
+
+		GLenum result = glClientWaitSync(readback.fence, 0, 0);
+
+		if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED)
+			processReadback(readback);
+	}
+
+	bool changed = residencyChanged;
+
+	residencyChanged = false;
+
+	return changed;
+}
+
+
+void SamplerFeedback::resetResidency() {
+
+	for (auto& feedbackTexture : textures) {
+
+		initMipResidency(feedbackTexture.residency, feedbackTexture.residency.numLevels);
+		feedbackTexture.lastMinMip = MIP_NOT_NEEDED;
+
+		glBindTexture(GL_TEXTURE_2D, feedbackTexture.texture);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+	}
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+
+GLint SamplerFeedback::getMinMipNeeded(GLuint slot) const {
+
+	return (slot < textures.size()) ? textures[slot].lastMinMip : MIP_NOT_NEEDED;
+}
+
+
+GLint SamplerFeedback::getResidentBaseLevel(GLuint slot) const {
+
+	return (slot < textures.size()) ? textures[slot].residency.baseLevel : 0;
+}
+
+
+GLuint SamplerFeedback::getNumLevels(GLuint slot) const {
+
+	return (slot < textures.size()) ? textures[slot].residency.numLevels : 0;
+}
+
+
+GLuint SamplerFeedback::getTileCount() const {
+
+	return tilesX * tilesY;
+}
+
+
+unsigned long long SamplerFeedback::getResultsProcessed() const {
+
+	return resultsProcessed;
+}
+
+
+unsigned long long SamplerFeedback::getFramesSkipped() const {
+
+	return framesSkipped;
+}
+
+#pragma endregion
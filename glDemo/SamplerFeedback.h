@@ -0,0 +1,101 @@
+#pragma once
+
+#include "core.h"
+#include "MipFeedback.h"
+
+// Optional feedback pass recording which mip levels of registered textures the view needs.  The screen is divided into tiles and the feedback fragment shader (Shaders\sampler_feedback.fs) computes the level of detail from texture coordinate derivatives (allowing for anisotropic filtering) and stores the per-tile minimum in a texture buffer with imageAtomicMin.  The tile buffer is copied to one of a ring of readback buffers guarded by fences and read on a later frame once the GPU has finished, so the pass never stalls the pipeline.  Results are reduced on the CPU (see MipFeedback.h) to the minimum mip each texture needs, which drives each texture's residency.  The demo's textures are uploaded in full so residency is applied by clamping GL_TEXTURE_BASE_LEVEL - a streaming loader would upload and release levels at the same point.  Requires GL_ARB_shader_image_load_store
+
+class SamplerFeedback {
+
+	static const GLuint		NUM_READBACK_BUFFERS = 3;
+
+	struct FeedbackTexture {
+
+		GLuint			texture;
+		GLuint			width, height;
+		GLfloat			maxAnisotropy;
+		MipResidency	residency;
+		GLint			lastMinMip; // minimum mip from the most recent feedback result
+	};
+
+	struct Readback {
+
+		GLuint			buffer;
+		GLuint			size; // bytes allocated
+		GLsync			fence; // 0 if the buffer is free
+		GLuint			tilesX, tilesY, numSlots; // layout of the tiles when the copy was made
+	};
+
+	bool					supported;
+
+	GLuint					tileSize; // pixels
+	GLuint					tilesX, tilesY;
+	GLuint					evictDelay;
+
+	// Tile buffer - tilesX * tilesY tiles per registered texture
+	GLuint					tileBuffer;
+	GLuint					tileTexture;
+	GLuint					tileBufferSize; // bytes allocated
+	std::vector<GLuint>		clearData;
+
+	Readback				readbacks[NUM_READBACK_BUFFERS];
+	GLuint					currentReadback;
+
+	std::vector<FeedbackTexture>	textures;
+
+	bool					passActive;
+	bool					residencyChanged; // set when a readback changes a texture's resident levels
+
+	// Statistics
+	unsigned long long		resultsProcessed;
+	unsigned long long		framesSkipped; // feedback passes skipped because every readback buffer was in use
+
+	//
+	// Private API
+	//
+
+	void allocateTileBuffer();
+	void processReadback(Readback& readback);
+
+public:
+
+	// Feedback is recorded per tileSize x tileSize pixel tile for a viewport of the given size.  Levels are evicted after evictDelay consecutive results have not needed them
+	SamplerFeedback(GLuint tileSize, GLuint viewportWidth, GLuint viewportHeight, GLuint evictDelay = 8);
+
+	~SamplerFeedback();
+
+	// Return false if the feedback pass is not supported by the current context.  All other calls are ignored in this case
+	bool isSupported() const;
+
+	void setViewportSize(GLuint width, GLuint height);
+
+	// Register a GL_TEXTURE_2D for feedback and return its feedback slot
+	GLuint registerTexture(GLuint texture);
+
+	// Link a feedback program from the given vertex shader and the feedback fragment shader.  The vertex shader must output texture coordinates in the same SimplePacket block as Shaders\basic_texture.vs.  Return 0 if feedback is not supported
+	GLuint createProgram(const std::string& vsPath);
+
+	// Start a feedback pass.  Colour and depth writes are disabled until endPass.  Return false if the pass is skipped this frame
+	bool beginPass();
+
+	// Set the feedback uniforms of program (which must be in use) to record into the given slot
+	void bindSlot(GLuint program, GLuint slot);
+
+	// End the feedback pass and queue the tile buffer for readback
+	void endPass();
+
+	// Process readbacks the GPU has completed and update texture residency.  Return true if any texture's resident levels changed
+	bool update();
+
+	// Restore the full mip chain of every registered texture
+	void resetResidency();
+
+	// Feedback results for a slot
+	GLint getMinMipNeeded(GLuint slot) const;
+	GLint getResidentBaseLevel(GLuint slot) const;
+	GLuint getNumLevels(GLuint slot) const;
+
+	GLuint getTileCount() const;
+	unsigned long long getResultsProcessed() const;
+	unsigned long long getFramesSkipped() const;
+};
@@ -0,0 +1,528 @@
+
+#include "SceneBVH.h"
+#include "CPUProfiler.h"
+#include "JobSystem.h"
+#include <chrono>
+
+using namespace std;
+using namespace cst;
+
+
+#pragma region Bounds helpers
+
+static inline float surfaceArea(const glm::vec3& boundsMin, const glm::vec3& boundsMax) {
+
+	glm::vec3 e = glm::max(boundsMax - boundsMin, glm::vec3(0.0f));
+
+	return 2.0f * (e.x * e.y + e.y * e.z + e.z * e.x);
+}
+
+static inline void emptyBounds(glm::vec3& boundsMin, glm::vec3& boundsMax) {
+
+	boundsMin = glm::vec3(numeric_limits<float>::max());
+	boundsMax = glm::vec3(-numeric_limits<float>::max());
+}
+
+#pragma endregion
+
+
+#pragma region Private API
+
+// Return the bounds of objects [first, first + count) in objectIndices and the bounds of their centroids
+SceneBVH::RangeBounds SceneBVH::computeRangeBounds(GLuint first, GLuint count) const {
+
+	auto accumulate = [this](GLuint begin, GLuint end, RangeBounds& range) {
+
+		for (GLuint i = begin; i < end; i++) {
+
+			GLuint obj = objectIndices[i];
+
+			range.boundsMin = glm::min(range.boundsMin, objectMin[obj]);
+			range.boundsMax = glm::max(range.boundsMax, objectMax[obj]);
+			range.centroidMin = glm::min(range.centroidMin, centroids[obj]);
+			range.centroidMax = glm::max(range.centroidMax, centroids[obj]);
+		}
+	};
+
+	RangeBounds range;
+
+	emptyBounds(range.boundsMin, range.boundsMax);
+	emptyBounds(range.centroidMin, range.centroidMax);
+
+	if (!jobSystem || count <= PARALLEL_BIN_THRESHOLD) {
+
+		accumulate(first, first + count, range);
+		return range;
+	}
+
+	// Large ranges are split into chunks, each accumulating into its own result, then merged
+	const size_t grainSize = PARALLEL_BIN_THRESHOLD / 4;
+
+	vector<RangeBounds> partials((count + grainSize - 1) / grainSize, range);
+
+	jobSystem->parallelFor(first, first + count, grainSize, [&](size_t begin, size_t end) {
+
+		accumulate((GLuint)begin, (GLuint)end, partials[(begin - first) / grainSize]);
+	});
+
+	for (auto& partial : partials) {
+
+		range.boundsMin = glm::min(range.boundsMin, partial.boundsMin);
+		range.boundsMax = glm::max(range.boundsMax, partial.boundsMax);
+		range.centroidMin = glm::min(range.centroidMin, partial.centroidMin);
+		range.centroidMax = glm::max(range.centroidMax, partial.centroidMax);
+	}
+
+	return range;
+}
+
+
+// Bin the centroids of objects [first, first + count) along each axis
+void SceneBVH::computeBins(GLuint first, GLuint count, const RangeBounds& range, Bin bins[3][NUM_BINS]) const {
+
+	glm::vec3 extent = range.centroidMax - range.centroidMin;
+	glm::vec3 binScale;
+
+	for (int axis = 0; axis < 3; axis++)
+		binScale[axis] = (extent[axis] > 0.0f) ? float(NUM_BINS) / extent[axis] : 0.0f;
+
+	auto accumulate = [&](GLuint begin, GLuint end, Bin (*target)[NUM_BINS]) {
+
+		for (int axis = 0; axis < 3; axis++) {
+
+			for (GLuint b = 0; b < NUM_BINS; b++) {
+
+				emptyBounds(target[axis][b].boundsMin, target[axis][b].boundsMax);
+				target[axis][b].count = 0;
+			}
+		}
+
+		for (GLuint i = begin; i < end; i++) {
+
+			GLuint obj = objectIndices[i];
+
+			for (int axis = 0; axis < 3; axis++) {
+
+				GLuint b = std::min<GLuint>(GLuint((centroids[obj][axis] - range.centroidMin[axis]) * binScale[axis]), NUM_BINS - 1);
+
+				Bin& bin = target[axis][b];
+
+				bin.boundsMin = glm::min(bin.boundsMin, objectMin[obj]);
+				bin.boundsMax = glm::max(bin.boundsMax, objectMax[obj]);
+				bin.count++;
+			}
+		}
+	};
+
+	if (!jobSystem || count <= PARALLEL_BIN_THRESHOLD) {
+
+		accumulate(first, first + count, bins);
+		return;
+	}
+
+	struct BinSet {
+
+		Bin		bins[3][NUM_BINS];
+	};
+
+	const size_t grainSize = PARALLEL_BIN_THRESHOLD / 4;
+
+	vector<BinSet> partials((count + grainSize - 1) / grainSize);
+
+	jobSystem->parallelFor(first, first + count, grainSize, [&](size_t begin, size_t end) {
+
+		accumulate((GLuint)begin, (GLuint)end, partials[(begin - first) / grainSize].bins);
+	});
+
+	for (int axis = 0; axis < 3; axis++) {
+
+		for (GLuint b = 0; b < NUM_BINS; b++) {
+
+			Bin& bin = bins[axis][b];
+
+			emptyBounds(bin.boundsMin, bin.boundsMax);
+			bin.count = 0;
+
+			for (auto& partial : partials) {
+
+				bin.boundsMin = glm::min(bin.boundsMin, partial.bins[axis][b].boundsMin);
+				bin.boundsMax = glm::max(bin.boundsMax, partial.bins[axis][b].boundsMax);
+				bin.count += partial.bins[axis][b].count;
+			}
+		}
+	}
+}
+
+
+// Build the subtree rooted at nodeIndex over objects [first, first + count) in objectIndices.  Large subtrees are split across the job system - child jobs are tracked by counter
+void SceneBVH::buildNode(GLuint nodeIndex, GLuint first, GLuint count, JobCounter* counter) {
+
+	RangeBounds range = computeRangeBounds(first, count);
+
+	Node& node = nodes[nodeIndex];
+
+	node.boundsMin = range.boundsMin;
+	node.boundsMax = range.boundsMax;
+	node.first = first;
+	node.numObjects = count;
+
+	if (count <= MAX_LEAF_SIZE)
+		return;
+
+	// Find the lowest cost split over all axes using the binned surface area heuristic.  The cost of a split is approximated by countLeft * areaLeft + countRight * areaRight
+	Bin bins[3][NUM_BINS];
+
+	computeBins(first, count, range, bins);
+
+	float bestCost = numeric_limits<float>::max();
+	int bestAxis = -1;
+	GLuint bestSplit = 0;
+
+	for (int axis = 0; axis < 3; axis++) {
+
+		if (range.centroidMax[axis] <= range.centroidMin[axis])
+			continue;
+
+		// Sweep from the right to record the cost of each right hand partition, then from the left to evaluate each split
+		float rightArea[NUM_BINS];
+		GLuint rightCount[NUM_BINS];
+		glm::vec3 boundsMin, boundsMax;
+		GLuint n = 0;
+
+		emptyBounds(boundsMin, boundsMax);
+
+		for (GLuint b = NUM_BINS - 1; b > 0; b--) {
+
+			boundsMin = glm::min(boundsMin, bins[axis][b].boundsMin);
+			boundsMax = glm::max(boundsMax, bins[axis][b].boundsMax);
+			n += bins[axis][b].count;
+
+			rightArea[b] = surfaceArea(boundsMin, boundsMax);
+			rightCount[b] = n;
+		}
+
+		emptyBounds(boundsMin, boundsMax);
+		n = 0;
+
+		for (GLuint b = 0; b < NUM_BINS - 1; b++) {
+
+			boundsMin = glm::min(boundsMin, bins[axis][b].boundsMin);
+			boundsMax = glm::max(boundsMax, bins[axis][b].boundsMax);
+			n += bins[axis][b].count;
+
+			if (n == 0 || rightCount[b + 1] == 0)
+				continue;
+
+			float cost = float(n) * surfaceArea(boundsMin, boundsMax) + float(rightCount[b + 1]) * rightArea[b + 1];
+
+			if (cost < bestCost) {
+
+				bestCost = cost;
+				bestAxis = axis;
+				bestSplit = b + 1;
+			}
+		}
+	}
+
+	GLuint leftCount;
+
+	if (bestAxis >= 0) {
+
+		// Keep small nodes as leaves if splitting does not reduce the expected cost
+		if (count <= MAX_LEAF_SIZE * 4 && bestCost >= float(count) * surfaceArea(range.boundsMin, range.boundsMax))
+			return;
+
+		float binScale = float(NUM_BINS) / (range.centroidMax[bestAxis] - range.centroidMin[bestAxis]);
+		float centroidMin = range.centroidMin[bestAxis];
+
+		auto splitPoint = std::partition(objectIndices.begin() + first, objectIndices.begin() + first + count, [&](GLuint obj) {
+
+			return std::min<GLuint>(GLuint((centroids[obj][bestAxis] - centroidMin) * binScale), NUM_BINS - 1) < bestSplit;
+		});
+
+		leftCount = GLuint(splitPoint - (objectIndices.begin() + first));
+	}
+	else {
+
+		// All centroids coincide - split the range in half so leaves stay small
+		leftCount = count / 2;
+	}
+
+	GLuint left = nodesUsed.fetch_add(2);
+
+	node.first = left;
+	node.numObjects = 0;
+
+	if (jobSystem && count > PARALLEL_BUILD_THRESHOLD) {
+
+		jobSystem->submit([this, left, first, leftCount, counter]() { buildNode(left, first, leftCount, counter); }, counter);
+		buildNode(left + 1, first + leftCount, count - leftCount, counter);
+	}
+	else {
+
+		buildNode(left, first, leftCount, counter);
+		buildNode(left + 1, first + leftCount, count - leftCount, counter);
+	}
+}
+
+#pragma endregion
+
+
+#pragma region Public API
+
+SceneBVH::SceneBVH() : nodesUsed(0) {
+
+	jobSystem = nullptr;
+
+	buildTime = 0.0;
+	refitTime = 0.0;
+	cullTime = 0.0;
+
+	lastNodesVisited = 0;
+	lastObjectsTested = 0;
+	lastObjectsAccepted = 0;
+}
+
+
+void SceneBVH::build(const glm::vec3* boundsMin, const glm::vec3* boundsMax, GLuint numObjects, JobSystem* jobSystem) {
+
+	CPU_PROFILE_FUNCTION();
+
+	auto startTime = chrono::steady_clock::now();
+
+	this->jobSystem = jobSystem;
+
+	nodes.clear();
+	nodesUsed = 0;
+
+	objectIndices.resize(numObjects);
+	objectMin.assign(boundsMin, boundsMin + numObjects);
+	objectMax.assign(boundsMax, boundsMax + numObjects);
+	centroids.resize(numObjects);
+
+	if (numObjects > 0) {
+
+		for (GLuint i = 0; i < numObjects; i++) {
+
+			objectIndices[i] = i;
+			centroids[i] = (boundsMin[i] + boundsMax[i]) * 0.5f;
+		}
+
+		// A binary tree with n leaves has 2n - 1 nodes
+		nodes.resize(2 * numObjects - 1);
+		nodesUsed = 1;
+
+		JobCounter counter;
+
+		buildNode(0, 0, numObjects, &counter);
+
+		if (jobSystem)
+			jobSystem->wait(counter);
+
+		// Store object bounds in leaf order
+		vector<glm::vec3> orderedMin(numObjects), orderedMax(numObjects);
+
+		for (GLuint i = 0; i < numObjects; i++) {
+
+			orderedMin[i] = objectMin[objectIndices[i]];
+			orderedMax[i] = objectMax[objectIndices[i]];
+		}
+
+		objectMin.swap(orderedMin);
+		objectMax.swap(orderedMax);
+
+		nodes.resize(nodesUsed);
+	}
+
+	centroids.clear();
+	centroids.shrink_to_fit();
+
+	buildTime = chrono::duration<double, milli>(chrono::steady_clock::now() - startTime).count();
+}
+
+
+void SceneBVH::refit(const glm::vec3* boundsMin, const glm::vec3* boundsMax) {
+
+	CPU_PROFILE_FUNCTION();
+
+	auto startTime = chrono::steady_clock::now();
+
+	GLuint numNodes = (GLuint)nodes.size();
+
+	// Leaves are independent so are refit in parallel
+	auto refitLeaves = [&](size_t begin, size_t end) {
+
+		for (size_t n = begin; n < end; n++) {
+
+			Node& node = nodes[n];
+
+			if (node.numObjects == 0)
+				continue;
+
+			emptyBounds(node.boundsMin, node.boundsMax);
+
+			for (GLuint i = node.first; i < node.first + node.numObjects; i++) {
+
+				objectMin[i] = boundsMin[objectIndices[i]];
+				objectMax[i] = boundsMax[objectIndices[i]];
+
+				node.boundsMin = glm::min(node.boundsMin, objectMin[i]);
+				node.boundsMax = glm::max(node.boundsMax, objectMax[i]);
+			}
+		}
+	};
+
+	if (jobSystem)
+		jobSystem->parallelFor(0, numNodes, 4096, refitLeaves);
+	else
+		refitLeaves(0, numNodes);
+
+	// Children are always allocated after their parent so a reverse sweep updates every child before its parent
+	for (GLuint n = numNodes; n-- > 0;) {
+
+		Node& node = nodes[n];
+
+		if (node.numObjects > 0)
+			continue;
+
+		const Node& left = nodes[node.first];
+		const Node& right = nodes[node.first + 1];
+
+		node.boundsMin = glm::min(left.boundsMin, right.boundsMin);
+		node.boundsMax = glm::max(left.boundsMax, right.boundsMax);
+	}
+
+	refitTime = chrono::duration<double, milli>(chrono::steady_clock::now() - startTime).count();
+}
+
+
+GLuint SceneBVH::cull(const ViewFrustum& frustum, vector<GLuint>& visibleObjects) {
+
+	CPU_PROFILE_FUNCTION();
+
+	auto startTime = chrono::steady_clock::now();
+
+	visibleObjects.clear();
+
+	lastNodesVisited = 0;
+	lastObjectsTested = 0;
+	lastObjectsAccepted = 0;
+
+	if (nodes.empty()) {
+
+		cullTime = 0.0;
+		return 0;
+	}
+
+	// Traversal stack of (node, plane mask) pairs.  The stack grows by one entry per level so is kept small for a SAH tree
+	struct StackEntry {
+
+		GLuint			node;
+		unsigned int	planeMask;
+	};
+
+	vector<StackEntry> stack;
+
+	stack.reserve(128);
+	stack.push_back({ 0, frustum.cullPlaneMask() });
+
+	while (!stack.empty()) {
+
+		StackEntry entry = stack.back();
+		stack.pop_back();
+		const Node& node = nodes[entry.node];
+		unsigned int planeMask = entry.planeMask;
+
+		lastNodesVisited++;
+
+		// Only test planes the parent crossed
+		if (planeMask != 0) {
+
+			glm::vec3 centre = (node.boundsMin + node.boundsMax) * 0.5f;
+			glm::vec3 extent = (node.boundsMax - node.boundsMin) * 0.5f;
+
+			if (frustum.intersectAABB(centre, extent, planeMask) == PL_BACK)
+				continue;
+		}
+
+		if (node.numObjects > 0) {
+
+			for (GLuint i = node.first; i < node.first + node.numObjects; i++) {
+
+				if (planeMask == 0) {
+
+					visibleObjects.push_back(objectIndices[i]);
+					lastObjectsAccepted++;
+				}
+				else {
+
+					unsigned int objectMask = planeMask;
+
+					lastObjectsTested++;
+
+					if (frustum.intersectAABB((objectMin[i] + objectMax[i]) * 0.5f, (objectMax[i] - objectMin[i]) * 0.5f, objectMask) != PL_BACK)
+						visibleObjects.push_back(objectIndices[i]);
+				}
+			}
+		}
+		else {
+
+			stack.push_back({ node.first + 1, planeMask });
+			stack.push_back({ node.first, planeMask });
+		}
+	}
+
+	cullTime = chrono::duration<double, milli>(chrono::steady_clock::now() - startTime).count();
+
+	return (GLuint)visibleObjects.size();
+}
+
+
+GLuint SceneBVH::getNodeCount() const {
+
+	return (GLuint)nodes.size();
+}
+
+
+GLuint SceneBVH::getObjectCount() const {
+
+	return (GLuint)objectIndices.size();
+}
+
+
+double SceneBVH::getBuildTime() const {
+
+	return buildTime;
+}
+
+
+double SceneBVH::getRefitTime() const {
+
+	return refitTime;
+}
+
+
+double SceneBVH::getCullTime() const {
+
+	return cullTime;
+}
+
+
+GLuint SceneBVH::getNodesVisited() const {
+
+	return lastNodesVisited;
+}
+
+
+GLuint SceneBVH::getObjectsTested() const {
+
+	return lastObjectsTested;
+}
+
+
+GLuint SceneBVH::getObjectsAccepted() const {
+
+	return lastObjectsAccepted;
+}
+
+#pragma endregion
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "core.h"
+#include "ViewFrustum.h"
+#include <atomic>
+
+class JobSystem;
+class JobCounter;
+
+// Bounding volume hierarchy over the world space AABBs of scene objects, used to cull large scenes (road segments, billboards etc.) against a ViewFrustum in sub-linear time.  The tree is built top-down with a binned surface area heuristic (SAH) - large nodes are binned in parallel and subtrees are built in parallel on a JobSystem.  When objects move the tree can be refit (node bounds recalculated with the same topology) rather than rebuilt.  Traversal tracks a plane mask per node so children are not tested against planes their parent lies completely in front of, and subtrees lying completely inside the frustum are accepted without further tests
+
+class SceneBVH {
+
+	struct Node {
+
+		glm::vec3		boundsMin;
+		GLuint			first; // interior node: index of left child (the right child is first + 1).  Leaf node: index of the first object in objectIndices
+		glm::vec3		boundsMax;
+		GLuint			numObjects; // 0 for interior nodes
+	};
+
+	// Axis-aligned bounds of a range of objects and of their centroids
+	struct RangeBounds {
+
+		glm::vec3		boundsMin, boundsMax;
+		glm::vec3		centroidMin, centroidMax;
+	};
+
+	struct Bin {
+
+		glm::vec3		boundsMin, boundsMax;
+		GLuint			count;
+	};
+
+	static const GLuint		MAX_LEAF_SIZE = 4;
+	static const GLuint		NUM_BINS = 16;
+	static const GLuint		PARALLEL_BUILD_THRESHOLD = 4096; // nodes with more objects than this build their subtrees in parallel
+	static const GLuint		PARALLEL_BIN_THRESHOLD = 65536; // nodes with more objects than this compute bounds and bins in parallel
+
+	std::vector<Node>		nodes;
+	std::atomic<GLuint>		nodesUsed;
+
+	// objectIndices maps leaf order to object index.  Object bounds are stored in leaf order so traversal reads them sequentially
+	std::vector<GLuint>		objectIndices;
+	std::vector<glm::vec3>	objectMin, objectMax;
+	std::vector<glm::vec3>	centroids; // build only - indexed by object index
+
+	JobSystem*				jobSystem;
+
+	// Statistics
+	double					buildTime, refitTime, cullTime; // milliseconds
+	GLuint					lastNodesVisited;
+	GLuint					lastObjectsTested;
+	GLuint					lastObjectsAccepted; // objects in subtrees found to be completely inside the frustum
+
+	//
+	// Private API
+	//
+
+	RangeBounds computeRangeBounds(GLuint first, GLuint count) const;
+	void computeBins(GLuint first, GLuint count, const RangeBounds& range, Bin bins[3][NUM_BINS]) const;
+	void buildNode(GLuint nodeIndex, GLuint first, GLuint count, JobCounter* counter);
+
+public:
+
+	SceneBVH();
+
+	// Build the hierarchy over numObjects objects with the given world space bounds.  If jobSystem is nullptr the tree is built on the calling thread
+	void build(const glm::vec3* boundsMin, const glm::vec3* boundsMax, GLuint numObjects, JobSystem* jobSystem);
+
+	// Recalculate node bounds after objects have moved.  Object i must refer to the same object as in the last call to build.  The tree topology is unchanged so culling efficiency degrades if objects move far from their original positions - rebuild in this case
+	void refit(const glm::vec3* boundsMin, const glm::vec3* boundsMax);
+
+	// Append the indices of objects intersecting the frustum to visibleObjects (which is cleared first) and return the number of visible objects
+	GLuint cull(const cst::ViewFrustum& frustum, std::vector<GLuint>& visibleObjects);
+
+	GLuint getNodeCount() const;
+	GLuint getObjectCount() const;
+
+	// Timings (in milliseconds) of the last build, refit and cull
+	double getBuildTime() const;
+	double getRefitTime() const;
+	double getCullTime() const;
+
+	// Traversal statistics for the last cull
+	GLuint getNodesVisited() const;
+	GLuint getObjectsTested() const;
+	GLuint getObjectsAccepted() const;
+};
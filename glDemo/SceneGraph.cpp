@@ -0,0 +1,355 @@
+
+#include "SceneGraph.h"
+#include "CPUProfiler.h"
+#include "JobSystem.h"
+#include "MultiDrawBatch.h"
+#include <chrono>
+
+using namespace std;
+
+
+// Nodes per job when a level is split across the job system
+static const size_t UPDATE_GRAIN_SIZE = 2048;
+static const size_t SUBMIT_GRAIN_SIZE = 4096;
+
+
+#pragma region Private API
+
+// Sort nodes by depth (stable, so siblings keep their relative order) and rebuild the level ranges.  A node's depth is always greater than its parent's so the result is parent-before-child
+void SceneGraph::rebuildOrder() {
+
+	GLuint numNodes = (GLuint)parent.size();
+
+	bool sorted = true;
+
+	for (GLuint i = 1; i < numNodes && sorted; i++)
+		sorted = (depth[i - 1] <= depth[i]);
+
+	if (!sorted) {
+
+		vector<GLuint> order(numNodes);
+
+		for (GLuint i = 0; i < numNodes; i++)
+			order[i] = i;
+
+		stable_sort(order.begin(), order.end(), [this](GLuint a, GLuint b) { return depth[a] < depth[b]; });
+
+		// newIndex[old position] = new position
+		vector<GLuint> newIndex(numNodes);
+
+		for (GLuint i = 0; i < numNodes; i++)
+			newIndex[order[i]] = i;
+
+		auto permute = [&order](auto& values) {
+
+			typename std::remove_reference<decltype(values)>::type sortedValues(values.size());
+
+			for (size_t i = 0; i < values.size(); i++)
+				sortedValues[i] = values[order[i]];
+
+			values.swap(sortedValues);
+		};
+
+		permute(parent);
+		permute(depth);
+		permute(position);
+		permute(orientation);
+		permute(scale);
+		permute(worldTransform);
+		permute(localChanged);
+		permute(meshID);
+		permute(textureLayer);
+		permute(indexToHandle);
+
+		for (GLuint i = 0; i < numNodes; i++) {
+
+			if (parent[i] != NO_PARENT)
+				parent[i] = newIndex[parent[i]];
+
+			handleToIndex[indexToHandle[i]] = i;
+		}
+	}
+
+	// Rebuild level ranges
+	levelStart.clear();
+
+	for (GLuint i = 0; i < numNodes; i++) {
+
+		while (levelStart.size() <= depth[i])
+			levelStart.push_back(i);
+	}
+
+	levelStart.push_back(numNodes);
+
+	structureChanged = false;
+}
+
+#pragma endregion
+
+
+#pragma region Public API
+
+SceneGraph::SceneGraph(JobSystem* jobSystem) {
+
+	this->jobSystem = jobSystem;
+
+	structureChanged = false;
+	anyLocalChanged = false;
+
+	lastNodesUpdated = 0;
+	lastUpdateTime = 0.0;
+}
+
+
+GLuint SceneGraph::addNode(GLuint parentHandle, const glm::vec3& localPosition, const glm::quat& localOrientation, const glm::vec3& localScale, GLuint meshID, GLint textureLayer) {
+
+	GLuint handle = (GLuint)handleToIndex.size();
+	GLuint index = (GLuint)parent.size();
+
+	GLuint parentIndex = (parentHandle != NO_PARENT && parentHandle < handle) ? handleToIndex[parentHandle] : NO_PARENT;
+
+	// New nodes are appended - if this breaks the depth ordering the arrays are re-sorted on the next update
+	parent.push_back(parentIndex);
+	depth.push_back((parentIndex != NO_PARENT) ? depth[parentIndex] + 1 : 0);
+	position.push_back(localPosition);
+	orientation.push_back(localOrientation);
+	scale.push_back(localScale);
+	worldTransform.push_back(glm::mat4(1.0f));
+	localChanged.push_back(1);
+	worldChanged.push_back(0);
+	this->meshID.push_back(meshID);
+	this->textureLayer.push_back(textureLayer);
+
+	handleToIndex.push_back(index);
+	indexToHandle.push_back(handle);
+
+	structureChanged = true;
+	anyLocalChanged = true;
+
+	return handle;
+}
+
+
+void SceneGraph::setLocalTransform(GLuint handle, const glm::vec3& localPosition, const glm::quat& localOrientation, const glm::vec3& localScale) {
+
+	GLuint index = handleToIndex[handle];
+
+	position[index] = localPosition;
+	orientation[index] = localOrientation;
+	scale[index] = localScale;
+
+	localChanged[index] = 1;
+	anyLocalChanged = true;
+}
+
+
+void SceneGraph::setPosition(GLuint handle, const glm::vec3& localPosition) {
+
+	GLuint index = handleToIndex[handle];
+
+	position[index] = localPosition;
+
+	localChanged[index] = 1;
+	anyLocalChanged = true;
+}
+
+
+void SceneGraph::setOrientation(GLuint handle, const glm::quat& localOrientation) {
+
+	GLuint index = handleToIndex[handle];
+
+	orientation[index] = localOrientation;
+
+	localChanged[index] = 1;
+	anyLocalChanged = true;
+}
+
+
+const glm::vec3& SceneGraph::getPosition(GLuint handle) const {
+
+	return position[handleToIndex[handle]];
+}
+
+
+const glm::quat& SceneGraph::getOrientation(GLuint handle) const {
+
+	return orientation[handleToIndex[handle]];
+}
+
+
+const glm::mat4& SceneGraph::getWorldTransform(GLuint handle) const {
+
+	return worldTransform[handleToIndex[handle]];
+}
+
+
+GLuint SceneGraph::getMeshID(GLuint handle) const {
+
+	return meshID[handleToIndex[handle]];
+}
+
+
+GLint SceneGraph::getTextureLayer(GLuint handle) const {
+
+	return textureLayer[handleToIndex[handle]];
+}
+
+
+GLuint SceneGraph::getNodeCount() const {
+
+	return (GLuint)parent.size();
+}
+
+
+GLuint SceneGraph::getDepth() const {
+
+	return (levelStart.empty()) ? 0 : (GLuint)levelStart.size() - 1;
+}
+
+
+GLuint SceneGraph::update() {
+
+	CPU_PROFILE_FUNCTION();
+
+	auto startTime = chrono::steady_clock::now();
+
+	lastNodesUpdated = 0;
+
+	if (structureChanged)
+		rebuildOrder();
+
+	if (!anyLocalChanged) {
+
+		lastUpdateTime = chrono::duration<double, milli>(chrono::steady_clock::now() - startTime).count();
+		return 0;
+	}
+
+	atomic<GLuint> nodesUpdated(0);
+
+	// A node is recomputed if its local transform changed or its parent's world transform was recomputed earlier in this update.  Levels are processed in order so parents are always complete before their children are read
+	auto updateRange = [&](size_t begin, size_t end) {
+
+		GLuint n = 0;
+
+		for (size_t i = begin; i < end; i++) {
+
+			GLuint p = parent[i];
+			bool parentChanged = (p != NO_PARENT) && worldChanged[p];
+
+			if (!localChanged[i] && !parentChanged)
+				continue;
+
+			glm::mat4 local = glm::translate(glm::mat4(1.0f), position[i]) * glm::mat4_cast(orientation[i]) * glm::scale(glm::mat4(1.0f), scale[i]);
+
+			worldTransform[i] = (p != NO_PARENT) ? worldTransform[p] * local : local;
+			worldChanged[i] = 1;
+			n++;
+		}
+
+		nodesUpdated += n;
+	};
+
+	for (size_t level = 0; level + 1 < levelStart.size(); level++) {
+
+		size_t begin = levelStart[level];
+		size_t end = levelStart[level + 1];
+
+		if (jobSystem)
+			jobSystem->parallelFor(begin, end, UPDATE_GRAIN_SIZE, updateRange);
+		else
+			updateRange(begin, end);
+	}
+
+	// Reset change flags for the next update
+	std::fill(localChanged.begin(), localChanged.end(), GLubyte(0));
+	std::fill(worldChanged.begin(), worldChanged.end(), GLubyte(0));
+
+	anyLocalChanged = false;
+
+	lastNodesUpdated = nodesUpdated;
+	lastUpdateTime = chrono::duration<double, milli>(chrono::steady_clock::now() - startTime).count();
+
+	return lastNodesUpdated;
+}
+
+
+GLuint SceneGraph::submit(MultiDrawBatch* batch, const GLuint* handles, GLuint count) {
+
+	CPU_PROFILE_FUNCTION();
+
+	// Group node positions by mesh
+	for (auto& bucket : meshBuckets)
+		bucket.clear();
+
+	auto addToBucket = [this](GLuint index) {
+
+		GLuint mesh = meshID[index];
+
+		if (mesh == NO_MESH)
+			return;
+
+		if (mesh >= meshBuckets.size())
+			meshBuckets.resize(mesh + 1);
+
+		meshBuckets[mesh].push_back(index);
+	};
+
+	if (handles) {
+
+		for (GLuint i = 0; i < count; i++)
+			addToBucket(handleToIndex[handles[i]]);
+	}
+	else {
+
+		for (GLuint i = 0; i < (GLuint)parent.size(); i++)
+			addToBucket(i);
+	}
+
+	// Reserve one instanced command per mesh and copy world transforms straight into the batch's instance buffer
+	GLuint numSubmitted = 0;
+
+	for (GLuint mesh = 0; mesh < (GLuint)meshBuckets.size(); mesh++) {
+
+		const vector<GLuint>& bucket = meshBuckets[mesh];
+
+		if (bucket.empty())
+			continue;
+
+		MultiDrawInstance* instances = batch->reserveDraws(mesh, (GLuint)bucket.size());
+
+		if (!instances)
+			break;
+
+		auto writeRange = [&](size_t begin, size_t end) {
+
+			for (size_t i = begin; i < end; i++) {
+
+				instances[i].modelTransform = worldTransform[bucket[i]];
+				instances[i].params = glm::vec4((float)textureLayer[bucket[i]], 0.0f, 0.0f, 0.0f);
+			}
+		};
+
+		if (jobSystem)
+			jobSystem->parallelFor(0, bucket.size(), SUBMIT_GRAIN_SIZE, writeRange);
+		else
+			writeRange(0, bucket.size());
+
+		numSubmitted += (GLuint)bucket.size();
+	}
+
+	return numSubmitted;
+}
+
+
+GLuint SceneGraph::getNodesUpdated() const {
+
+	return lastNodesUpdated;
+}
+
+
+double SceneGraph::getUpdateTime() const {
+
+	return lastUpdateTime;
+}
+
+#pragma endregion
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "core.h"
+#include <atomic>
+
+class JobSystem;
+class MultiDrawBatch;
+
+// Transform hierarchy for scene objects.  Node data is stored in structure-of-arrays form, ordered by depth so every parent precedes its children and each level of the hierarchy is a contiguous range.  update() propagates local transforms to world space one level at a time, with each level split into chunks processed in parallel on a JobSystem.  Setters flag a node's local transform as changed and only changed nodes and their descendants are recomputed.  Nodes are referred to by handles that remain valid when the node arrays are re-ordered.  Nodes with a mesh can be submitted to a MultiDrawBatch, with world transforms written straight into the batch's per-frame instance buffer
+
+class SceneGraph {
+
+public:
+
+	static const GLuint		NO_PARENT = 0xFFFFFFFF;
+	static const GLuint		NO_MESH = 0xFFFFFFFF;
+
+private:
+
+	// Node data (SoA) indexed by node position in depth order
+	std::vector<GLuint>		parent; // index of parent node (NO_PARENT for root nodes)
+	std::vector<GLuint>		depth;
+	std::vector<glm::vec3>	position;
+	std::vector<glm::quat>	orientation;
+	std::vector<glm::vec3>	scale;
+	std::vector<glm::mat4>	worldTransform;
+	std::vector<GLubyte>	localChanged; // local transform modified since the last update
+	std::vector<GLubyte>	worldChanged; // world transform recomputed in the current update
+	std::vector<GLuint>		meshID; // MultiDrawBatch mesh (NO_MESH for transform-only nodes)
+	std::vector<GLint>		textureLayer;
+
+	// Handle <-> node position mapping
+	std::vector<GLuint>		handleToIndex;
+	std::vector<GLuint>		indexToHandle;
+
+	// levelStart[d] is the position of the first node at depth d.  levelStart has one extra entry marking the end of the deepest level
+	std::vector<GLuint>		levelStart;
+
+	bool					structureChanged; // nodes added since the last update
+	bool					anyLocalChanged;
+
+	// Scratch storage for submit - node positions grouped by mesh
+	std::vector<std::vector<GLuint>>	meshBuckets;
+
+	JobSystem*				jobSystem;
+
+	// Statistics for the last update
+	GLuint					lastNodesUpdated;
+	double					lastUpdateTime; // milliseconds
+
+	//
+	// Private API
+	//
+
+	void rebuildOrder(); // sort nodes by depth (stable) and rebuild the level ranges
+
+public:
+
+	// Create an empty scene graph.  If jobSystem is nullptr updates are made on the calling thread
+	SceneGraph(JobSystem* jobSystem);
+
+	// Add a node with the given local transform (relative to parentHandle, or world space if parentHandle = NO_PARENT) and return its handle.  If meshID is not NO_MESH the node is drawn by submit
+	GLuint addNode(GLuint parentHandle, const glm::vec3& localPosition, const glm::quat& localOrientation, const glm::vec3& localScale, GLuint meshID = NO_MESH, GLint textureLayer = -1);
+
+	// Local transform setters.  The world transform of the node and its descendants is recalculated on the next update
+	void setLocalTransform(GLuint handle, const glm::vec3& localPosition, const glm::quat& localOrientation, const glm::vec3& localScale);
+	void setPosition(GLuint handle, const glm::vec3& localPosition);
+	void setOrientation(GLuint handle, const glm::quat& localOrientation);
+
+	const glm::vec3& getPosition(GLuint handle) const;
+	const glm::quat& getOrientation(GLuint handle) const;
+
+	// World transform as of the last update
+	const glm::mat4& getWorldTransform(GLuint handle) const;
+
+	GLuint getMeshID(GLuint handle) const;
+	GLint getTextureLayer(GLuint handle) const;
+
+	GLuint getNodeCount() const;
+	GLuint getDepth() const; // number of levels in the hierarchy
+
+	// Propagate changed local transforms to world space.  Return the number of nodes whose world transform was recomputed
+	GLuint update();
+
+	// Write draws for the given nodes (or all nodes with a mesh if handles is nullptr) into batch.  Draws are grouped by mesh so each mesh is one instanced command.  Must be called between batch->beginFrame and batch->render.  Return the number of draws submitted
+	GLuint submit(MultiDrawBatch* batch, const GLuint* handles = nullptr, GLuint count = 0);
+
+	// Statistics for the last update
+	GLuint getNodesUpdated() const;
+	double getUpdateTime() const;
+};
@@ -0,0 +1,27 @@
+
+#include "SelfTest.h"
+
+
+using namespace std;
+
+
+bool selfTestCheck(bool condition, const char* description, int& failures) {
+
+	cout << ((condition) ? "  pass: " : "  FAIL: ") << description << endl;
+
+	if (!condition)
+		failures++;
+
+	return condition;
+}
+
+
+bool selfTestSummary(int failures) {
+
+	if (failures == 0)
+		cout << "All checks passed" << endl;
+	else
+		cout << failures << " checks failed" << endl;
+
+	return failures == 0;
+}
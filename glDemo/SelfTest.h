@@ -0,0 +1,11 @@
+#pragma once
+
+#include "core.h"
+
+// Reporting shared by the self-tests run from the command line (-feedbacktest, -footprinttest, -atlastest).  Each check prints one "pass:" / "FAIL:" line to cout and the summary prints the number of failures, so every self-test reads and fails the same way
+
+// Report a check to cout and count it in failures if condition is false.  Return condition
+bool selfTestCheck(bool condition, const char* description, int& failures);
+
+// Report the number of failed checks to cout.  Return true if there were none
+bool selfTestSummary(int failures);
@@ -1,6 +1,9 @@
 
 
 #include "ShaderSetup.h"
+#include "CPUProfiler.h"
+#include "GLDebugOutput.h"
+#include <sstream>
 
 
 using namespace std;
@@ -9,7 +12,6 @@ using namespace std;
 // private function declarations
 
 static GLSL_ERROR createShaderFromFile(GLenum shaderType, const string& shaderFilePath, GLuint* shaderObject, const string** shaderSource);
-static const string* shaderSourceStringFromFile(const string& filePath);
 static void printSourceListing(const string& sourceString, bool showLineNumbers = true);
 static void reportProgramInfoLog(GLuint program);
 static void reportShaderInfoLog(GLuint shader);
@@ -19,6 +21,9 @@ static void reportShaderInfoLog(GLuint shader);
 
 GLuint setupShaders(const string& vsPath, const string& gsPath, const string& fsPath, GLSL_ERROR* error_result) {
 
+	CPU_PROFILE_FUNCTION();
+	GLCallContext glCallContext(__FUNCTION__);
+
 	GLuint					vertexShader = 0;
 	GLuint					geometryShader = 0;
 	GLuint					fragmentShader = 0;
@@ -347,7 +352,10 @@ GLuint setupShaders(const string& vsPath, const string& gsPath, const string& fs
 
 	// Attach shader objects
 	glAttachShader(glslProgram, vertexShader);
-	glAttachShader(glslProgram, geometryShader);
+
+	if (geometryShader)
+		glAttachShader(glslProgram, geometryShader);
+
 	glAttachShader(glslProgram, fragmentShader);
 
 
@@ -449,32 +457,18 @@ const string* shaderSourceStringFromFile(const string& filePath) {
 
 	string* sourceString = NULL;
 
-	const char* file_str = filePath.c_str();
-
-	struct stat fileStatus;
-	int file_error = stat(file_str, &fileStatus);
-
-	if (file_error == 0) {
+	string path = nativePath(filePath);
 
-		_off_t fileSize = fileStatus.st_size;
+	ifstream shaderFile(path);
 
-		char* src = (char*)calloc(fileSize + 1, 1); // add null-terminator character at end of string
+	if (shaderFile.is_open()) {
 
-		if (src) {
+		ostringstream source;
 
-			ifstream shaderFile(file_str);
+		source << shaderFile.rdbuf();
+		sourceString = new string(source.str());
 
-			if (shaderFile.is_open()) {
-
-				shaderFile.read(src, fileSize);
-				sourceString = new string(src);
-
-				shaderFile.close();
-			}
-
-			// dispose of local resources
-			free(src);
-		}
+		shaderFile.close();
 	}
 
 	// return pointer to new source string
@@ -44,3 +44,5 @@ GLuint setupShaders(
 	GLSL_ERROR* error_result = nullptr
 );
 
+// Read the shader source in filePath.  Return nullptr if the file cannot be read.  The caller owns the returned string
+const std::string* shaderSourceStringFromFile(const std::string& filePath);
@@ -0,0 +1,393 @@
+
+#include "core.h"
+#include "StreamingRoad.h"
+#include "CPUProfiler.h"
+#include "GLDebugOutput.h"
+#include "ShaderSetup.h"
+#include "SamplerFeedback.h"
+#include <chrono>
+
+
+using namespace std;
+using namespace cst;
+
+
+// Unit quad geometry - each chunk is this quad scaled to the chunk size in the vertex shader (rendered directly as a triangle strip)
+
+static float chunkPositionArray[] = {
+
+	-0.5f, -0.5f, 0.0f, 1.0f,
+	0.5f, -0.5f, 0.0f, 1.0f,
+	-0.5f, 0.5f, 0.0f, 1.0f,
+	0.5f, 0.5f, 0.0f, 1.0f
+};
+
+static float chunkTextureCoordArray[] = {
+
+	0.0f, 1.0f,
+	1.0f, 1.0f,
+	0.0f, 0.0f,
+	1.0f, 0.0f
+};
+
+
+#pragma region Private API
+
+void StreamingRoad::loadShader() {
+
+	shader = setupShaders(
+		string("Shaders\\streaming_road.vs.txt"),
+		string(""),
+		string("Shaders\\basic_texture.fs.txt")
+	);
+
+	viewProjectionLocation = glGetUniformLocation(shader, "viewProjectionMatrix");
+	chunkSizeLocation = glGetUniformLocation(shader, "chunkSize");
+}
+
+
+void StreamingRoad::setupVAO() {
+
+	glGenVertexArrays(1, &vertexArrayObj);
+	glBindVertexArray(vertexArrayObj);
+
+	glGenBuffers(1, &quadVertexBuffer);
+	glBindBuffer(GL_ARRAY_BUFFER, quadVertexBuffer);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(chunkPositionArray), chunkPositionArray, GL_STATIC_DRAW);
+
+	glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 0, (const GLvoid*)0);
+
+	glGenBuffers(1, &quadTextureCoordBuffer);
+	glBindBuffer(GL_ARRAY_BUFFER, quadTextureCoordBuffer);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(chunkTextureCoordArray), chunkTextureCoordArray, GL_STATIC_DRAW);
+
+	glVertexAttribPointer(3, 2, GL_FLOAT, GL_TRUE, 0, (const GLvoid*)0);
+
+	// Per-chunk instance buffer - respecified each frame with the visible chunks
+	glGenBuffers(1, &instanceBuffer);
+	glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+	glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(glm::vec4), nullptr, GL_STREAM_DRAW);
+
+	glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, 0, (const GLvoid*)0);
+	glVertexAttribDivisor(4, 1);
+
+	glEnableVertexAttribArray(0);
+	glEnableVertexAttribArray(3);
+	glEnableVertexAttribArray(4);
+
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+
+GLuint StreamingRoad::chunkSlot(long long chunk) const {
+
+	// Chunk numbers behind the start of the road are negative
+	long long slot = chunk % (long long)capacity;
+
+	return (GLuint)((slot < 0) ? slot + capacity : slot);
+}
+
+
+void StreamingRoad::generateChunk(long long chunk) {
+
+	chunkStart[chunkSlot(chunk)] = (double)chunk * chunkLength;
+
+	chunksGenerated++;
+}
+
+
+// Make the resident range cover one chunk behind the viewer up to viewDistance ahead.  Chunks leaving the range are recycled and their slots reused for newly generated chunks
+void StreamingRoad::updateChunks() {
+
+	long long first = (long long)floor(travelDistance / chunkLength) - 1;
+	long long end = (long long)floor((travelDistance + viewDistance) / chunkLength) + 1;
+
+	if (end - first > (long long)capacity)
+		end = first + capacity;
+
+	for (long long c = firstResident; c < endResident; c++) {
+
+		if (c < first || c >= end)
+			chunksRecycled++;
+	}
+
+	for (long long c = first; c < end; c++) {
+
+		if (c < firstResident || c >= endResident)
+			generateChunk(c);
+	}
+
+	firstResident = first;
+	endResident = end;
+}
+
+
+void StreamingRoad::readTimerQuery(GLuint query) {
+
+	if (!timerQueryIssued[query])
+		return;
+
+	GLint available = 0;
+
+	glGetQueryObjectiv(timerQueries[query], GL_QUERY_RESULT_AVAILABLE, &available);
+
+	if (available) {
+
+		GLuint64 elapsed = 0;
+
+		glGetQueryObjectui64v(timerQueries[query], GL_QUERY_RESULT, &elapsed);
+
+		lastGPUTime = (double)elapsed * 1.0e-6;
+		timerQueryIssued[query] = false;
+	}
+}
+
+#pragma endregion
+
+
+#pragma region Public API
+
+StreamingRoad::StreamingRoad(float roadWidth, float chunkLength, float roadHeight, float maxViewDistance) {
+
+	this->roadWidth = roadWidth;
+	this->chunkLength = chunkLength;
+	this->roadHeight = roadHeight;
+
+	capacity = (GLuint)ceil(maxViewDistance / chunkLength) + 2;
+
+	viewDistance = maxViewDistance;
+	travelDistance = 0.0;
+
+	firstResident = 0;
+	endResident = 0;
+
+	chunkStart.resize(capacity);
+
+	centreX.resize(capacity);
+	centreY.resize(capacity);
+	centreZ.resize(capacity);
+	extentX.resize(capacity);
+	extentY.resize(capacity);
+	extentZ.resize(capacity);
+	visibilityMask.resize((capacity + 31) / 32);
+	visibleChunks.reserve(capacity);
+
+	glGenQueries(NUM_TIMER_QUERIES, timerQueries);
+
+	for (GLuint i = 0; i < NUM_TIMER_QUERIES; i++)
+		timerQueryIssued[i] = false;
+
+	currentTimerQuery = 0;
+
+	chunksGenerated = 0;
+	chunksRecycled = 0;
+	lastVisibleChunks = 0;
+	lastCPUTime = 0.0;
+	lastGPUTime = 0.0;
+
+	feedback = nullptr;
+	feedbackShader = 0;
+	feedbackViewProjectionLocation = -1;
+	feedbackChunkSizeLocation = -1;
+
+	loadShader();
+	setupVAO();
+}
+
+
+StreamingRoad::~StreamingRoad() {
+
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	glDeleteQueries(NUM_TIMER_QUERIES, timerQueries);
+
+	glDeleteBuffers(1, &quadVertexBuffer);
+	glDeleteBuffers(1, &quadTextureCoordBuffer);
+	glDeleteBuffers(1, &instanceBuffer);
+
+	glDeleteVertexArrays(1, &vertexArrayObj);
+
+	glDeleteProgram(shader);
+
+	if (feedbackShader)
+		glDeleteProgram(feedbackShader);
+}
+
+
+void StreamingRoad::setViewDistance(float distance) {
+
+	viewDistance = glm::clamp<float>(distance, chunkLength, getMaxViewDistance());
+}
+
+
+float StreamingRoad::getViewDistance() const {
+
+	return viewDistance;
+}
+
+
+float StreamingRoad::getMaxViewDistance() const {
+
+	return float(capacity - 2) * chunkLength;
+}
+
+
+void StreamingRoad::advance(double distance) {
+
+	travelDistance += distance;
+}
+
+
+double StreamingRoad::getTravelDistance() const {
+
+	return travelDistance;
+}
+
+
+void StreamingRoad::render(const glm::mat4& viewProjection, const ViewFrustum& frustum, GLuint texture) {
+
+	CPU_PROFILE_FUNCTION();
+	GLCallContext glCallContext(__FUNCTION__);
+
+	auto startTime = chrono::steady_clock::now();
+
+	updateChunks();
+
+	// Chunk bounds relative to the viewer.  The road runs along -z so a chunk further along the road has a smaller z coordinate
+	GLuint numResident = (GLuint)(endResident - firstResident);
+
+	for (GLuint i = 0; i < numResident; i++) {
+
+		double start = chunkStart[chunkSlot(firstResident + i)];
+
+		centreX[i] = 0.0f;
+		centreY[i] = roadHeight;
+		centreZ[i] = (float)(travelDistance - (start + 0.5 * chunkLength));
+		extentX[i] = roadWidth * 0.5f;
+		extentY[i] = 0.0f;
+		extentZ[i] = chunkLength * 0.5f;
+	}
+
+	frustum.cullAABBs(centreX.data(), centreY.data(), centreZ.data(), extentX.data(), extentY.data(), extentZ.data(), numResident, visibilityMask.data());
+
+	visibleChunks.clear();
+
+	for (GLuint i = 0; i < numResident; i++) {
+
+		if (visibilityMask[i >> 5] & (1u << (i & 31)))
+			visibleChunks.push_back(glm::vec4(centreX[i], centreY[i], centreZ[i], 1.0f));
+	}
+
+	lastVisibleChunks = (GLuint)visibleChunks.size();
+
+	// Collect the oldest timing result before its query object is reused.  If the GPU has not finished with it yet this frame is not timed rather than stalling
+	readTimerQuery(currentTimerQuery);
+
+	bool timeFrame = !timerQueryIssued[currentTimerQuery];
+
+	if (timeFrame)
+		glBeginQuery(GL_TIME_ELAPSED, timerQueries[currentTimerQuery]);
+
+	if (!visibleChunks.empty()) {
+
+		// Orphan the instance buffer so the upload does not wait on the previous frame's draw
+		glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+		glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(glm::vec4), nullptr, GL_STREAM_DRAW);
+		glBufferSubData(GL_ARRAY_BUFFER, 0, visibleChunks.size() * sizeof(glm::vec4), visibleChunks.data());
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+		glUseProgram(shader);
+		glUniformMatrix4fv(viewProjectionLocation, 1, GL_FALSE, (const GLfloat*)&viewProjection);
+		glUniform2f(chunkSizeLocation, roadWidth, chunkLength);
+
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D, texture);
+
+		glBindVertexArray(vertexArrayObj);
+		glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, (GLsizei)visibleChunks.size());
+		glBindVertexArray(0);
+	}
+
+	if (timeFrame) {
+
+		glEndQuery(GL_TIME_ELAPSED);
+
+		timerQueryIssued[currentTimerQuery] = true;
+		currentTimerQuery = (currentTimerQuery + 1) % NUM_TIMER_QUERIES;
+	}
+
+	lastCPUTime = chrono::duration<double, milli>(chrono::steady_clock::now() - startTime).count();
+}
+
+
+void StreamingRoad::attachFeedback(SamplerFeedback* feedback) {
+
+	if (feedbackShader)
+		glDeleteProgram(feedbackShader);
+
+	this->feedback = feedback;
+
+	// The feedback program shares the road's vertex shader
+	feedbackShader = (feedback) ? feedback->createProgram(string("Shaders\\streaming_road.vs.txt")) : 0;
+	feedbackViewProjectionLocation = (feedbackShader) ? glGetUniformLocation(feedbackShader, "viewProjectionMatrix") : -1;
+	feedbackChunkSizeLocation = (feedbackShader) ? glGetUniformLocation(feedbackShader, "chunkSize") : -1;
+}
+
+
+void StreamingRoad::renderFeedback(const glm::mat4& viewProjection, GLuint slot) {
+
+	GLCallContext glCallContext(__FUNCTION__);
+
+	// The instance buffer still holds the chunks visible in the last render
+	if (!feedbackShader || visibleChunks.empty())
+		return;
+
+	glUseProgram(feedbackShader);
+	glUniformMatrix4fv(feedbackViewProjectionLocation, 1, GL_FALSE, (const GLfloat*)&viewProjection);
+	glUniform2f(feedbackChunkSizeLocation, roadWidth, chunkLength);
+	feedback->bindSlot(feedbackShader, slot);
+
+	glBindVertexArray(vertexArrayObj);
+	glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, (GLsizei)visibleChunks.size());
+	glBindVertexArray(0);
+}
+
+
+GLuint StreamingRoad::getResidentChunkCount() const {
+
+	return (GLuint)(endResident - firstResident);
+}
+
+
+GLuint StreamingRoad::getVisibleChunkCount() const {
+
+	return lastVisibleChunks;
+}
+
+
+unsigned long long StreamingRoad::getChunksGenerated() const {
+
+	return chunksGenerated;
+}
+
+
+unsigned long long StreamingRoad::getChunksRecycled() const {
+
+	return chunksRecycled;
+}
+
+
+double StreamingRoad::getCPUTime() const {
+
+	return lastCPUTime;
+}
+
+
+double StreamingRoad::getGPUTime() const {
+
+	return lastGPUTime;
+}
+
+#pragma endregion
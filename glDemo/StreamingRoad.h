@@ -0,0 +1,100 @@
+#pragma once
+
+#include "core.h"
+#include "ViewFrustum.h"
+
+class SamplerFeedback;
+
+// Model an endless road made of fixed-size chunks laid end to end along the -z axis.  Chunks are generated ahead of the viewer as it travels along the road and recycled once they fall behind, so the number of resident chunks depends only on the view distance.  Chunks are held in a ring indexed by chunk number, culled against a ViewFrustum as a batch and all visible chunks are drawn with a single instanced call using one texture.  Chunk positions are stored in double precision and made relative to the viewer each frame so the road does not lose precision far from the origin.  CPU time per frame (chunk update, culling, upload and draw submission) and GPU time (measured with a ring of GL_TIME_ELAPSED queries so results are read without stalling) are recorded for comparing filtering and culling cost as the view distance grows.  Rendered with Shaders\streaming_road.vs and Shaders\basic_texture.fs
+
+class StreamingRoad {
+
+	static const GLuint		NUM_TIMER_QUERIES = 4;
+
+	GLuint					vertexArrayObj;
+
+	GLuint					quadVertexBuffer;
+	GLuint					quadTextureCoordBuffer;
+	GLuint					instanceBuffer;
+
+	GLuint					shader;
+	GLint					viewProjectionLocation;
+	GLint					chunkSizeLocation;
+
+	// Sampler feedback program (created by attachFeedback) - shares the road's vertex shader
+	SamplerFeedback*		feedback;
+	GLuint					feedbackShader;
+	GLint					feedbackViewProjectionLocation;
+	GLint					feedbackChunkSizeLocation;
+
+	// Chunk dimensions - the road lies in the plane y = roadHeight
+	float					roadWidth, chunkLength, roadHeight;
+
+	float					viewDistance;
+	double					travelDistance; // distance the viewer has travelled along the road
+
+	// Chunk ring - chunk c is stored in slot c mod capacity.  Resident chunks are [firstResident, endResident)
+	GLuint					capacity;
+	long long				firstResident, endResident;
+	std::vector<double>		chunkStart; // distance along the road of the start of each slot's chunk
+
+	// Culling inputs (SoA, in resident chunk order) and results
+	std::vector<float>		centreX, centreY, centreZ;
+	std::vector<float>		extentX, extentY, extentZ;
+	std::vector<uint32_t>	visibilityMask;
+	std::vector<glm::vec4>	visibleChunks; // per-instance data - viewer relative chunk centre
+
+	// GPU timer query ring
+	GLuint					timerQueries[NUM_TIMER_QUERIES];
+	bool					timerQueryIssued[NUM_TIMER_QUERIES];
+	GLuint					currentTimerQuery;
+
+	// Statistics
+	unsigned long long		chunksGenerated, chunksRecycled;
+	GLuint					lastVisibleChunks;
+	double					lastCPUTime, lastGPUTime; // milliseconds
+
+	//
+	// Private API
+	//
+
+	void loadShader();
+	void setupVAO();
+	GLuint chunkSlot(long long chunk) const;
+	void generateChunk(long long chunk);
+	void updateChunks();
+	void readTimerQuery(GLuint query);
+
+public:
+
+	// Create a road roadWidth units wide made of chunks chunkLength units long.  Enough chunk storage is allocated for view distances up to maxViewDistance
+	StreamingRoad(float roadWidth, float chunkLength, float roadHeight, float maxViewDistance);
+
+	~StreamingRoad();
+
+	// Chunks are kept resident from one chunk behind the viewer up to viewDistance ahead.  The distance is clamped to the maximum given on construction
+	void setViewDistance(float distance);
+	float getViewDistance() const;
+	float getMaxViewDistance() const;
+
+	// Move the viewer along the road
+	void advance(double distance);
+	double getTravelDistance() const;
+
+	// Update resident chunks, cull them against frustum and draw the visible chunks textured with texture
+	void render(const glm::mat4& viewProjection, const cst::ViewFrustum& frustum, GLuint texture);
+
+	// Create the program used to draw the road into feedback's passes (replacing any earlier attachment)
+	void attachFeedback(SamplerFeedback* feedback);
+
+	// Draw the chunks visible in the last call to render into the current pass of the attached sampler feedback, recording into the given feedback slot.  Does nothing if no feedback is attached or feedback is not supported
+	void renderFeedback(const glm::mat4& viewProjection, GLuint slot);
+
+	// Statistics
+	GLuint getResidentChunkCount() const;
+	GLuint getVisibleChunkCount() const; // visible in the last frame rendered
+	unsigned long long getChunksGenerated() const;
+	unsigned long long getChunksRecycled() const;
+	double getCPUTime() const; // milliseconds, last frame
+	double getGPUTime() const; // milliseconds, most recent result available (a few frames behind)
+};
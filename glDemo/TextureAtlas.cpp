@@ -0,0 +1,950 @@
+
+#include "TextureAtlas.h"
+#include "SelfTest.h"
+#include "TextureLoader.h"
+#include "JobSystem.h"
+#include "CPUProfiler.h"
+#include "GLDebugOutput.h"
+#include <random>
+
+
+using namespace std;
+
+
+#pragma region Skyline packer
+
+SkylinePacker::SkylinePacker(GLuint width, GLuint height) {
+
+	reset(width, height);
+}
+
+
+void SkylinePacker::reset(GLuint width, GLuint height) {
+
+	this->width = width;
+	this->height = height;
+
+	skyline.clear();
+
+	if (width > 0)
+		skyline.push_back({ 0, 0, width });
+
+	usedArea = 0;
+}
+
+
+bool SkylinePacker::fit(size_t i, GLuint w, GLuint h, GLuint& y) const {
+
+	GLuint x = skyline[i].x;
+
+	if (x + w > width)
+		return false;
+
+	// The rectangle rests on the highest segment it spans
+	GLint remaining = (GLint)w;
+
+	y = 0;
+
+	while (remaining > 0) {
+
+		y = std::max(y, skyline[i].y);
+
+		if (y + h > height)
+			return false;
+
+		remaining -= (GLint)skyline[i].width;
+		i++;
+	}
+
+	return true;
+}
+
+
+bool SkylinePacker::insert(GLuint w, GLuint h, GLuint& x, GLuint& y) {
+
+	if (w == 0 || h == 0 || w > width || h > height)
+		return false;
+
+	size_t bestIndex = skyline.size();
+	GLuint bestTop = 0xFFFFFFFF;
+
+	for (size_t i = 0; i < skyline.size(); i++) {
+
+		GLuint segmentY;
+
+		if (fit(i, w, h, segmentY) && segmentY + h < bestTop) {
+
+			bestIndex = i;
+			bestTop = segmentY + h;
+			x = skyline[i].x;
+			y = segmentY;
+		}
+	}
+
+	if (bestIndex == skyline.size())
+		return false;
+
+	// New segment over the rectangle, then trim or remove the segments it covers
+	skyline.insert(skyline.begin() + bestIndex, { x, y + h, w });
+
+	for (size_t i = bestIndex + 1; i < skyline.size(); ) {
+
+		Segment& segment = skyline[i];
+		GLuint coveredEnd = x + w;
+
+		if (segment.x >= coveredEnd)
+			break;
+
+		GLuint shrink = coveredEnd - segment.x;
+
+		if (shrink >= segment.width) {
+
+			skyline.erase(skyline.begin() + i);
+			continue;
+		}
+
+		segment.x += shrink;
+		segment.width -= shrink;
+		break;
+	}
+
+	// Merge neighbours at the same height
+	for (size_t i = 0; i + 1 < skyline.size(); ) {
+
+		if (skyline[i].y == skyline[i + 1].y) {
+
+			skyline[i].width += skyline[i + 1].width;
+			skyline.erase(skyline.begin() + i + 1);
+		}
+		else {
+
+			i++;
+		}
+	}
+
+	usedArea += (unsigned long long)w * h;
+
+	return true;
+}
+
+
+unsigned long long SkylinePacker::getUsedArea() const {
+
+	return usedArea;
+}
+
+
+GLuint SkylinePacker::getWidth() const {
+
+	return width;
+}
+
+
+GLuint SkylinePacker::getHeight() const {
+
+	return height;
+}
+
+#pragma endregion
+
+
+#pragma region Private API
+
+// Decode every queued file in parallel.  Return false if any file could not be loaded
+bool TextureAtlas::decodePending() {
+
+	CPU_PROFILE_FUNCTION();
+
+	JobSystem& jobSystem = JobSystem::global();
+	JobCounter decoded;
+
+	for (Pending& image : pending) {
+
+		if (image.filename.empty())
+			continue;
+
+		jobSystem.submit([this, &image]() {
+
+			FREE_IMAGE_FORMAT fileType = image.fileType;
+
+			if (fileType == FIF_UNKNOWN) {
+
+				string path = nativePath(image.filename);
+
+				fileType = FreeImage_GetFileType(path.c_str());
+
+				if (fileType == FIF_UNKNOWN)
+					fileType = FreeImage_GetFIFFromFilename(path.c_str());
+			}
+
+			FIBITMAP* bitmap = fiLoadBitmap32(image.filename, fileType, properties.flipImageY);
+
+			if (!bitmap)
+				return;
+
+			image.width = FreeImage_GetWidth(bitmap);
+			image.height = FreeImage_GetHeight(bitmap);
+			image.pixels.resize((size_t)image.width * image.height * 4);
+
+			for (GLuint y = 0; y < image.height; y++)
+				memcpy(image.pixels.data() + (size_t)y * image.width * 4, FreeImage_GetScanLine(bitmap, y), (size_t)image.width * 4);
+
+			FreeImage_Unload(bitmap);
+
+		}, &decoded);
+	}
+
+	jobSystem.wait(decoded);
+
+	bool allLoaded = true;
+
+	for (const Pending& image : pending) {
+
+		if (image.pixels.empty())
+			allLoaded = false;
+	}
+
+	return allLoaded;
+}
+
+
+// Share images between candidatePages and pack each page on its own job.  Images are taken in order (largest first), each by the page with the most space not yet claimed - images a page cannot place are returned in rejected
+void TextureAtlas::packIntoPages(const vector<Pending*>& images, const vector<GLuint>& candidatePages, vector<Pending*>& rejected) {
+
+	CPU_PROFILE_FUNCTION();
+
+	if (candidatePages.empty()) {
+
+		rejected = images;
+		return;
+	}
+
+	unsigned long long cellsPerPage = (unsigned long long)pages[0]->packer.getWidth() * pages[0]->packer.getHeight();
+
+	vector<long long> freeCells(candidatePages.size());
+	vector<vector<Pending*>> buckets(candidatePages.size());
+
+	for (size_t i = 0; i < candidatePages.size(); i++)
+		freeCells[i] = (long long)(cellsPerPage - pages[candidatePages[i]]->packer.getUsedArea());
+
+	for (Pending* image : images) {
+
+		size_t best = max_element(freeCells.begin(), freeCells.end()) - freeCells.begin();
+
+		buckets[best].push_back(image);
+		freeCells[best] -= (long long)image->cellsWide * image->cellsHigh;
+	}
+
+	JobSystem& jobSystem = JobSystem::global();
+	JobCounter packed;
+	vector<vector<Pending*>> pageRejected(candidatePages.size());
+
+	for (size_t i = 0; i < candidatePages.size(); i++) {
+
+		if (buckets[i].empty())
+			continue;
+
+		jobSystem.submit([this, &buckets, &pageRejected, &candidatePages, i]() {
+
+			Page& page = *pages[candidatePages[i]];
+
+			for (Pending* image : buckets[i]) {
+
+				if (page.packer.insert(image->cellsWide, image->cellsHigh, image->cellX, image->cellY)) {
+
+					AtlasEntry& entry = entries[image->entryID];
+
+					entry.page = (GLint)candidatePages[i];
+					writeImage(page, *image);
+					page.dirty = true;
+				}
+				else {
+
+					pageRejected[i].push_back(image);
+				}
+			}
+
+		}, &packed);
+	}
+
+	jobSystem.wait(packed);
+
+	rejected.clear();
+
+	for (const vector<Pending*>& pageImages : pageRejected)
+		rejected.insert(rejected.end(), pageImages.begin(), pageImages.end());
+}
+
+
+// Copy a placed image into its page with its edge texels extended through the gutter, and record the entry's placement and ownership of the texels
+void TextureAtlas::writeImage(Page& page, const Pending& image) {
+
+	AtlasEntry& entry = entries[image.entryID];
+
+	GLuint left = image.cellX * cellSize;
+	GLuint bottom = image.cellY * cellSize;
+	GLuint paddedWidth = image.cellsWide * cellSize;
+	GLuint paddedHeight = image.cellsHigh * cellSize;
+
+	entry.x = left + gutter;
+	entry.y = bottom + gutter;
+	entry.width = image.width;
+	entry.height = image.height;
+	entry.uvRect = glm::vec4((float)entry.x, (float)entry.y, (float)(entry.x + entry.width), (float)(entry.y + entry.height)) / (float)pageSize;
+
+	for (GLuint y = 0; y < paddedHeight; y++) {
+
+		GLuint sourceY = (GLuint)glm::clamp<GLint>((GLint)y - (GLint)gutter, 0, (GLint)image.height - 1);
+		const GLubyte* sourceRow = image.pixels.data() + (size_t)sourceY * image.width * 4;
+		size_t rowStart = (size_t)(bottom + y) * pageSize + left;
+		GLubyte* destRow = page.base.pixels.data() + rowStart * 4;
+
+		for (GLuint x = 0; x < paddedWidth; x++) {
+
+			GLuint sourceX = (GLuint)glm::clamp<GLint>((GLint)x - (GLint)gutter, 0, (GLint)image.width - 1);
+
+			memcpy(destRow + x * 4, sourceRow + sourceX * 4, 4);
+			page.owner[rowStart + x] = (GLint)image.entryID;
+		}
+	}
+
+	page.imageTexels += (unsigned long long)image.width * image.height;
+}
+
+#pragma endregion
+
+
+#pragma region Public API
+
+TextureAtlas::TextureAtlas(GLuint pageSize, GLuint mipLevels, GLuint maxAnisotropy, const TextureProperties& properties) : properties(properties) {
+
+	this->mipLevels = std::max<GLuint>(mipLevels, 1);
+	this->maxAnisotropy = std::max<GLuint>(maxAnisotropy, 1);
+
+	// Every kept level has whole texels on the grid.  At the coarsest level kept the gutter covers the bilinear footprint plus half the anisotropic footprint
+	cellSize = 1u << (this->mipLevels - 1);
+	gutter = cellSize * (this->maxAnisotropy / 2 + 1);
+
+	this->pageSize = std::max(pageSize - pageSize % cellSize, cellSize);
+}
+
+
+TextureAtlas::~TextureAtlas() {
+
+	for (Page* page : pages) {
+
+		if (page->texture)
+			glDeleteTextures(1, &page->texture);
+
+		delete page;
+	}
+}
+
+
+GLuint TextureAtlas::add(const string& filename, FREE_IMAGE_FORMAT fileType) {
+
+	GLuint entryID = (GLuint)entries.size();
+
+	entries.push_back({ -1, 0, 0, 0, 0, glm::vec4(0.0f) });
+
+	Pending image;
+
+	image.entryID = entryID;
+	image.filename = filename;
+	image.fileType = fileType;
+	image.width = 0;
+	image.height = 0;
+
+	pending.push_back(image);
+
+	return entryID;
+}
+
+
+GLuint TextureAtlas::addImage(const GLubyte* pixels, GLuint width, GLuint height) {
+
+	GLuint entryID = (GLuint)entries.size();
+
+	entries.push_back({ -1, 0, 0, 0, 0, glm::vec4(0.0f) });
+
+	Pending image;
+
+	image.entryID = entryID;
+	image.fileType = FIF_UNKNOWN;
+	image.width = width;
+	image.height = height;
+
+	if (pixels && width > 0 && height > 0)
+		image.pixels.assign(pixels, pixels + (size_t)width * height * 4);
+
+	pending.push_back(image);
+
+	return entryID;
+}
+
+
+bool TextureAtlas::pack() {
+
+	CPU_PROFILE_FUNCTION();
+
+	if (pending.empty())
+		return true;
+
+	bool allPacked = decodePending();
+
+	GLuint cellsPerSide = pageSize / cellSize;
+	unsigned long long cellsPerPage = (unsigned long long)cellsPerSide * cellsPerSide;
+
+	// Images that fit a page, tallest first then widest (skyline packing wastes least when heights decrease)
+	vector<Pending*> images;
+
+	for (Pending& image : pending) {
+
+		if (image.pixels.empty())
+			continue;
+
+		image.cellsWide = (image.width + 2 * gutter + cellSize - 1) / cellSize;
+		image.cellsHigh = (image.height + 2 * gutter + cellSize - 1) / cellSize;
+
+		if (image.cellsWide > cellsPerSide || image.cellsHigh > cellsPerSide) {
+
+			cout << "Texture atlas: " << ((image.filename.empty()) ? "image" : image.filename) << " (" << image.width << "x" << image.height << ") does not fit a " << pageSize << "x" << pageSize << " page with a " << gutter << " texel gutter" << endl;
+			allPacked = false;
+			continue;
+		}
+
+		images.push_back(&image);
+	}
+
+	sort(images.begin(), images.end(), [](const Pending* a, const Pending* b) {
+
+		return (a->cellsHigh != b->cellsHigh) ? a->cellsHigh > b->cellsHigh : a->cellsWide > b->cellsWide;
+	});
+
+	// Fill the existing pages first, then open enough new pages for what is left (at the occupancy skyline packing typically reaches) and pack into every page with space until all images are placed.  A new page always takes at least one image so this terminates
+	vector<Pending*> rejected;
+	bool firstRound = true;
+
+	while (!images.empty()) {
+
+		if (!firstRound || pages.empty()) {
+
+			unsigned long long remainingCells = 0;
+
+			for (const Pending* image : images)
+				remainingCells += (unsigned long long)image->cellsWide * image->cellsHigh;
+
+			GLuint newPages = std::max<GLuint>((GLuint)ceil((double)remainingCells / (cellsPerPage * 0.85)), 1);
+
+			for (GLuint i = 0; i < newPages; i++) {
+
+				Page* page = new Page();
+
+				page->packer.reset(cellsPerSide, cellsPerSide);
+				page->base.width = pageSize;
+				page->base.height = pageSize;
+				page->base.pixels.assign((size_t)pageSize * pageSize * 4, 0);
+				page->owner.assign((size_t)pageSize * pageSize, -1);
+				page->imageTexels = 0;
+				page->texture = 0;
+				page->dirty = true;
+
+				pages.push_back(page);
+			}
+		}
+
+		vector<GLuint> candidatePages;
+
+		for (GLuint i = 0; i < (GLuint)pages.size(); i++) {
+
+			if (pages[i]->packer.getUsedArea() < cellsPerPage)
+				candidatePages.push_back(i);
+		}
+
+		packIntoPages(images, candidatePages, rejected);
+
+		images.swap(rejected);
+		firstRound = false;
+	}
+
+	// Rebuild the mip chains of changed pages in parallel
+	JobSystem& jobSystem = JobSystem::global();
+	JobCounter mipsBuilt;
+	bool sRGB = isSRGBFormat(properties.internalFormat);
+
+	for (Page* page : pages) {
+
+		if (!page->dirty || mipLevels < 2)
+			continue;
+
+		jobSystem.submit([page, sRGB]() {
+
+			buildMipChain(page->base.pixels.data(), page->base.width, page->base.height, sRGB, page->mipLevels);
+
+		}, &mipsBuilt);
+	}
+
+	jobSystem.wait(mipsBuilt);
+
+	pending.clear();
+
+	return allPacked;
+}
+
+
+void TextureAtlas::upload() {
+
+	CPU_PROFILE_FUNCTION();
+	GLCallContext glCallContext(__FUNCTION__);
+
+	for (Page* page : pages) {
+
+		if (!page->dirty)
+			continue;
+
+		bool created = (page->texture == 0);
+
+		if (created)
+			glGenTextures(1, &page->texture);
+
+		glBindTexture(GL_TEXTURE_2D, page->texture);
+
+		for (GLuint level = 0; level < mipLevels; level++) {
+
+			const MipLevel& source = (level == 0) ? page->base : page->mipLevels[level - 1];
+
+			if (created)
+				glTexImage2D(GL_TEXTURE_2D, level, properties.internalFormat, source.width, source.height, 0, GL_BGRA, GL_UNSIGNED_BYTE, source.pixels.data());
+			else
+				glTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, source.width, source.height, GL_BGRA, GL_UNSIGNED_BYTE, source.pixels.data());
+		}
+
+		if (created) {
+
+			// Mipmap filters have no meaning without levels
+			GLint minFilter = properties.minFilter;
+
+			if (mipLevels == 1 && minFilter != GL_NEAREST && minFilter != GL_LINEAR)
+				minFilter = GL_LINEAR;
+
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, mipLevels - 1);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, minFilter);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, properties.maxFilter);
+			glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, glm::clamp(properties.anisotropicLevel, 1.0f, (GLfloat)maxAnisotropy));
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		}
+
+		page->dirty = false;
+	}
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+
+const AtlasEntry& TextureAtlas::getEntry(GLuint id) const {
+
+	return entries[id];
+}
+
+
+GLuint TextureAtlas::getNumEntries() const {
+
+	return (GLuint)entries.size();
+}
+
+
+GLuint TextureAtlas::getPageCount() const {
+
+	return (GLuint)pages.size();
+}
+
+
+GLuint TextureAtlas::getPageSize() const {
+
+	return pageSize;
+}
+
+
+GLuint TextureAtlas::getGutter() const {
+
+	return gutter;
+}
+
+
+GLuint TextureAtlas::getPageTexture(GLuint page) const {
+
+	return (page < pages.size()) ? pages[page]->texture : 0;
+}
+
+
+const GLubyte* TextureAtlas::getPageLevel(GLuint page, GLuint level, GLuint& width, GLuint& height) const {
+
+	if (page >= pages.size() || level >= mipLevels)
+		return nullptr;
+
+	const MipLevel* source = nullptr;
+
+	if (level == 0)
+		source = &pages[page]->base;
+	else if (level - 1 < pages[page]->mipLevels.size())
+		source = &pages[page]->mipLevels[level - 1];
+
+	if (!source)
+		return nullptr;
+
+	width = source->width;
+	height = source->height;
+
+	return source->pixels.data();
+}
+
+
+float TextureAtlas::getOccupancy(GLuint page) const {
+
+	if (page >= pages.size())
+		return 0.0f;
+
+	return (float)((double)pages[page]->imageTexels / ((double)pageSize * pageSize));
+}
+
+
+float TextureAtlas::getPackedOccupancy() const {
+
+	if (pages.empty())
+		return 0.0f;
+
+	unsigned long long usedCells = 0;
+
+	for (const Page* page : pages)
+		usedCells += page->packer.getUsedArea();
+
+	return (float)((double)usedCells * cellSize * cellSize / ((double)pageSize * pageSize * pages.size()));
+}
+
+
+float TextureAtlas::getOccupancy() const {
+
+	if (pages.empty())
+		return 0.0f;
+
+	unsigned long long imageTexels = 0;
+
+	for (const Page* page : pages)
+		imageTexels += page->imageTexels;
+
+	return (float)((double)imageTexels / ((double)pageSize * pageSize * pages.size()));
+}
+
+
+AtlasBleedReport TextureAtlas::checkBleed(GLuint anisotropy) const {
+
+	CPU_PROFILE_FUNCTION();
+
+	AtlasBleedReport report = { 0, 0, 0, 0 };
+
+	double spread = (double)(((anisotropy > 0) ? anisotropy : maxAnisotropy) - 1) * 0.5;
+
+	for (GLuint id = 0; id < (GLuint)entries.size(); id++) {
+
+		const AtlasEntry& entry = entries[id];
+
+		if (entry.page < 0)
+			continue;
+
+		const vector<GLint>& owner = pages[entry.page]->owner;
+		unsigned long long entryBleeds = 0;
+
+		// Bilinear taps of a sample at (x, y) level 0 texels on level - every level 0 texel under each tap (clamped to the page) must belong to the entry
+		auto sample = [&](double x, double y, GLuint level) {
+
+			double scale = (double)(1u << level);
+			GLint levelSize = (GLint)(pageSize >> level);
+			GLint tapX = (GLint)floor(x / scale - 0.5);
+			GLint tapY = (GLint)floor(y / scale - 0.5);
+			bool bleeds = false;
+
+			for (GLint ty = tapY; ty <= tapY + 1 && !bleeds; ty++) {
+
+				for (GLint tx = tapX; tx <= tapX + 1 && !bleeds; tx++) {
+
+					GLuint texelX = (GLuint)glm::clamp(tx, 0, levelSize - 1) << level;
+					GLuint texelY = (GLuint)glm::clamp(ty, 0, levelSize - 1) << level;
+
+					for (GLuint y0 = texelY; y0 < texelY + (1u << level) && !bleeds; y0++) {
+
+						for (GLuint x0 = texelX; x0 < texelX + (1u << level); x0++) {
+
+							if (owner[(size_t)y0 * pageSize + x0] != (GLint)id) {
+
+								bleeds = true;
+								break;
+							}
+						}
+					}
+				}
+			}
+
+			report.samples++;
+
+			if (bleeds)
+				entryBleeds++;
+		};
+
+		double left = entry.x, right = entry.x + entry.width;
+		double bottom = entry.y, top = entry.y + entry.height;
+
+		for (GLuint level = 0; level < mipLevels; level++) {
+
+			double step = (double)(1u << level);
+			double offset = spread * step;
+
+			// Samples along each edge at every texel of the level, pushed outward by half the anisotropic footprint
+			for (double y = bottom + step * 0.5; y < top; y += step) {
+
+				sample(left - offset, y, level);
+				sample(right + offset, y, level);
+			}
+
+			for (double x = left + step * 0.5; x < right; x += step) {
+
+				sample(x, bottom - offset, level);
+				sample(x, top + offset, level);
+			}
+
+			sample(left - offset, bottom - offset, level);
+			sample(right + offset, bottom - offset, level);
+			sample(left - offset, top + offset, level);
+			sample(right + offset, top + offset, level);
+		}
+
+		report.entriesChecked++;
+		report.bleeds += entryBleeds;
+
+		if (entryBleeds > 0)
+			report.entriesBleeding++;
+	}
+
+	return report;
+}
+
+
+void TextureAtlas::printReport(ostream& out) const {
+
+	GLuint placed = 0;
+
+	for (const AtlasEntry& entry : entries) {
+
+		if (entry.page >= 0)
+			placed++;
+	}
+
+	out << "Texture atlas: " << placed << " of " << entries.size() << " images on " << pages.size() << " " << pageSize << "x" << pageSize << " pages (" << mipLevels << " levels, " << maxAnisotropy << "x anisotropy, " << gutter << " texel gutter), " << getOccupancy() * 100.0f << "% occupied by images, " << getPackedOccupancy() * 100.0f << "% with gutters" << endl;
+
+	for (GLuint i = 0; i < (GLuint)pages.size(); i++)
+		out << "  page " << i << ": " << getOccupancy(i) * 100.0f << "% images, " << 100.0 * pages[i]->packer.getUsedArea() / ((double)pages[i]->packer.getWidth() * pages[i]->packer.getHeight()) << "% with gutters" << endl;
+
+	AtlasBleedReport bleed = checkBleed();
+
+	out << "  bleed check: " << bleed.samples << " edge samples over " << bleed.entriesChecked << " images, " << bleed.bleeds << " bleeding (" << bleed.entriesBleeding << " images)" << endl;
+}
+
+#pragma endregion
+
+
+#pragma region Self test
+
+// Distinct opaque colour for each image
+static glm::u8vec4 selfTestColour(GLuint index) {
+
+	GLuint hash = (index + 1) * 2654435761u;
+
+	return glm::u8vec4((hash >> 8) & 0xFF, (hash >> 16) & 0xFF, (hash >> 24) & 0xFF, 0xFF);
+}
+
+
+static GLuint addSolidImages(TextureAtlas& atlas, mt19937& random, GLuint count, vector<glm::u8vec4>& colours) {
+
+	uniform_int_distribution<GLuint> sizes(4, 160);
+	vector<GLubyte> pixels;
+
+	GLuint first = atlas.getNumEntries();
+
+	for (GLuint i = 0; i < count; i++) {
+
+		GLuint width = sizes(random), height = sizes(random);
+		glm::u8vec4 colour = selfTestColour((GLuint)colours.size());
+
+		pixels.resize((size_t)width * height * 4);
+
+		for (size_t t = 0; t < (size_t)width * height; t++)
+			memcpy(pixels.data() + t * 4, &colour, 4);
+
+		atlas.addImage(pixels.data(), width, height);
+		colours.push_back(colour);
+	}
+
+	return first;
+}
+
+
+// Return true if the texel at (x, y) of level of page has colour
+static bool texelIs(const TextureAtlas& atlas, GLuint page, GLuint level, GLint x, GLint y, const glm::u8vec4& colour) {
+
+	GLuint width, height;
+	const GLubyte* pixels = atlas.getPageLevel(page, level, width, height);
+
+	if (!pixels)
+		return false;
+
+	x = glm::clamp<GLint>(x, 0, (GLint)width - 1);
+	y = glm::clamp<GLint>(y, 0, (GLint)height - 1);
+
+	return memcmp(pixels + ((size_t)y * width + x) * 4, &colour, 4) == 0;
+}
+
+
+bool runTextureAtlasSelfTest() {
+
+	int failures = 0;
+
+	cout << "Texture atlas self test" << endl;
+
+	// Skyline packer on its own
+	SkylinePacker packer(8, 8);
+	GLuint x, y;
+
+	bool packed = packer.insert(4, 4, x, y) && x == 0 && y == 0;
+	packed = packed && packer.insert(4, 2, x, y) && x == 4 && y == 0;
+	packed = packed && packer.insert(4, 2, x, y) && x == 4 && y == 2;
+	packed = packed && packer.insert(8, 4, x, y) && x == 0 && y == 4;
+
+	selfTestCheck(packed, "skyline packer places rectangles bottom-left", failures);
+	selfTestCheck(!packer.insert(1, 1, x, y) && packer.getUsedArea() == 64, "full skyline rejects further rectangles", failures);
+
+	// 4 levels and 4x anisotropy - an 8 texel grid and 3 texels of gutter at level 3
+	const GLuint mipLevels = 4, anisotropy = 4;
+	TextureProperties properties = TextureProperties(GL_RGBA8, GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR, 4.0f, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, true, false);
+	TextureAtlas atlas(1024, mipLevels, anisotropy, properties);
+	mt19937 random(1234);
+	vector<glm::u8vec4> colours;
+
+	selfTestCheck(atlas.getGutter() == 24, "gutter covers 3 texels at the coarsest level", failures);
+
+	addSolidImages(atlas, random, 300, colours);
+
+	bool allPacked = atlas.pack();
+	GLuint firstPages = atlas.getPageCount();
+	vector<AtlasEntry> firstEntries;
+
+	for (GLuint i = 0; i < atlas.getNumEntries(); i++)
+		firstEntries.push_back(atlas.getEntry(i));
+
+	// Incremental insertion - the second batch fills the existing pages before new ones are opened
+	float firstOccupancy = atlas.getOccupancy();
+
+	addSolidImages(atlas, random, 100, colours);
+	allPacked = atlas.pack() && allPacked;
+
+	selfTestCheck(allPacked, "every image packed", failures);
+
+	bool unmoved = true;
+
+	for (GLuint i = 0; i < (GLuint)firstEntries.size(); i++) {
+
+		const AtlasEntry& entry = atlas.getEntry(i);
+
+		if (entry.page != firstEntries[i].page || entry.x != firstEntries[i].x || entry.y != firstEntries[i].y)
+			unmoved = false;
+	}
+
+	selfTestCheck(unmoved, "earlier images keep their place", failures);
+
+	bool existingPagesUsed = false;
+
+	for (GLuint i = (GLuint)firstEntries.size(); i < atlas.getNumEntries(); i++) {
+
+		if (atlas.getEntry(i).page < (GLint)firstPages)
+			existingPagesUsed = true;
+	}
+
+	selfTestCheck(existingPagesUsed && atlas.getOccupancy() > firstOccupancy, "second batch fills existing pages", failures);
+
+	// Every image is where its entry says, with its corners and uv rectangle intact
+	bool placed = true, uvCorrect = true;
+
+	for (GLuint i = 0; i < atlas.getNumEntries(); i++) {
+
+		const AtlasEntry& entry = atlas.getEntry(i);
+
+		if (entry.page < 0) {
+
+			placed = false;
+			continue;
+		}
+
+		GLint left = (GLint)entry.x, bottom = (GLint)entry.y;
+		GLint right = left + (GLint)entry.width - 1, top = bottom + (GLint)entry.height - 1;
+
+		if (!texelIs(atlas, entry.page, 0, left, bottom, colours[i]) || !texelIs(atlas, entry.page, 0, right, top, colours[i]) ||
+			!texelIs(atlas, entry.page, 0, (left + right) / 2, (bottom + top) / 2, colours[i]))
+			placed = false;
+
+		glm::vec2 uv = remapAtlasUV(entry, glm::vec2(1.0f, 1.0f)) * (float)atlas.getPageSize();
+
+		if (fabs(uv.x - (right + 1)) > 1.0e-3f || fabs(uv.y - (top + 1)) > 1.0e-3f)
+			uvCorrect = false;
+	}
+
+	selfTestCheck(placed, "images intact at their entries", failures);
+	selfTestCheck(uvCorrect, "uv rectangles cover each image", failures);
+
+	// At the coarsest level the texels the filter reaches beyond each edge are still the image's own colour
+	bool coarseClean = true;
+	GLuint coarse = mipLevels - 1;
+	GLint reach = (GLint)(anisotropy / 2);
+
+	for (GLuint i = 0; i < atlas.getNumEntries(); i++) {
+
+		const AtlasEntry& entry = atlas.getEntry(i);
+
+		GLint left = (GLint)(entry.x >> coarse) - reach - 1;
+		GLint bottom = (GLint)(entry.y >> coarse) - reach - 1;
+		GLint right = (GLint)((entry.x + entry.width - 1) >> coarse) + reach + 1;
+		GLint top = (GLint)((entry.y + entry.height - 1) >> coarse) + reach + 1;
+
+		if (!texelIs(atlas, entry.page, coarse, left, bottom, colours[i]) || !texelIs(atlas, entry.page, coarse, right, top, colours[i]) ||
+			!texelIs(atlas, entry.page, coarse, left, top, colours[i]) || !texelIs(atlas, entry.page, coarse, right, bottom, colours[i]))
+			coarseClean = false;
+	}
+
+	selfTestCheck(coarseClean, "coarsest level keeps each image's colour through the gutter", failures);
+
+	AtlasBleedReport bleed = atlas.checkBleed();
+
+	selfTestCheck(bleed.samples > 0 && bleed.bleeds == 0, "no bleeding at the anisotropy the gutter was sized for", failures);
+
+	// The check must see bleeding when the atlas is sampled beyond what it was built for
+	AtlasBleedReport overSampled = atlas.checkBleed(16);
+
+	selfTestCheck(overSampled.bleeds > 0, "bleeding detected at 16x anisotropy", failures);
+	selfTestCheck(atlas.getPackedOccupancy() > 0.8f, "packed occupancy (with gutters) above 80%", failures);
+
+	// An image larger than a page is rejected without affecting the rest
+	TextureAtlas small(256, mipLevels, anisotropy, properties);
+	vector<glm::u8vec4> smallColours;
+
+	addSolidImages(small, random, 4, smallColours);
+
+	vector<GLubyte> wide((size_t)300 * 8 * 4, 0xFF);
+	GLuint wideID = small.addImage(wide.data(), 300, 8);
+
+	selfTestCheck(!small.pack() && small.getEntry(wideID).page == -1 && small.getEntry(0).page >= 0, "oversized image rejected", failures);
+
+	atlas.printReport(cout);
+
+	return selfTestSummary(failures);
+}
+
+#pragma endregion
@@ -0,0 +1,156 @@
+#pragma once
+
+#include "core.h"
+#include "TextureProperties.h"
+#include "MipBuilder.h"
+
+// Texture atlas for sprites and UI images.  Images are packed into square GL_TEXTURE_2D pages with a skyline (bottom-left) packer and each image is surrounded by a gutter of its own edge texels so mipmapped, anisotropic sampling near its edges never reads a neighbour.  The gutter is sized for the mip levels the atlas keeps and the anisotropy it is sampled with - rectangles are placed on a grid of 2^(mipLevels - 1) texels so no texel of the coarsest level kept straddles two images, and the gutter holds enough texels at that level for the bilinear footprint plus (maxAnisotropy - 1) / 2 texels of anisotropic spread outward.  Images can be added after earlier images are packed - they fill the existing pages first and new pages are only opened for what does not fit.  Packing is CPU only and runs on the global job system (files are decoded, pages packed and mip chains rebuilt in parallel), upload then creates or updates the GL textures of changed pages.  Pages keep a CPU copy of every level so later additions can rebuild mips and checkBleed can verify the gutters against the atlas contents.  Pages always clamp to edge - an image in an atlas cannot repeat.  The viewer itself does not draw from an atlas (its only images are the repeating road textures and the font) - the atlas is library code for sprite and UI rendering, exercised by -atlastest
+
+// Location of an image in the atlas
+struct AtlasEntry {
+
+	GLint			page; // -1 if the image could not be loaded or is too large for a page
+	GLuint			x, y; // bottom left texel of the image in its page
+	GLuint			width, height;
+	glm::vec4		uvRect; // (u0, v0, u1, v1) of the image in its page
+};
+
+
+// Map a texture coordinate in [0, 1] over the image to the atlas page
+inline glm::vec2 remapAtlasUV(const AtlasEntry& entry, const glm::vec2& uv) {
+
+	return glm::vec2(entry.uvRect.x, entry.uvRect.y) + uv * glm::vec2(entry.uvRect.z - entry.uvRect.x, entry.uvRect.w - entry.uvRect.y);
+}
+
+
+// Result of TextureAtlas::checkBleed
+struct AtlasBleedReport {
+
+	unsigned long long	samples; // edge samples taken over every entry and level
+	unsigned long long	bleeds; // samples whose filter footprint reached texels of another image (or unused space)
+	GLuint				entriesChecked;
+	GLuint				entriesBleeding;
+};
+
+
+// Bottom-left skyline packer for a width x height area.  The skyline is the top edge of everything placed so far, kept as a list of horizontal segments - each rectangle goes where its top is lowest (leftmost on a tie) and the segments it covers are replaced.  Fast and close to MaxRects for the mostly similar rectangles of sprite sheets, but it cannot use holes left under the skyline
+class SkylinePacker {
+
+	struct Segment {
+
+		GLuint		x, y, width;
+	};
+
+	GLuint					width, height;
+	std::vector<Segment>	skyline;
+	unsigned long long		usedArea;
+
+	// Height at which a w x h rectangle starting at segment i would sit.  Return false if it does not fit there
+	bool fit(size_t i, GLuint w, GLuint h, GLuint& y) const;
+
+public:
+
+	SkylinePacker(GLuint width = 0, GLuint height = 0);
+
+	// Start again with an empty width x height area
+	void reset(GLuint width, GLuint height);
+
+	// Place a w x h rectangle and return its bottom left corner.  Return false if it does not fit
+	bool insert(GLuint w, GLuint h, GLuint& x, GLuint& y);
+
+	unsigned long long getUsedArea() const;
+	GLuint getWidth() const;
+	GLuint getHeight() const;
+};
+
+
+class TextureAtlas {
+
+	struct Page {
+
+		SkylinePacker			packer; // in grid cells
+		MipLevel				base;
+		std::vector<MipLevel>	mipLevels; // levels 1..n (only the first mipLevels - 1 are uploaded)
+		std::vector<GLint>		owner; // entry covering each base texel (gutter included), -1 for unused texels
+		unsigned long long		imageTexels; // texels of packed images, excluding gutters
+		GLuint					texture; // 0 until uploaded
+		bool					dirty; // changed since the last upload
+	};
+
+	// Image waiting to be packed
+	struct Pending {
+
+		GLuint					entryID;
+		std::string				filename; // empty if the pixels were given directly
+		FREE_IMAGE_FORMAT		fileType;
+		std::vector<GLubyte>	pixels; // BGRA, bottom row first
+		GLuint					width, height;
+		GLuint					cellsWide, cellsHigh; // size with gutters in grid cells
+		GLuint					cellX, cellY; // placement in grid cells
+	};
+
+	GLuint						pageSize;
+	GLuint						mipLevels;
+	GLuint						maxAnisotropy;
+	GLuint						cellSize; // placement grid (texels)
+	GLuint						gutter; // texels of edge extension around each image
+	TextureProperties			properties;
+
+	std::vector<Page*>			pages;
+	std::vector<AtlasEntry>		entries;
+	std::vector<Pending>		pending;
+
+	bool decodePending();
+	void packIntoPages(const std::vector<Pending*>& images, const std::vector<GLuint>& candidatePages, std::vector<Pending*>& rejected);
+	void writeImage(Page& page, const Pending& image);
+
+public:
+
+	// Pages are pageSize x pageSize texels (rounded down to the placement grid).  mipLevels levels (including the base) are kept and uploaded - sampling below them is clamped by GL_TEXTURE_MAX_LEVEL.  maxAnisotropy is the highest anisotropy the pages are sampled with (properties.anisotropicLevel is clamped to it).  properties gives the internal format (sRGB formats are filtered in linear space), filtering and whether files are flipped - wrapping and genMipMaps are ignored
+	TextureAtlas(GLuint pageSize, GLuint mipLevels, GLuint maxAnisotropy, const TextureProperties& properties);
+	~TextureAtlas();
+
+	TextureAtlas(const TextureAtlas&) = delete;
+	TextureAtlas& operator=(const TextureAtlas&) = delete;
+
+	// Queue an image file and return the ID of its entry (valid once pack has been called).  The file type is taken from the image contents (or filename) if fileType is FIF_UNKNOWN
+	GLuint add(const std::string& filename, FREE_IMAGE_FORMAT fileType = FIF_UNKNOWN);
+
+	// Queue width x height BGRA pixels (bottom row first) and return the ID of its entry
+	GLuint addImage(const GLubyte* pixels, GLuint width, GLuint height);
+
+	// Pack every image queued since the last pack.  No GL calls are made.  Return false if any image could not be loaded or is larger than a page (its entry has page -1)
+	bool pack();
+
+	// Create textures for new pages and update pages changed by pack.  Must be called on a thread with a current GL context
+	void upload();
+
+	const AtlasEntry& getEntry(GLuint id) const;
+	GLuint getNumEntries() const;
+	GLuint getPageCount() const;
+	GLuint getPageSize() const;
+	GLuint getGutter() const;
+
+	// Texture of page (0 until uploaded)
+	GLuint getPageTexture(GLuint page) const;
+
+	// CPU copy of level of page (BGRA, bottom row first).  Return nullptr if the page or level does not exist
+	const GLubyte* getPageLevel(GLuint page, GLuint level, GLuint& width, GLuint& height) const;
+
+	// Fraction of page (or of every page) covered by images, excluding gutters
+	float getOccupancy(GLuint page) const;
+	float getOccupancy() const;
+
+	// Fraction of every page taken by images and their gutters (including grid rounding)
+	float getPackedOccupancy() const;
+
+	// Sample the edges of every entry at every kept level the way the GPU would with the given anisotropy (0 for the atlas' maxAnisotropy) - each edge sample is pushed outward by half the anisotropic footprint and the level 0 texels under its bilinear taps must all belong to the entry
+	AtlasBleedReport checkBleed(GLuint anisotropy = 0) const;
+
+	// Write the occupancy of each page and the bleed check to out
+	void printReport(std::ostream& out) const;
+};
+
+
+// Pack synthetic images (including an incremental second batch) and check their placement, colours, gutters and occupancy, reporting the results to cout.  Return true if all checks pass
+bool runTextureAtlasSelfTest();
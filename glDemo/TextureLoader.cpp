@@ -1,24 +1,44 @@
 
 #include "core.h"
 #include "TextureLoader.h"
+#include "CPUProfiler.h"
+#include "GLDebugOutput.h"
+#include "MipBuilder.h"
+#include "JobSystem.h"
 
 using namespace std;
 
 #pragma region MipMap processing
 
-static CGMipmapGenMode mipmapGenMode = CG_NO_MIPMAP_GEN;
-static bool mipmapModeInitialised = false;
+// The driver's mip chains are the default so every filtering mode is compared on the mips the driver itself produces - CPU generation is opt-in
+static CGMipmapGenMode mipmapGenMode = CG_CORE_MIPMAP_GEN;
 
-static void initialiseMipmapMode() {
+// Best GPU mipmap generation method supported by the driver - determined when GPU generation is first used
+static CGMipmapGenMode gpuMipmapGenMode = CG_NO_MIPMAP_GEN;
+static bool gpuMipmapModeInitialised = false;
+
+static void initialiseGPUMipmapMode() {
 
 	if (glewIsSupported("GL_ARB_framebuffer_object"))
-		mipmapGenMode = CG_CORE_MIPMAP_GEN;
+		gpuMipmapGenMode = CG_CORE_MIPMAP_GEN;
 	else if (glewIsSupported("GL_EXT_framebuffer_object"))
-		mipmapGenMode = CG_EXT_MIPMAP_GEN;
+		gpuMipmapGenMode = CG_EXT_MIPMAP_GEN;
 	else
-		mipmapGenMode = CG_NO_MIPMAP_GEN;
+		gpuMipmapGenMode = CG_NO_MIPMAP_GEN;
+
+	gpuMipmapModeInitialised = true;
+}
+
+
+void setMipmapGenMode(CGMipmapGenMode mode) {
+
+	mipmapGenMode = mode;
+}
 
-	mipmapModeInitialised = true;
+
+CGMipmapGenMode getMipmapGenMode() {
+
+	return mipmapGenMode;
 }
 
 #pragma endregion
@@ -26,19 +46,27 @@ static void initialiseMipmapMode() {
 
 #pragma region FreeImagePlus texture loader
 
-GLuint fiLoadTexture(string filename, FREE_IMAGE_FORMAT fileType, const TextureProperties& properties) {
+// Image decoded on a worker thread, ready for upload.  mipLevels holds levels 1..n if the mip chain is built on the CPU
+struct DecodedImage {
 
-	GLuint				newTexture = 0;
-	
-	FIBITMAP* loadedBitmap = FreeImage_Load(fileType, filename.c_str(), BMP_DEFAULT);
+	FIBITMAP*			bitmap = nullptr;
+	GLuint				width = 0;
+	GLuint				height = 0;
+	vector<MipLevel>	mipLevels;
+};
+
+
+FIBITMAP* fiLoadBitmap32(const string& filename, FREE_IMAGE_FORMAT fileType, bool flipImageY) {
+
+	FIBITMAP* loadedBitmap = FreeImage_Load(fileType, nativePath(filename).c_str(), BMP_DEFAULT);
 
 	if (!loadedBitmap) {
 
 		cout << "FreeImage: Cannot open image file " << filename << endl;
-		return 0;
+		return nullptr;
 	}
 
-	if (properties.flipImageY) {
+	if (flipImageY) {
 
 		FreeImage_FlipVertical(loadedBitmap);
 	}
@@ -49,16 +77,89 @@ GLuint fiLoadTexture(string filename, FREE_IMAGE_FORMAT fileType, const TextureP
 	if (!bitmap32bpp) {
 
 		cout << "FreeImage: Conversion to 32 bits successful for image " << filename << endl;
-		return 0;
+		return nullptr;
 	}
 
-	GLuint w = FreeImage_GetWidth(bitmap32bpp);
-	GLuint h = FreeImage_GetHeight(bitmap32bpp);
-	BYTE* buffer = FreeImage_GetBits(bitmap32bpp);
+	return bitmap32bpp;
+}
+
+
+// Build the CPU mip chain for image if required by properties and the current mipmap generation mode.  Safe to call from any thread
+static void buildImageMips(DecodedImage& image, const TextureProperties& properties) {
+
+	CPU_PROFILE_FUNCTION();
+
+	if (!image.bitmap || !properties.genMipMaps || mipmapGenMode != CG_CPU_MIPMAP_GEN)
+		return;
+
+	BYTE* buffer = FreeImage_GetBits(image.bitmap);
+
+	if (buffer)
+		buildMipChain(buffer, image.width, image.height, isSRGBFormat(properties.internalFormat), image.mipLevels);
+}
+
+
+// Decode the given image file into image.  Safe to call from any thread
+static bool decodeImage(const string& filename, FREE_IMAGE_FORMAT fileType, const TextureProperties& properties, DecodedImage& image) {
+
+	CPU_PROFILE_FUNCTION();
+
+	image.bitmap = fiLoadBitmap32(filename, fileType, properties.flipImageY);
+
+	if (!image.bitmap)
+		return false;
+
+	image.width = FreeImage_GetWidth(image.bitmap);
+	image.height = FreeImage_GetHeight(image.bitmap);
+
+	return true;
+}
+
+
+// Apply filtering, wrap and mipmap properties to the texture currently bound to target.  Mipmaps are generated here for the GPU generation modes - CPU generated levels are uploaded with the base image
+static void applyTextureProperties(GLenum target, const TextureProperties& properties) {
+
+	// Verify we don't use GL_LINEAR_MIPMAP_LINEAR which has no meaning in non-mipmapped textures.  If not set, default to GL_LINEAR (bi-linear) filtering.
+	GLint minFilter = (!properties.genMipMaps && properties.minFilter == GL_LINEAR_MIPMAP_LINEAR) ? GL_LINEAR : properties.minFilter;
+	GLint maxFilter = (!properties.genMipMaps && properties.maxFilter == GL_LINEAR_MIPMAP_LINEAR) ? GL_LINEAR : properties.maxFilter;
+
+	glTexParameteri(target, GL_TEXTURE_MIN_FILTER, minFilter);
+	glTexParameteri(target, GL_TEXTURE_MAG_FILTER, maxFilter);
+	glTexParameterf(target, GL_TEXTURE_MAX_ANISOTROPY_EXT, properties.anisotropicLevel);
+	glTexParameteri(target, GL_TEXTURE_WRAP_S, properties.wrap_s);
+	glTexParameteri(target, GL_TEXTURE_WRAP_T, properties.wrap_t);
+
+	if (!properties.genMipMaps || mipmapGenMode == CG_NO_MIPMAP_GEN || mipmapGenMode == CG_CPU_MIPMAP_GEN)
+		return;
+
+	// Initialise GPU mipmap creation method based on supported extensions
+	if (!gpuMipmapModeInitialised)
+		initialiseGPUMipmapMode();
+
+	if (gpuMipmapGenMode == CG_CORE_MIPMAP_GEN)
+		glGenerateMipmap(target);
+	else if (gpuMipmapGenMode == CG_EXT_MIPMAP_GEN)
+		glGenerateMipmapEXT(target);
+}
+
+
+// Create a GL_TEXTURE_2D from a decoded image and release the image's bitmap.  Must be called on a thread with a current GL context
+static GLuint uploadImage(DecodedImage& image, const string& filename, const TextureProperties& properties) {
+
+	CPU_PROFILE_FUNCTION();
+	GLCallContext glCallContext(__FUNCTION__);
+
+	GLuint				newTexture = 0;
+
+	if (!image.bitmap)
+		return 0;
+
+	BYTE* buffer = FreeImage_GetBits(image.bitmap);
 
 	if (!buffer) {
 
-		FreeImage_Unload(bitmap32bpp);
+		FreeImage_Unload(image.bitmap);
+		image.bitmap = nullptr;
 
 		cout << "FreeImage: Cannot access bitmap data for image " << filename << endl;
 		return 0;
@@ -66,40 +167,376 @@ GLuint fiLoadTexture(string filename, FREE_IMAGE_FORMAT fileType, const TextureP
 
 	glGenTextures(1, &newTexture);
 	glBindTexture(GL_TEXTURE_2D, newTexture);
-	glTexImage2D(GL_TEXTURE_2D, 0, properties.internalFormat, w, h, 0, GL_BGRA, GL_UNSIGNED_BYTE, buffer);
+	glTexImage2D(GL_TEXTURE_2D, 0, properties.internalFormat, image.width, image.height, 0, GL_BGRA, GL_UNSIGNED_BYTE, buffer);
+
+	for (GLuint i = 0; i < (GLuint)image.mipLevels.size(); i++) {
+
+		const MipLevel& level = image.mipLevels[i];
+
+		glTexImage2D(GL_TEXTURE_2D, i + 1, properties.internalFormat, level.width, level.height, 0, GL_BGRA, GL_UNSIGNED_BYTE, level.pixels.data());
+	}
 
 	// Setup default texture properties
 	if (newTexture) {
 
-		// Verify we don't use GL_LINEAR_MIPMAP_LINEAR which has no meaning in non-mipmapped textures.  If not set, default to GL_LINEAR (bi-linear) filtering.
-		GLint minFilter = (!properties.genMipMaps && properties.minFilter == GL_LINEAR_MIPMAP_LINEAR) ? GL_LINEAR : properties.minFilter;
-		GLint maxFilter = (!properties.genMipMaps && properties.maxFilter == GL_LINEAR_MIPMAP_LINEAR) ? GL_LINEAR : properties.maxFilter;
+		applyTextureProperties(GL_TEXTURE_2D, properties);
+	}
+
+	// Cleanup resources
+	FreeImage_Unload(image.bitmap);
+	image.bitmap = nullptr;
+	image.mipLevels.clear();
+
+	// Return texture ID
+	return newTexture;
+}
+
+
+GLuint fiLoadTexture(string filename, FREE_IMAGE_FORMAT fileType, const TextureProperties& properties) {
+
+	CPU_PROFILE_FUNCTION();
+
+	DecodedImage image;
+
+	if (!decodeImage(filename, fileType, properties, image))
+		return 0;
+
+	buildImageMips(image, properties);
+
+	return uploadImage(image, filename, properties);
+}
+
+
+vector<GLuint> fiLoadTextures(const vector<TextureLoadRequest>& requests) {
+
+	CPU_PROFILE_FUNCTION();
+
+	JobSystem& jobSystem = JobSystem::global();
+
+	vector<DecodedImage> images(requests.size());
+	JobCounter decoded;
+
+	// Decode and build mip chains in parallel.  The mip chain of each image is only started once that image is decoded, so large images are not held up waiting for the whole batch
+	for (size_t i = 0; i < requests.size(); i++) {
+
+		jobSystem.submit([&requests, &images, i]() {
+
+			if (decodeImage(requests[i].filename, requests[i].fileType, requests[i].properties, images[i]))
+				buildImageMips(images[i], requests[i].properties);
+
+		}, &decoded);
+	}
+
+	jobSystem.wait(decoded);
+
+	// Upload serially on the GL thread
+	vector<GLuint> textures(requests.size(), 0);
+
+	for (size_t i = 0; i < requests.size(); i++)
+		textures[i] = uploadImage(images[i], requests[i].filename, requests[i].properties);
+
+	return textures;
+}
+
+#pragma endregion
+
+
+#pragma region Texture array builder
+
+// Smallest power of two >= x
+static GLuint nextPowerOfTwo(GLuint x) {
+
+	GLuint p = 1;
+
+	while (p < x)
+		p <<= 1;
+
+	return p;
+}
+
+
+// Power of two nearest to x (rounding up on a tie) so images are scaled by the smallest factor
+static GLuint nearestPowerOfTwo(GLuint x) {
+
+	GLuint p = nextPowerOfTwo(x);
+
+	return (p > 1 && p - x > x - p / 2) ? p / 2 : p;
+}
+
+
+// Copy bitmap into the bottom left corner of a new width x height bitmap, extending the last column and row into the padding so filtering and coarse mip levels do not blend in unrelated texels.  Return nullptr if the bitmap cannot be allocated
+static FIBITMAP* padBitmap(FIBITMAP* bitmap, GLuint width, GLuint height) {
+
+	GLuint w = FreeImage_GetWidth(bitmap);
+	GLuint h = FreeImage_GetHeight(bitmap);
+
+	FIBITMAP* padded = FreeImage_Allocate(width, height, 32);
+
+	if (!padded)
+		return nullptr;
+
+	for (GLuint y = 0; y < height; y++) {
+
+		const GLuint* src = (const GLuint*)FreeImage_GetScanLine(bitmap, std::min(y, h - 1));
+		GLuint* dst = (GLuint*)FreeImage_GetScanLine(padded, y);
+
+		memcpy(dst, src, w * sizeof(GLuint));
+
+		for (GLuint x = w; x < width; x++)
+			dst[x] = src[w - 1];
+	}
+
+	return padded;
+}
 
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, minFilter);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, maxFilter);
-		glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, properties.anisotropicLevel);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, properties.wrap_s);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, properties.wrap_t);
 
-		// Initialise mipmap creation method based on supported extensions
-		if (!mipmapModeInitialised)
-			initialiseMipmapMode();
+// Fit a decoded image to its texture array layer.  Layer sizes for the resize and pad fits are clamped to [minSize, maxSize].  Return false (releasing the bitmap) if the image cannot be resized.  Safe to call from any thread
+static bool fitArrayLayer(DecodedImage& image, const string& filename, TextureArrayFit fit, GLuint minSize, GLuint maxSize, glm::vec2& uvScale) {
 
-		if (properties.genMipMaps && mipmapGenMode != CG_NO_MIPMAP_GEN) {
+	CPU_PROFILE_FUNCTION();
 
-			if (mipmapGenMode == CG_CORE_MIPMAP_GEN)
-				glGenerateMipmap(GL_TEXTURE_2D);
-			else if (mipmapGenMode == CG_EXT_MIPMAP_GEN)
-				glGenerateMipmapEXT(GL_TEXTURE_2D);
+	uvScale = glm::vec2(1.0f, 1.0f);
+
+	if (fit == ARRAY_FIT_EXACT)
+		return true;
+
+	GLuint layerWidth = glm::clamp<GLuint>((fit == ARRAY_FIT_RESIZE) ? nearestPowerOfTwo(image.width) : nextPowerOfTwo(image.width), minSize, maxSize);
+	GLuint layerHeight = glm::clamp<GLuint>((fit == ARRAY_FIT_RESIZE) ? nearestPowerOfTwo(image.height) : nextPowerOfTwo(image.height), minSize, maxSize);
+
+	// Padded images larger than the layer are scaled down to fit, keeping their aspect ratio
+	GLuint width = layerWidth, height = layerHeight;
+
+	if (fit == ARRAY_FIT_PAD) {
+
+		float scale = std::min(std::min((float)layerWidth / image.width, (float)layerHeight / image.height), 1.0f);
+
+		width = std::max<GLuint>((GLuint)(image.width * scale), 1);
+		height = std::max<GLuint>((GLuint)(image.height * scale), 1);
+	}
+
+	if (width != image.width || height != image.height) {
+
+		FIBITMAP* rescaled = FreeImage_Rescale(image.bitmap, width, height, FILTER_BILINEAR);
+
+		FreeImage_Unload(image.bitmap);
+		image.bitmap = rescaled;
+
+		if (!image.bitmap) {
+
+			cout << "FreeImage: Cannot rescale image " << filename << " to " << width << " x " << height << " for a texture array layer" << endl;
+			return false;
+		}
+	}
+
+	if (width != layerWidth || height != layerHeight) {
+
+		FIBITMAP* padded = padBitmap(image.bitmap, layerWidth, layerHeight);
+
+		FreeImage_Unload(image.bitmap);
+		image.bitmap = padded;
+
+		if (!image.bitmap) {
+
+			cout << "FreeImage: Cannot pad image " << filename << " to " << layerWidth << " x " << layerHeight << " for a texture array layer" << endl;
+			return false;
 		}
+
+		uvScale = glm::vec2((float)width / layerWidth, (float)height / layerHeight);
 	}
 
+	image.width = layerWidth;
+	image.height = layerHeight;
+
+	return true;
+}
+
+
+// Return true if textures with properties a and b can share an array (every property except the image orientation applies to the whole array)
+static bool sameArrayProperties(const TextureProperties& a, const TextureProperties& b) {
+
+	return a.internalFormat == b.internalFormat && a.minFilter == b.minFilter && a.maxFilter == b.maxFilter && a.anisotropicLevel == b.anisotropicLevel && a.wrap_s == b.wrap_s && a.wrap_t == b.wrap_t && a.genMipMaps == b.genMipMaps;
+}
+
+
+TextureArrayBuilder::TextureArrayBuilder(GLuint minLayerSize, GLuint maxLayerSize) {
+
+	this->minLayerSize = std::max<GLuint>(minLayerSize, 1);
+	this->maxLayerSize = maxLayerSize;
+}
+
+
+GLuint TextureArrayBuilder::add(const string& filename, FREE_IMAGE_FORMAT fileType, const TextureProperties& properties, TextureArrayFit fit) {
+
+	GLuint handleID = (GLuint)handles.size();
+
+	handles.push_back({ 0, -1, glm::vec2(1.0f, 1.0f) });
+	requests.push_back({ filename, fileType, properties, fit, handleID });
+
+	return handleID;
+}
+
+
+bool TextureArrayBuilder::build() {
+
+	CPU_PROFILE_FUNCTION();
+	GLCallContext glCallContext(__FUNCTION__);
+
+	if (requests.empty())
+		return true;
+
+	GLint maxTextureSize = 0, maxLayers = 0;
+
+	glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTextureSize);
+	glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayers);
+
+	GLuint maxSize = std::max<GLuint>((GLuint)maxTextureSize, 1);
+
+	if (maxLayerSize > 0)
+		maxSize = std::min(maxSize, maxLayerSize);
+
+	GLuint minSize = std::min(minLayerSize, maxSize);
+	GLuint layersPerArray = (GLuint)std::max(maxLayers, 1);
+
+	JobSystem& jobSystem = JobSystem::global();
+
+	vector<DecodedImage> images(requests.size());
+	vector<glm::vec2> uvScales(requests.size());
+	JobCounter processed;
+
+	// 1. Decode, fit to a layer and build the mip chain of every image in parallel.  Each layer size depends only on its own image
+	for (size_t i = 0; i < requests.size(); i++) {
+
+		jobSystem.submit([this, &images, &uvScales, minSize, maxSize, i]() {
+
+			const Request& request = requests[i];
+			DecodedImage& image = images[i];
+			FREE_IMAGE_FORMAT fileType = request.fileType;
+
+			if (fileType == FIF_UNKNOWN) {
+
+				string path = nativePath(request.filename);
+
+				fileType = FreeImage_GetFileType(path.c_str());
+
+				if (fileType == FIF_UNKNOWN)
+					fileType = FreeImage_GetFIFFromFilename(path.c_str());
+			}
+
+			if (!decodeImage(request.filename, fileType, request.properties, image))
+				return;
+
+			if (fitArrayLayer(image, request.filename, request.fit, minSize, maxSize, uvScales[i]))
+				buildImageMips(image, request.properties);
+
+		}, &processed);
+	}
+
+	jobSystem.wait(processed);
+
+	// 2. Group the images that can share an array - groups are few so a linear search is enough
+	struct ArrayGroup {
+
+		size_t					first; // request defining the group's properties
+		GLuint					width, height;
+		std::vector<size_t>		members;
+	};
+
+	vector<ArrayGroup> groups;
+	bool allLoaded = true;
+
+	for (size_t i = 0; i < requests.size(); i++) {
+
+		if (!images[i].bitmap) {
+
+			allLoaded = false;
+			continue;
+		}
+
+		auto group = find_if(groups.begin(), groups.end(), [&](const ArrayGroup& g) {
+
+			return g.width == images[i].width && g.height == images[i].height && sameArrayProperties(requests[g.first].properties, requests[i].properties);
+		});
+
+		if (group == groups.end()) {
+
+			groups.push_back({ i, images[i].width, images[i].height, {} });
+			group = groups.end() - 1;
+		}
+
+		group->members.push_back(i);
+	}
+
+	// 3. Upload each group on the GL thread, split into arrays of at most layersPerArray layers.  Layers of the same size share the same mip chain length
+	for (const ArrayGroup& group : groups) {
+
+		const TextureProperties& properties = requests[group.first].properties;
+
+		for (size_t start = 0; start < group.members.size(); start += layersPerArray) {
+
+			GLsizei numLayers = (GLsizei)std::min<size_t>(group.members.size() - start, layersPerArray);
+			const DecodedImage& firstImage = images[group.members[start]];
+
+			GLuint newArray = 0;
+
+			glGenTextures(1, &newArray);
+			glBindTexture(GL_TEXTURE_2D_ARRAY, newArray);
+			glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, properties.internalFormat, group.width, group.height, numLayers, 0, GL_BGRA, GL_UNSIGNED_BYTE, nullptr);
+
+			for (GLuint i = 0; i < (GLuint)firstImage.mipLevels.size(); i++) {
+
+				const MipLevel& level = firstImage.mipLevels[i];
+
+				glTexImage3D(GL_TEXTURE_2D_ARRAY, i + 1, properties.internalFormat, level.width, level.height, numLayers, 0, GL_BGRA, GL_UNSIGNED_BYTE, nullptr);
+			}
+
+			for (GLsizei layer = 0; layer < numLayers; layer++) {
+
+				size_t index = group.members[start + layer];
+				DecodedImage& image = images[index];
+
+				glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, group.width, group.height, 1, GL_BGRA, GL_UNSIGNED_BYTE, FreeImage_GetBits(image.bitmap));
+
+				for (GLuint i = 0; i < (GLuint)image.mipLevels.size(); i++) {
+
+					const MipLevel& level = image.mipLevels[i];
+
+					glTexSubImage3D(GL_TEXTURE_2D_ARRAY, i + 1, 0, 0, layer, level.width, level.height, 1, GL_BGRA, GL_UNSIGNED_BYTE, level.pixels.data());
+				}
+
+				handles[requests[index].handleID] = { newArray, layer, uvScales[index] };
+			}
+
+			// GPU mipmaps are generated for all layers
+			applyTextureProperties(GL_TEXTURE_2D_ARRAY, properties);
+
+			arrays.push_back(newArray);
+		}
+	}
+
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
 	// Cleanup resources
-	FreeImage_Unload(bitmap32bpp);
+	for (auto& image : images) {
 
-	// Return texture ID
-	return newTexture;
+		if (image.bitmap)
+			FreeImage_Unload(image.bitmap);
+	}
+
+	requests.clear();
+
+	return allLoaded;
 }
 
-#pragma endregion
 
+const TextureArrayHandle& TextureArrayBuilder::getHandle(GLuint id) const {
+
+	return handles[id];
+}
+
+
+const vector<GLuint>& TextureArrayBuilder::getArrays() const {
+
+	return arrays;
+}
+
+#pragma endregion
@@ -6,9 +6,83 @@
 enum CGMipmapGenMode {
 	
 	CG_NO_MIPMAP_GEN = 0,
-	CG_CORE_MIPMAP_GEN,
-	CG_EXT_MIPMAP_GEN
+	CG_CORE_MIPMAP_GEN, // driver generated mip chains (default)
+	CG_EXT_MIPMAP_GEN,
+	CG_CPU_MIPMAP_GEN // mip chains are built on the job system (2x2 box filter, see MipBuilder) and uploaded with the base image
 };
 
+// Texture load request for batch loading
+struct TextureLoadRequest {
+
+	std::string			filename;
+	FREE_IMAGE_FORMAT	fileType;
+	TextureProperties	properties;
+
+	TextureLoadRequest(const std::string& filename, FREE_IMAGE_FORMAT fileType, const TextureProperties& properties) : filename(filename), fileType(fileType), properties(properties) {}
+};
+
+// Select how mipmaps are generated for textures with genMipMaps set.  CG_CORE_MIPMAP_GEN and CG_EXT_MIPMAP_GEN use whichever GPU method the driver supports
+void setMipmapGenMode(CGMipmapGenMode mode);
+CGMipmapGenMode getMipmapGenMode();
+
+// Load the given image file and convert to a 32 bit (BGRA) bitmap.  The bitmap is flipped vertically if flipImageY is true.  Return nullptr if the image cannot be loaded or converted.  The caller is responsible for unloading the returned bitmap.  Safe to call from any thread
+FIBITMAP* fiLoadBitmap32(const std::string& filename, FREE_IMAGE_FORMAT fileType, bool flipImageY);
+
 // FreeImage texture loader
 GLuint fiLoadTexture(std::string filename, FREE_IMAGE_FORMAT fileType, const TextureProperties& properties);
+
+// FreeImage batch texture loader.  Images are decoded (and mip chains built) in parallel on the global job system then uploaded on the calling thread, which must have a current GL context.  Return one texture per request in request order (0 if a load failed)
+std::vector<GLuint> fiLoadTextures(const std::vector<TextureLoadRequest>& requests);
+
+
+// How an image is fitted to a texture array layer by TextureArrayBuilder
+enum TextureArrayFit {
+
+	ARRAY_FIT_EXACT = 0, // the layer is the size of the image - only images of the same size share an array
+	ARRAY_FIT_RESIZE, // rescaled to the nearest power of two size
+	ARRAY_FIT_PAD // placed in the bottom left corner of the next power of two size with its edge texels extended into the padding.  Texture coordinates must be scaled by the handle's uvScale so the image cannot repeat
+};
+
+
+// Location of an image in a texture array built by TextureArrayBuilder
+struct TextureArrayHandle {
+
+	GLuint			array; // 0 if the image could not be loaded
+	GLint			layer;
+	glm::vec2		uvScale; // (1, 1) unless the layer is padded
+};
+
+
+// Pack many images into as few GL_TEXTURE_2D_ARRAYs as possible so objects using different images can be drawn together without texture binds (see MultiDrawBatch).  Images are grouped by layer size and by the properties an array shares (internal format, filtering, wrapping and mipmaps) - each group becomes one array, split where it exceeds GL_MAX_ARRAY_TEXTURE_LAYERS.  Layer sizes are clamped to [minLayerSize, maxLayerSize] for the resize and pad fits so nearby sizes can be forced into a single array.  Images are decoded, fitted and their mip chains built per layer in parallel on the global job system and uploaded by build on the calling thread, which must have a current GL context.  The arrays belong to the caller
+class TextureArrayBuilder {
+
+	struct Request {
+
+		std::string			filename;
+		FREE_IMAGE_FORMAT	fileType;
+		TextureProperties	properties;
+		TextureArrayFit		fit;
+		GLuint				handleID;
+	};
+
+	GLuint							minLayerSize, maxLayerSize;
+	std::vector<Request>			requests;
+	std::vector<TextureArrayHandle>	handles;
+	std::vector<GLuint>				arrays;
+
+public:
+
+	// maxLayerSize 0 uses GL_MAX_TEXTURE_SIZE
+	TextureArrayBuilder(GLuint minLayerSize = 1, GLuint maxLayerSize = 0);
+
+	// Queue an image and return the ID of its handle (valid once build has been called).  The file type is taken from the image contents (or filename) if fileType is FIF_UNKNOWN
+	GLuint add(const std::string& filename, FREE_IMAGE_FORMAT fileType, const TextureProperties& properties, TextureArrayFit fit = ARRAY_FIT_RESIZE);
+
+	// Load every image queued since the last build into new arrays.  Return false if any image failed to load (its handle has array 0)
+	bool build();
+
+	const TextureArrayHandle& getHandle(GLuint id) const;
+
+	// Every array created, in order of creation
+	const std::vector<GLuint>& getArrays() const;
+};
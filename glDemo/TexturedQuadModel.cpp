@@ -1,8 +1,11 @@
 
 #include "core.h"
 #include "TexturedQuadModel.h"
+#include "GLDebugOutput.h"
 #include "TextureLoader.h"
 #include "ShaderSetup.h"
+#include "MultiDrawBatch.h"
+#include "SamplerFeedback.h"
 
 
 using namespace std;
@@ -74,6 +77,10 @@ void TexturedQuadModel::setupVAO() {
 
 TexturedQuadModel::TexturedQuadModel(string filename, FREE_IMAGE_FORMAT fileType, const TextureProperties& properties) {
 
+	feedback = nullptr;
+	feedbackShader = 0;
+	feedbackMvpLocation = -1;
+
 	loadShader();
 	setupVAO();
 
@@ -84,6 +91,10 @@ TexturedQuadModel::TexturedQuadModel(string filename, FREE_IMAGE_FORMAT fileType
 
 TexturedQuadModel::TexturedQuadModel(GLuint texture) {
 
+	feedback = nullptr;
+	feedbackShader = 0;
+	feedbackMvpLocation = -1;
+
 	loadShader();
 	setupVAO();
 
@@ -106,6 +117,9 @@ TexturedQuadModel::~TexturedQuadModel() {
 	glDeleteVertexArrays(1, &quadVertexArrayObj);
 
 	glDeleteShader(quadShader);
+
+	if (feedbackShader)
+		glDeleteProgram(feedbackShader);
 }
 
 
@@ -116,6 +130,8 @@ GLuint TexturedQuadModel::getTexture() {
 
 void TexturedQuadModel::render(const glm::mat4& T) {
 
+	GLCallContext glCallContext(__FUNCTION__);
+
 	static GLint mvpLocation = glGetUniformLocation(quadShader, "mvpMatrix");
 
 	glUseProgram(quadShader);
@@ -134,3 +150,38 @@ void TexturedQuadModel::render(const glm::mat4& T) {
 }
 
 
+void TexturedQuadModel::attachFeedback(SamplerFeedback* feedback) {
+
+	if (feedbackShader)
+		glDeleteProgram(feedbackShader);
+
+	this->feedback = feedback;
+
+	feedbackShader = (feedback) ? feedback->createProgram(string("Shaders\\basic_texture.vs.txt")) : 0;
+	feedbackMvpLocation = (feedbackShader) ? glGetUniformLocation(feedbackShader, "mvpMatrix") : -1;
+}
+
+
+void TexturedQuadModel::renderFeedback(const glm::mat4& T, GLuint slot) {
+
+	GLCallContext glCallContext(__FUNCTION__);
+
+	if (!feedbackShader)
+		return;
+
+	glUseProgram(feedbackShader);
+	glUniformMatrix4fv(feedbackMvpLocation, 1, GL_FALSE, (const GLfloat*)&(T));
+	feedback->bindSlot(feedbackShader, slot);
+
+	glBindVertexArray(quadVertexArrayObj);
+	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+	glBindVertexArray(0);
+}
+
+
+GLuint TexturedQuadModel::addMeshToBatch(MultiDrawBatch* batch) {
+
+	static GLuint quadIndexArray[] = { 0, 1, 2, 3 };
+
+	return batch->addMesh(GL_TRIANGLE_STRIP, (const glm::vec4*)quadPositionArray, nullptr, (const glm::vec2*)quadTextureCoordArray, 4, quadIndexArray, 4);
+}
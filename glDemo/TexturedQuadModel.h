@@ -3,6 +3,9 @@
 #include "core.h"
 #include "TextureProperties.h"
 
+class MultiDrawBatch;
+class SamplerFeedback;
+
 // Model a simple textured quad oriented to face along the +z axis (so the textured quad faces the viewer in (right-handed) eye coordinate space.  The quad is modelled using VBOs and VAOs and rendered using the basic texture shader in Resources\Shaders\basic_texture.vs and Resources\Shaders\basic_texture.fs
 
 class TexturedQuadModel {
@@ -18,6 +21,11 @@ private:
 
 	GLuint					texture;
 
+	// Sampler feedback program (created by attachFeedback) - shares the quad's vertex shader
+	SamplerFeedback*		feedback;
+	GLuint					feedbackShader;
+	GLint					feedbackMvpLocation;
+
 	//
 	// Private API
 	//
@@ -40,4 +48,13 @@ public:
 	GLuint getTexture();
 
 	void render(const glm::mat4& T);
+
+	// Create the program used to draw the quad into feedback's passes (replacing any earlier attachment)
+	void attachFeedback(SamplerFeedback* feedback);
+
+	// Draw the quad into the current pass of the attached sampler feedback, recording into the given feedback slot.  Does nothing if no feedback is attached or feedback is not supported
+	void renderFeedback(const glm::mat4& T, GLuint slot);
+
+	// Add the textured quad geometry to the given MultiDrawBatch and return the batch mesh ID
+	static GLuint addMeshToBatch(MultiDrawBatch* batch);
 };
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <atomic>
+
+// Lock-free triple buffer for publishing snapshots of state from one producer thread to one consumer thread.  The producer writes into writeBuffer() and calls publish().  The consumer calls update() to acquire the most recently published snapshot and reads it through readBuffer().  Intermediate snapshots are dropped, so the consumer always sees the latest state and neither side ever blocks
+
+namespace cst {
+
+	template <typename T>
+	class TripleBuffer {
+
+		static const unsigned		INDEX_MASK = 0x3;
+		static const unsigned		FRESH_BIT = 0x4; // set when the middle buffer holds a snapshot the consumer has not seen
+
+		struct alignas(64) Slot {
+
+			T		value;
+		};
+
+		Slot						slots[3];
+
+		unsigned					back; // owned by the producer
+		unsigned					front; // owned by the consumer
+		alignas(64) std::atomic<unsigned>	middle; // shared - index of the buffer in transit plus FRESH_BIT
+
+	public:
+
+		TripleBuffer() : back(0), front(1), middle(2) {}
+
+		TripleBuffer(const TripleBuffer&) = delete;
+		TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+		// Producer interface
+
+		T& writeBuffer() {
+
+			return slots[back].value;
+		}
+
+		// Publish the contents of writeBuffer() to the consumer.  The producer receives a new (stale) buffer to write into, so the complete state must be written before each publish
+		void publish() {
+
+			unsigned prev = middle.exchange(back | FRESH_BIT, std::memory_order_acq_rel);
+			back = prev & INDEX_MASK;
+		}
+
+
+		// Consumer interface
+
+		// Acquire the latest published snapshot.  Return true if a new snapshot was received since the last call
+		bool update() {
+
+			if ((middle.load(std::memory_order_relaxed) & FRESH_BIT) == 0)
+				return false;
+
+			unsigned prev = middle.exchange(front, std::memory_order_acq_rel);
+			front = prev & INDEX_MASK;
+
+			return true;
+		}
+
+		const T& readBuffer() const {
+
+			return slots[front].value;
+		}
+	};
+
+}
@@ -2,6 +2,15 @@
 #include "ViewFrustum.h"
 #include "cst-math.h"
 
+// Select the batch culling path at compile time - AVX processes 8 objects per iteration, SSE2 4
+#if defined(__AVX__)
+#include <immintrin.h>
+#define CST_FRUSTUM_AVX
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CST_FRUSTUM_SSE2
+#endif
+
 
 using namespace std;
 
@@ -9,19 +18,88 @@ using namespace std;
 namespace cst {
 
 
+	std::atomic<unsigned long long> ViewFrustum::recomputeCount(0);
+	std::atomic<unsigned long long> ViewFrustum::recomputesAvoided(0);
+
+
 	//
 	// Private API implementation
 	//
 
+	// mark the projection derived values (and therefore the world coordinate planes) as stale.  If they are already stale the recalculation an eager update would have made is counted as avoided
+	void ViewFrustum::invalidateProjection() {
+
+		if (projectionDirty)
+			recomputesAvoided++;
+
+		projectionDirty = true;
+
+		invalidateWorldPlanes();
+	}
+
+
+	// mark the world coordinate planes as stale
+	void ViewFrustum::invalidateWorldPlanes() {
+
+		if (worldPlanesDirty)
+			recomputesAvoided++;
+
+		worldPlanesDirty = true;
+	}
+
+
+	// recalculate flength, P and the eye coordinate planes if stale
+	void ViewFrustum::updateProjection() const {
+
+		if (!projectionDirty)
+			return;
+
+		calculateFocalLength();
+		calculateProjectionMatrix();
+		calculateEyeCoordPlanes();
+
+		projectionDirty = false;
+		recomputeCount++;
+	}
+
+
+	// recalculate the world coordinate planes if stale.  Given R is the orientation of the camera, R^-1 = R^T is used to rotate this to eye coordinate space.  Let T^-1 be translate(-C.x, -C.y, -C.z) be the translation from the camera world coordinate to eye coordinate space.  The view transform is therefore (R^T * T^-1).  The inverse of this is therefore T * R which maps from eye coordinate space to world coordinate space.  The inverse transpose of T * R is actually W = (R^-1 * T^-1)^T.  This inverse transpose is used to map the frustum plane normals from eye coordinate space to world coordinate space
+	void ViewFrustum::updateWorldPlanes() const {
+
+		if (!worldPlanesDirty)
+			return;
+
+		// world planes are derived from the eye coordinate planes
+		updateProjection();
+
+		const glm::vec4& C = cameraPos;
+
+		glm::mat4 W = glm::transpose(glm::transpose(cameraOrientation) *
+			glm::translate(glm::mat4(1.0f), glm::vec3(-C.x, -C.y, -C.z)));
+		//GUMatrix4 W = (R.transpose() * GUMatrix4::translationMatrix(-C.x, -C.y, -C.z)).transpose();
+
+		wLeft = W * eLeft;
+		wRight = W * eRight;
+		wBottom = W * eBottom;
+		wTop = W * eTop;
+		wNear = W * eNear;
+		wFar = W * eFar;
+
+		updateCullPlanes();
+
+		worldPlanesDirty = false;
+		recomputeCount++;
+	}
+
 	// given the current projection coefficients, calculate the derived quantity flength (focal length)
-	void ViewFrustum::calculateFocalLength() {
+	void ViewFrustum::calculateFocalLength() const {
 
 		flength = 1.0f / tanf(glm::radians<float>(fovy) / 2.0f);
 	}
 
 
 	// calculate the projection matrix for the current projection coefficients.  The matrix is stored in column major format.  An infinite perspective projection matrix is setup if d_far = 0.0 as determined by equalf
-	void ViewFrustum::calculateProjectionMatrix() {
+	void ViewFrustum::calculateProjectionMatrix() const {
 
 		//if (isInfinite())
 		//	P = glm::infinitePerspective(fovy, aspect, d_near);
@@ -33,7 +111,7 @@ namespace cst {
 
 
 	// calculate frustum planes in eye coordinate space based on the current projection coefficients.  The resulting plane normal vectors are normalised to unit length.  For OpenGL, by default the frustum and therefore the planes are oriented along the negative z axis.   Note:  The plane equations below are based on Lengyel's model on p. 116 (2nd ed.)  However Lengyel uses h/w aspect and fovx rather than w/h aspect and fovy as used here.  Therefore the bottom and top become the left and right vectors and visa versa.  The x and y components are also swapped (compare below with table 4.1 in the above reference).  For a frustum representing an infinite perspective projection the far plane coefficients represent a 'placeholder' plane offset 1.0 from the near plane.  This should not be used for view frustum intersection testing and is only setup for testing / frustum visualisation purposes
-	void ViewFrustum::calculateEyeCoordPlanes() {
+	void ViewFrustum::calculateEyeCoordPlanes() const {
 
 		float e = flength;
 		float a = aspect;
@@ -48,6 +126,40 @@ namespace cst {
 		eTop = glm::vec4(0.0f, -eBottom.y, eBottom.z, 0.0f);
 		eNear = glm::vec4(0.0f, 0.0f, -1.0f, -d_near);
 		eFar = glm::vec4(0.0f, 0.0f, 1.0f, (isInfinite() ? d_near + 1.0f : d_far));
+
+		// the far plane is only tested for finite projections
+		numCullPlanes = isInfinite() ? 5 : 6;
+	}
+
+
+	// copy the world coordinate planes into SoA form for batch culling
+	void ViewFrustum::updateCullPlanes() const {
+
+		const glm::vec4* planes[6] = { &wLeft, &wRight, &wBottom, &wTop, &wNear, &wFar };
+
+		for (int i = 0; i < 6; i++) {
+
+			planeNX[i] = planes[i]->x;
+			planeNY[i] = planes[i]->y;
+			planeNZ[i] = planes[i]->z;
+			planeD[i] = planes[i]->w;
+
+			planeAbsNX[i] = fabsf(planes[i]->x);
+			planeAbsNY[i] = fabsf(planes[i]->y);
+			planeAbsNZ[i] = fabsf(planes[i]->z);
+		}
+	}
+
+
+	// return the number of set bits in v
+	static inline size_t countBits(uint32_t v) {
+
+		size_t n = 0;
+
+		for (; v; n++)
+			v &= v - 1;
+
+		return n;
 	}
 
 
@@ -64,10 +176,13 @@ namespace cst {
 		d_near = 0.1f;
 		d_far = 500.0f;
 
-		// calculate derived values
-		calculateFocalLength();
-		calculateProjectionMatrix();
-		calculateEyeCoordPlanes();
+		// default camera at the origin looking down the -z axis
+		cameraPos = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+		cameraOrientation = glm::mat4(1.0f);
+
+		// derived values are calculated on first use
+		projectionDirty = true;
+		worldPlanesDirty = true;
 	}
 
 
@@ -79,10 +194,13 @@ namespace cst {
 		d_near = nearInit;
 		d_far = farInit;
 
-		// calculate derived values
-		calculateFocalLength();
-		calculateProjectionMatrix();
-		calculateEyeCoordPlanes();
+		// default camera at the origin looking down the -z axis
+		cameraPos = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+		cameraOrientation = glm::mat4(1.0f);
+
+		// derived values are calculated on first use
+		projectionDirty = true;
+		worldPlanesDirty = true;
 	}
 
 
@@ -90,6 +208,8 @@ namespace cst {
 
 	const glm::mat4& ViewFrustum::projectionMatrix() const {
 
+		updateProjection();
+
 		return P;
 	}
 
@@ -105,10 +225,8 @@ namespace cst {
 
 		fovy = newFovy;
 
-		// calculate derived values
-		calculateFocalLength();
-		calculateProjectionMatrix();
-		calculateEyeCoordPlanes();
+		// derived values are recalculated on next use
+		invalidateProjection();
 	}
 
 
@@ -123,14 +241,15 @@ namespace cst {
 
 		aspect = newAspect;
 
-		// calculate derived values (focal length flength does not need recalculating here)
-		calculateProjectionMatrix();
-		calculateEyeCoordPlanes();
+		// derived values are recalculated on next use
+		invalidateProjection();
 	}
 
 
 	float ViewFrustum::focalLength() const {
 
+		updateProjection();
+
 		return flength;
 	}
 
@@ -146,9 +265,8 @@ namespace cst {
 
 		d_near = newDistance;
 
-		// calculate derived values (focal length flength does not need recalculating here)
-		calculateProjectionMatrix();
-		calculateEyeCoordPlanes();
+		// derived values are recalculated on next use
+		invalidateProjection();
 	}
 
 
@@ -163,9 +281,8 @@ namespace cst {
 
 		d_far = newDistance;
 
-		// calculate derived values (focal length flength does not need recalculating here)
-		calculateProjectionMatrix();
-		calculateEyeCoordPlanes();
+		// derived values are recalculated on next use
+		invalidateProjection();
 	}
 
 
@@ -179,6 +296,8 @@ namespace cst {
 	// return the frustum planes in eye coordinates via the specified pointers.  All provided pointers are assumed to be valid
 	void ViewFrustum::getEyeCoordPlanes(glm::vec4* eLeft_, glm::vec4* eRight_, glm::vec4* eTop_, glm::vec4* eBottom_, glm::vec4* eNear_, glm::vec4* eFar_) const {
 
+		updateProjection();
+
 		*eLeft_ = eLeft;
 		*eRight_ = eRight;
 		*eTop_ = eTop;
@@ -190,6 +309,8 @@ namespace cst {
 	// return the frustum planes in world coordinates via the specified pointers.  All provided pointers are assumed to be valid
 	void ViewFrustum::getWorldCoordPlanes(glm::vec4* wLeft_, glm::vec4* wRight_, glm::vec4* wTop_, glm::vec4* wBottom_, glm::vec4* wNear_, glm::vec4* wFar_) const {
 
+		updateWorldPlanes();
+
 		*wLeft_ = wLeft;
 		*wRight_ = wRight;
 		*wTop_ = wTop;
@@ -201,24 +322,28 @@ namespace cst {
 
 	// Frustum plane methods
 
-	// Given camera position C and orientation R in R3, calculate the view frustum planes in world coordinate space.  Given R is the orientation of the camera, R^-1 = R^T is used to rotate this to eye coordinate space.  Let T^-1 be translate(-C.x, -C.y, -C.z) be the translation from the camera world coordinate to eye coordinate space.  The view transform is therefore (R^T * T^-1).  The inverse of this is therefore T * R which maps from eye coordinate space to world coordinate space.  The inverse transpose of T * R is actually W = (R^-1 * T^-1)^T.  This inverse transpose is used to map the frustum plane normals from eye coordinate space to world coordinate space.  The frustum planes are normalised so |abc| = 1.0 for the plane coefficients <a, b, c, d>
+	// Given camera position C and orientation R in R3, calculate the view frustum planes in world coordinate space.  The pose is stored and the planes are recalculated on the next access (see updateWorldPlanes).  The frustum planes are normalised so |abc| = 1.0 for the plane coefficients <a, b, c, d>
 	void ViewFrustum::calculateWorldCoordPlanes(const glm::vec4& C, const glm::mat4& R) {
-		glm::mat4 W = glm::transpose(glm::transpose(R) *
-			glm::translate(glm::mat4(1.0f), glm::vec3(-C.x, -C.y, -C.z)));
-		//GUMatrix4 W = (R.transpose() * GUMatrix4::translationMatrix(-C.x, -C.y, -C.z)).transpose();
 
-		wLeft = W * eLeft;
-		wRight = W * eRight;
-		wBottom = W * eBottom;
-		wTop = W * eTop;
-		wNear = W * eNear;
-		wFar = W * eFar;
+		cameraPos = C;
+		cameraOrientation = R;
+
+		invalidateWorldPlanes();
+	}
+
+
+	// bring all derived values up to date
+	void ViewFrustum::updateDerivedValues() const {
+
+		updateWorldPlanes();
 	}
 
 
 	// return true if the given point P lies inside the frustum, false otherwise.  P is assumed to be in world coordinate space and it is assumed the world coordinate planes of the frustum have already been calculated with a previous call to CGViewFrustum::calculateWorldCoordPlanes.  If d_far = 0.0 (an infinite perspective projection is used) then the far plane is ignored in determining whether the point lies within the frustum
 	bool ViewFrustum::pointInFrustum(const glm::vec4& P) const {
 
+		updateWorldPlanes();
+
 		// test P against each plane in turn
 
 		if (glm::dot(wLeft, P) + wLeft.w < 0.0f)
@@ -246,4 +371,282 @@ namespace cst {
 		return true;
 	}
 
+
+	// return true if the sphere intersects or lies inside the frustum.  The sphere is outside if its centre lies further than radius behind any plane
+	bool ViewFrustum::sphereInFrustum(const glm::vec3& centre, float radius) const {
+
+		updateWorldPlanes();
+
+		for (int i = 0; i < numCullPlanes; i++) {
+
+			if (planeNX[i] * centre.x + planeNY[i] * centre.y + planeNZ[i] * centre.z + planeD[i] < -radius)
+				return false;
+		}
+
+		return true;
+	}
+
+
+	// return true if the axis-aligned box intersects or lies inside the frustum.  The box is outside if its vertex furthest along a plane normal (the 'p-vertex') lies behind that plane.  The distance of the p-vertex from the plane is the distance of the centre plus the extent projected onto |n|
+	bool ViewFrustum::aabbInFrustum(const glm::vec3& centre, const glm::vec3& extent) const {
+
+		updateWorldPlanes();
+
+		for (int i = 0; i < numCullPlanes; i++) {
+
+			float d = planeNX[i] * centre.x + planeNY[i] * centre.y + planeNZ[i] * centre.z + planeD[i];
+			float r = planeAbsNX[i] * extent.x + planeAbsNY[i] * extent.y + planeAbsNZ[i] * extent.z;
+
+			if (d + r < 0.0f)
+				return false;
+		}
+
+		return true;
+	}
+
+
+	// return a bit mask of the planes used for culling.  The far plane (bit 5) is only included for a finite frustum
+	unsigned int ViewFrustum::cullPlaneMask() const {
+
+		updateProjection();
+
+		return (1u << numCullPlanes) - 1;
+	}
+
+
+	// test the axis-aligned box against the planes in planeMask, clearing the bits of planes the box lies completely in front of.  For each plane the box's centre distance d and projected extent r = |n| . extent give the box's interval [d - r, d + r] along the plane normal
+	frustum_plane_intersect ViewFrustum::intersectAABB(const glm::vec3& centre, const glm::vec3& extent, unsigned int& planeMask) const {
+
+		updateWorldPlanes();
+
+		for (int i = 0; i < numCullPlanes; i++) {
+
+			unsigned int bit = 1u << i;
+
+			if (!(planeMask & bit))
+				continue;
+
+			float d = planeNX[i] * centre.x + planeNY[i] * centre.y + planeNZ[i] * centre.z + planeD[i];
+			float r = planeAbsNX[i] * extent.x + planeAbsNY[i] * extent.y + planeAbsNZ[i] * extent.z;
+
+			if (d + r < 0.0f)
+				return PL_BACK;
+
+			if (d - r >= 0.0f)
+				planeMask &= ~bit;
+		}
+
+		return (planeMask == 0) ? PL_FRONT : PL_INTERSECT;
+	}
+
+
+	// batch version of sphereInFrustum.  Each iteration loads a group of spheres and accumulates an 'outside' mask over the planes - there are no per-object branches
+	size_t ViewFrustum::cullSpheres(const float* centreX, const float* centreY, const float* centreZ, const float* radius, size_t count, uint32_t* visibilityMask) const {
+
+		size_t numVisible = 0;
+		size_t i = 0;
+
+		updateWorldPlanes();
+
+		memset(visibilityMask, 0, ((count + 31) / 32) * sizeof(uint32_t));
+
+#if defined(CST_FRUSTUM_AVX)
+
+		__m256 nx[6], ny[6], nz[6], d[6];
+
+		for (int p = 0; p < numCullPlanes; p++) {
+
+			nx[p] = _mm256_set1_ps(planeNX[p]);
+			ny[p] = _mm256_set1_ps(planeNY[p]);
+			nz[p] = _mm256_set1_ps(planeNZ[p]);
+			d[p] = _mm256_set1_ps(planeD[p]);
+		}
+
+		for (; i + 8 <= count; i += 8) {
+
+			__m256 cx = _mm256_loadu_ps(centreX + i);
+			__m256 cy = _mm256_loadu_ps(centreY + i);
+			__m256 cz = _mm256_loadu_ps(centreZ + i);
+			__m256 negR = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(radius + i));
+			__m256 outside = _mm256_setzero_ps();
+
+			for (int p = 0; p < numCullPlanes; p++) {
+
+				__m256 dist = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(cx, nx[p]), _mm256_mul_ps(cy, ny[p])), _mm256_add_ps(_mm256_mul_ps(cz, nz[p]), d[p]));
+
+				outside = _mm256_or_ps(outside, _mm256_cmp_ps(dist, negR, _CMP_LT_OQ));
+			}
+
+			uint32_t bits = ~uint32_t(_mm256_movemask_ps(outside)) & 0xFFu;
+
+			visibilityMask[i >> 5] |= bits << (i & 31);
+			numVisible += countBits(bits);
+		}
+
+#elif defined(CST_FRUSTUM_SSE2)
+
+		__m128 nx[6], ny[6], nz[6], d[6];
+
+		for (int p = 0; p < numCullPlanes; p++) {
+
+			nx[p] = _mm_set1_ps(planeNX[p]);
+			ny[p] = _mm_set1_ps(planeNY[p]);
+			nz[p] = _mm_set1_ps(planeNZ[p]);
+			d[p] = _mm_set1_ps(planeD[p]);
+		}
+
+		for (; i + 4 <= count; i += 4) {
+
+			__m128 cx = _mm_loadu_ps(centreX + i);
+			__m128 cy = _mm_loadu_ps(centreY + i);
+			__m128 cz = _mm_loadu_ps(centreZ + i);
+			__m128 negR = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(radius + i));
+			__m128 outside = _mm_setzero_ps();
+
+			for (int p = 0; p < numCullPlanes; p++) {
+
+				__m128 dist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(cx, nx[p]), _mm_mul_ps(cy, ny[p])), _mm_add_ps(_mm_mul_ps(cz, nz[p]), d[p]));
+
+				outside = _mm_or_ps(outside, _mm_cmplt_ps(dist, negR));
+			}
+
+			uint32_t bits = ~uint32_t(_mm_movemask_ps(outside)) & 0xFu;
+
+			visibilityMask[i >> 5] |= bits << (i & 31);
+			numVisible += countBits(bits);
+		}
+
+#endif
+
+		// remaining objects (or all objects if SIMD is not available)
+		for (; i < count; i++) {
+
+			if (sphereInFrustum(glm::vec3(centreX[i], centreY[i], centreZ[i]), radius[i])) {
+
+				visibilityMask[i >> 5] |= 1u << (i & 31);
+				numVisible++;
+			}
+		}
+
+		return numVisible;
+	}
+
+
+	// batch version of aabbInFrustum
+	size_t ViewFrustum::cullAABBs(const float* centreX, const float* centreY, const float* centreZ, const float* extentX, const float* extentY, const float* extentZ, size_t count, uint32_t* visibilityMask) const {
+
+		size_t numVisible = 0;
+		size_t i = 0;
+
+		updateWorldPlanes();
+
+		memset(visibilityMask, 0, ((count + 31) / 32) * sizeof(uint32_t));
+
+#if defined(CST_FRUSTUM_AVX)
+
+		__m256 nx[6], ny[6], nz[6], d[6], ax[6], ay[6], az[6];
+
+		for (int p = 0; p < numCullPlanes; p++) {
+
+			nx[p] = _mm256_set1_ps(planeNX[p]);
+			ny[p] = _mm256_set1_ps(planeNY[p]);
+			nz[p] = _mm256_set1_ps(planeNZ[p]);
+			d[p] = _mm256_set1_ps(planeD[p]);
+			ax[p] = _mm256_set1_ps(planeAbsNX[p]);
+			ay[p] = _mm256_set1_ps(planeAbsNY[p]);
+			az[p] = _mm256_set1_ps(planeAbsNZ[p]);
+		}
+
+		for (; i + 8 <= count; i += 8) {
+
+			__m256 cx = _mm256_loadu_ps(centreX + i);
+			__m256 cy = _mm256_loadu_ps(centreY + i);
+			__m256 cz = _mm256_loadu_ps(centreZ + i);
+			__m256 ex = _mm256_loadu_ps(extentX + i);
+			__m256 ey = _mm256_loadu_ps(extentY + i);
+			__m256 ez = _mm256_loadu_ps(extentZ + i);
+			__m256 outside = _mm256_setzero_ps();
+
+			for (int p = 0; p < numCullPlanes; p++) {
+
+				__m256 dist = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(cx, nx[p]), _mm256_mul_ps(cy, ny[p])), _mm256_add_ps(_mm256_mul_ps(cz, nz[p]), d[p]));
+				__m256 r = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ex, ax[p]), _mm256_mul_ps(ey, ay[p])), _mm256_mul_ps(ez, az[p]));
+
+				outside = _mm256_or_ps(outside, _mm256_cmp_ps(_mm256_add_ps(dist, r), _mm256_setzero_ps(), _CMP_LT_OQ));
+			}
+
+			uint32_t bits = ~uint32_t(_mm256_movemask_ps(outside)) & 0xFFu;
+
+			visibilityMask[i >> 5] |= bits << (i & 31);
+			numVisible += countBits(bits);
+		}
+
+#elif defined(CST_FRUSTUM_SSE2)
+
+		__m128 nx[6], ny[6], nz[6], d[6], ax[6], ay[6], az[6];
+
+		for (int p = 0; p < numCullPlanes; p++) {
+
+			nx[p] = _mm_set1_ps(planeNX[p]);
+			ny[p] = _mm_set1_ps(planeNY[p]);
+			nz[p] = _mm_set1_ps(planeNZ[p]);
+			d[p] = _mm_set1_ps(planeD[p]);
+			ax[p] = _mm_set1_ps(planeAbsNX[p]);
+			ay[p] = _mm_set1_ps(planeAbsNY[p]);
+			az[p] = _mm_set1_ps(planeAbsNZ[p]);
+		}
+
+		for (; i + 4 <= count; i += 4) {
+
+			__m128 cx = _mm_loadu_ps(centreX + i);
+			__m128 cy = _mm_loadu_ps(centreY + i);
+			__m128 cz = _mm_loadu_ps(centreZ + i);
+			__m128 ex = _mm_loadu_ps(extentX + i);
+			__m128 ey = _mm_loadu_ps(extentY + i);
+			__m128 ez = _mm_loadu_ps(extentZ + i);
+			__m128 outside = _mm_setzero_ps();
+
+			for (int p = 0; p < numCullPlanes; p++) {
+
+				__m128 dist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(cx, nx[p]), _mm_mul_ps(cy, ny[p])), _mm_add_ps(_mm_mul_ps(cz, nz[p]), d[p]));
+				__m128 r = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ex, ax[p]), _mm_mul_ps(ey, ay[p])), _mm_mul_ps(ez, az[p]));
+
+				outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(dist, r), _mm_setzero_ps()));
+			}
+
+			uint32_t bits = ~uint32_t(_mm_movemask_ps(outside)) & 0xFu;
+
+			visibilityMask[i >> 5] |= bits << (i & 31);
+			numVisible += countBits(bits);
+		}
+
+#endif
+
+		// remaining objects (or all objects if SIMD is not available)
+		for (; i < count; i++) {
+
+			if (aabbInFrustum(glm::vec3(centreX[i], centreY[i], centreZ[i]), glm::vec3(extentX[i], extentY[i], extentZ[i]))) {
+
+				visibilityMask[i >> 5] |= 1u << (i & 31);
+				numVisible++;
+			}
+		}
+
+		return numVisible;
+	}
+
+
+	// Derived value statistics across all frustums
+
+	unsigned long long ViewFrustum::getRecomputeCount() {
+
+		return recomputeCount;
+	}
+
+
+	unsigned long long ViewFrustum::getRecomputesAvoided() {
+
+		return recomputesAvoided;
+	}
+
 }
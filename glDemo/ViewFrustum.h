@@ -2,8 +2,9 @@
 #pragma once
 
 #include "core.h"
+#include <atomic>
 
-// Model a (symmetric) view frustum in R3.  The frustum model assumes a right-hand coordinate system (OpenGL).  Value semantics apply.
+// Model a (symmetric) view frustum in R3.  The frustum model assumes a right-hand coordinate system (OpenGL).  Value semantics apply.  Derived values (focal length, projection matrix and frustum planes) are evaluated lazily - setters mark them stale and they are recalculated once on the next access.  Since const accessors may update the derived values a frustum shared between threads should be read once (for example with updateDerivedValues) before it is shared
 
 namespace cst {
 
@@ -17,32 +18,59 @@ namespace cst {
 		// define parameters for the view frustum (projection coefficients)
 		float			fovy; // vertical field-of-view specified in degrees - specifies entire field of view, not the half-field of the view
 		float			aspect; // aspect ratio (w/h)
-		float			flength; // focal length derived from the vertical field-of-view (fovy)
+		mutable float	flength; // focal length derived from the vertical field-of-view (fovy)
 		float			d_near; // distance to the near plane
 		float			d_far; // distance to the far plane
 
 		// frustum planes in eye coordinate space.  These only change when the projection coefficients change
-		glm::vec4		eLeft, eRight, eTop, eBottom, eNear, eFar;
+		mutable glm::vec4	eLeft, eRight, eTop, eBottom, eNear, eFar;
 
 		// projection matrix based on the above projection coefficients
-		glm::mat4		P;
+		mutable glm::mat4	P;
+
+		// camera position and orientation the world coordinate planes are derived from (set by calculateWorldCoordPlanes)
+		glm::vec4		cameraPos;
+		glm::mat4		cameraOrientation;
+
+		// dirty flags for the derived values.  projectionDirty covers flength, P and the eye coordinate planes
+		mutable bool	projectionDirty;
+		mutable bool	worldPlanesDirty;
+
+		// derived value statistics across all frustums - recomputeCount counts actual recalculations, recomputesAvoided counts invalidations of values that were already stale (each of which would have been a full recalculation if derived values were updated eagerly)
+		static std::atomic<unsigned long long>	recomputeCount;
+		static std::atomic<unsigned long long>	recomputesAvoided;
 
 
 		// Auxiliary values
 
 		// view frustum planes in world coordinates
-		glm::vec4		wLeft, wRight, wTop, wBottom, wNear, wFar;
+		mutable glm::vec4	wLeft, wRight, wTop, wBottom, wNear, wFar;
+
+		// world coordinate planes in SoA form for batch culling, ordered left, right, bottom, top, near, far.  planeAbsN* store |a|, |b| and |c| for AABB tests
+		mutable float	planeNX[6], planeNY[6], planeNZ[6], planeD[6];
+		mutable float	planeAbsNX[6], planeAbsNY[6], planeAbsNZ[6];
+		mutable int		numCullPlanes; // 5 for an infinite perspective projection (far plane ignored), 6 otherwise
 
 
 		//
 		// Private API
 		//
 
-		void calculateFocalLength(); // given the current projection coefficients, calculate the derived quantity flength (focal length)
+		void invalidateProjection(); // mark the projection derived values (and therefore the world coordinate planes) as stale
+
+		void invalidateWorldPlanes(); // mark the world coordinate planes as stale
+
+		void updateProjection() const; // recalculate flength, P and the eye coordinate planes if stale
 
-		void calculateProjectionMatrix(); // calculate the projection matrix for the current projection coefficients.  The matrix is stored in column major format.  An infinite perspective projection matrix is setup if d_far = 0.0 as determined by equalf
+		void updateWorldPlanes() const; // recalculate the world coordinate planes if stale
 
-		void calculateEyeCoordPlanes(); // calculate the frustum planes in eye coordinate space based on the current projection coefficients.  For a frustum representing an infinite perspective projection the far plane coefficients represent a 'placeholder' plane offset 1.0 from the near plane.  This should not be used for view frustum intersection testing and is only setup for testing / frustum visualisation purposes
+		void calculateFocalLength() const; // given the current projection coefficients, calculate the derived quantity flength (focal length)
+
+		void calculateProjectionMatrix() const; // calculate the projection matrix for the current projection coefficients.  The matrix is stored in column major format.  An infinite perspective projection matrix is setup if d_far = 0.0 as determined by equalf
+
+		void updateCullPlanes() const; // copy the world coordinate planes into SoA form for batch culling
+
+		void calculateEyeCoordPlanes() const; // calculate the frustum planes in eye coordinate space based on the current projection coefficients.  For a frustum representing an infinite perspective projection the far plane coefficients represent a 'placeholder' plane offset 1.0 from the near plane.  This should not be used for view frustum intersection testing and is only setup for testing / frustum visualisation purposes
 
 		//frustum_plane_intersect intersectPlaneAABB(const GUVector4 &plane, const CGAABB &B) const; // Test AABB 'B' against a specific plane within the frustum.  Return PL_INTERSECT if the AABB lies across the plane, PL_FRONT if it lies completely in front of the plane (that is, on the side the plane normal is pointing) and PL_BACK if it lies completely behind the plane
 
@@ -81,10 +109,34 @@ namespace cst {
 
 		// Frustum plane methods
 
-		void calculateWorldCoordPlanes(const glm::vec4& vcamPos, const glm::mat4& R); // Given camera position C and orientation R in R3, calculate the view frustum planes in world coordinate space.  The frustum planes are normalised so |abc| = 1.0 for the plane coefficients <a, b, c, d>
+		void calculateWorldCoordPlanes(const glm::vec4& vcamPos, const glm::mat4& R); // Given camera position C and orientation R in R3, calculate the view frustum planes in world coordinate space.  The frustum planes are normalised so |abc| = 1.0 for the plane coefficients <a, b, c, d>.  The planes are recalculated on the next access rather than immediately
+
+		void updateDerivedValues() const; // bring all derived values up to date
 
 		bool pointInFrustum(const glm::vec4& P) const; // return true if the given point P lies inside the frustum, false otherwise.  P is assumed to be in world coordinate space and it is assumed the world coordinate planes of the frustum have already been calculated with a previous call to CGViewFrustum::calculateWorldCoordPlanes.  If d_far = 0.0 (an infinite perspective projection is used) then the far plane is ignored in determining whether the point lies within the frustum
 
+		bool sphereInFrustum(const glm::vec3& centre, float radius) const; // return true if the sphere intersects or lies inside the frustum.  As with pointInFrustum the world coordinate planes are assumed to be calculated and the far plane is ignored for an infinite perspective projection
+
+		bool aabbInFrustum(const glm::vec3& centre, const glm::vec3& extent) const; // return true if the axis-aligned box with the given centre and half-extents intersects or lies inside the frustum.  The test is conservative - a box lying outside the frustum near a corner may be reported as visible
+
+		unsigned int cullPlaneMask() const; // return a bit mask of the planes used for culling.  Bits 0 - 4 represent the left, right, bottom, top and near planes.  Bit 5 represents the far plane and is only set for a finite frustum
+
+		frustum_plane_intersect intersectAABB(const glm::vec3& centre, const glm::vec3& extent, unsigned int& planeMask) const; // Test the axis-aligned box with the given centre and half-extents against the planes whose bits are set in planeMask.  Return PL_BACK if the box lies completely behind any tested plane (outside the frustum).  Otherwise clear the bits of the planes the box lies completely in front of and return PL_FRONT if no bits remain (the box lies inside the frustum) or PL_INTERSECT if it crosses a remaining plane.  Boxes contained in this box (for example child nodes in a bounding volume hierarchy) do not need to be tested against the cleared planes
+
+
+		// Batch culling methods.  Objects are passed in SoA form and bit (i % 32) of visibilityMask[i / 32] is set if object i is visible, cleared otherwise.  visibilityMask must hold (count + 31) / 32 words.  8 objects are tested per iteration when compiled with AVX, 4 with SSE2, otherwise the scalar tests above are used.  Return the number of visible objects
+
+		size_t cullSpheres(const float* centreX, const float* centreY, const float* centreZ, const float* radius, size_t count, uint32_t* visibilityMask) const; // batch version of sphereInFrustum
+
+		size_t cullAABBs(const float* centreX, const float* centreY, const float* centreZ, const float* extentX, const float* extentY, const float* extentZ, size_t count, uint32_t* visibilityMask) const; // batch version of aabbInFrustum
+
+
+		// Derived value statistics across all frustums
+
+		static unsigned long long getRecomputeCount(); // number of times derived values were recalculated
+
+		static unsigned long long getRecomputesAvoided(); // number of recalculations avoided by lazy evaluation
+
 	};
 
 }
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "core.h"
+#include "ArcballCamera.h"
+#include "RedrawScheduler.h"
+#include "GPUProfiler.h"
+
+// Viewer state and scene entry points defined in main.cpp that the batch modes (BatchModes.h) drive without the window, input thread and render thread.  Everything else about the scene stays private to main.cpp.  The scene functions make GL calls so they must be called on the thread with the viewer's context current
+
+static const GLuint			NUM_ROADS = 5;
+
+// Display name and short name (used in capture filenames) of each road filtering mode
+extern const char* const	filterStrings[NUM_ROADS];
+extern const char* const	filterTags[NUM_ROADS];
+
+extern cst::ArcballCamera*	mainCamera;
+extern int					currentRoad; // road filtering mode rendered
+extern RedrawScheduler*		redrawScheduler;
+extern GPUProfiler*			gpuProfiler;
+extern bool					showOverlay; // text overlay
+
+// Create the scene for a viewport of width x height pixels
+void setupScene(int width, int height);
+
+// Publish the camera state (simulation side) and acquire the latest published state (render side)
+void publishCameraSnapshot();
+void acquireCameraSnapshot();
+
+// Render the scene from the acquired camera state into the bound framebuffer
+void renderScene();
+
+// Scene and filtering mode the current frame is profiled under
+std::string profileTag();
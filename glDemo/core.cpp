@@ -1 +1,15 @@
-#include "core.h"
\ No newline at end of file
+#include "core.h"
+
+
+std::string nativePath(const std::string& path) {
+
+#ifdef _WIN32
+	return path;
+#else
+	std::string converted = path;
+
+	std::replace(converted.begin(), converted.end(), '\\', '/');
+
+	return converted;
+#endif
+}
@@ -1,27 +1,41 @@
 #pragma once
 
 // These libraries are needed to link the program (Visual Studio specific)
+#ifdef _MSC_VER
 #pragma comment(lib,"opengl32.lib")
 #pragma comment(lib,"glu32.lib")
 #pragma comment(lib,"lib\\glfw3.lib")
 #pragma comment(lib,"lib\\glew32s.lib")
 #pragma comment(lib,"lib\\glew32.lib")
 #pragma comment(lib,"lib\\FreeImage.lib")
+#endif
 
 #define GLEW_STATIC
 #include "GL/glew.h" 
 #include "GLFW/glfw3.h"
 
+#ifdef _WIN32
 #include <Windows.h>
+#endif
+
 #include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
 #include <assert.h>
 #include <math.h>
+#include <algorithm>
+#include <limits>
 #include <iostream>
 #include <fstream>
 #include <string>
 #include <random>
 #include <vector>
-#include "glm\mat4x4.hpp"
-#include "glm\ext.hpp"
-#include "FreeImage\\FreeImage.h"
+#include "glm/mat4x4.hpp"
+#include "glm/ext.hpp"
+#include "FreeImage/FreeImage.h"
+
+// Convert a path written with Windows separators ("Assets\\Textures\\road.bmp") to the separators of the host platform
+std::string nativePath(const std::string& path);
 
+// Route the GL 1.1 entry points through pointers the GL call trace can hook
+#include "GLCallTrace.h"
@@ -5,31 +5,204 @@
 #include "PrincipleAxesModel.h"
 #include "TexturedQuadModel.h"
 #include "GUFont.h"
+#include "MultiDrawBatch.h"
+#include "RedrawScheduler.h"
+#include "SPSCQueue.h"
+#include "TripleBuffer.h"
+#include "JobSystem.h"
+#include "CullingBenchmark.h"
+#include "SceneBVH.h"
+#include "SceneGraph.h"
+#include "StreamingRoad.h"
+#include "SamplerFeedback.h"
+#include "GPUProfiler.h"
+#include "CPUProfiler.h"
+#include "GLDebugOutput.h"
+#include "GLCallTrace.h"
+#include "InputLog.h"
+#include "FlythroughBenchmark.h"
+#include "MicroBenchmark.h"
+#include "OffscreenTarget.h"
+#include "FrameCapture.h"
+#include "QualityController.h"
+#include "FootprintAnalysis.h"
+#include "TextureAtlas.h"
+#include "Viewer.h"
+#include "BatchModes.h"
+#include "CommandLine.h"
+#include <thread>
+#include <chrono>
 
 using namespace std;
 using namespace cst;
 
 #pragma region Global variables
 
-// Camera model and tracking
+// Camera model and tracking (owned by the input / simulation thread)
 ArcballCamera*		mainCamera = nullptr;
 bool				mouseDown = false;
 double				prevMouseX, prevMouseY;
 
+// Input accumulated by the event handlers and applied once per simulation step, so a burst of mouse events results in a single camera update
+float				pendingRotateTheta = 0.0f, pendingRotatePhi = 0.0f;
+float				pendingZoom = 1.0f;
+float				pendingAspect = 0.0f;
+float				pendingViewDistanceScale = 1.0f;
+
+// Streaming road view distance (the camera far plane follows it)
+static const float	MIN_VIEW_DISTANCE = 128.0f;
+static const float	MAX_VIEW_DISTANCE = 16384.0f;
+float				viewDistance = 1000.0f;
+
+// Camera state published by the simulation thread to the render thread
+struct CameraSnapshot {
+
+	glm::mat4		viewTransform;
+	glm::mat4		projectionTransform;
+	ViewFrustum		frustum;
+	glm::vec4		position;
+};
+
+TripleBuffer<CameraSnapshot> cameraSnapshots;
+
+// Scene updates sent from the input thread to the render thread
+enum RenderCommandType { RENDER_SET_FILTER = 0, RENDER_NEXT_SCENE_MODE, RENDER_RESIZE, RENDER_SET_VIEW_DISTANCE, RENDER_TOGGLE_FEEDBACK, RENDER_TOGGLE_PROFILER, RENDER_EXPORT_PROFILE, RENDER_TOGGLE_GL_TRACE, RENDER_EXPORT_GL_TRACE, RENDER_TOGGLE_CAPTURE, RENDER_TOGGLE_QUALITY, RENDER_NEXT_FOOTPRINT_MODE };
+
+struct RenderCommand {
+
+	RenderCommandType	type;
+	int					param[2];
+};
+
+SPSCQueue<RenderCommand, 256> renderCommands;
+std::atomic<bool>	renderThreadRunning;
+
 // Demo object for camera testing (setup for now but not rendered as part of main demo)
 PrincipleAxesModel*	principleAxes = nullptr;
 
-// Road textures
-static const GLuint	NUM_ROADS = 5;
+// Road textures (this and the remaining scene state is owned by the render thread once it has started)
 TexturedQuadModel*	road[NUM_ROADS];
 int					currentRoad;
 
+const char* const	filterStrings[NUM_ROADS] = {
+	"Point filtering",
+	"Bi-linear filtering",
+	"Tri-linear filtering",
+	"Anisotropic filtering 2x",
+	"Anisotropic filtering 8x" };
+
+// Short filter names used in capture filenames
+const char* const	filterTags[NUM_ROADS] = { "point", "bilinear", "trilinear", "aniso2x", "aniso8x" };
+
+// Sampler feedback for the road textures - when enabled the road modes record the mip levels the view needs and clamp each texture's resident levels to them
+SamplerFeedback*	samplerFeedback = nullptr;
+GLuint				roadFeedbackSlot[NUM_ROADS];
+bool				feedbackEnabled = false;
+
+// Endless road generated in chunks ahead of the viewer.  When animated the viewer travels along the road at STREAMING_ROAD_SPEED units per second
+static const float	STREAMING_ROAD_SPEED = 60.0f;
+StreamingRoad*		streamingRoad = nullptr;
+
+// Scene transform hierarchy - the road and synthetic scene objects are nodes in the scene graph
+SceneGraph*			sceneGraph = nullptr;
+GLuint				roadNode;
+
+// Synthetic stress scene used to compare multi-draw-indirect submission against per-object draw calls
+enum SceneMode { SCENE_ROAD = 0, SCENE_STREAMING_ROAD, SCENE_MULTIDRAW, SCENE_PER_OBJECT, NUM_SCENE_MODES };
+
+static const char*	sceneModeStrings[NUM_SCENE_MODES] = { "Road", "Streaming road", "Multi-draw", "Per-object" };
+
+// The synthetic scene is a set of clusters, each a scene graph node with objects as children.  When animated each cluster spins around its own y axis
+static const GLuint	NUM_SYNTHETIC_OBJECTS = 50000;
+static const GLuint	NUM_SYNTHETIC_CLUSTERS = 256;
+MultiDrawBatch*		multiDrawBatch = nullptr;
+GLuint				batchQuadMesh, batchAxesMesh;
+vector<GLuint>		syntheticClusters; // scene graph handles
+vector<GLuint>		syntheticObjects; // scene graph handles - object i is object i in the BVH
+SceneBVH*			syntheticSceneBVH = nullptr; // culls the synthetic scene in both modes
+vector<glm::vec3>	syntheticBoundsMin, syntheticBoundsMax;
+vector<GLuint>		visibleObjects, visibleNodes;
+TexturedQuadModel*	syntheticQuads[2] = { nullptr, nullptr }; // per-object quads with the road and ship images of the texture array layers
+GLint				syntheticQuadLayers[2];
+GLuint				perObjectDrawCalls = 0; // draw calls issued by the last per-object frame
+int					sceneMode;
+std::atomic<bool>	animateScene; // toggled by the input thread, read by the render thread
+
+// GPU profiler - frames are tagged with the scene and filtering mode so the cost of each mode can be compared
+GPUProfiler*		gpuProfiler = nullptr;
+bool				showProfiler = false;
+
+// Redraw scheduler - frames are only rendered when the view changes unless continuous mode is enabled
+RedrawScheduler*	redrawScheduler = nullptr;
+
+// Input recording / replay.  During a replay the render thread renders one frame per simulation step and the time of each step and frame is kept for the timing report
+static const double	REPLAY_ANIMATION_STEP = 1.0 / 60.0; // seconds of animation per replayed step
+InputLog*			inputLog = nullptr;
+vector<float>		replayStepTimes; // milliseconds (main thread)
+vector<float>		lockedFrameTimes; // milliseconds (render thread) of each frame-locked frame
+
+bool				showOverlay = true; // text overlay (disabled for headless rendering)
+
+// Frame time averaged over the last second
+double				frameTimeAccum = 0.0;
+int					frameTimeCount = 0;
+float				avgFrameTimeMs = 0.0f;
+
 // Window size
 const unsigned int	initWidth = 1024;
 const unsigned int	initHeight = 768;
 
+// Frame capture - created and destroyed on the render thread (V toggles it).  The render thread keeps its own copy of the framebuffer size for the reads
+FrameCapture*		frameCapture = nullptr;
+bool				captureFromStartup = false;
+string				captureFilenamePrefix;
+CaptureOutput		captureOutput = CAPTURE_PNG;
+int					renderWidth = initWidth, renderHeight = initHeight;
+
+// Dynamic quality scaling - when enabled (Q, or "-quality ms" from startup) the controller moves between these steps to hold the GPU frame time within budget.  The steps use the mipmapped road textures - point and bilinear have no mip chain so LOD bias has no effect and minified sampling without mips is not cheaper.  Keys 1-5 select a filtering mode directly and turn the controller off
+static const GLuint	NUM_QUALITY_STEPS = 6;
+static const GLuint	NO_QUALITY_STEP = 0xFFFFFFFF;
+
+static const QualityStep	qualityLadder[NUM_QUALITY_STEPS] = {
+
+	{ "Tri-linear, LOD bias +1, 50% scale", 2, 1.0f, 0.5f },
+	{ "Tri-linear, LOD bias +0.5, 75% scale", 2, 0.5f, 0.75f },
+	{ "Tri-linear, LOD bias +0.5", 2, 0.5f, 1.0f },
+	{ "Tri-linear", 2, 0.0f, 1.0f },
+	{ "Anisotropic 2x", 3, 0.0f, 1.0f },
+	{ "Anisotropic 8x", 4, 0.0f, 1.0f } };
+
+QualitySettings		qualitySettings;
+bool				adaptiveQualityFromStartup = false;
+string				qualityLogFilename; // decisions written when the controller stops
+string				qualityTraceFilename; // GPU frame times written when the controller stops (input for -qualityreplay)
+
+// Controller state (render thread)
+QualityController*	qualityController = nullptr;
+GPUFrameTimer*		qualityTimer = nullptr;
+vector<QualityTraceFrame>	qualityTrace;
+GLuint				appliedQualityStep = NO_QUALITY_STEP;
+float				lastQualityFrameTime = 0.0f;
+OffscreenTarget*	scaledTarget = nullptr; // render target for steps below window resolution
+
+// Footprint analysis of the road quad under the current camera (road scene).  H cycles off / analyse / analyse and apply - when applied the current anisotropic road texture uses the lowest anisotropy level covering footprintPercentile of the road's pixels instead of its fixed level
+enum FootprintMode { FOOTPRINT_OFF = 0, FOOTPRINT_ANALYSE, FOOTPRINT_APPLY, NUM_FOOTPRINT_MODES };
+
+static const GLuint	FOOTPRINT_STRIDE = 4; // pixels between samples
+FootprintMode		footprintMode = FOOTPRINT_OFF;
+float				footprintPercentile;
+FootprintHistogram	footprintHistogram;
+GLfloat				footprintRecommendation = 1.0f;
+double				footprintTime = 0.0; // ms
+bool				printFootprint = false; // write the next histogram to cout
+glm::vec2			roadTextureSize;
+GLfloat				roadAnisotropy[NUM_ROADS]; // level each road texture was loaded with
+GLfloat				maxSupportedAnisotropy = 1.0f;
+GLint				footprintAppliedRoad = -1; // road texture whose level has been replaced
+GLfloat				footprintAppliedLevel = 0.0f;
+
 // Variables to store text rendering properties and font
-GUFont*				font;
+GUFont*				font = nullptr;
 glm::mat4			fontViewMatrix;
 glm::vec4			fontColour;
 
@@ -38,25 +211,108 @@ glm::vec4			fontColour;
 
 #pragma region Function prototypes
 
-void renderScene();
+void renderThreadMain(GLFWwindow* window);
+void processRenderCommands();
+void renderFeedbackStatus(float y);
+void renderProfilerStatus(float y);
+void renderGLTraceStatus(float y);
+void renderCaptureStatus(float y);
+void renderQualityStatus(float y);
+void renderFootprintStatus(float y);
+void analyseRoadFootprint(const glm::mat4& roadMVP);
+void setRoadAnisotropy(GLuint roadIndex, GLfloat level);
+void restoreRoadAnisotropy();
+void startAdaptiveQuality();
+void stopAdaptiveQuality();
+void applyQualityStep();
+void updateAdaptiveQuality();
 void updateScene();
+void sendRenderCommand(const RenderCommand& command);
+void setupSyntheticScene();
+void updateSyntheticBounds();
+void animateSyntheticScene(float dt);
+void renderSyntheticScene(const glm::mat4& T, const ViewFrustum& frustum);
 void mouseMoveHandler(GLFWwindow* window, double xpos, double ypos);
 void mouseButtonHandler(GLFWwindow* window, int button, int action, int mods);
 void mouseScrollHandler(GLFWwindow* window, double xoffset, double yoffset);
 void mouseEnterHandler(GLFWwindow* window, int entered);
 void resizeWindow(GLFWwindow* window, int width, int height);
 void keyboardHandler(GLFWwindow* window, int key, int scancode, int action, int mods);
+void handleInput(GLFWwindow* window, const InputEvent& event);
+void applyInput(GLFWwindow* window, const InputEvent& event);
+void applyKeyPress(GLFWwindow* window, int key);
 
 #pragma endregion
 
 
-int main() {
+int main(int argc, char* argv[]) {
 
 	//
 	// 1. Initialisation
 	//
 	
 
+	CPU_PROFILE_THREAD("Main");
+
+	// Parse command line (printUsage in CommandLine.cpp lists the options).  Benchmarks, self tests and batch modes run without opening a window then exit
+	CommandLineOptions options;
+
+	if (!parseCommandLine(argc, argv, options))
+		return 1;
+
+	if (options.cpuMipmaps)
+		setMipmapGenMode(CG_CPU_MIPMAP_GEN);
+
+	switch (options.command) {
+
+		case COMMAND_HELP:
+			printUsage(cout);
+			return 0;
+
+		case COMMAND_FLYTHROUGH_BENCHMARK:
+			return runFlythroughBenchmark(options.flythrough, initWidth, initHeight) ? 0 : 1;
+
+		case COMMAND_HEADLESS_CAPTURE:
+			return runHeadlessCapture(options.headless) ? 0 : 1;
+
+		case COMMAND_QUALITY_REPLAY:
+			return replayQualityTrace(options.qualityReplayFilename, options.qualityLogFilename, vector<QualityStep>(qualityLadder, qualityLadder + NUM_QUALITY_STEPS), options.quality) ? 0 : 1;
+
+		case COMMAND_MICROBENCHMARKS:
+			return runMicroBenchmarks(options.microBenchmarks) ? 0 : 1;
+
+		case COMMAND_CULLING_BENCHMARK:
+			return runCullingBenchmark(options.benchmarkObjects) ? 0 : 1;
+
+		case COMMAND_BVH_BENCHMARK:
+			return runBVHBenchmark(options.benchmarkObjects) ? 0 : 1;
+
+		case COMMAND_FEEDBACK_TEST:
+			return runMipFeedbackSelfTest() ? 0 : 1;
+
+		case COMMAND_FOOTPRINT_TEST:
+			return runFootprintSelfTest() ? 0 : 1;
+
+		case COMMAND_ATLAS_TEST:
+			return runTextureAtlasSelfTest() ? 0 : 1;
+
+		default:
+			break;
+	}
+
+	// Viewer settings read by the render thread
+	captureFromStartup = options.captureFromStartup;
+	captureFilenamePrefix = options.captureFilenamePrefix;
+	captureOutput = options.captureOutput;
+	adaptiveQualityFromStartup = options.adaptiveQuality;
+	qualitySettings = options.quality;
+	qualityLogFilename = options.qualityLogFilename;
+	qualityTraceFilename = options.qualityTraceFilename;
+	footprintPercentile = options.footprintPercentile;
+
+	redrawScheduler = new RedrawScheduler(options.continuousRedraw);
+
+
 	// Initialise glfw and setup window
 	glfwInit();
 
@@ -78,6 +334,27 @@ int main() {
 	glfwMakeContextCurrent(window);
 	
 
+	// Start recording or replaying input.  A replay renders one frame per recorded step so the scheduler is frame-locked
+	inputLog = new InputLog();
+
+	if (!options.replayFilename.empty()) {
+
+		if (!inputLog->startReplay(options.replayFilename)) {
+
+			glfwTerminate();
+			return 1;
+		}
+
+		redrawScheduler->setFrameLocked(true);
+		replayStepTimes.reserve(inputLog->getReplayLength());
+		lockedFrameTimes.reserve(inputLog->getReplayLength());
+	}
+	else if (!options.recordFilename.empty()) {
+
+		inputLog->startRecording(options.recordFilename);
+	}
+
+
 	// Set callback functions to handle different events
 	glfwSetFramebufferSizeCallback(window, resizeWindow); // resize window callback
 	glfwSetKeyCallback(window, keyboardHandler); // Keyboard input callback
@@ -88,9 +365,15 @@ int main() {
 
 	// Initialise glew
 	glewInit();
+
+	// Aggregate driver debug output (errors and slow path warnings) for the session
+	GLDebugOutput::install();
+
+	if (!options.glTraceFilename.empty())
+		GLCallTrace::install();
 	
 	// Setup window's initial size
-	resizeWindow(window, initWidth, initHeight);
+	glViewport(0, 0, initWidth, initHeight);
 
 	//
 	// Report OpenGL properties for created context
@@ -124,203 +407,1319 @@ int main() {
 
 
 	// Initialise scene - geometry and shaders etc
-	glClearColor(0.0f, 0.0f, 0.0f, 0.0f); // setup background colour to be black
+	setupScene(initWidth, initHeight);
 
 
-	// Setup font
-	font = new GUFont(wstring(L"Courier New"), 18);
-	fontViewMatrix = glm::ortho(-4.0f, 4.0f, -4.0f, 4.0f, -1.0f, 1.0f);
-	fontColour = glm::vec4(1.0f, 1.0f, 0.0f, 1.0f);
+	//
+	// 2. Main loop
+	// 
+	
 
-	// Setup main camera and test axis object
-	float viewportAspect = (float)initWidth / (float)initHeight;
-	mainCamera = new ArcballCamera(0.0f, 0.0f, 5.0f, 55.0f, viewportAspect, 0.1f, 1000.0f);
+	// Publish the initial camera state then hand the GL context over to the render thread.  All further GL calls are made on the render thread
+	publishCameraSnapshot();
 
-	principleAxes = new PrincipleAxesModel();
+	glfwMakeContextCurrent(NULL);
 
+	renderThreadRunning = true;
+	thread renderThread(renderThreadMain, window);
 
-	//
-	// Load example road texture with different filtering properites
-	//
+	// The main thread handles input and simulation.  GLFW requires events to be processed on the main thread.  Block waiting for events so an idle viewer costs nothing - the timeout keeps the simulation stepping for animation
+	while (!glfwWindowShouldClose(window)) {
 
-	// Point filtering
-	road[0] = new TexturedQuadModel(string("Assets\\Textures\\road.bmp"), FIF_BMP, TextureProperties(GL_COMPRESSED_SRGB, GL_NEAREST, GL_NEAREST, 1.0f, GL_REPEAT, GL_REPEAT, false, true));
+		if (inputLog->isReplaying()) {
 
-	// Bilinear filtering
-	road[1] = new TexturedQuadModel(string("Assets\\Textures\\road.bmp"), FIF_BMP, TextureProperties(GL_SRGB8_ALPHA8, GL_LINEAR, GL_LINEAR, 1.0f, GL_REPEAT, GL_REPEAT, false, true));
+			// Apply the events recorded in this step then wait for the step's frame.  Events are still polled so the window stays responsive (live input is ignored)
+			glfwPollEvents();
 
-	// Tri-linear filtering
-	road[2] = new TexturedQuadModel(string("Assets\\Textures\\road.bmp"), FIF_BMP, TextureProperties(GL_SRGB8_ALPHA8, GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR, 1.0f, GL_REPEAT, GL_REPEAT, true, true));
+			double stepStartTime = glfwGetTime();
+			InputEvent event;
 
-	// Anisotropic x2
-	road[3] = new TexturedQuadModel(string("Assets\\Textures\\road.bmp"), FIF_BMP, TextureProperties(GL_SRGB8_ALPHA8, GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR, 2.0f, GL_REPEAT, GL_REPEAT, true, true));
+			while (inputLog->nextEvent(event))
+				applyInput(window, event);
 
-	// Anisotropic x8
-	road[4] = new TexturedQuadModel(string("Assets\\Textures\\road.bmp"), FIF_BMP, TextureProperties(GL_SRGB8_ALPHA8, GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR, 8.0f, GL_REPEAT, GL_REPEAT, true, true));
+			updateScene();
 
-	currentRoad = 0;
+			redrawScheduler->waitForFrame(redrawScheduler->requestFrame());
 
+			replayStepTimes.push_back((float)((glfwGetTime() - stepStartTime) * 1000.0));
 
-	//
-	// 2. Main loop
-	// 
-	
+			inputLog->endStep();
 
-	// Loop while program is not terminated.
-	while (!glfwWindowShouldClose(window)) {
+			if (inputLog->isReplayFinished())
+				glfwSetWindowShouldClose(window, true);
+		}
+		else {
 
-		updateScene();
-		renderScene();						// Render into the current buffer
-		glfwSwapBuffers(window);			// Displays what was just rendered (using double buffering).
+			glfwWaitEventsTimeout((redrawScheduler->isContinuous() || animateScene) ? 1.0 / 120.0 : 0.25);
 
-		// Poll events (key presses, mouse events)
-		// glfwWaitEvents();				// Use this if no animation.
-		// glfwWaitEventsTimeout(1.0/60.0);	// Use this to animate at 60 frames/sec (timing is NOT reliable)
-		glfwPollEvents();					// Use this version when animating as fast as possible
+			updateScene();
+
+			inputLog->endStep();
+		}
 	}
 
+	// Stop the render thread and take the context back for shutdown
+	renderThreadRunning = false;
+	redrawScheduler->interrupt();
+	renderThread.join();
+
+	glfwMakeContextCurrent(window);
+
+	if (inputLog->isReplaying())
+		writeReplayTiming(options.replayTimingFilename, replayStepTimes, lockedFrameTimes);
+
+	inputLog->stop();
+
+	if (!options.traceFilename.empty())
+		CPUProfiler::writeChromeTrace(options.traceFilename);
+
+	if (!options.glTraceFilename.empty())
+		GLCallTrace::writeJSON(options.glTraceFilename);
+
+	if (GLDebugOutput::isInstalled())
+		GLDebugOutput::reportSummary(cout);
+
+	redrawScheduler->reportSummary(cout);
+
 	glfwTerminate();
 	return 0;
 }
 
 
 
-// renderScene - function to render the current scene
-void renderScene()
-{
-	// Clear the rendering window
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+// Render thread entry point.  Frames are rendered from the latest camera snapshot and only when the redraw scheduler requests one
+void renderThreadMain(GLFWwindow* window) {
 
-	// Get view-projection transform
-	glm::mat4 T = mainCamera->projectionTransform() * mainCamera->viewTransform();
+	CPU_PROFILE_THREAD("Render");
+
+	glfwMakeContextCurrent(window);
 
-	// Setup transform to position and project road model
-	glm::mat4 roadMVP =
-		T *
-		glm::rotate(glm::mat4(1.0f), glm::radians<float>(-80.0f), glm::vec3(1.0f, 0.0f, 0.0f)) *
-		glm::scale(glm::mat4(1.0f), glm::vec3(32.0f, 128.0f, 1.0f));
+	// Frame-locked frames are timed so do not wait for vertical sync
+	if (redrawScheduler->isFrameLocked())
+		glfwSwapInterval(0);
 
-	// Draw the road model
-	road[currentRoad]->render(roadMVP);
+	gpuProfiler = new GPUProfiler();
 
+	if (captureFromStartup)
+		frameCapture = new FrameCapture(captureOutput, captureFilenamePrefix);
 
-	// Display text showing current filtering mode
-	static const char* filterStrings[] = {
-		"Point filtering",
-		"Bi-linear filtering",
-		"Tri-linear filtering",
-		"Anisotropic filtering 2x",
-		"Anisotropic filtering 8x" };
+	if (adaptiveQualityFromStartup)
+		startAdaptiveQuality();
+
+	double lastAnimationTime = glfwGetTime();
+
+	while (renderThreadRunning) {
+
+		if (redrawScheduler->beginFrame()) {
+
+			CPU_PROFILE_ZONE("Frame");
+
+			double frameStartTime = glfwGetTime();
+
+			GLDebugOutput::setFrameNumber(redrawScheduler->getFramesRendered());
+
+			// Apply scene updates and acquire the latest camera state.  This is done after beginFrame so any update that marked the frame dirty is guaranteed to be visible
+			processRenderCommands();
+			acquireCameraSnapshot();
+
+			// Advance the scene animation by the time since the last frame.  Replayed frames advance by a fixed step so every replay animates identically
+			double animationTime = glfwGetTime();
+			double animationStep = (redrawScheduler->isFrameLocked()) ? REPLAY_ANIMATION_STEP : animationTime - lastAnimationTime;
+
+			if (animateScene && sceneMode == SCENE_STREAMING_ROAD)
+				streamingRoad->advance(STREAMING_ROAD_SPEED * animationStep);
+			else if (animateScene && sceneMode != SCENE_ROAD)
+				animateSyntheticScene((float)animationStep);
+
+			lastAnimationTime = animationTime;
+
+			// Select the quality step before the frame so the filtering mode is included in the profile tag
+			if (qualityController) {
+
+				applyQualityStep();
+				qualityTimer->beginFrame(qualityController->getCurrentStep());
+			}
+
+			gpuProfiler->setTag(profileTag());
+			gpuProfiler->beginFrame();
+
+			renderScene();						// Render into the current buffer
+
+			gpuProfiler->endFrame();
+
+			if (qualityController) {
+
+				qualityTimer->endFrame();
+				updateAdaptiveQuality();
+			}
+
+			GLCallTrace::endFrame();
+
+			// Hand completed reads to the encoder first so their slots are free for this frame
+			if (frameCapture) {
+
+				frameCapture->update();
+				frameCapture->capture(renderWidth, renderHeight, redrawScheduler->getFramesRendered());
+			}
+
+			{
+				CPU_PROFILE_ZONE("glfwSwapBuffers");
+
+				glfwSwapBuffers(window);		// Displays what was just rendered (using double buffering).
+			}
+
+			// Frame-locked frames are timed to completion on the GPU
+			if (redrawScheduler->isFrameLocked()) {
 
-	glDisable(GL_TEXTURE_2D);
-	glUseProgram(0);
-	font->renderText(-4.0f, 3.5f, fontViewMatrix, fontColour, "Filtering mode: %s", filterStrings[currentRoad]);
+				glFinish();
+				lockedFrameTimes.push_back((float)((glfwGetTime() - frameStartTime) * 1000.0));
+			}
+
+			redrawScheduler->endFrame();
+
+			// Update frame time statistics (time spent rendering, excluding time blocked waiting for a redraw)
+			frameTimeAccum += glfwGetTime() - frameStartTime;
+			frameTimeCount++;
+
+			if (frameTimeCount >= 60 || !redrawScheduler->isContinuous()) {
+
+				avgFrameTimeMs = (float)(frameTimeAccum * 1000.0 / frameTimeCount);
+				frameTimeAccum = 0.0;
+				frameTimeCount = 0;
+			}
+		}
+		else {
+
+			// Reads still in flight would otherwise wait for the next redraw
+			if (frameCapture)
+				frameCapture->flush();
+
+			// Drain the command queue so a producer waiting on a full queue is released without a redraw
+			processRenderCommands();
+
+			redrawScheduler->waitForRedraw();
+		}
+	}
+
+	stopAdaptiveQuality();
+
+	delete frameCapture;
+	frameCapture = nullptr;
+
+	glfwMakeContextCurrent(NULL);
 }
 
-// Function called to animate elements in the scene
-void updateScene() {
+
+// Histogram the texel footprint of the road's pixels and recommend (and in FOOTPRINT_APPLY mode set) the anisotropy level of the current road texture
+void analyseRoadFootprint(const glm::mat4& roadMVP) {
+
+	CPU_PROFILE_FUNCTION();
+
+	auto startTime = chrono::steady_clock::now();
+
+	GLuint width = (scaledTarget) ? (GLuint)scaledTarget->getWidth() : (GLuint)renderWidth;
+	GLuint height = (scaledTarget) ? (GLuint)scaledTarget->getHeight() : (GLuint)renderHeight;
+
+	clearFootprintHistogram(footprintHistogram);
+	analyseQuadFootprint(roadMVP, roadTextureSize, width, height, FOOTPRINT_STRIDE, footprintHistogram);
+
+	footprintRecommendation = recommendAnisotropy(footprintHistogram, footprintPercentile, maxSupportedAnisotropy);
+	footprintTime = chrono::duration<double, milli>(chrono::steady_clock::now() - startTime).count();
+
+	if (printFootprint) {
+
+		printFootprintHistogram(footprintHistogram, cout);
+		cout << "Recommended anisotropy for " << footprintPercentile * 100.0f << "% of pixels: " << footprintRecommendation << "x (" << filterStrings[currentRoad] << " uses " << roadAnisotropy[currentRoad] << "x)" << endl;
+		printFootprint = false;
+	}
+
+	if (footprintMode != FOOTPRINT_APPLY)
+		return;
+
+	// Only the anisotropic modes are changed so the other modes still show what their names say
+	if (footprintAppliedRoad != currentRoad)
+		restoreRoadAnisotropy();
+
+	if (roadAnisotropy[currentRoad] > 1.0f && footprintRecommendation != footprintAppliedLevel) {
+
+		setRoadAnisotropy(currentRoad, footprintRecommendation);
+
+		footprintAppliedRoad = currentRoad;
+		footprintAppliedLevel = footprintRecommendation;
+	}
 }
 
 
-#pragma region Event Handler functions
+void setRoadAnisotropy(GLuint roadIndex, GLfloat level) {
 
-void mouseMoveHandler(GLFWwindow* window, double xpos, double ypos) {
+	glBindTexture(GL_TEXTURE_2D, road[roadIndex]->getTexture());
+	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, level);
+	glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+
+// Return the road texture changed by the footprint analysis to the level it was loaded with
+void restoreRoadAnisotropy() {
+
+	if (footprintAppliedRoad >= 0)
+		setRoadAnisotropy(footprintAppliedRoad, roadAnisotropy[footprintAppliedRoad]);
+
+	footprintAppliedRoad = -1;
+	footprintAppliedLevel = 0.0f;
+}
+
+
+// Start the quality controller at the highest step.  Render thread only
+void startAdaptiveQuality() {
+
+	vector<QualityStep> steps(qualityLadder, qualityLadder + NUM_QUALITY_STEPS);
+
+	qualityController = new QualityController(steps, qualitySettings, NUM_QUALITY_STEPS - 1);
+	qualityTimer = new GPUFrameTimer();
+	qualityTrace.clear();
+	appliedQualityStep = NO_QUALITY_STEP;
+
+	cout << "Adaptive quality on - " << qualitySettings.targetFrameTime << " ms GPU budget" << endl;
+}
+
+
+// Stop the quality controller, writing its decisions and timing trace if requested, and restore full quality rendering.  Render thread only
+void stopAdaptiveQuality() {
+
+	if (!qualityController)
+		return;
 
-	if (mouseDown) {
+	if (!qualityLogFilename.empty() && qualityController->writeDecisionLog(qualityLogFilename))
+		cout << "Quality decisions written to " << qualityLogFilename << endl;
 
-		//cout << "x = " << xpos << ", y = " << ypos << endl;
-		double dx = xpos - prevMouseX;
-		double dy = ypos - prevMouseY;
+	if (!qualityTraceFilename.empty() && writeQualityTrace(qualityTraceFilename, qualityTrace))
+		cout << "Quality trace written to " << qualityTraceFilename << endl;
 
-		if (mainCamera)
-			mainCamera->rotateCamera((float)-dy, (float)-dx);
+	// Remove the LOD bias of the last step applied
+	if (appliedQualityStep != NO_QUALITY_STEP && qualityLadder[appliedQualityStep].lodBias != 0.0f) {
 
-		prevMouseX = xpos;
-		prevMouseY = ypos;
+		glBindTexture(GL_TEXTURE_2D, road[qualityLadder[appliedQualityStep].textureLevel]->getTexture());
+		glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_LOD_BIAS, 0.0f);
+		glBindTexture(GL_TEXTURE_2D, 0);
 	}
 
+	delete scaledTarget;
+	delete qualityTimer;
+	delete qualityController;
+
+	scaledTarget = nullptr;
+	qualityTimer = nullptr;
+	qualityController = nullptr;
+	appliedQualityStep = NO_QUALITY_STEP;
+
+	cout << "Adaptive quality off" << endl;
 }
 
-void mouseButtonHandler(GLFWwindow* window, int button, int action, int mods) {
 
-	if (button == GLFW_MOUSE_BUTTON_LEFT) {
+// Select the road texture and LOD bias of the current quality step and bind the reduced resolution target if the step needs one
+void applyQualityStep() {
+
+	GLuint step = qualityController->getCurrentStep();
+	const QualityStep& quality = qualityLadder[step];
 
-		if (action == GLFW_PRESS) {
+	if (step != appliedQualityStep) {
 
-			mouseDown = true;
-			glfwGetCursorPos(window, &prevMouseX, &prevMouseY);
+		// Only the texture of the current step carries a bias
+		if (appliedQualityStep != NO_QUALITY_STEP && qualityLadder[appliedQualityStep].lodBias != 0.0f) {
+
+			glBindTexture(GL_TEXTURE_2D, road[qualityLadder[appliedQualityStep].textureLevel]->getTexture());
+			glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_LOD_BIAS, 0.0f);
 		}
-		else if (action == GLFW_RELEASE) {
 
-			mouseDown = false;
+		glBindTexture(GL_TEXTURE_2D, road[quality.textureLevel]->getTexture());
+		glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_LOD_BIAS, quality.lodBias);
+		glBindTexture(GL_TEXTURE_2D, 0);
+
+		currentRoad = quality.textureLevel;
+		appliedQualityStep = step;
+	}
+
+	if (quality.renderScale < 1.0f) {
+
+		GLsizei width = std::max((GLsizei)(renderWidth * quality.renderScale), 1);
+		GLsizei height = std::max((GLsizei)(renderHeight * quality.renderScale), 1);
+
+		if (!scaledTarget || scaledTarget->getWidth() != width || scaledTarget->getHeight() != height) {
+
+			delete scaledTarget;
+			scaledTarget = new OffscreenTarget(width, height);
 		}
+
+		scaledTarget->bind();
+	}
+	else if (scaledTarget) {
+
+		delete scaledTarget;
+		scaledTarget = nullptr;
 	}
 }
 
-void mouseScrollHandler(GLFWwindow* window, double xoffset, double yoffset) {
 
-	if (mainCamera) {
+// Feed completed GPU frame times to the controller.  Results arrive a few frames late so frames rendered at an earlier step are recorded in the trace but not used to judge the current step
+void updateAdaptiveQuality() {
+
+	float frameTime;
+	GLuint step;
 
-		if (yoffset < 0.0)
-			mainCamera->scaleRadius(1.1f);
-		else if (yoffset > 0.0)
-			mainCamera->scaleRadius(0.9f);
+	while (qualityTimer->getFrameTime(frameTime, step)) {
+
+		qualityTrace.push_back({ step, frameTime });
+		lastQualityFrameTime = frameTime;
+
+		if (step == qualityController->getCurrentStep())
+			qualityController->addFrameTime(frameTime);
 	}
 }
 
-void mouseEnterHandler(GLFWwindow* window, int entered) {
-}
 
-// Function to call when window resized
-void resizeWindow(GLFWwindow* window, int width, int height)
-{
-	if (mainCamera) {
+// Create the scene - font, camera, road textures and models, streaming road, scene graph and synthetic scene - for a viewport of width x height pixels.  A GL context must be current
+void setupScene(int width, int height) {
+
+	CPU_PROFILE_FUNCTION();
+
+	glClearColor(0.0f, 0.0f, 0.0f, 0.0f); // setup background colour to be black
+
+
+	// Setup font
+	font = new GUFont(18);
+	font->setViewportSize(width, height);
+	fontViewMatrix = glm::ortho(-4.0f, 4.0f, -4.0f, 4.0f, -1.0f, 1.0f);
+	fontColour = glm::vec4(1.0f, 1.0f, 0.0f, 1.0f);
+
+	// Setup main camera and test axis object
+	float viewportAspect = (float)width / (float)height;
+	mainCamera = new ArcballCamera(0.0f, 0.0f, 5.0f, 55.0f, viewportAspect, 0.1f, viewDistance);
 
-		mainCamera->setAspectRatio((float)width / (float)height);
+	principleAxes = new PrincipleAxesModel();
+
+
+	//
+	// Load example road texture with different filtering properites.  The images are decoded in parallel on the job system and uploaded here
+	//
+
+	JobSystem::global().resetStats();
+
+	vector<TextureLoadRequest> roadRequests = {
+
+		// Point filtering
+		TextureLoadRequest(string("Assets\\Textures\\road.bmp"), FIF_BMP, TextureProperties(GL_COMPRESSED_SRGB, GL_NEAREST, GL_NEAREST, 1.0f, GL_REPEAT, GL_REPEAT, false, true)),
+
+		// Bilinear filtering
+		TextureLoadRequest(string("Assets\\Textures\\road.bmp"), FIF_BMP, TextureProperties(GL_SRGB8_ALPHA8, GL_LINEAR, GL_LINEAR, 1.0f, GL_REPEAT, GL_REPEAT, false, true)),
+
+		// Tri-linear filtering
+		TextureLoadRequest(string("Assets\\Textures\\road.bmp"), FIF_BMP, TextureProperties(GL_SRGB8_ALPHA8, GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR, 1.0f, GL_REPEAT, GL_REPEAT, true, true)),
+
+		// Anisotropic x2
+		TextureLoadRequest(string("Assets\\Textures\\road.bmp"), FIF_BMP, TextureProperties(GL_SRGB8_ALPHA8, GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR, 2.0f, GL_REPEAT, GL_REPEAT, true, true)),
+
+		// Anisotropic x8
+		TextureLoadRequest(string("Assets\\Textures\\road.bmp"), FIF_BMP, TextureProperties(GL_SRGB8_ALPHA8, GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR, 8.0f, GL_REPEAT, GL_REPEAT, true, true))
+	};
+
+	vector<GLuint> roadTextures = fiLoadTextures(roadRequests);
+
+	for (GLuint i = 0; i < NUM_ROADS; i++)
+		road[i] = new TexturedQuadModel(roadTextures[i]);
+
+	currentRoad = 0;
+
+	// Texture size and anisotropy levels for the footprint analysis
+	GLint roadTextureWidth = 0, roadTextureHeight = 0;
+
+	for (GLuint i = 0; i < NUM_ROADS; i++) {
+
+		roadAnisotropy[i] = 1.0f;
+
+		glBindTexture(GL_TEXTURE_2D, roadTextures[i]);
+		glGetTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, &roadAnisotropy[i]);
+
+		if (i == 0) {
+
+			glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &roadTextureWidth);
+			glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &roadTextureHeight);
+		}
+	}
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	roadTextureSize = glm::vec2((float)std::max(roadTextureWidth, 1), (float)std::max(roadTextureHeight, 1));
+
+	glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &maxSupportedAnisotropy);
+	maxSupportedAnisotropy = std::max(maxSupportedAnisotropy, 1.0f);
+
+	clearFootprintHistogram(footprintHistogram);
+
+	// Register the road textures for sampler feedback (16 x 16 pixel tiles)
+	samplerFeedback = new SamplerFeedback(16, width, height);
+
+	for (GLuint i = 0; i < NUM_ROADS; i++) {
+
+		roadFeedbackSlot[i] = samplerFeedback->registerTexture(roadTextures[i]);
+		road[i]->attachFeedback(samplerFeedback);
 	}
 
-	glViewport(0, 0, width, height);		// Draw into entire window
+	// Setup the streaming road.  Chunks have the same size as the single road quad so texel density matches
+	streamingRoad = new StreamingRoad(32.0f, 128.0f, -1.0f, MAX_VIEW_DISTANCE);
+	streamingRoad->setViewDistance(viewDistance);
+	streamingRoad->attachFeedback(samplerFeedback);
+
+
+	// Setup the scene graph.  The road is rotated to lie along the ground and scaled to a long strip
+	sceneGraph = new SceneGraph(&JobSystem::global());
+	roadNode = sceneGraph->addNode(SceneGraph::NO_PARENT, glm::vec3(0.0f), glm::angleAxis(glm::radians<float>(-80.0f), glm::vec3(1.0f, 0.0f, 0.0f)), glm::vec3(32.0f, 128.0f, 1.0f));
+
+	// Setup synthetic scene for multi-draw-indirect testing
+	setupSyntheticScene();
+	animateScene = false;
+	sceneMode = SCENE_ROAD;
+
+	// Report how the texture loading work was spread over the job system
+	JobSystem::global().reportStats(cout);
 }
 
-// Function to call to handle keyboard input
-void keyboardHandler(GLFWwindow* window, int key, int scancode, int action, int mods)
-{
-	if (action == GLFW_PRESS) {
 
-		// check which key was pressed...
-		switch (key)
-		{
-			case GLFW_KEY_ESCAPE:
-				glfwSetWindowShouldClose(window, true);
+// Apply scene updates queued by the input thread (render thread)
+void processRenderCommands() {
+
+	CPU_PROFILE_FUNCTION();
+
+	RenderCommand command;
+
+	while (renderCommands.pop(command)) {
+
+		switch (command.type) {
+
+			case RENDER_SET_FILTER:
+				stopAdaptiveQuality();
+				currentRoad = command.param[0];
 				break;
 
-			case GLFW_KEY_1:
-				currentRoad = 0;
+			case RENDER_NEXT_SCENE_MODE:
+				sceneMode = (sceneMode + 1) % NUM_SCENE_MODES;
 				break;
 
-			case GLFW_KEY_2:
-				currentRoad = 1;
+			case RENDER_RESIZE:
+				glViewport(0, 0, command.param[0], command.param[1]);		// Draw into entire window
+				font->setViewportSize(command.param[0], command.param[1]);
+				samplerFeedback->setViewportSize(command.param[0], command.param[1]);
+				renderWidth = command.param[0];
+				renderHeight = command.param[1];
 				break;
 
-			case GLFW_KEY_3:
-				currentRoad = 2;
+			case RENDER_SET_VIEW_DISTANCE:
+				streamingRoad->setViewDistance((float)command.param[0]);
 				break;
 
-			case GLFW_KEY_4:
-				currentRoad = 3;
+			case RENDER_TOGGLE_PROFILER:
+				showProfiler = !showProfiler;
 				break;
 
-			case GLFW_KEY_5:
-				currentRoad = 4;
+			case RENDER_EXPORT_PROFILE:
+				if (gpuProfiler->exportCSV("gpu_profile.csv"))
+					cout << "GPU profile written to gpu_profile.csv" << endl;
 				break;
 
-			default:
-			{
-			}
+			case RENDER_TOGGLE_GL_TRACE:
+				if (GLCallTrace::isInstalled())
+					GLCallTrace::uninstall();
+				else if (GLCallTrace::install())
+					GLCallTrace::reset();
+				break;
+
+			case RENDER_EXPORT_GL_TRACE:
+				GLCallTrace::writeJSON("gl_trace.json");
+				break;
+
+			case RENDER_NEXT_FOOTPRINT_MODE:
+				footprintMode = (FootprintMode)((footprintMode + 1) % NUM_FOOTPRINT_MODES);
+				printFootprint = (footprintMode == FOOTPRINT_ANALYSE);
+
+				if (footprintMode != FOOTPRINT_APPLY)
+					restoreRoadAnisotropy();
+
+				break;
+
+			case RENDER_TOGGLE_QUALITY:
+				if (qualityController)
+					stopAdaptiveQuality();
+				else
+					startAdaptiveQuality();
+				break;
+
+			case RENDER_TOGGLE_CAPTURE:
+				if (frameCapture) {
+
+					delete frameCapture;
+					frameCapture = nullptr;
+				}
+				else {
+
+					frameCapture = new FrameCapture(captureOutput, captureFilenamePrefix);
+				}
+				break;
+
+			case RENDER_TOGGLE_FEEDBACK:
+				feedbackEnabled = !feedbackEnabled;
+
+				if (!feedbackEnabled)
+					samplerFeedback->resetResidency();
+
+				break;
 		}
 	}
-	else if (action == GLFW_RELEASE) {
-		// handle key release events
+}
+
+
+// renderScene - function to render the current scene
+void renderScene()
+{
+	CPU_PROFILE_FUNCTION();
+
+	GPUProfileScope sceneScope(gpuProfiler, "renderScene");
+	GLCallContext sceneContext("renderScene");
+
+	// Clear the rendering window
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+	// Get view-projection transform
+	const CameraSnapshot& camera = cameraSnapshots.readBuffer();
+
+	glm::mat4 T = camera.projectionTransform * camera.viewTransform;
+
+	// Apply feedback results the GPU has completed.  If resident levels changed redraw so the change is visible
+	if (feedbackEnabled && samplerFeedback->update())
+		redrawScheduler->markDirty(REDRAW_ASSET_ARRIVED);
+
+	if (sceneMode == SCENE_ROAD) {
+
+		// Setup transform to position and project road model
+		glm::mat4 roadMVP = T * sceneGraph->getWorldTransform(roadNode);
+
+		// The footprint is analysed before drawing so an applied anisotropy level takes effect this frame
+		if (footprintMode != FOOTPRINT_OFF)
+			analyseRoadFootprint(roadMVP);
+
+		// Draw the road model
+		GPUProfileScope roadScope(gpuProfiler, "Road");
+		GLCallContext roadContext("Road");
+
+		road[currentRoad]->render(roadMVP);
+	}
+	else if (sceneMode == SCENE_STREAMING_ROAD) {
+
+		// All visible chunks are drawn with the texture (and filtering mode) of the current road model
+		GPUProfileScope roadScope(gpuProfiler, "Streaming road");
+		GLCallContext roadContext("Streaming road");
+
+		streamingRoad->render(T, camera.frustum, road[currentRoad]->getTexture());
+	}
+	else {
+
+		renderSyntheticScene(T, camera.frustum);
+	}
+
+	// Sampler feedback pass for the road modes.  This writes no colour or depth so it follows the scene
+	if (feedbackEnabled && (sceneMode == SCENE_ROAD || sceneMode == SCENE_STREAMING_ROAD) && samplerFeedback->beginPass()) {
+
+		GPUProfileScope feedbackScope(gpuProfiler, "Sampler feedback");
+		GLCallContext feedbackContext("Sampler feedback");
+
+		if (sceneMode == SCENE_ROAD)
+			road[currentRoad]->renderFeedback(T * sceneGraph->getWorldTransform(roadNode), roadFeedbackSlot[currentRoad]);
+		else
+			streamingRoad->renderFeedback(T, roadFeedbackSlot[currentRoad]);
+
+		samplerFeedback->endPass();
+	}
+
+	// Frames rendered below window resolution are scaled up before the overlay so text stays sharp
+	if (scaledTarget) {
+
+		scaledTarget->blitToDefault(renderWidth, renderHeight);
+		glClear(GL_DEPTH_BUFFER_BIT);
+	}
+
+	// Captures are compared image to image so are rendered without the overlay
+	if (!showOverlay)
+		return;
+
+	// Display text showing current filtering mode
+
+	if (sceneMode == SCENE_ROAD) {
+
+		font->renderText(-4.0f, 3.5f, fontViewMatrix, fontColour, "Filtering mode: %s", filterStrings[currentRoad]);
+		renderFeedbackStatus(3.3f);
+		renderFootprintStatus(3.1f);
+	}
+	else if (sceneMode == SCENE_STREAMING_ROAD) {
+
+		font->renderText(-4.0f, 3.5f, fontViewMatrix, fontColour, "Streaming road: %s, view distance %.0f (+/- to change), %.0f travelled%s", filterStrings[currentRoad], streamingRoad->getViewDistance(), streamingRoad->getTravelDistance(), (animateScene) ? " (A to stop)" : " (A to drive)");
+		font->renderText(-4.0f, 3.3f, fontViewMatrix, fontColour, "Chunks: %u / %u visible, %llu generated, %llu recycled", streamingRoad->getVisibleChunkCount(), streamingRoad->getResidentChunkCount(), streamingRoad->getChunksGenerated(), streamingRoad->getChunksRecycled());
+		font->renderText(-4.0f, 3.1f, fontViewMatrix, fontColour, "Road CPU %.3f ms, GPU %.3f ms", streamingRoad->getCPUTime(), streamingRoad->getGPUTime());
+		renderFeedbackStatus(2.9f);
+	}
+	else if (sceneMode == SCENE_MULTIDRAW) {
+
+		font->renderText(-4.0f, 3.5f, fontViewMatrix, fontColour, "Multi-draw indirect: %u / %u objects visible, %u commands, %u draw calls, %.2f ms", multiDrawBatch->getDrawCount(), (GLuint)syntheticObjects.size(), multiDrawBatch->getCommandCount(), multiDrawBatch->getAPICallCount(), avgFrameTimeMs);
+		font->renderText(-4.0f, 3.3f, fontViewMatrix, fontColour, "BVH cull: %.3f ms, %u nodes visited, %u objects tested", syntheticSceneBVH->getCullTime(), syntheticSceneBVH->getNodesVisited(), syntheticSceneBVH->getObjectsTested());
+		font->renderText(-4.0f, 3.1f, fontViewMatrix, fontColour, "Scene graph: %u nodes, %u updated in %.3f ms%s", sceneGraph->getNodeCount(), sceneGraph->getNodesUpdated(), sceneGraph->getUpdateTime(), (animateScene) ? " (animating - A to stop)" : "");
+	}
+	else {
+
+		font->renderText(-4.0f, 3.5f, fontViewMatrix, fontColour, "Per-object draws: %u / %u objects visible, %u draw calls, %.2f ms", (GLuint)visibleObjects.size(), (GLuint)syntheticObjects.size(), perObjectDrawCalls, avgFrameTimeMs);
+		font->renderText(-4.0f, 3.3f, fontViewMatrix, fontColour, "BVH cull: %.3f ms, %u nodes visited, %u objects tested", syntheticSceneBVH->getCullTime(), syntheticSceneBVH->getNodesVisited(), syntheticSceneBVH->getObjectsTested());
+	}
+
+	renderGLTraceStatus(2.7f);
+	renderCaptureStatus(2.5f);
+	renderQualityStatus(2.3f);
+
+	font->renderText(-4.0f, -3.8f, fontViewMatrix, fontColour, "%s redraw: %llu frames rendered, %llu idle wakeups", (redrawScheduler->isContinuous()) ? "Continuous" : "Event-driven", redrawScheduler->getFramesRendered(), redrawScheduler->getIdleWakeups());
+	font->renderText(-4.0f, -3.6f, fontViewMatrix, fontColour, "Text: %u strings, %u regenerated, %.1f KB formatted (peak %.1f KB)", font->getStringCount(), font->getRegeneratedCount(), (double)font->getArenaBytes() / 1024.0, (double)font->getPeakArenaBytes() / 1024.0);
+	font->renderText(-4.0f, -3.4f, fontViewMatrix, fontColour, "Camera / frustum updates: %llu recomputed, %llu avoided", ArcballCamera::getRecomputeCount() + ViewFrustum::getRecomputeCount(), ArcballCamera::getRecomputesAvoided() + ViewFrustum::getRecomputesAvoided());
+
+	if (showProfiler)
+		renderProfilerStatus(-3.2f);
+	else
+		font->renderText(-4.0f, -3.2f, fontViewMatrix, fontColour, "GPU profiler: G to show, P to export CSV.  GL performance warnings: %llu", GLDebugOutput::getPerformanceMessageCount());
+
+	// Draw all text for the frame
+	GPUProfileScope textScope(gpuProfiler, "Text");
+	GLCallContext textContext("Text");
+
+	font->render();
+}
+
+
+// Tag identifying the scene and filtering mode for the GPU profiler.  The synthetic scenes use their own texture array so the filtering mode is not included
+string profileTag() {
+
+	if (sceneMode == SCENE_ROAD || sceneMode == SCENE_STREAMING_ROAD)
+		return string(sceneModeStrings[sceneMode]) + " / " + filterStrings[currentRoad];
+	else
+		return string(sceneModeStrings[sceneMode]);
+}
+
+
+// Overlay lines (from y upwards) showing GPU timings for the current tag, then the total frame time of every tag recorded so modes can be compared
+void renderProfilerStatus(float y) {
+
+	string tag = profileTag();
+
+	vector<GPUProfiler::ScopeStats> scopes = gpuProfiler->getStats(tag);
+	vector<string> tags = gpuProfiler->getTags();
+
+	for (const string& otherTag : tags) {
+
+		GPUProfiler::ScopeStats stats;
+
+		if (gpuProfiler->getStats(otherTag, "renderScene", stats)) {
+
+			font->renderText(-4.0f, y, fontViewMatrix, fontColour, "%s %s: avg %.3f ms, p95 %.3f ms (%u samples)", (otherTag == tag) ? ">" : " ", otherTag.c_str(), stats.average, stats.p95, stats.samples);
+			y += 0.2f;
+		}
+	}
+
+	font->renderText(-4.0f, y, fontViewMatrix, fontColour, "Frame cost by mode (P to export CSV, G to hide):");
+	y += 0.3f;
+
+	// Drawn bottom-up so scopes read top-down in the order they were recorded
+	for (auto it = scopes.rbegin(); it != scopes.rend(); it++) {
+
+		font->renderText(-4.0f + 0.2f * it->depth, y, fontViewMatrix, fontColour, "%s: avg %.3f, p50 %.3f, p95 %.3f, p99 %.3f ms", it->name.c_str(), it->average, it->p50, it->p95, it->p99);
+		y += 0.2f;
+	}
+
+	font->renderText(-4.0f, y, fontViewMatrix, fontColour, "GPU time - %s (%llu frames profiled, %llu skipped)", tag.c_str(), gpuProfiler->getFramesProfiled(), gpuProfiler->getFramesSkipped());
+}
+
+
+// Overlay line reporting the GL calls made in the last traced frame
+void renderGLTraceStatus(float y) {
+
+	if (!GLCallTrace::isInstalled()) {
+
+		font->renderText(-4.0f, y, fontViewMatrix, fontColour, "GL call trace off (L to enable)");
+		return;
+	}
+
+	const GLCallTrace::FrameStats& stats = GLCallTrace::getLastFrame();
+
+	font->renderText(-4.0f, y, fontViewMatrix, fontColour, "GL calls: %llu (%llu draws, %llu binds redundant), uploaded %.1f KB buffers, %.1f KB textures (L to stop, D to dump)", GLCallTrace::totalCalls(stats), GLCallTrace::drawCalls(stats), GLCallTrace::redundantBinds(stats), (double)stats.bufferBytes / 1024.0, (double)stats.textureBytes / 1024.0);
+}
+
+
+// Overlay line reporting frame capture progress and the render thread time it costs
+void renderCaptureStatus(float y) {
+
+	if (!frameCapture) {
+
+		font->renderText(-4.0f, y, fontViewMatrix, fontColour, "Frame capture off (V to start)");
+		return;
+	}
+
+	font->renderText(-4.0f, y, fontViewMatrix, fontColour, "Capturing to %s: %llu frames, %llu encoded, %llu dropped, %.3f ms per frame (V to stop)", captureFilenamePrefix.c_str(), frameCapture->getFramesCaptured(), frameCapture->getFramesEncoded(), frameCapture->getFramesDropped(), frameCapture->getFrameTime());
+}
+
+
+// Overlay line reporting the adaptive quality step and the GPU frame time it is holding
+void renderQualityStatus(float y) {
+
+	if (!qualityController) {
+
+		font->renderText(-4.0f, y, fontViewMatrix, fontColour, "Adaptive quality off (Q to hold %.1f ms)", qualitySettings.targetFrameTime);
+		return;
+	}
+
+	GLuint step = qualityController->getCurrentStep();
+
+	font->renderText(-4.0f, y, fontViewMatrix, fontColour, "Adaptive quality: %s (step %u / %u), GPU %.2f ms, budget %.1f ms, %u changes (Q to stop)", qualityLadder[step].name, step + 1, NUM_QUALITY_STEPS, lastQualityFrameTime, qualitySettings.targetFrameTime, (GLuint)qualityController->getDecisions().size());
+}
+
+
+// Overlay line reporting the anisotropy the road's pixels need and the level recommended for them
+void renderFootprintStatus(float y) {
+
+	if (footprintMode == FOOTPRINT_OFF) {
+
+		font->renderText(-4.0f, y, fontViewMatrix, fontColour, "Footprint analysis off (H to analyse)");
+		return;
+	}
+
+	const char* applied = (footprintAppliedRoad >= 0) ? "applied" : (footprintMode == FOOTPRINT_APPLY) ? "anisotropic modes only" : "H to apply";
+
+	font->renderText(-4.0f, y, fontViewMatrix, fontColour, "Footprint: ratio p50 %u, p%.0f %u -> %.0fx recommended (%s), LOD p50 %u, %u pixels in %.2f ms", anisotropyPercentile(footprintHistogram, 0.5f), footprintPercentile * 100.0f, anisotropyPercentile(footprintHistogram, footprintPercentile), footprintRecommendation, applied, lodPercentile(footprintHistogram, 0.5f), footprintHistogram.pixels, footprintTime);
+}
+
+
+// Overlay line reporting sampler feedback results for the current road texture
+void renderFeedbackStatus(float y) {
+
+	if (!samplerFeedback->isSupported()) {
+
+		font->renderText(-4.0f, y, fontViewMatrix, fontColour, "Sampler feedback not supported");
+	}
+	else if (feedbackEnabled) {
+
+		GLuint slot = roadFeedbackSlot[currentRoad];
+		GLint minMip = samplerFeedback->getMinMipNeeded(slot);
+
+		if (minMip == MIP_NOT_NEEDED)
+			font->renderText(-4.0f, y, fontViewMatrix, fontColour, "Sampler feedback: texture not sampled, resident levels %d - %u, %llu results (F to disable)", samplerFeedback->getResidentBaseLevel(slot), samplerFeedback->getNumLevels(slot) - 1, samplerFeedback->getResultsProcessed());
+		else
+			font->renderText(-4.0f, y, fontViewMatrix, fontColour, "Sampler feedback: min mip needed %d, resident levels %d - %u, %llu results (F to disable)", minMip, samplerFeedback->getResidentBaseLevel(slot), samplerFeedback->getNumLevels(slot) - 1, samplerFeedback->getResultsProcessed());
+	}
+	else {
+
+		font->renderText(-4.0f, y, fontViewMatrix, fontColour, "Sampler feedback off (F to enable)");
+	}
+}
+
+
+// Setup a synthetic scene of textured quads and principle axes objects in clusters scattered around the origin.  Quads alternate between the road and player ship layers of a texture array
+void setupSyntheticScene() {
+
+	CPU_PROFILE_FUNCTION();
+
+	// The road tile and ship sprite are packed into one texture array so every quad is drawn by the same multi-draw call.  Layers are fixed at 1024 x 1024 so both images share the array whatever their size
+	TextureProperties layerProperties(GL_SRGB8_ALPHA8, GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR, 8.0f, GL_REPEAT, GL_REPEAT, true, true);
+	TextureArrayBuilder arrayBuilder(1024, 1024);
+
+	GLuint roadLayer = arrayBuilder.add(string("Assets\\Textures\\road.bmp"), FIF_BMP, layerProperties);
+	GLuint shipLayer = arrayBuilder.add(string("Assets\\Textures\\player1_ship.png"), FIF_PNG, layerProperties);
+
+	arrayBuilder.build();
+
+	syntheticQuadLayers[0] = arrayBuilder.getHandle(roadLayer).layer;
+	syntheticQuadLayers[1] = arrayBuilder.getHandle(shipLayer).layer;
+
+	// The per-object path draws the same images as separate textures with the same properties so the two modes are compared like for like
+	syntheticQuads[0] = new TexturedQuadModel(string("Assets\\Textures\\road.bmp"), FIF_BMP, layerProperties);
+	syntheticQuads[1] = new TexturedQuadModel(string("Assets\\Textures\\player1_ship.png"), FIF_PNG, layerProperties);
+
+	multiDrawBatch = new MultiDrawBatch(NUM_SYNTHETIC_OBJECTS);
+	multiDrawBatch->setTextureArray(arrayBuilder.getHandle(roadLayer).array);
+
+	batchQuadMesh = TexturedQuadModel::addMeshToBatch(multiDrawBatch);
+	batchAxesMesh = PrincipleAxesModel::addMeshToBatch(multiDrawBatch);
+
+	mt19937 rng(1);
+	uniform_real_distribution<float> clusterPosition(-90.0f, 90.0f);
+	uniform_real_distribution<float> objectPosition(-10.0f, 10.0f);
+	uniform_real_distribution<float> angle(0.0f, glm::two_pi<float>());
+
+	syntheticClusters.resize(NUM_SYNTHETIC_CLUSTERS);
+	syntheticObjects.resize(NUM_SYNTHETIC_OBJECTS);
+
+	for (GLuint c = 0; c < NUM_SYNTHETIC_CLUSTERS; c++)
+		syntheticClusters[c] = sceneGraph->addNode(SceneGraph::NO_PARENT, glm::vec3(clusterPosition(rng), clusterPosition(rng), clusterPosition(rng)), glm::quat(1.0f, 0.0f, 0.0f, 0.0f), glm::vec3(1.0f));
+
+	for (GLuint i = 0; i < NUM_SYNTHETIC_OBJECTS; i++) {
+
+		GLuint cluster = syntheticClusters[i % NUM_SYNTHETIC_CLUSTERS];
+		glm::vec3 position = glm::vec3(objectPosition(rng), objectPosition(rng), objectPosition(rng));
+		glm::quat orientation = glm::angleAxis(angle(rng), glm::vec3(0.0f, 1.0f, 0.0f));
+
+		// Every fourth object is a principle axes model
+		if (i % 4 == 3)
+			syntheticObjects[i] = sceneGraph->addNode(cluster, position, orientation, glm::vec3(1.0f), batchAxesMesh, MultiDrawBatch::NO_TEXTURE);
+		else
+			syntheticObjects[i] = sceneGraph->addNode(cluster, position, orientation, glm::vec3(1.0f), batchQuadMesh, syntheticQuadLayers[i % 2]);
+	}
+
+	sceneGraph->update();
+
+	// Build the culling hierarchy from world space bounds
+	syntheticBoundsMin.resize(NUM_SYNTHETIC_OBJECTS);
+	syntheticBoundsMax.resize(NUM_SYNTHETIC_OBJECTS);
+
+	updateSyntheticBounds();
+
+	syntheticSceneBVH = new SceneBVH();
+	syntheticSceneBVH->build(syntheticBoundsMin.data(), syntheticBoundsMax.data(), NUM_SYNTHETIC_OBJECTS, &JobSystem::global());
+
+	cout << "Synthetic scene BVH: " << syntheticSceneBVH->getNodeCount() << " nodes built in " << syntheticSceneBVH->getBuildTime() << "ms" << endl;
+}
+
+
+// Calculate world space bounds of the synthetic scene objects from their scene graph transforms.  Both meshes lie within <-0.5, -0.5, -0.5> - <1.1, 1.1, 1.1> in model coordinates
+void updateSyntheticBounds() {
+
+	const glm::vec3 localCentre = glm::vec3(0.3f);
+	const glm::vec3 localExtent = glm::vec3(0.8f);
+
+	JobSystem::global().parallelFor(0, syntheticObjects.size(), 4096, [&](size_t begin, size_t end) {
+
+		for (size_t i = begin; i < end; i++) {
+
+			const glm::mat4& M = sceneGraph->getWorldTransform(syntheticObjects[i]);
+
+			glm::vec3 centre = glm::vec3(M * glm::vec4(localCentre, 1.0f));
+			glm::vec3 extent = glm::abs(glm::vec3(M[0])) * localExtent.x + glm::abs(glm::vec3(M[1])) * localExtent.y + glm::abs(glm::vec3(M[2])) * localExtent.z;
+
+			syntheticBoundsMin[i] = centre - extent;
+			syntheticBoundsMax[i] = centre + extent;
+		}
+	});
+}
+
+
+// Spin each cluster of the synthetic scene around its y axis then update the scene graph and refit the culling hierarchy (render thread)
+void animateSyntheticScene(float dt) {
+
+	CPU_PROFILE_FUNCTION();
+
+	for (GLuint c = 0; c < NUM_SYNTHETIC_CLUSTERS; c++) {
+
+		float speed = 0.25f + float(c % 8) * 0.125f;
+
+		sceneGraph->setOrientation(syntheticClusters[c], glm::angleAxis(speed * dt, glm::vec3(0.0f, 1.0f, 0.0f)) * sceneGraph->getOrientation(syntheticClusters[c]));
+	}
+
+	sceneGraph->update();
+
+	updateSyntheticBounds();
+	syntheticSceneBVH->refit(syntheticBoundsMin.data(), syntheticBoundsMax.data());
+}
+
+
+// Render the synthetic scene either through the multi-draw batch or with a draw call per object.  Both modes draw the objects intersecting the view frustum (culled with the scene BVH) with the same images
+void renderSyntheticScene(const glm::mat4& T, const ViewFrustum& frustum) {
+
+	syntheticSceneBVH->cull(frustum, visibleObjects);
+
+	if (sceneMode == SCENE_MULTIDRAW) {
+
+		GPUProfileScope drawScope(gpuProfiler, "Multi-draw");
+		GLCallContext drawContext("Multi-draw");
+
+		multiDrawBatch->beginFrame();
+
+		// The scene graph writes the world transforms of the visible objects straight into the batch
+		visibleNodes.resize(visibleObjects.size());
+
+		for (size_t i = 0; i < visibleObjects.size(); i++)
+			visibleNodes[i] = syntheticObjects[visibleObjects[i]];
+
+		sceneGraph->submit(multiDrawBatch, visibleNodes.data(), (GLuint)visibleNodes.size());
+
+		multiDrawBatch->render(T);
+	}
+	else {
+
+		// Timed as a single scope - a scope per object would exceed GPUProfiler::MAX_SCOPES
+		GPUProfileScope drawScope(gpuProfiler, "Per-object draws");
+		GLCallContext drawContext("Per-object draws");
+
+		perObjectDrawCalls = 0;
+
+		for (GLuint object : visibleObjects) {
+
+			GLuint node = syntheticObjects[object];
+
+			if (sceneGraph->getMeshID(node) == batchAxesMesh)
+				principleAxes->render(T * sceneGraph->getWorldTransform(node));
+			else
+				syntheticQuads[(sceneGraph->getTextureLayer(node) == syntheticQuadLayers[1]) ? 1 : 0]->render(T * sceneGraph->getWorldTransform(node));
+
+			perObjectDrawCalls++;
+		}
+
+		glBindVertexArray(0);
+	}
+}
+
+// Function called to animate elements in the scene (input / simulation thread).  Input accumulated since the last step is applied as a single camera update and the result published to the render thread
+void updateScene() {
+
+	CPU_PROFILE_FUNCTION();
+
+	bool cameraChanged = false;
+
+	if (pendingAspect > 0.0f) {
+
+		mainCamera->setAspectRatio(pendingAspect);
+		pendingAspect = 0.0f;
+		cameraChanged = true;
+	}
+
+	if (pendingRotateTheta != 0.0f || pendingRotatePhi != 0.0f) {
+
+		mainCamera->rotateCamera(pendingRotateTheta, pendingRotatePhi);
+		pendingRotateTheta = 0.0f;
+		pendingRotatePhi = 0.0f;
+		cameraChanged = true;
+	}
+
+	if (pendingZoom != 1.0f) {
+
+		mainCamera->scaleRadius(pendingZoom);
+		pendingZoom = 1.0f;
+		cameraChanged = true;
+	}
+
+	if (pendingViewDistanceScale != 1.0f) {
+
+		viewDistance = glm::clamp<float>(viewDistance * pendingViewDistanceScale, MIN_VIEW_DISTANCE, MAX_VIEW_DISTANCE);
+		pendingViewDistanceScale = 1.0f;
+
+		mainCamera->setFarPlaneDistance(viewDistance);
+		sendRenderCommand({ RENDER_SET_VIEW_DISTANCE, { (int)viewDistance, 0 } });
+		cameraChanged = true;
+	}
+
+	if (cameraChanged) {
+
+		publishCameraSnapshot();
+		redrawScheduler->markDirty(REDRAW_CAMERA);
+	}
+
+	// The render thread steps the animation each frame it draws
+	if (animateScene)
+		redrawScheduler->markDirty(REDRAW_ANIMATION);
+}
+
+
+// Copy the camera state into the triple buffer and publish it to the render thread
+void publishCameraSnapshot() {
+
+	CPU_PROFILE_FUNCTION();
+
+	CameraSnapshot& snapshot = cameraSnapshots.writeBuffer();
+
+	snapshot.viewTransform = mainCamera->viewTransform();
+	snapshot.projectionTransform = mainCamera->projectionTransform();
+	snapshot.frustum = mainCamera->getViewFrustum();
+	snapshot.position = mainCamera->getPosition();
+
+	cameraSnapshots.publish();
+}
+
+
+// Acquire the latest camera state published by the simulation thread (render thread)
+void acquireCameraSnapshot() {
+
+	cameraSnapshots.update();
+}
+
+
+// Queue a scene update for the render thread (input or benchmark thread).  Commands are never dropped - while the queue is full the render thread is woken to drain it (it does so even when there is nothing to render) and the caller waits
+void sendRenderCommand(const RenderCommand& command) {
+
+	while (!renderCommands.push(command) && renderThreadRunning) {
+
+		redrawScheduler->interrupt();
+		std::this_thread::yield();
+	}
+}
+
+
+#pragma region Event Handler functions
+
+// GLFW event callbacks.  Events are recorded when recording input and ignored while a recording is replayed (apart from Escape so a replay can be abandoned)
+void mouseMoveHandler(GLFWwindow* window, double xpos, double ypos) {
+
+	InputEvent event = {};
+
+	event.type = INPUT_CURSOR_POS;
+	event.x = xpos;
+	event.y = ypos;
+
+	handleInput(window, event);
+}
+
+void mouseButtonHandler(GLFWwindow* window, int button, int action, int mods) {
+
+	InputEvent event = {};
+
+	event.type = INPUT_MOUSE_BUTTON;
+	event.key = button;
+	event.action = action;
+	event.mods = mods;
+	glfwGetCursorPos(window, &event.x, &event.y);
+
+	handleInput(window, event);
+}
+
+void mouseScrollHandler(GLFWwindow* window, double xoffset, double yoffset) {
+
+	InputEvent event = {};
+
+	event.type = INPUT_SCROLL;
+	event.x = xoffset;
+	event.y = yoffset;
+
+	handleInput(window, event);
+}
+
+void mouseEnterHandler(GLFWwindow* window, int entered) {
+}
+
+// Function to call when window resized
+void resizeWindow(GLFWwindow* window, int width, int height) {
+
+	InputEvent event = {};
+
+	event.type = INPUT_RESIZE;
+	event.width = width;
+	event.height = height;
+
+	handleInput(window, event);
+}
+
+// Function to call to handle keyboard input.  Only key presses change the viewer state so other key events are not recorded
+void keyboardHandler(GLFWwindow* window, int key, int scancode, int action, int mods) {
+
+	if (action != GLFW_PRESS)
+		return;
+
+	InputEvent event = {};
+
+	event.type = INPUT_KEY;
+	event.key = key;
+	event.action = action;
+	event.mods = mods;
+
+	handleInput(window, event);
+}
+
+
+void handleInput(GLFWwindow* window, const InputEvent& event) {
+
+	if (inputLog->isReplaying()) {
+
+		if (event.type == INPUT_KEY && event.key == GLFW_KEY_ESCAPE)
+			glfwSetWindowShouldClose(window, true);
+
+		return;
+	}
+
+	inputLog->record(event);
+	applyInput(window, event);
+}
+
+
+// Apply a live or replayed input event
+void applyInput(GLFWwindow* window, const InputEvent& event) {
+
+	switch (event.type) {
+
+		case INPUT_CURSOR_POS:
+
+			if (mouseDown) {
+
+				double dx = event.x - prevMouseX;
+				double dy = event.y - prevMouseY;
+
+				pendingRotateTheta += (float)-dy;
+				pendingRotatePhi += (float)-dx;
+
+				prevMouseX = event.x;
+				prevMouseY = event.y;
+			}
+
+			break;
+
+		case INPUT_MOUSE_BUTTON:
+
+			if (event.key == GLFW_MOUSE_BUTTON_LEFT) {
+
+				if (event.action == GLFW_PRESS) {
+
+					mouseDown = true;
+					prevMouseX = event.x;
+					prevMouseY = event.y;
+				}
+				else if (event.action == GLFW_RELEASE) {
+
+					mouseDown = false;
+				}
+			}
+
+			break;
+
+		case INPUT_SCROLL:
+
+			if (event.y < 0.0)
+				pendingZoom *= 1.1f;
+			else if (event.y > 0.0)
+				pendingZoom *= 0.9f;
+
+			break;
+
+		case INPUT_RESIZE:
+
+			if (event.width <= 0 || event.height <= 0)
+				break;
+
+			// The camera aspect ratio is updated on the next simulation step and the viewport on the render thread
+			pendingAspect = (float)event.width / (float)event.height;
+
+			sendRenderCommand({ RENDER_RESIZE, { event.width, event.height } });
+			redrawScheduler->markDirty(REDRAW_RESIZE);
+			break;
+
+		case INPUT_KEY:
+			applyKeyPress(window, event.key);
+			break;
+
+		default:
+			break;
+	}
+}
+
+
+void applyKeyPress(GLFWwindow* window, int key) {
+
+	// check which key was pressed...
+	switch (key)
+	{
+		case GLFW_KEY_ESCAPE:
+			glfwSetWindowShouldClose(window, true);
+			break;
+
+		case GLFW_KEY_1:
+			sendRenderCommand({ RENDER_SET_FILTER, { 0, 0 } });
+			redrawScheduler->markDirty(REDRAW_FILTER_MODE);
+			break;
+
+		case GLFW_KEY_2:
+			sendRenderCommand({ RENDER_SET_FILTER, { 1, 0 } });
+			redrawScheduler->markDirty(REDRAW_FILTER_MODE);
+			break;
+
+		case GLFW_KEY_3:
+			sendRenderCommand({ RENDER_SET_FILTER, { 2, 0 } });
+			redrawScheduler->markDirty(REDRAW_FILTER_MODE);
+			break;
+
+		case GLFW_KEY_4:
+			sendRenderCommand({ RENDER_SET_FILTER, { 3, 0 } });
+			redrawScheduler->markDirty(REDRAW_FILTER_MODE);
+			break;
+
+		case GLFW_KEY_5:
+			sendRenderCommand({ RENDER_SET_FILTER, { 4, 0 } });
+			redrawScheduler->markDirty(REDRAW_FILTER_MODE);
+			break;
+
+		case GLFW_KEY_M:
+			sendRenderCommand({ RENDER_NEXT_SCENE_MODE, { 0, 0 } });
+			redrawScheduler->markDirty(REDRAW_SCENE_MODE);
+			break;
+
+		case GLFW_KEY_C:
+			redrawScheduler->setContinuous(!redrawScheduler->isContinuous());
+			break;
+
+		case GLFW_KEY_EQUAL:
+		case GLFW_KEY_KP_ADD:
+			pendingViewDistanceScale *= 2.0f;
+			break;
+
+		case GLFW_KEY_MINUS:
+		case GLFW_KEY_KP_SUBTRACT:
+			pendingViewDistanceScale *= 0.5f;
+			break;
+
+		case GLFW_KEY_T:
+			CPUProfiler::writeChromeTrace("cpu_trace.json");
+			break;
+
+		case GLFW_KEY_G:
+			sendRenderCommand({ RENDER_TOGGLE_PROFILER, { 0, 0 } });
+			redrawScheduler->markDirty(REDRAW_OVERLAY);
+			break;
+
+		case GLFW_KEY_P:
+			sendRenderCommand({ RENDER_EXPORT_PROFILE, { 0, 0 } });
+			redrawScheduler->markDirty(REDRAW_TOOL);
+			break;
+
+		case GLFW_KEY_L:
+			sendRenderCommand({ RENDER_TOGGLE_GL_TRACE, { 0, 0 } });
+			redrawScheduler->markDirty(REDRAW_TOOL);
+			break;
+
+		case GLFW_KEY_D:
+			sendRenderCommand({ RENDER_EXPORT_GL_TRACE, { 0, 0 } });
+			redrawScheduler->markDirty(REDRAW_TOOL);
+			break;
+
+		case GLFW_KEY_H:
+			sendRenderCommand({ RENDER_NEXT_FOOTPRINT_MODE, { 0, 0 } });
+			redrawScheduler->markDirty(REDRAW_OVERLAY);
+			break;
+
+		case GLFW_KEY_Q:
+			sendRenderCommand({ RENDER_TOGGLE_QUALITY, { 0, 0 } });
+			redrawScheduler->markDirty(REDRAW_QUALITY);
+			break;
+
+		case GLFW_KEY_V:
+			sendRenderCommand({ RENDER_TOGGLE_CAPTURE, { 0, 0 } });
+			redrawScheduler->markDirty(REDRAW_TOOL);
+			break;
+
+		case GLFW_KEY_F:
+			sendRenderCommand({ RENDER_TOGGLE_FEEDBACK, { 0, 0 } });
+			redrawScheduler->markDirty(REDRAW_QUALITY);
+			break;
+
+		case GLFW_KEY_A:
+			animateScene = !animateScene;
+			redrawScheduler->markDirty(REDRAW_ANIMATION);
+			break;
+
+		default:
+		{
+		}
 	}
 }
 